@@ -27,6 +27,7 @@ namespace d2dx
 	{
 	public:
 		Batch() noexcept :
+			_contentKey(0),
 			_textureStartAddress(0),
 			_startVertexHigh_textureIndex(0),
 			_textureHash(0),
@@ -180,6 +181,16 @@ namespace d2dx
 			_textureHash = textureHash;
 		}
 
+		inline uint64_t GetContentKey() const noexcept
+		{
+			return _contentKey;
+		}
+
+		void SetContentKey(uint64_t contentKey) noexcept
+		{
+			_contentKey = contentKey;
+		}
+
 		inline uint32_t GetTextureAtlas() const noexcept
 		{
 			return (uint32_t)(_textureAtlas & 7);
@@ -240,7 +251,8 @@ namespace d2dx
 		}
 
 	private:
-		uint32_t _textureHash;
+		uint64_t _contentKey;									// WideHash of the texture pixels
+		uint32_t _textureHash;									// FNV-1a, used to identify known game textures
 		uint16_t _startVertexLow;
 		uint16_t _vertexCount;
 		uint16_t _textureStartAddress;							// byte address / D2DX_TMU_ADDRESS_ALIGNMENT
@@ -251,5 +263,5 @@ namespace d2dx
 		uint8_t _textureAtlas;									// .....AAA
 	};
 
-	static_assert(sizeof(Batch) == 16, "sizeof(Batch)");
+	static_assert(sizeof(Batch) == 24, "sizeof(Batch)");
 }
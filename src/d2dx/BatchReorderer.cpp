@@ -0,0 +1,175 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "BatchReorderer.h"
+#include "Utils.h"
+
+using namespace d2dx;
+
+/* Bounding boxes are inclusive, so batches that merely touch count as overlapping. */
+static bool RectsOverlap(
+	const Rect& a,
+	const Rect& b)
+{
+	return
+		a.offset.x <= (b.offset.x + b.size.width) && b.offset.x <= (a.offset.x + a.size.width) &&
+		a.offset.y <= (b.offset.y + b.size.height) && b.offset.y <= (a.offset.y + a.size.height);
+}
+
+static Rect UnionRects(
+	const Rect& a,
+	const Rect& b)
+{
+	const int32_t minx = min(a.offset.x, b.offset.x);
+	const int32_t miny = min(a.offset.y, b.offset.y);
+	const int32_t maxx = max(a.offset.x + a.size.width, b.offset.x + b.size.width);
+	const int32_t maxy = max(a.offset.y + a.size.height, b.offset.y + b.size.height);
+	return { minx, miny, maxx - minx, maxy - miny };
+}
+
+_Use_decl_annotations_
+BatchReorderer::BatchReorderer(
+	uint32_t maxBatchCount) :
+	_groups{ maxBatchCount },
+	_nextBatches{ maxBatchCount }
+{
+}
+
+_Use_decl_annotations_
+uint32_t BatchReorderer::Reorder(
+	const Batch* batches,
+	const Rect* batchRects,
+	const BatchDrawState* drawStates,
+	uint32_t batchCount,
+	const Vertex* vertices,
+	bool allowReordering,
+	Batch* drawBatches,
+	Vertex* drawVertices,
+	uint32_t* drawVertexCount)
+{
+	assert(batchCount <= _groups.capacity);
+
+	const int32_t window = allowReordering ? (int32_t)Window : 1;
+	int32_t groupCount = 0;
+
+	for (int32_t i = 0; i < (int32_t)batchCount; ++i)
+	{
+		const Batch& batch = batches[i];
+
+		if (!batch.IsValid())
+		{
+			D2DX_DEBUG_LOG("Skipping batch %i, it is invalid.", i);
+			continue;
+		}
+
+		const BatchDrawState& drawState = drawStates[i];
+		const Rect& rect = batchRects[i];
+		const int32_t firstCandidate = max(0, groupCount - window);
+		uint32_t overlapTestCount = 0;
+		int32_t target = -1;
+
+		for (int32_t g = groupCount - 1; g >= firstCandidate; --g)
+		{
+			const Group& group = _groups.items[g];
+
+			if (group.drawState == drawState &&
+				(group.vertexCount + batch.GetVertexCount()) <= MaxDrawCallVertexCount)
+			{
+				target = g;
+				break;
+			}
+
+			if (!allowReordering || Overlaps(g, rect, batchRects, overlapTestCount))
+			{
+				break;
+			}
+		}
+
+		_nextBatches.items[i] = -1;
+
+		if (target < 0)
+		{
+			Group& group = _groups.items[groupCount++];
+			group.drawState = drawState;
+			group.bounds = rect;
+			group.vertexCount = batch.GetVertexCount();
+			group.firstBatch = i;
+			group.lastBatch = i;
+		}
+		else
+		{
+			Group& group = _groups.items[target];
+			group.bounds = UnionRects(group.bounds, rect);
+			group.vertexCount += batch.GetVertexCount();
+			_nextBatches.items[group.lastBatch] = i;
+			group.lastBatch = i;
+		}
+	}
+
+	uint32_t vertexCount = 0;
+
+	for (int32_t g = 0; g < groupCount; ++g)
+	{
+		const Group& group = _groups.items[g];
+
+		Batch& drawBatch = drawBatches[g];
+		drawBatch = batches[group.firstBatch];
+		drawBatch.SetStartVertex(vertexCount);
+		drawBatch.SetVertexCount(group.vertexCount);
+
+		for (int32_t i = group.firstBatch; i >= 0; i = _nextBatches.items[i])
+		{
+			const Batch& batch = batches[i];
+			memcpy(drawVertices + vertexCount, vertices + batch.GetStartVertex(), sizeof(Vertex) * batch.GetVertexCount());
+			vertexCount += batch.GetVertexCount();
+		}
+	}
+
+	*drawVertexCount = vertexCount;
+
+	return (uint32_t)groupCount;
+}
+
+_Use_decl_annotations_
+bool BatchReorderer::Overlaps(
+	int32_t groupIndex,
+	const Rect& rect,
+	const Rect* batchRects,
+	uint32_t& overlapTestCount) const
+{
+	const Group& group = _groups.items[groupIndex];
+
+	if (!RectsOverlap(group.bounds, rect))
+	{
+		return false;
+	}
+
+	/* The bounds of a group can be much larger than its batches, e.g. for floor tiles spread over the
+	   screen, so test the batches themselves. */
+	for (int32_t i = group.firstBatch; i >= 0; i = _nextBatches.items[i])
+	{
+		if (++overlapTestCount > MaxOverlapTests ||
+			RectsOverlap(batchRects[i], rect))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,97 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Batch.h"
+#include "Buffer.h"
+#include "Vertex.h"
+
+namespace d2dx
+{
+	struct ITextureCache;
+
+	/* The state that must be equal for batches to be drawn in one draw call. */
+	struct BatchDrawState final
+	{
+		const ITextureCache* textureCache;
+		uint32_t textureAtlas;
+		AlphaBlend alphaBlend;
+
+		bool operator==(const BatchDrawState& rhs) const noexcept
+		{
+			return textureCache == rhs.textureCache && textureAtlas == rhs.textureAtlas && alphaBlend == rhs.alphaBlend;
+		}
+	};
+
+	/*
+		Merges the batches of a frame into as few draw calls as possible. Each batch is moved back to
+		the latest earlier draw call with the same draw state, as long as it does not overlap (by screen
+		bounding box) any batch drawn after that draw call. Overlapping batches therefore keep their
+		painter's order, while e.g. interleaved floor tiles and sprites in different parts of the screen
+		are grouped. The search is limited to the last Window draw calls and MaxOverlapTests bounding
+		box tests per batch; beyond that a batch is treated as overlapping.
+	*/
+	class BatchReorderer final
+	{
+	public:
+		static constexpr uint32_t Window = 64;
+		static constexpr uint32_t MaxOverlapTests = 256;
+
+		/* One quad short of the index buffer, since Batch stores the vertex count in 16 bits. */
+		static constexpr uint32_t MaxDrawCallVertexCount = 4 * (D2DX_MAX_QUADS_PER_DRAW_CALL - 1);
+
+		BatchReorderer(
+			_In_ uint32_t maxBatchCount);
+
+		~BatchReorderer() noexcept {}
+
+		/* Writes the merged draw calls to drawBatches and their vertices, contiguous and in draw order,
+		   to drawVertices. Without allowReordering only consecutive batches are merged. Returns the
+		   number of draw calls; invalid batches are dropped. */
+		uint32_t Reorder(
+			_In_reads_(batchCount) const Batch* batches,
+			_In_reads_(batchCount) const Rect* batchRects,
+			_In_reads_(batchCount) const BatchDrawState* drawStates,
+			_In_ uint32_t batchCount,
+			_In_ const Vertex* vertices,
+			_In_ bool allowReordering,
+			_Out_writes_(batchCount) Batch* drawBatches,
+			_Out_ Vertex* drawVertices,
+			_Out_ uint32_t* drawVertexCount);
+
+	private:
+		bool Overlaps(
+			_In_ int32_t groupIndex,
+			_In_ const Rect& rect,
+			_In_ const Rect* batchRects,
+			_Inout_ uint32_t& overlapTestCount) const;
+
+		struct Group final
+		{
+			BatchDrawState drawState;
+			Rect bounds;
+			uint32_t vertexCount;
+			int32_t firstBatch;
+			int32_t lastBatch;
+		};
+
+		Buffer<Group> _groups;
+		Buffer<int32_t> _nextBatches;
+	};
+}
@@ -52,17 +52,28 @@ _Use_decl_annotations_
 D2DXContext::D2DXContext(
 	const std::shared_ptr<IGameHelper>& gameHelper,
 	const std::shared_ptr<ISimd>& simd,
-	const std::shared_ptr<CompatibilityModeDisabler>& compatibilityModeDisabler) :
+	const std::shared_ptr<CompatibilityModeDisabler>& compatibilityModeDisabler,
+	const std::shared_ptr<IRenderContext>& renderContext) :
+	_renderContext{ renderContext },
 	_gameHelper{ gameHelper },
 	_simd{ simd },
 	_compatibilityModeDisabler{ compatibilityModeDisabler },
+	_textureHasher{ simd },
 	_frame(0),
 	_majorGameState(MajorGameState::Unknown),
 	_paletteKeys(D2DX_MAX_PALETTES, true),
+	_textureCacheMemos(D2DX_TMU_MEMORY_SIZE / 256, true),
 	_batchCount(0),
 	_batches(D2DX_MAX_BATCHES_PER_FRAME),
+	_batchRects(D2DX_MAX_BATCHES_PER_FRAME),
 	_vertexCount(0),
 	_vertices(D2DX_MAX_VERTICES_PER_FRAME),
+	_batchReorderer{ D2DX_MAX_BATCHES_PER_FRAME },
+	_batchDrawStates(D2DX_MAX_BATCHES_PER_FRAME),
+	_drawBatchCount(0),
+	_drawBatches(D2DX_MAX_BATCHES_PER_FRAME),
+	_drawVertexCount(0),
+	_drawVertices(D2DX_MAX_VERTICES_PER_FRAME),
 	_customGameSize{ 0,0 },
 	_suggestedGameSize{ 0, 0 },
 	_options{ GetCommandLineOptions() },
@@ -71,10 +82,22 @@ D2DXContext::D2DXContext(
 	_textMotionPredictor{ gameHelper },
 	_unitMotionPredictor{ gameHelper },
 	_weatherMotionPredictor{ gameHelper },
+	_frameProfiler{ D2DX_FRAME_PROFILER_HISTORY_SIZE },
 	_featureFlags{ 0 }
 {
 	_threadId = GetCurrentThreadId();
 
+	if (_options.GetFlag(OptionsFlag::DbgTraceEvents))
+	{
+		_traceEventWriter = std::make_unique<TraceEventWriter>("d2dx_trace.json");
+		TraceEventWriter::SetInstance(_traceEventWriter.get());
+		_frameProfiler.SetTraceEventWriter(_traceEventWriter.get());
+	}
+
+	_frameProfiler.SetEnabled(
+		_options.GetFlag(OptionsFlag::DbgProfileFrames) ||
+		_options.GetFlag(OptionsFlag::DbgTraceEvents));
+
 	if (!_options.GetFlag(OptionsFlag::NoCompatModeFix))
 	{
 		_compatibilityModeDisabler->DisableCompatibilityMode();
@@ -111,6 +134,12 @@ D2DXContext::D2DXContext(
 
 D2DXContext::~D2DXContext() noexcept
 {
+	DumpFrameProfile();
+	LogFrameTimeStatistics();
+
+	_frameProfiler.SetTraceEventWriter(nullptr);
+	_traceEventWriter = nullptr;
+
 	DetachLateDetours();
 }
 
@@ -256,20 +285,28 @@ void D2DXContext::OnTexDownload(
 	int32_t width,
 	int32_t height)
 {
+	ProfilerScope profilerScope{ _frameProfiler, ProfilerPhase::TexDownload };
+
 	assert(tmu == 0 && (startAddress & 255) == 0);
 	if (!(tmu == 0 && (startAddress & 255) == 0))
 	{
 		return;
 	}
 
-	_textureHasher.Invalidate(startAddress);
-
 	uint32_t memRequired = (uint32_t)(width * height);
 
 	auto pStart = _glideState.tmuMemory.items + startAddress;
 	auto pEnd = _glideState.tmuMemory.items + startAddress + memRequired;
 	assert(pEnd <= (_glideState.tmuMemory.items + _glideState.tmuMemory.capacity));
-	memcpy_s(pStart, _glideState.tmuMemory.capacity - startAddress, sourceAddress, memRequired);
+	if (memRequired > _glideState.tmuMemory.capacity - startAddress)
+	{
+		_textureHasher.Invalidate(startAddress, memRequired);
+		return;
+	}
+
+	/* Hash while copying, so the texture is only read once and the GetHash in OnTexSource is a hit. */
+	const uint64_t contentKey = _simd->CopyAndHashBytes64(pStart, sourceAddress, memRequired);
+	_textureHasher.SetHash(startAddress, contentKey, memRequired);
 }
 
 _Use_decl_annotations_
@@ -279,6 +316,8 @@ void D2DXContext::OnTexSource(
 	int32_t width,
 	int32_t height)
 {
+	ProfilerScope profilerScope{ _frameProfiler, ProfilerPhase::TexSource };
+
 	assert(tmu == 0 && (startAddress & 255) == 0);
 	if (!(tmu == 0 && (startAddress & 255) == 0))
 	{
@@ -294,7 +333,10 @@ void D2DXContext::OnTexSource(
 	_BitScanReverse((DWORD*)&stShift, max(width, height));
 	_glideState.stShift = 8 - stShift;
 
-	uint32_t hash = _textureHasher.GetHash(startAddress, pixels, pixelsSize);
+	const uint64_t contentKey = _textureHasher.GetHash(startAddress, pixels, pixelsSize);
+
+	uint32_t hash = 0;
+	const TextureCategory category = _gameHelper->GetTextureCategory(contentKey, pixels, pixelsSize, hash);
 
 	/* Patch the '5' to not look like '6'. */
 	if (hash == 0x8a12f6bb)
@@ -306,11 +348,12 @@ void D2DXContext::OnTexSource(
 
 	_scratchBatch.SetTextureStartAddress(startAddress);
 	_scratchBatch.SetTextureHash(hash);
+	_scratchBatch.SetContentKey(contentKey);
 	_scratchBatch.SetTextureSize(width, height);
 
 	if (_scratchBatch.GetTextureCategory() == TextureCategory::Unknown)
 	{
-		_scratchBatch.SetTextureCategory(_gameHelper->GetTextureCategoryFromHash(hash));
+		_scratchBatch.SetTextureCategory(category);
 	}
 
 	if (_options.GetFlag(OptionsFlag::DbgDumpTextures))
@@ -352,68 +395,60 @@ void D2DXContext::CheckMajorGameState()
 	}
 }
 
-_Use_decl_annotations_
-void D2DXContext::DrawBatches(
-	uint32_t startVertexLocation)
+void D2DXContext::ReorderBatches()
 {
-	const int32_t batchCount = (int32_t)_batchCount;
-
-	Batch mergedBatch;
-	int32_t drawCalls = 0;
-
-	for (int32_t i = 0; i < batchCount; ++i)
+	for (uint32_t i = 0; i < _batchCount; ++i)
 	{
 		const Batch& batch = _batches.items[i];
 
-		if (!batch.IsValid())
-		{
-			D2DX_DEBUG_LOG("Skipping batch %i, it is invalid.", i);
-			continue;
-		}
-
-		if (!mergedBatch.IsValid())
+		if (batch.IsValid())
 		{
-			mergedBatch = batch;
-		}
-		else
-		{
-			if (_renderContext->GetTextureCache(batch) != _renderContext->GetTextureCache(mergedBatch) ||
-				batch.GetTextureAtlas() != mergedBatch.GetTextureAtlas() ||
-				batch.GetAlphaBlend() != mergedBatch.GetAlphaBlend() ||
-				((mergedBatch.GetVertexCount() + batch.GetVertexCount()) > 65535))
-			{
-				_renderContext->Draw(mergedBatch, startVertexLocation);
-				++drawCalls;
-				mergedBatch = batch;
-			}
-			else
-			{
-				mergedBatch.SetVertexCount(mergedBatch.GetVertexCount() + batch.GetVertexCount());
-			}
+			_batchDrawStates.items[i] = { _renderContext->GetTextureCache(batch), batch.GetTextureAtlas(), batch.GetAlphaBlend() };
 		}
 	}
 
-	if (mergedBatch.IsValid())
+	_drawBatchCount = _batchReorderer.Reorder(
+		_batches.items,
+		_batchRects.items,
+		_batchDrawStates.items,
+		_batchCount,
+		_vertices.items,
+		!_options.GetFlag(OptionsFlag::NoBatchReordering),
+		_drawBatches.items,
+		_drawVertices.items,
+		&_drawVertexCount);
+}
+
+_Use_decl_annotations_
+void D2DXContext::DrawBatches(
+	uint32_t startVertexLocation)
+{
+	for (uint32_t i = 0; i < _drawBatchCount; ++i)
 	{
-		_renderContext->Draw(mergedBatch, startVertexLocation);
-		++drawCalls;
+		_renderContext->Draw(_drawBatches.items[i], startVertexLocation);
 	}
 
 	if (!(_frame & 255))
 	{
-		D2DX_DEBUG_LOG("Nr draw calls: %i", drawCalls);
+		D2DX_DEBUG_LOG("Nr draw calls: %u (%u batches)", _drawBatchCount, _batchCount);
 	}
 }
 
 
 void D2DXContext::OnBufferSwap()
 {
-	CheckMajorGameState();
+	{
+		ProfilerScope profilerScope{ _frameProfiler, ProfilerPhase::CheckMajorGameState };
+		CheckMajorGameState();
+	}
+
 	InsertLogoOnTitleScreen();
 
 	if (IsFeatureEnabled(Feature::UnitMotionPrediction) &&
 		_majorGameState == MajorGameState::InGame)
 	{
+		ProfilerScope profilerScope{ _frameProfiler, ProfilerPhase::MotionOffset };
+
 		const Offset offset = _unitMotionPredictor.GetOffset(_gameHelper->GetPlayerUnit());
 
 		for (uint32_t i = 0; i < _batchCount; ++i)
@@ -432,20 +467,51 @@ void D2DXContext::OnBufferSwap()
 						-offset.x,
 						-offset.y);
 				}
+
+				_batchRects.items[i].offset.x -= offset.x;
+				_batchRects.items[i].offset.y -= offset.y;
 			}
 		}
 	}
 
-	auto startVertexLocation = _renderContext->BulkWriteVertices(_vertices.items, _vertexCount);
+	{
+		ProfilerScope profilerScope{ _frameProfiler, ProfilerPhase::ReorderBatches };
+		ReorderBatches();
+	}
+
+	if (_frameDigest)
+	{
+		_frameDigest->AddFrame(_drawBatches.items, _drawBatchCount, _drawVertices.items, _drawVertexCount);
+	}
+
+	uint32_t startVertexLocation = 0;
+
+	{
+		ProfilerScope profilerScope{ _frameProfiler, ProfilerPhase::BulkWriteVertices };
+		startVertexLocation = _renderContext->BulkWriteVertices(_drawVertices.items, _drawVertexCount);
+	}
+
+	{
+		ProfilerScope profilerScope{ _frameProfiler, ProfilerPhase::FlushTextureUploads };
+		_renderContext->FlushTextureUploads();
+	}
 
-	DrawBatches(startVertexLocation);
+	{
+		ProfilerScope profilerScope{ _frameProfiler, ProfilerPhase::DrawBatches };
+		DrawBatches(startVertexLocation);
+	}
 
-	_skipCountingSleep = true;
-	_renderContext->Present();
-	_skipCountingSleep = false;
+	{
+		ProfilerScope profilerScope{ _frameProfiler, ProfilerPhase::Present };
+		_skipCountingSleep = true;
+		_renderContext->Present();
+		_skipCountingSleep = false;
+	}
 
 	++_frame;
 
+	_frameProfiler.EndFrame((uint32_t)_frame, _batchCount, _vertexCount);
+
 	if (!(_frame & 255))
 	{
 		_textureHasher.PrintStats();
@@ -560,6 +626,8 @@ void D2DXContext::OnDrawPoint(
 	const void* pt,
 	uint32_t gameContext)
 {
+	ProfilerScope profilerScope{ _frameProfiler, ProfilerPhase::Draw };
+
 	Batch batch = _scratchBatch;
 	batch.SetGameAddress(GameAddress::Unknown);
 	batch.SetStartVertex(_vertexCount);
@@ -585,16 +653,19 @@ void D2DXContext::OnDrawPoint(
 	vertex1.AddOffset(1, 0);
 	vertex2.AddOffset(1, 1);
 
-	assert((_vertexCount + 3) < _vertices.capacity);
+	/* Batches are drawn as quads, so the triangle becomes a degenerate quad. */
+	assert((_vertexCount + 4) < _vertices.capacity);
 	_vertices.items[_vertexCount++] = vertex0;
 	_vertices.items[_vertexCount++] = vertex1;
 	_vertices.items[_vertexCount++] = vertex2;
+	_vertices.items[_vertexCount++] = vertex2;
 
-	batch.SetVertexCount(3);
+	batch.SetVertexCount(4);
 
-	_surfaceIdTracker.UpdateBatchSurfaceId(batch, _majorGameState, _gameSize, &_vertices.items[batch.GetStartVertex()], batch.GetVertexCount());
+	const Rect batchRect = _surfaceIdTracker.UpdateBatchSurfaceId(batch, _majorGameState, _gameSize, &_vertices.items[batch.GetStartVertex()], batch.GetVertexCount());
 
 	assert(_batchCount < _batches.capacity);
+	_batchRects.items[_batchCount] = batchRect;
 	_batches.items[_batchCount++] = batch;
 }
 
@@ -604,6 +675,8 @@ void D2DXContext::OnDrawLine(
 	const void* v2,
 	uint32_t gameContext)
 {
+	ProfilerScope profilerScope{ _frameProfiler, ProfilerPhase::Draw };
+
 	Batch batch = _scratchBatch;
 	batch.SetGameAddress(GameAddress::DrawLine);
 	batch.SetStartVertex(_vertexCount);
@@ -688,25 +761,20 @@ void D2DXContext::OnDrawLine(
 		vertex3.SetColor(c);
 		vertex4.SetColor(c);
 
-		assert((_vertexCount + 3 * 4) < _vertices.capacity);
+		/* A fan of four triangles around the midpoint, as two quads. */
+		assert((_vertexCount + 2 * 4) < _vertices.capacity);
 
 		_vertices.items[_vertexCount++] = vertex0;
 		_vertices.items[_vertexCount++] = vertex1;
 		_vertices.items[_vertexCount++] = vertex2;
-
-		_vertices.items[_vertexCount++] = vertex0;
-		_vertices.items[_vertexCount++] = vertex2;
 		_vertices.items[_vertexCount++] = vertex3;
 
 		_vertices.items[_vertexCount++] = vertex0;
 		_vertices.items[_vertexCount++] = vertex3;
 		_vertices.items[_vertexCount++] = vertex4;
-
-		_vertices.items[_vertexCount++] = vertex0;
-		_vertices.items[_vertexCount++] = vertex4;
 		_vertices.items[_vertexCount++] = vertex1;
 
-		batch.SetVertexCount(3 * 4);
+		batch.SetVertexCount(2 * 4);
 
 		_lastWeatherParticleIndex = currentWeatherParticleIndex;
 	}
@@ -737,18 +805,18 @@ void D2DXContext::OnDrawLine(
 			(int32_t)(d2Vertex1->x + wideningVec.x),
 			(int32_t)(d2Vertex1->y + wideningVec.y));
 
-		assert((_vertexCount + 6) < _vertices.capacity);
-		_vertices.items[_vertexCount++] = vertex0;
-		_vertices.items[_vertexCount++] = vertex1;
-		_vertices.items[_vertexCount++] = vertex2;
+		/* Triangles (0, 1, 2) and (1, 2, 3), as a quad starting at vertex 1. */
+		assert((_vertexCount + 4) < _vertices.capacity);
 		_vertices.items[_vertexCount++] = vertex1;
+		_vertices.items[_vertexCount++] = vertex0;
 		_vertices.items[_vertexCount++] = vertex2;
 		_vertices.items[_vertexCount++] = vertex3;
 
-		batch.SetVertexCount(6);
+		batch.SetVertexCount(4);
 	}
 
 	assert(_batchCount < _batches.capacity);
+	_batchRects.items[_batchCount] = SurfaceIdTracker::GetBounds(&_vertices.items[batch.GetStartVertex()], (int32_t)batch.GetVertexCount());
 	_batches.items[_batchCount++] = batch;
 }
 
@@ -757,11 +825,28 @@ const Batch D2DXContext::PrepareBatchForSubmit(
 	Batch batch,
 	PrimitiveType primitiveType,
 	uint32_t vertexCount,
-	uint32_t gameContext) const
+	uint32_t gameContext)
 {
+	if (_batchCount >= _batches.capacity ||
+		(_vertexCount + vertexCount) > _vertices.capacity)
+	{
+		D2DX_DEBUG_LOG("Frame exceeds %u batches or %u vertices, dropping draw call.", _batches.capacity, _vertices.capacity);
+		return Batch();
+	}
+
 	auto gameAddress = _gameHelper->IdentifyGameAddress(gameContext);
 
-	auto tcl = _renderContext->UpdateTexture(batch, _glideState.tmuMemory.items, _glideState.tmuMemory.capacity);
+	/* Refine the category first, the texture cache partitions on it. */
+	batch.SetTextureCategory(_gameHelper->RefineTextureCategoryFromGameAddress(batch.GetTextureCategory(), gameAddress));
+
+	TextureCacheMemo& textureCacheMemo = _textureCacheMemos.items[batch.GetTextureStartAddress() >> 8];
+	const TextureCacheLocation lastLocation = textureCacheMemo.contentKey == batch.GetContentKey() ?
+		textureCacheMemo.location : TextureCacheLocation{ -1, -1 };
+
+	auto tcl = _renderContext->UpdateTexture(batch, _glideState.tmuMemory.items, _glideState.tmuMemory.capacity, lastLocation);
+
+	textureCacheMemo.contentKey = batch.GetContentKey();
+	textureCacheMemo.location = tcl;
 
 	if (tcl._textureAtlas < 0)
 	{
@@ -774,7 +859,6 @@ const Batch D2DXContext::PrepareBatchForSubmit(
 	batch.SetGameAddress(gameAddress);
 	batch.SetStartVertex(_vertexCount);
 	batch.SetVertexCount(vertexCount);
-	batch.SetTextureCategory(_gameHelper->RefineTextureCategoryFromGameAddress(batch.GetTextureCategory(), gameAddress));
 	return batch;
 }
 
@@ -804,6 +888,19 @@ void D2DXContext::EnsureReadVertexStateUpdated(
 	_readVertexState.isDirty = false;
 }
 
+_Use_decl_annotations_
+Vertex D2DXContext::ReadVertex(
+	const uint8_t* d2VertexBytes) const
+{
+	const D2::Vertex* d2Vertex = (const D2::Vertex*)d2VertexBytes;
+
+	Vertex v = _readVertexState.templateVertex;
+	v.SetPosition((int32_t)d2Vertex->x, (int32_t)d2Vertex->y);
+	v.SetTexcoord((int32_t)d2Vertex->s >> _glideState.stShift, (int32_t)d2Vertex->t >> _glideState.stShift);
+	v.SetColor(_readVertexState.maskedConstantColor | (d2Vertex->color & _readVertexState.iteratedColorMask));
+	return v;
+}
+
 _Use_decl_annotations_
 void D2DXContext::OnDrawVertexArray(
 	uint32_t mode,
@@ -811,6 +908,8 @@ void D2DXContext::OnDrawVertexArray(
 	uint8_t** pointers,
 	uint32_t gameContext)
 {
+	ProfilerScope profilerScope{ _frameProfiler, ProfilerPhase::Draw };
+
 	assert(mode == GR_TRIANGLE_STRIP || mode == GR_TRIANGLE_FAN);
 
 	if (count < 3 || (mode != GR_TRIANGLE_STRIP && mode != GR_TRIANGLE_FAN))
@@ -818,7 +917,10 @@ void D2DXContext::OnDrawVertexArray(
 		return;
 	}
 
-	Batch batch = PrepareBatchForSubmit(_scratchBatch, PrimitiveType::Triangles, 3 * (count - 2), gameContext);
+	/* Each pair of triangles becomes a quad; an odd last triangle becomes a degenerate quad. */
+	const uint32_t quadCount = (count - 1) / 2;
+
+	Batch batch = PrepareBatchForSubmit(_scratchBatch, PrimitiveType::Triangles, 4 * quadCount, gameContext);
 
 	if (!batch.IsValid())
 	{
@@ -827,56 +929,39 @@ void D2DXContext::OnDrawVertexArray(
 
 	EnsureReadVertexStateUpdated(batch);
 
-	Vertex v = _readVertexState.templateVertex;
-
-	const uint32_t iteratedColorMask = _readVertexState.iteratedColorMask;
-	const uint32_t maskedConstantColor = _readVertexState.maskedConstantColor;
-
 	Vertex* pVertices = &_vertices.items[_vertexCount];
 
-	for (int32_t i = 0; i < 3; ++i)
-	{
-		const D2::Vertex* d2Vertex = (const D2::Vertex*)pointers[i];
-		v.SetPosition((int32_t)d2Vertex->x, (int32_t)d2Vertex->y);
-		v.SetTexcoord((int32_t)d2Vertex->s >> _glideState.stShift, (int32_t)d2Vertex->t >> _glideState.stShift);
-		v.SetColor(maskedConstantColor | (d2Vertex->color & iteratedColorMask));
-		*pVertices++ = v;
-	}
-
 	if (mode == GR_TRIANGLE_FAN)
 	{
-		auto vertex0 = pVertices[-3];
+		/* Triangles (0, i, i + 1) and (0, i + 1, i + 2). */
+		const Vertex vertex0 = ReadVertex(pointers[0]);
 
-		for (uint32_t i = 0; i < (count - 3); ++i)
+		for (uint32_t i = 1; i < (count - 1); i += 2)
 		{
 			*pVertices++ = vertex0;
-			*pVertices++ = pVertices[-2];
-			const D2::Vertex* d2Vertex = (const D2::Vertex*)pointers[i + 3];
-			v.SetPosition((int32_t)d2Vertex->x, (int32_t)d2Vertex->y);
-			v.SetTexcoord((int32_t)d2Vertex->s >> _glideState.stShift, (int32_t)d2Vertex->t >> _glideState.stShift);
-			v.SetColor(maskedConstantColor | (d2Vertex->color & iteratedColorMask));
-			*pVertices++ = v;
+			*pVertices++ = ReadVertex(pointers[i]);
+			*pVertices++ = ReadVertex(pointers[i + 1]);
+			*pVertices++ = ReadVertex(pointers[min(i + 2, count - 1)]);
 		}
 	}
 	else
 	{
-		for (uint32_t i = 0; i < (count - 3); ++i)
+		/* Triangles (i, i + 1, i + 2) and (i + 1, i + 2, i + 3), as a quad starting at vertex i + 1. */
+		for (uint32_t i = 0; (i + 2) < count; i += 2)
 		{
-			*pVertices++ = pVertices[-2];
-			*pVertices++ = pVertices[-2];
-			const D2::Vertex* d2Vertex = (const D2::Vertex*)pointers[i + 3];
-			v.SetPosition((int32_t)d2Vertex->x, (int32_t)d2Vertex->y);
-			v.SetTexcoord((int32_t)d2Vertex->s >> _glideState.stShift, (int32_t)d2Vertex->t >> _glideState.stShift);
-			v.SetColor(maskedConstantColor | (d2Vertex->color & iteratedColorMask));
-			*pVertices++ = v;
+			*pVertices++ = ReadVertex(pointers[i + 1]);
+			*pVertices++ = ReadVertex(pointers[i]);
+			*pVertices++ = ReadVertex(pointers[i + 2]);
+			*pVertices++ = ReadVertex(pointers[min(i + 3, count - 1)]);
 		}
 	}
 
-	_vertexCount += 3 * (count - 2);
+	_vertexCount += 4 * quadCount;
 
-	_surfaceIdTracker.UpdateBatchSurfaceId(batch, _majorGameState, _gameSize, &_vertices.items[batch.GetStartVertex()], batch.GetVertexCount());
+	const Rect batchRect = _surfaceIdTracker.UpdateBatchSurfaceId(batch, _majorGameState, _gameSize, &_vertices.items[batch.GetStartVertex()], batch.GetVertexCount());
 
 	assert(_batchCount < _batches.capacity);
+	_batchRects.items[_batchCount] = batchRect;
 	_batches.items[_batchCount++] = batch;
 }
 
@@ -888,6 +973,8 @@ void D2DXContext::OnDrawVertexArrayContiguous(
 	uint32_t stride,
 	uint32_t gameContext)
 {
+	ProfilerScope profilerScope{ _frameProfiler, ProfilerPhase::Draw };
+
 	assert(count == 4);
 	assert(mode == GR_TRIANGLE_FAN);
 	assert(stride == sizeof(D2::Vertex));
@@ -897,7 +984,7 @@ void D2DXContext::OnDrawVertexArrayContiguous(
 		return;
 	}
 
-	Batch batch = PrepareBatchForSubmit(_scratchBatch, PrimitiveType::Triangles, 6, gameContext);
+	Batch batch = PrepareBatchForSubmit(_scratchBatch, PrimitiveType::Triangles, 4, gameContext);
 
 	if (!batch.IsValid())
 	{
@@ -923,14 +1010,12 @@ void D2DXContext::OnDrawVertexArrayContiguous(
 		pVertices[i] = v;
 	}
 
-	pVertices[4] = pVertices[0];
-	pVertices[5] = pVertices[2];
-
-	_vertexCount += 6;
+	_vertexCount += 4;
 
-	_surfaceIdTracker.UpdateBatchSurfaceId(batch, _majorGameState, _gameSize, &_vertices.items[batch.GetStartVertex()], batch.GetVertexCount());
+	const Rect batchRect = _surfaceIdTracker.UpdateBatchSurfaceId(batch, _majorGameState, _gameSize, &_vertices.items[batch.GetStartVertex()], batch.GetVertexCount());
 
 	assert(_batchCount < _batches.capacity);
+	_batchRects.items[_batchCount] = batchRect;
 	_batches.items[_batchCount++] = batch;
 }
 
@@ -939,6 +1024,8 @@ void D2DXContext::OnTexDownloadTable(
 	GrTexTable_t type,
 	void* data)
 {
+	ProfilerScope profilerScope{ _frameProfiler, ProfilerPhase::TexDownloadTable };
+
 	if (type != GR_TEXTABLE_PALETTE)
 	{
 		assert(false && "Unhandled table type.");
@@ -947,8 +1034,7 @@ void D2DXContext::OnTexDownloadTable(
 
 	_readVertexState.isDirty = true;
 
-	uint32_t hash = fnv_32a_buf(data, 1024, FNV1_32A_INIT);
-	assert(hash != 0);
+	const uint64_t hash = _simd->HashBytes64((const uint8_t*)data, 1024);
 
 	for (uint32_t i = 0; i < D2DX_MAX_GAME_PALETTES; ++i)
 	{
@@ -984,6 +1070,14 @@ void D2DXContext::OnTexDownloadTable(
 			}
 
 			_renderContext->SetPalette(i, palette);
+
+			if (_traceEventWriter)
+			{
+				const int64_t ticks = TraceEventWriter::GetTicks();
+				auto& traceEvent = _traceEventWriter->AddEvent(TraceEventType::Instant, "PaletteUpload", "palette", ticks, ticks);
+				TraceEventWriter::AddArg(traceEvent, "paletteIndex", i);
+			}
+
 			return;
 		}
 	}
@@ -1021,6 +1115,8 @@ void D2DXContext::OnLfbUnlock(
 	const uint32_t* lfbPtr,
 	uint32_t strideInBytes)
 {
+	ProfilerScope profilerScope{ _frameProfiler, ProfilerPhase::LfbUnlock };
+
 	bool forCinematic = !(_majorGameState == MajorGameState::Unknown || _majorGameState == MajorGameState::FmvIntro);
 	_renderContext->WriteToScreen(lfbPtr, 640, 480, forCinematic);
 }
@@ -1068,11 +1164,13 @@ void D2DXContext::PrepareLogoTextureBatch()
 	_renderContext->SetPalette(D2DX_LOGO_PALETTE_INDEX, palette.items);
 
 	uint32_t hash = fnv_32a_buf((void*)srcPixels, sizeof(uint8_t) * 81 * 40, FNV1_32A_INIT);
+	const uint64_t contentKey = _simd->HashBytes64(srcPixels, sizeof(uint8_t) * 81 * 40);
 
 	uint8_t* data = _glideState.sideTmuMemory.items;
 
 	_logoTextureBatch.SetTextureStartAddress(0);
 	_logoTextureBatch.SetTextureHash(hash);
+	_logoTextureBatch.SetContentKey(contentKey);
 	_logoTextureBatch.SetTextureSize(128, 128);
 	_logoTextureBatch.SetTextureCategory(TextureCategory::TitleScreen);
 	_logoTextureBatch.SetAlphaBlend(AlphaBlend::SrcAlphaInvSrcAlpha);
@@ -1080,7 +1178,7 @@ void D2DXContext::PrepareLogoTextureBatch()
 	_logoTextureBatch.SetRgbCombine(RgbCombine::ColorMultipliedByTexture);
 	_logoTextureBatch.SetAlphaCombine(AlphaCombine::One);
 	_logoTextureBatch.SetPaletteIndex(D2DX_LOGO_PALETTE_INDEX);
-	_logoTextureBatch.SetVertexCount(6);
+	_logoTextureBatch.SetVertexCount(4);
 
 	memset(data, 0, _logoTextureBatch.GetTextureWidth() * _logoTextureBatch.GetTextureHeight());
 
@@ -1100,7 +1198,7 @@ void D2DXContext::InsertLogoOnTitleScreen()
 
 	PrepareLogoTextureBatch();
 
-	auto tcl = _renderContext->UpdateTexture(_logoTextureBatch, _glideState.sideTmuMemory.items, _glideState.sideTmuMemory.capacity);
+	auto tcl = _renderContext->UpdateTexture(_logoTextureBatch, _glideState.sideTmuMemory.items, _glideState.sideTmuMemory.capacity, { -1, -1 });
 
 	_logoTextureBatch.SetTextureAtlas(tcl._textureAtlas);
 	_logoTextureBatch.SetTextureIndex(tcl._textureIndex);
@@ -1118,14 +1216,13 @@ void D2DXContext::InsertLogoOnTitleScreen()
 	Vertex vertex2(x + 80, y + 41, 80, 41, color, true, _logoTextureBatch.GetTextureIndex(), D2DX_LOGO_PALETTE_INDEX, D2DX_SURFACE_ID_USER_INTERFACE);
 	Vertex vertex3(x, y + 41, 0, 41, color, true, _logoTextureBatch.GetTextureIndex(), D2DX_LOGO_PALETTE_INDEX, D2DX_SURFACE_ID_USER_INTERFACE);
 
-	assert((_vertexCount + 6) < _vertices.capacity);
+	assert((_vertexCount + 4) < _vertices.capacity);
 	_vertices.items[_vertexCount++] = vertex0;
 	_vertices.items[_vertexCount++] = vertex1;
 	_vertices.items[_vertexCount++] = vertex2;
-	_vertices.items[_vertexCount++] = vertex0;
-	_vertices.items[_vertexCount++] = vertex2;
 	_vertices.items[_vertexCount++] = vertex3;
 
+	_batchRects.items[_batchCount] = SurfaceIdTracker::GetBounds(&_vertices.items[_logoTextureBatch.GetStartVertex()], 4);
 	_batches.items[_batchCount++] = _logoTextureBatch;
 }
 
@@ -1258,6 +1355,63 @@ const Options& D2DXContext::GetOptions() const
 	return _options;
 }
 
+const std::shared_ptr<IGameHelper>& D2DXContext::GetGameHelper() const
+{
+	return _gameHelper;
+}
+
+void D2DXContext::LogFrameTimeStatistics()
+{
+	static const char* majorGameStateNames[(int32_t)MajorGameState::Count] =
+	{
+		"Unknown", "FmvIntro", "Menus", "InGame", "TitleScreen"
+	};
+
+	if (!_renderContext)
+	{
+		return;
+	}
+
+	for (int32_t i = 0; i < (int32_t)MajorGameState::Count; ++i)
+	{
+		FrameTimeStatistics statistics;
+		_renderContext->GetFrameTimeStatistics((MajorGameState)i, &statistics);
+
+		if (statistics.frameCount > 0)
+		{
+			D2DX_LOG("Frame times (%s): %u frames, p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms, %u over %.2f ms budget.",
+				majorGameStateNames[i],
+				statistics.frameCount,
+				statistics.p50Ms,
+				statistics.p95Ms,
+				statistics.p99Ms,
+				statistics.maxMs,
+				statistics.framesOverBudget,
+				statistics.budgetMs);
+		}
+	}
+}
+
+_Use_decl_annotations_
+void D2DXContext::SetFrameDigest(
+	FrameDigest* frameDigest)
+{
+	_frameDigest = frameDigest;
+}
+
+MajorGameState D2DXContext::GetMajorGameState() const
+{
+	return _majorGameState;
+}
+
+void D2DXContext::DumpFrameProfile()
+{
+	if (_options.GetFlag(OptionsFlag::DbgProfileFrames))
+	{
+		_frameProfiler.Dump("d2dx_frameprofile.csv");
+	}
+}
+
 void D2DXContext::OnBufferClear()
 {
 	if (_majorGameState == MajorGameState::InGame)
@@ -19,6 +19,7 @@
 #pragma once
 
 #include "Batch.h"
+#include "BatchReorderer.h"
 #include "Buffer.h"
 #include "IBuiltinResMod.h"
 #include "ID2DXContext.h"
@@ -27,6 +28,9 @@
 #include "IRenderContext.h"
 #include "IWin32InterceptionHandler.h"
 #include "CompatibilityModeDisabler.h"
+#include "FrameDigest.h"
+#include "FrameProfiler.h"
+#include "TraceEventWriter.h"
 #include "SurfaceIdTracker.h"
 #include "TextureHasher.h"
 #include "TextMotionPredictor.h"
@@ -45,10 +49,15 @@ namespace d2dx
 		D2DXContext(
 			_In_ const std::shared_ptr<IGameHelper>& gameHelper,
 			_In_ const std::shared_ptr<ISimd>& simd,
-			_In_ const std::shared_ptr<CompatibilityModeDisabler>& compatibilityModeDisabler);
+			_In_ const std::shared_ptr<CompatibilityModeDisabler>& compatibilityModeDisabler,
+			_In_opt_ const std::shared_ptr<IRenderContext>& renderContext = nullptr);
 		
 		virtual ~D2DXContext() noexcept;
 
+		/* For headless runs: digest the batches and vertices submitted each frame. */
+		void SetFrameDigest(
+			_In_opt_ FrameDigest* frameDigest);
+
 #pragma region IGlide3x
 
 		virtual const char* OnGetString(
@@ -167,9 +176,15 @@ namespace d2dx
 
 		virtual const Options& GetOptions() const override;
 
+		virtual const std::shared_ptr<IGameHelper>& GetGameHelper() const override;
+
 		virtual bool IsFeatureEnabled(
 			_In_ Feature feature) override;
 
+		virtual MajorGameState GetMajorGameState() const override;
+
+		virtual void DumpFrameProfile() override;
+
 #pragma endregion ID2DXContext
 
 #pragma region IWin32InterceptionHandler
@@ -208,10 +223,14 @@ namespace d2dx
 	private:		
 		void CheckMajorGameState();
 
+		void LogFrameTimeStatistics();
+
 		void PrepareLogoTextureBatch();
 
 		void InsertLogoOnTitleScreen();
 
+		void ReorderBatches();
+
 		void DrawBatches(
 			_In_ uint32_t startVertexLocation);
 
@@ -219,11 +238,15 @@ namespace d2dx
 			_In_ Batch batch,
 			_In_ PrimitiveType primitiveType,
 			_In_ uint32_t vertexCount,
-			_In_ uint32_t gameContext) const;
+			_In_ uint32_t gameContext);
 		
 		void EnsureReadVertexStateUpdated(
 			_In_ const Batch& batch);
 
+		/* Converts a game vertex using the state set up by EnsureReadVertexStateUpdated. */
+		Vertex ReadVertex(
+			_In_ const uint8_t* d2VertexBytes) const;
+
 		struct GlideState
 		{
 			Buffer<uint8_t> tmuMemory{ D2DX_TMU_MEMORY_SIZE };
@@ -259,17 +282,39 @@ namespace d2dx
 		TextMotionPredictor _textMotionPredictor;
 		WeatherMotionPredictor _weatherMotionPredictor;
 		SurfaceIdTracker _surfaceIdTracker;
+		FrameProfiler _frameProfiler;
+		FrameDigest* _frameDigest = nullptr;
+		std::unique_ptr<TraceEventWriter> _traceEventWriter;
 
 		MajorGameState _majorGameState;
 
-		Buffer<uint32_t> _paletteKeys;
+		Buffer<uint64_t> _paletteKeys;
+
+		/* The texture last drawn from each 256-byte slot of TMU memory, and where it was in the texture
+		   cache, so that drawing it again skips the cache search. */
+		struct TextureCacheMemo final
+		{
+			uint64_t contentKey;
+			TextureCacheLocation location;
+		};
+
+		Buffer<TextureCacheMemo> _textureCacheMemos;
 
 		uint32_t _batchCount;
 		Buffer<Batch> _batches;
+		Buffer<Rect> _batchRects;
 
 		uint32_t _vertexCount;
 		Buffer<Vertex> _vertices;
 
+		/* The batches of the frame merged into draw calls by ReorderBatches, with their vertices. */
+		BatchReorderer _batchReorderer;
+		Buffer<BatchDrawState> _batchDrawStates;
+		uint32_t _drawBatchCount;
+		Buffer<Batch> _drawBatches;
+		uint32_t _drawVertexCount;
+		Buffer<Vertex> _drawVertices;
+
 		Options _options;
 		Batch _logoTextureBatch;
 		
@@ -19,7 +19,7 @@
 #include "pch.h"
 #include "D2DXContextFactory.h"
 #include "GameHelper.h"
-#include "SimdSse2.h"
+#include "SimdFactory.h"
 #include "D2DXContext.h"
 #include "CompatibilityModeDisabler.h"
 
@@ -36,7 +36,7 @@ ID2DXContext* D2DXContextFactory::GetInstance(
 	if (!instance && !destroyed && createIfNeeded)
 	{
 		auto gameHelper = std::make_shared<GameHelper>();
-		auto simd = std::make_shared<SimdSse2>();
+		auto simd = SimdFactory::CreateBest();
 		auto compatibilityModeDisabler = std::make_shared<CompatibilityModeDisabler>();
 		instance = std::make_shared<D2DXContext>(gameHelper, simd, compatibilityModeDisabler);
 	}
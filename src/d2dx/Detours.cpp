@@ -30,6 +30,7 @@ using namespace d2dx;
 static bool hasDetoured = false;
 static bool hasDetachedDetours = false;
 static bool hasLateDetoured = false;
+static bool hasAttachedLateDetours = false;
 static bool hasDetachedLateDetours = false;
 
 D2::UnitAny* currentlyDrawingUnit = nullptr;
@@ -814,11 +815,13 @@ void d2dx::AttachLateDetours(
 		D2DX_LOG("Failed to detour D2Gfx functions: %i.", lError);
 		D2DX_FATAL_ERROR("Failed to detour D2Gfx functions");
 	}
+
+	hasAttachedLateDetours = true;
 }
 
 void d2dx::DetachLateDetours()
 {
-	if (!hasLateDetoured || hasDetachedLateDetours)
+	if (!hasAttachedLateDetours || hasDetachedLateDetours)
 	{
 		return;
 	}
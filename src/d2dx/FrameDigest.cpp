@@ -0,0 +1,208 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "FrameDigest.h"
+#include "Utils.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+void FrameDigest::AddFrame(
+	const Batch* batches,
+	uint32_t batchCount,
+	const Vertex* vertices,
+	uint32_t vertexCount)
+{
+	FrameDigestEntry entry;
+	entry.frame = (uint32_t)_frames.size();
+	entry.vertexCount = vertexCount;
+	entry.batchDigests.resize(batchCount);
+
+	uint32_t digest = fnv_32a_buf(&vertexCount, sizeof(vertexCount), FNV1_32A_INIT);
+
+	for (uint32_t i = 0; i < batchCount; ++i)
+	{
+		const Batch& batch = batches[i];
+		uint32_t batchDigest = fnv_32a_buf((void*)&batch, sizeof(Batch), FNV1_32A_INIT);
+
+		const uint32_t startVertex = batch.GetStartVertex();
+		const uint32_t batchVertexCount = batch.GetVertexCount();
+
+		if (startVertex + batchVertexCount <= vertexCount)
+		{
+			batchDigest = fnv_32a_buf((void*)(vertices + startVertex), sizeof(Vertex) * batchVertexCount, batchDigest);
+		}
+
+		entry.batchDigests[i] = batchDigest;
+		digest = fnv_32a_buf(&batchDigest, sizeof(batchDigest), digest);
+	}
+
+	entry.digest = digest;
+	_frames.push_back(std::move(entry));
+}
+
+uint32_t FrameDigest::GetFrameCount() const
+{
+	return (uint32_t)_frames.size();
+}
+
+_Use_decl_annotations_
+const FrameDigestEntry& FrameDigest::GetFrame(
+	uint32_t index) const
+{
+	assert(index < _frames.size());
+	return _frames[index];
+}
+
+_Use_decl_annotations_
+bool FrameDigest::Save(
+	const char* filename) const
+{
+	FILE* file = nullptr;
+
+	if (fopen_s(&file, filename, "w") != 0)
+	{
+		D2DX_LOG("Failed to open %s for writing.", filename);
+		return false;
+	}
+
+	fprintf(file, "d2dxdigest 1\n");
+
+	for (const auto& entry : _frames)
+	{
+		fprintf(file, "%u %08x %u %u", entry.frame, entry.digest, entry.vertexCount, (uint32_t)entry.batchDigests.size());
+
+		for (uint32_t batchDigest : entry.batchDigests)
+		{
+			fprintf(file, " %08x", batchDigest);
+		}
+
+		fprintf(file, "\n");
+	}
+
+	fclose(file);
+	return true;
+}
+
+_Use_decl_annotations_
+bool FrameDigest::Load(
+	const char* filename)
+{
+	FILE* file = nullptr;
+
+	if (fopen_s(&file, filename, "r") != 0)
+	{
+		D2DX_LOG("Failed to open %s for reading.", filename);
+		return false;
+	}
+
+	_frames.clear();
+
+	uint32_t version = 0;
+	bool succeeded = fscanf_s(file, "d2dxdigest %u", &version) == 1 && version == 1;
+
+	while (succeeded)
+	{
+		FrameDigestEntry entry;
+		uint32_t batchCount = 0;
+
+		const int result = fscanf_s(file, "%u %x %u %u", &entry.frame, &entry.digest, &entry.vertexCount, &batchCount);
+
+		if (result == EOF)
+		{
+			break;
+		}
+
+		if (result != 4 || batchCount > D2DX_MAX_BATCHES_PER_FRAME)
+		{
+			succeeded = false;
+			break;
+		}
+
+		entry.batchDigests.resize(batchCount);
+
+		for (uint32_t i = 0; i < batchCount && succeeded; ++i)
+		{
+			succeeded = fscanf_s(file, "%x", &entry.batchDigests[i]) == 1;
+		}
+
+		_frames.push_back(std::move(entry));
+	}
+
+	fclose(file);
+
+	if (!succeeded)
+	{
+		D2DX_LOG("Failed to parse %s.", filename);
+		_frames.clear();
+	}
+
+	return succeeded;
+}
+
+_Use_decl_annotations_
+bool FrameDigest::Compare(
+	const FrameDigest& expected,
+	const FrameDigest& actual,
+	FrameDigestMismatch* mismatch)
+{
+	assert(mismatch);
+
+	const uint32_t frameCount = (uint32_t)min(expected._frames.size(), actual._frames.size());
+
+	for (uint32_t i = 0; i < frameCount; ++i)
+	{
+		const auto& expectedFrame = expected._frames[i];
+		const auto& actualFrame = actual._frames[i];
+
+		if (expectedFrame.digest == actualFrame.digest)
+		{
+			continue;
+		}
+
+		*mismatch = { i, -1, expectedFrame.digest, actualFrame.digest };
+
+		const uint32_t batchCount = (uint32_t)min(expectedFrame.batchDigests.size(), actualFrame.batchDigests.size());
+
+		for (uint32_t j = 0; j < batchCount; ++j)
+		{
+			if (expectedFrame.batchDigests[j] != actualFrame.batchDigests[j])
+			{
+				*mismatch = { i, (int32_t)j, expectedFrame.batchDigests[j], actualFrame.batchDigests[j] };
+				return false;
+			}
+		}
+
+		/* One frame has extra batches; the first of them is the first difference. */
+		if (expectedFrame.batchDigests.size() != actualFrame.batchDigests.size())
+		{
+			mismatch->batchIndex = (int32_t)batchCount;
+		}
+
+		return false;
+	}
+
+	if (expected._frames.size() != actual._frames.size())
+	{
+		*mismatch = { frameCount, -1, (uint32_t)expected._frames.size(), (uint32_t)actual._frames.size() };
+		return false;
+	}
+
+	return true;
+}
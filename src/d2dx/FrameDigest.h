@@ -0,0 +1,86 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Batch.h"
+#include "Vertex.h"
+
+#include <vector>
+
+namespace d2dx
+{
+	struct FrameDigestEntry final
+	{
+		uint32_t frame = 0;
+		uint32_t digest = 0;
+		uint32_t vertexCount = 0;
+		std::vector<uint32_t> batchDigests;
+	};
+
+	struct FrameDigestMismatch final
+	{
+		uint32_t frame;
+
+		/* Index of the first differing batch, or -1 if only the vertex count or frame count differs. */
+		int32_t batchIndex;
+
+		/* The differing digests, or the frame counts if the runs have different lengths. */
+		uint32_t expected;
+		uint32_t actual;
+	};
+
+	/*
+		Records a digest of the batches and vertices that D2DXContext draws each frame, in draw
+		order (including the texture cache locations and surface ids assigned to them), for bit-exact
+		regression checks of headless runs against a golden file. Each batch is digested together
+		with its vertices, so that a mismatch can be traced to the first batch that differs.
+	*/
+	class FrameDigest final
+	{
+	public:
+		FrameDigest() {}
+		~FrameDigest() noexcept {}
+
+		void AddFrame(
+			_In_reads_(batchCount) const Batch* batches,
+			_In_ uint32_t batchCount,
+			_In_reads_(vertexCount) const Vertex* vertices,
+			_In_ uint32_t vertexCount);
+
+		uint32_t GetFrameCount() const;
+
+		const FrameDigestEntry& GetFrame(
+			_In_ uint32_t index) const;
+
+		bool Save(
+			_In_z_ const char* filename) const;
+
+		bool Load(
+			_In_z_ const char* filename);
+
+		/* Returns true if the digests are identical, otherwise describes the first difference. */
+		static bool Compare(
+			_In_ const FrameDigest& expected,
+			_In_ const FrameDigest& actual,
+			_Out_ FrameDigestMismatch* mismatch);
+
+	private:
+		std::vector<FrameDigestEntry> _frames;
+	};
+}
@@ -0,0 +1,184 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "FrameProfiler.h"
+#include "Utils.h"
+
+using namespace d2dx;
+
+static const char* phaseNames[(int32_t)ProfilerPhase::Count] =
+{
+	"TexDownload",
+	"TexSource",
+	"Draw",
+	"TexDownloadTable",
+	"LfbUnlock",
+	"CheckMajorGameState",
+	"MotionOffset",
+	"ReorderBatches",
+	"BulkWriteVertices",
+	"FlushTextureUploads",
+	"DrawBatches",
+	"Present",
+};
+
+_Use_decl_annotations_
+FrameProfiler::FrameProfiler(
+	uint32_t historySize) :
+	_history{ historySize, true }
+{
+	assert(historySize > 0);
+
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	_msPerTick = 1000.0 / (double)frequency.QuadPart;
+
+	memset(_currentTicks, 0, sizeof(_currentTicks));
+	memset(_currentCallCount, 0, sizeof(_currentCallCount));
+}
+
+_Use_decl_annotations_
+void FrameProfiler::SetEnabled(
+	bool enabled)
+{
+	_isEnabled = enabled;
+	_lastEndFrameTime = 0;
+	memset(_currentTicks, 0, sizeof(_currentTicks));
+	memset(_currentCallCount, 0, sizeof(_currentCallCount));
+}
+
+_Use_decl_annotations_
+void FrameProfiler::SetTraceEventWriter(
+	TraceEventWriter* traceEventWriter)
+{
+	_traceEventWriter = traceEventWriter;
+}
+
+_Use_decl_annotations_
+void FrameProfiler::EndFrame(
+	uint32_t frame,
+	uint32_t batchCount,
+	uint32_t vertexCount)
+{
+	if (!_isEnabled)
+	{
+		return;
+	}
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+
+	FrameProfile& profile = _history.items[_historyNext];
+	profile.frame = frame;
+	profile.batchCount = batchCount;
+	profile.vertexCount = vertexCount;
+	profile.frameMs = _lastEndFrameTime ? (float)((counter.QuadPart - _lastEndFrameTime) * _msPerTick) : 0.0f;
+
+	if (_traceEventWriter)
+	{
+		if (_lastEndFrameTime)
+		{
+			auto& frameEvent = _traceEventWriter->AddEvent(TraceEventType::Complete, "Frame", "frame", _lastEndFrameTime, counter.QuadPart);
+			TraceEventWriter::AddArg(frameEvent, "frame", frame);
+			TraceEventWriter::AddArg(frameEvent, "batches", batchCount);
+			TraceEventWriter::AddArg(frameEvent, "vertices", vertexCount);
+		}
+
+		auto& callbackEvent = _traceEventWriter->AddEvent(TraceEventType::Counter, "Glide callbacks (ms)", "frame", counter.QuadPart, counter.QuadPart);
+
+		for (int32_t i = 0; i < (int32_t)ProfilerPhase::CheckMajorGameState; ++i)
+		{
+			TraceEventWriter::AddArg(callbackEvent, phaseNames[i], _currentTicks[i] * _msPerTick);
+		}
+	}
+
+	for (int32_t i = 0; i < (int32_t)ProfilerPhase::Count; ++i)
+	{
+		profile.phaseMs[i] = (float)(_currentTicks[i] * _msPerTick);
+		profile.callCount[i] = _currentCallCount[i];
+		_currentTicks[i] = 0;
+		_currentCallCount[i] = 0;
+	}
+
+	_historyNext = (_historyNext + 1) % _history.capacity;
+	_historyCount = min(_historyCount + 1, _history.capacity);
+	_lastEndFrameTime = counter.QuadPart;
+}
+
+uint32_t FrameProfiler::GetFrameCount() const
+{
+	return _historyCount;
+}
+
+_Use_decl_annotations_
+const FrameProfile& FrameProfiler::GetFrame(
+	uint32_t index) const
+{
+	assert(index < _historyCount);
+	const uint32_t oldest = (_historyNext + _history.capacity - _historyCount) % _history.capacity;
+	return _history.items[(oldest + index) % _history.capacity];
+}
+
+_Use_decl_annotations_
+void FrameProfiler::Dump(
+	const char* filename) const
+{
+	FILE* file = nullptr;
+
+	if (fopen_s(&file, filename, "w") != 0)
+	{
+		D2DX_LOG("Failed to open %s for writing.", filename);
+		return;
+	}
+
+	fprintf(file, "frame,frameMs,batches,vertices");
+
+	for (int32_t i = 0; i < (int32_t)ProfilerPhase::Count; ++i)
+	{
+		fprintf(file, ",%sMs,%sCalls", phaseNames[i], phaseNames[i]);
+	}
+
+	fprintf(file, "\n");
+
+	for (uint32_t i = 0; i < _historyCount; ++i)
+	{
+		const FrameProfile& profile = GetFrame(i);
+
+		fprintf(file, "%u,%.3f,%u,%u", profile.frame, profile.frameMs, profile.batchCount, profile.vertexCount);
+
+		for (int32_t j = 0; j < (int32_t)ProfilerPhase::Count; ++j)
+		{
+			fprintf(file, ",%.3f,%u", profile.phaseMs[j], profile.callCount[j]);
+		}
+
+		fprintf(file, "\n");
+	}
+
+	fclose(file);
+
+	D2DX_LOG("Wrote %u frame profiles to %s.", _historyCount, filename);
+}
+
+_Use_decl_annotations_
+const char* FrameProfiler::GetPhaseName(
+	ProfilerPhase phase)
+{
+	assert((int32_t)phase >= 0 && phase < ProfilerPhase::Count);
+	return phaseNames[(int32_t)phase];
+}
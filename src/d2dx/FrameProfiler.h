@@ -0,0 +1,163 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+#include "TraceEventWriter.h"
+
+#define D2DX_FRAME_PROFILER_HISTORY_SIZE 1024
+
+namespace d2dx
+{
+	enum class ProfilerPhase
+	{
+		/* Game-thread Glide callbacks, accumulated over the frame. */
+		TexDownload = 0,
+		TexSource = 1,
+		Draw = 2,
+		TexDownloadTable = 3,
+		LfbUnlock = 4,
+
+		/* Phases of OnBufferSwap. */
+		CheckMajorGameState = 5,
+		MotionOffset = 6,
+		ReorderBatches = 7,
+		BulkWriteVertices = 8,
+		FlushTextureUploads = 9,
+		DrawBatches = 10,
+		Present = 11,
+
+		Count = 12
+	};
+
+	struct FrameProfile final
+	{
+		uint32_t frame;
+		uint32_t batchCount;
+		uint32_t vertexCount;
+		float frameMs;
+		float phaseMs[(int32_t)ProfilerPhase::Count];
+		uint32_t callCount[(int32_t)ProfilerPhase::Count];
+	};
+
+	/*
+		Keeps the per-phase CPU time of the most recent frames in a ring buffer. When disabled,
+		a ProfilerScope costs a single branch.
+	*/
+	class FrameProfiler final
+	{
+	public:
+		FrameProfiler(
+			_In_ uint32_t historySize);
+
+		~FrameProfiler() noexcept {}
+
+		inline bool IsEnabled() const
+		{
+			return _isEnabled;
+		}
+
+		void SetEnabled(
+			_In_ bool enabled);
+
+		/* Trace events are written for the OnBufferSwap phases and once per frame. */
+		void SetTraceEventWriter(
+			_In_opt_ TraceEventWriter* traceEventWriter);
+
+		inline void AddTime(
+			_In_ ProfilerPhase phase,
+			_In_ int64_t startTicks,
+			_In_ int64_t endTicks)
+		{
+			_currentTicks[(int32_t)phase] += endTicks - startTicks;
+			++_currentCallCount[(int32_t)phase];
+
+			if (_traceEventWriter && phase >= ProfilerPhase::CheckMajorGameState)
+			{
+				_traceEventWriter->AddComplete(GetPhaseName(phase), "frame", startTicks, endTicks);
+			}
+		}
+
+		void EndFrame(
+			_In_ uint32_t frame,
+			_In_ uint32_t batchCount,
+			_In_ uint32_t vertexCount);
+
+		/* Returns the number of frames in the history. Index 0 is the oldest frame. */
+		uint32_t GetFrameCount() const;
+
+		const FrameProfile& GetFrame(
+			_In_ uint32_t index) const;
+
+		void Dump(
+			_In_z_ const char* filename) const;
+
+		static _Ret_z_ const char* GetPhaseName(
+			_In_ ProfilerPhase phase);
+
+	private:
+		bool _isEnabled = false;
+		TraceEventWriter* _traceEventWriter = nullptr;
+		double _msPerTick = 0.0;
+		int64_t _lastEndFrameTime = 0;
+		int64_t _currentTicks[(int32_t)ProfilerPhase::Count];
+		uint32_t _currentCallCount[(int32_t)ProfilerPhase::Count];
+		Buffer<FrameProfile> _history;
+		uint32_t _historyNext = 0;
+		uint32_t _historyCount = 0;
+	};
+
+	class ProfilerScope final
+	{
+	public:
+		inline ProfilerScope(
+			_In_ FrameProfiler& profiler,
+			_In_ ProfilerPhase phase) :
+			_profiler{ profiler.IsEnabled() ? &profiler : nullptr },
+			_phase{ phase },
+			_startTime{ 0 }
+		{
+			if (_profiler)
+			{
+				LARGE_INTEGER counter;
+				QueryPerformanceCounter(&counter);
+				_startTime = counter.QuadPart;
+			}
+		}
+
+		inline ~ProfilerScope() noexcept
+		{
+			if (_profiler)
+			{
+				LARGE_INTEGER counter;
+				QueryPerformanceCounter(&counter);
+				_profiler->AddTime(_phase, _startTime, counter.QuadPart);
+			}
+		}
+
+		ProfilerScope(const ProfilerScope&) = delete;
+
+		ProfilerScope& operator=(const ProfilerScope&) = delete;
+
+	private:
+		FrameProfiler* _profiler;
+		ProfilerPhase _phase;
+		int64_t _startTime;
+	};
+}
@@ -0,0 +1,94 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "FrameTimeHistogram.h"
+
+using namespace d2dx;
+
+FrameTimeHistogram::FrameTimeHistogram()
+{
+	Reset();
+}
+
+void FrameTimeHistogram::Reset()
+{
+	_frameCount = 0;
+	_framesOverBudget = 0;
+	_maxMs = 0.0f;
+	memset(_buckets, 0, sizeof(_buckets));
+}
+
+_Use_decl_annotations_
+void FrameTimeHistogram::SetBudget(
+	float budgetMs)
+{
+	assert(budgetMs > 0.0f);
+	_budgetMs = budgetMs;
+}
+
+_Use_decl_annotations_
+float FrameTimeHistogram::GetPercentile(
+	float percentile) const
+{
+	if (_frameCount == 0)
+	{
+		return 0.0f;
+	}
+
+	percentile = max(0.0f, min(100.0f, percentile));
+
+	/* Nearest-rank: the smallest sample that at least 'percentile' percent of samples are <= to. */
+	uint32_t rank = (uint32_t)ceil(percentile * 0.01 * _frameCount);
+	rank = max(1U, rank);
+
+	uint32_t cumulativeCount = 0;
+
+	for (uint32_t i = 0; i < D2DX_FRAME_TIME_HISTOGRAM_BUCKET_COUNT; ++i)
+	{
+		cumulativeCount += _buckets[i];
+
+		if (cumulativeCount >= rank)
+		{
+			if (i == D2DX_FRAME_TIME_HISTOGRAM_BUCKET_COUNT - 1)
+			{
+				break;
+			}
+
+			const float bucketUpperMs = (float)(i + 1) / D2DX_FRAME_TIME_HISTOGRAM_BUCKETS_PER_MS;
+			return min(bucketUpperMs, _maxMs);
+		}
+	}
+
+	return _maxMs;
+}
+
+_Use_decl_annotations_
+void FrameTimeHistogram::GetStatistics(
+	FrameTimeStatistics* statistics) const
+{
+	assert(statistics);
+
+	statistics->frameCount = _frameCount;
+	statistics->framesOverBudget = _framesOverBudget;
+	statistics->budgetMs = _budgetMs;
+	statistics->p50Ms = GetPercentile(50.0f);
+	statistics->p95Ms = GetPercentile(95.0f);
+	statistics->p99Ms = GetPercentile(99.0f);
+	statistics->maxMs = _maxMs;
+}
@@ -0,0 +1,93 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#define D2DX_FRAME_TIME_HISTOGRAM_BUCKETS_PER_MS 4
+#define D2DX_FRAME_TIME_HISTOGRAM_BUCKET_COUNT 512
+
+namespace d2dx
+{
+	struct FrameTimeStatistics final
+	{
+		uint32_t frameCount;
+		uint32_t framesOverBudget;
+		float budgetMs;
+		float p50Ms;
+		float p95Ms;
+		float p99Ms;
+		float maxMs;
+	};
+
+	/*
+		Streaming frame time histogram with 0.25 ms buckets up to 128 ms; longer frames share the
+		last bucket. Percentiles are reported at bucket resolution, and the max is exact. Adding a
+		sample never allocates.
+	*/
+	class FrameTimeHistogram final
+	{
+	public:
+		FrameTimeHistogram();
+		~FrameTimeHistogram() noexcept {}
+
+		void Reset();
+
+		void SetBudget(
+			_In_ float budgetMs);
+
+		inline void Add(
+			_In_ double frameTimeMs)
+		{
+			if (frameTimeMs < 0.0)
+			{
+				frameTimeMs = 0.0;
+			}
+
+			uint32_t bucketIndex = (uint32_t)min(
+				frameTimeMs * D2DX_FRAME_TIME_HISTOGRAM_BUCKETS_PER_MS,
+				(double)(D2DX_FRAME_TIME_HISTOGRAM_BUCKET_COUNT - 1));
+
+			++_buckets[bucketIndex];
+			++_frameCount;
+
+			if (frameTimeMs > _budgetMs)
+			{
+				++_framesOverBudget;
+			}
+
+			if (frameTimeMs > _maxMs)
+			{
+				_maxMs = (float)frameTimeMs;
+			}
+		}
+
+		/* Returns the upper bound of the bucket containing the given percentile (0-100). */
+		float GetPercentile(
+			_In_ float percentile) const;
+
+		void GetStatistics(
+			_Out_ FrameTimeStatistics* statistics) const;
+
+	private:
+		uint32_t _frameCount = 0;
+		uint32_t _framesOverBudget = 0;
+		float _budgetMs = 1000.0f / 60.0f;
+		float _maxMs = 0.0f;
+		uint32_t _buckets[D2DX_FRAME_TIME_HISTOGRAM_BUCKET_COUNT];
+	};
+}
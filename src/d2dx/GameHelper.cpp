@@ -372,8 +372,26 @@ void GameHelper::InitializeTextureHashPrefixTable()
 }
 
 _Use_decl_annotations_
-TextureCategory GameHelper::GetTextureCategoryFromHash(
-	uint32_t textureHash) const
+TextureCategory GameHelper::GetTextureCategory(
+	uint64_t contentKey,
+	const uint8_t* pixels,
+	uint32_t pixelsSize,
+	uint32_t& identityHash)
+{
+	return LookupTextureCategory(_textureIdentities, contentKey, pixels, pixelsSize, identityHash);
+}
+
+_Use_decl_annotations_
+TextureCategory GameHelper::RefineTextureCategoryFromGameAddress(
+	TextureCategory previousCategory,
+	GameAddress gameAddress) const
+{
+	return LookupTextureCategoryFromGameAddress(previousCategory, gameAddress);
+}
+
+_Use_decl_annotations_
+TextureCategory GameHelper::LookupTextureCategoryFromHash(
+	uint32_t textureHash)
 {
 	Buffer<uint32_t>& table = prefixTable[textureHash >> 24];
 
@@ -394,9 +412,31 @@ TextureCategory GameHelper::GetTextureCategoryFromHash(
 }
 
 _Use_decl_annotations_
-TextureCategory GameHelper::RefineTextureCategoryFromGameAddress(
+TextureCategory GameHelper::LookupTextureCategory(
+	TextureIdentityTable& textureIdentities,
+	uint64_t contentKey,
+	const uint8_t* pixels,
+	uint32_t pixelsSize,
+	uint32_t& identityHash)
+{
+	TextureCategory category;
+
+	/* The game reuploads the same textures over and over, so the byte-at-a-time FNV-1a pass
+	   is only needed for content that has not been seen before. */
+	if (!textureIdentities.Find(contentKey, identityHash, category))
+	{
+		identityHash = fnv_32a_buf((void*)pixels, pixelsSize, FNV1_32A_INIT);
+		category = LookupTextureCategoryFromHash(identityHash);
+		textureIdentities.Insert(contentKey, identityHash, category);
+	}
+
+	return category;
+}
+
+_Use_decl_annotations_
+TextureCategory GameHelper::LookupTextureCategoryFromGameAddress(
 	TextureCategory previousCategory,
-	GameAddress gameAddress) const
+	GameAddress gameAddress)
 {
 	if (previousCategory != TextureCategory::Unknown)
 	{
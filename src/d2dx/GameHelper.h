@@ -19,6 +19,7 @@
 #pragma once
 
 #include "IGameHelper.h"
+#include "TextureIdentityTable.h"
 #include "Types.h"
 
 namespace d2dx 
@@ -31,6 +32,26 @@ namespace d2dx
 
 		static const HMODULE GetModule(LPCWSTR szModule);
 
+		/* The texture category tables don't depend on the game being loaded, and are
+		   shared with tools that replay captured Glide traces. */
+		static void InitializeTextureHashPrefixTable();
+
+		static TextureCategory LookupTextureCategoryFromHash(
+			_In_ uint32_t textureHash);
+
+		/* Looks up content in textureIdentities, hashing it with FNV-1a and looking up the
+		   texture category tables only the first time it is seen. */
+		static TextureCategory LookupTextureCategory(
+			_Inout_ TextureIdentityTable& textureIdentities,
+			_In_ uint64_t contentKey,
+			_In_reads_(pixelsSize) const uint8_t* pixels,
+			_In_ uint32_t pixelsSize,
+			_Out_ uint32_t& identityHash);
+
+		static TextureCategory LookupTextureCategoryFromGameAddress(
+			_In_ TextureCategory previousCategory,
+			_In_ GameAddress gameAddress);
+
 		virtual GameVersion GetVersion() const override;
 		
 		virtual _Ret_z_ const char* GetVersionString() const override;
@@ -42,8 +63,11 @@ namespace d2dx
 		virtual GameAddress IdentifyGameAddress(
 			_In_ uint32_t returnAddress) const override;
 
-		virtual TextureCategory GetTextureCategoryFromHash(
-			_In_ uint32_t textureHash) const override;
+		virtual TextureCategory GetTextureCategory(
+			_In_ uint64_t contentKey,
+			_In_reads_(pixelsSize) const uint8_t* pixels,
+			_In_ uint32_t pixelsSize,
+			_Out_ uint32_t& identityHash) override;
 		
 		virtual TextureCategory RefineTextureCategoryFromGameAddress(
 			_In_ TextureCategory previousCategory,
@@ -89,8 +113,6 @@ namespace d2dx
 	private:
 		GameVersion GetGameVersion();
 		
-		void InitializeTextureHashPrefixTable();
-		
 		bool ProbeUInt32(
 			_In_ HANDLE hModule, 
 			_In_ uint32_t offset,
@@ -109,5 +131,6 @@ namespace d2dx
 		HANDLE _hD2WinDll;
 		GameVersion _version;
 		bool _isProjectDiablo2;
+		TextureIdentityTable _textureIdentities;
 	};
 }
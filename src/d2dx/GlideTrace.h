@@ -0,0 +1,222 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "D2Types.h"
+
+#define D2DX_GLIDE_TRACE_MAGIC 0x54473244 /* "D2GT" */
+#define D2DX_GLIDE_TRACE_VERSION 2
+
+namespace d2dx
+{
+	/*
+		A Glide trace is a file header followed by a stream of records. Each record is a
+		GlideTraceRecordHeader followed by payloadSize bytes: a fixed-size struct for the
+		record type, optionally followed by variable-length data.
+
+		Bulky data (TMU uploads, palettes, LFB contents) is stored once per content in Blob
+		records, which must precede the first record referencing them by id.
+
+		Game state that D2DX queries from the game's memory is captured too, so that the trace
+		can be replayed without the game: a GameAddress record precedes the first draw call
+		from each distinct return address, and a FrameState record precedes a BufferSwap
+		whenever the state differs from the previous frame.
+	*/
+
+	enum class GlideTraceRecordType : uint8_t
+	{
+		Blob = 1,
+		SstWinOpen = 2,
+		VertexLayout = 3,
+		TexDownload = 4,
+		TexSource = 5,
+		ConstantColorValue = 6,
+		AlphaBlendFunction = 7,
+		ColorCombine = 8,
+		AlphaCombine = 9,
+		ChromakeyMode = 10,
+		DrawPoint = 11,
+		DrawLine = 12,
+		DrawVertexArray = 13,
+		DrawVertexArrayContiguous = 14,
+		TexDownloadTable = 15,
+		LoadGammaTable = 16,
+		LfbUnlock = 17,
+		GammaCorrectionRGB = 18,
+		BufferClear = 19,
+		BufferSwap = 20,
+		GameAddress = 21,
+		FrameState = 22,
+		Count
+	};
+
+#pragma pack(push, 1)
+
+	struct GlideTraceFileHeader final
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t reserved[2];
+	};
+
+	struct GlideTraceRecordHeader final
+	{
+		GlideTraceRecordType type;
+		uint32_t payloadSize;
+	};
+
+	/* Followed by size bytes of content. */
+	struct GlideTraceBlob final
+	{
+		uint32_t blobId;
+		uint32_t size;
+	};
+
+	struct GlideTraceSstWinOpen final
+	{
+		uint32_t hWnd;
+		int32_t width;
+		int32_t height;
+	};
+
+	struct GlideTraceVertexLayout final
+	{
+		uint32_t param;
+		int32_t offset;
+	};
+
+	struct GlideTraceTexDownload final
+	{
+		uint32_t tmu;
+		uint32_t startAddress;
+		int32_t width;
+		int32_t height;
+		uint32_t blobId;
+	};
+
+	struct GlideTraceTexSource final
+	{
+		uint32_t tmu;
+		uint32_t startAddress;
+		int32_t width;
+		int32_t height;
+	};
+
+	struct GlideTraceConstantColorValue final
+	{
+		uint32_t color;
+	};
+
+	struct GlideTraceAlphaBlendFunction final
+	{
+		int32_t rgb_sf;
+		int32_t rgb_df;
+		int32_t alpha_sf;
+		int32_t alpha_df;
+	};
+
+	/* Used for both ColorCombine and AlphaCombine. */
+	struct GlideTraceCombine final
+	{
+		int32_t function;
+		int32_t factor;
+		int32_t local;
+		int32_t other;
+		uint32_t invert;
+	};
+
+	struct GlideTraceChromakeyMode final
+	{
+		int32_t mode;
+	};
+
+	struct GlideTraceDrawPoint final
+	{
+		uint32_t gameContext;
+		D2::Vertex vertex;
+	};
+
+	struct GlideTraceDrawLine final
+	{
+		uint32_t gameContext;
+		D2::Vertex vertices[2];
+	};
+
+	/* Followed by count D2::Vertex (the dereferenced vertex pointers). */
+	struct GlideTraceDrawVertexArray final
+	{
+		uint32_t mode;
+		uint32_t count;
+		uint32_t gameContext;
+	};
+
+	/* Followed by count * stride bytes of vertex data. */
+	struct GlideTraceDrawVertexArrayContiguous final
+	{
+		uint32_t mode;
+		uint32_t count;
+		uint32_t stride;
+		uint32_t gameContext;
+	};
+
+	/* The palette is captured before D2DXContext modifies it in place. */
+	struct GlideTraceTexDownloadTable final
+	{
+		int32_t type;
+		uint32_t blobId;
+	};
+
+	/* Followed by nentries uint32_t each of red, green and blue. */
+	struct GlideTraceLoadGammaTable final
+	{
+		uint32_t nentries;
+	};
+
+	struct GlideTraceLfbUnlock final
+	{
+		uint32_t strideInBytes;
+		uint32_t blobId;
+	};
+
+	struct GlideTraceGammaCorrectionRGB final
+	{
+		float red;
+		float green;
+		float blue;
+	};
+
+	struct GlideTraceGameAddress final
+	{
+		uint32_t gameContext;
+		uint32_t gameAddress;
+	};
+
+	struct GlideTraceFrameState final
+	{
+		uint32_t screenOpenMode;
+		int32_t currentAct;
+		uint8_t isInGame;
+		uint8_t isGameMenuOpen;
+	};
+
+#pragma pack(pop)
+
+	static_assert(sizeof(D2::Vertex) == 28, "sizeof(D2::Vertex)");
+	static_assert(sizeof(GlideTraceRecordHeader) == 5, "sizeof(GlideTraceRecordHeader)");
+}
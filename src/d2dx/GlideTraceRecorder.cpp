@@ -0,0 +1,452 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "GlideTraceRecorder.h"
+#include "Utils.h"
+
+using namespace d2dx;
+
+#define GLIDE_TRACE_BUFFER_SIZE (4 * 1024 * 1024)
+#define GLIDE_TRACE_COMPARE_BUFFER_SIZE (64 * 1024)
+
+/* 64-bit FNV-1a, mixed with the size. Only used to find blobs that may have been written
+   already, which IsBlobEqual then compares byte by byte, so it need not be fast. */
+static uint64_t HashBlob(
+	_In_reads_bytes_(size) const void* data,
+	_In_ uint32_t size)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	uint64_t hash = 0xcbf29ce484222325ULL ^ size;
+
+	for (uint32_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+_Use_decl_annotations_
+GlideTraceRecorder::GlideTraceRecorder(
+	const char* filename,
+	const std::shared_ptr<IGameHelper>& gameHelper) :
+	_gameHelper{ gameHelper },
+	_buffer{ GLIDE_TRACE_BUFFER_SIZE },
+	_compareBuffer{ GLIDE_TRACE_COMPARE_BUFFER_SIZE }
+{
+	/* Opened for reading too, so that WriteBlob can compare against blobs already written. */
+	if (fopen_s(&_file, filename, "w+b") != 0)
+	{
+		_file = nullptr;
+		D2DX_LOG("Failed to open Glide trace file %s.", filename);
+		return;
+	}
+
+	GlideTraceFileHeader header = { };
+	header.magic = D2DX_GLIDE_TRACE_MAGIC;
+	header.version = D2DX_GLIDE_TRACE_VERSION;
+	Write(&header, sizeof(header));
+
+	D2DX_LOG("Recording Glide trace to %s.", filename);
+}
+
+GlideTraceRecorder::~GlideTraceRecorder() noexcept
+{
+	if (_file)
+	{
+		Flush();
+		fclose(_file);
+		_file = nullptr;
+	}
+}
+
+_Use_decl_annotations_
+void GlideTraceRecorder::RecordSstWinOpen(
+	uint32_t hWnd,
+	int32_t width,
+	int32_t height)
+{
+	const GlideTraceSstWinOpen payload{ hWnd, width, height };
+	WriteRecord(GlideTraceRecordType::SstWinOpen, &payload, sizeof(payload));
+}
+
+_Use_decl_annotations_
+void GlideTraceRecorder::RecordVertexLayout(
+	uint32_t param,
+	int32_t offset)
+{
+	const GlideTraceVertexLayout payload{ param, offset };
+	WriteRecord(GlideTraceRecordType::VertexLayout, &payload, sizeof(payload));
+}
+
+_Use_decl_annotations_
+void GlideTraceRecorder::RecordTexDownload(
+	uint32_t tmu,
+	const uint8_t* sourceAddress,
+	uint32_t startAddress,
+	int32_t width,
+	int32_t height)
+{
+	const uint32_t blobId = WriteBlob(sourceAddress, (uint32_t)(width * height));
+	const GlideTraceTexDownload payload{ tmu, startAddress, width, height, blobId };
+	WriteRecord(GlideTraceRecordType::TexDownload, &payload, sizeof(payload));
+}
+
+_Use_decl_annotations_
+void GlideTraceRecorder::RecordTexSource(
+	uint32_t tmu,
+	uint32_t startAddress,
+	int32_t width,
+	int32_t height)
+{
+	const GlideTraceTexSource payload{ tmu, startAddress, width, height };
+	WriteRecord(GlideTraceRecordType::TexSource, &payload, sizeof(payload));
+}
+
+_Use_decl_annotations_
+void GlideTraceRecorder::RecordConstantColorValue(
+	uint32_t color)
+{
+	const GlideTraceConstantColorValue payload{ color };
+	WriteRecord(GlideTraceRecordType::ConstantColorValue, &payload, sizeof(payload));
+}
+
+_Use_decl_annotations_
+void GlideTraceRecorder::RecordAlphaBlendFunction(
+	GrAlphaBlendFnc_t rgb_sf,
+	GrAlphaBlendFnc_t rgb_df,
+	GrAlphaBlendFnc_t alpha_sf,
+	GrAlphaBlendFnc_t alpha_df)
+{
+	const GlideTraceAlphaBlendFunction payload{ rgb_sf, rgb_df, alpha_sf, alpha_df };
+	WriteRecord(GlideTraceRecordType::AlphaBlendFunction, &payload, sizeof(payload));
+}
+
+_Use_decl_annotations_
+void GlideTraceRecorder::RecordCombine(
+	GlideTraceRecordType type,
+	GrCombineFunction_t function,
+	GrCombineFactor_t factor,
+	GrCombineLocal_t local,
+	GrCombineOther_t other,
+	bool invert)
+{
+	assert(type == GlideTraceRecordType::ColorCombine || type == GlideTraceRecordType::AlphaCombine);
+	const GlideTraceCombine payload{ function, factor, local, other, invert ? 1U : 0U };
+	WriteRecord(type, &payload, sizeof(payload));
+}
+
+_Use_decl_annotations_
+void GlideTraceRecorder::RecordChromakeyMode(
+	GrChromakeyMode_t mode)
+{
+	const GlideTraceChromakeyMode payload{ mode };
+	WriteRecord(GlideTraceRecordType::ChromakeyMode, &payload, sizeof(payload));
+}
+
+_Use_decl_annotations_
+void GlideTraceRecorder::RecordDrawPoint(
+	const void* pt,
+	uint32_t gameContext)
+{
+	RecordGameAddress(gameContext);
+
+	GlideTraceDrawPoint payload;
+	payload.gameContext = gameContext;
+	payload.vertex = *(const D2::Vertex*)pt;
+	WriteRecord(GlideTraceRecordType::DrawPoint, &payload, sizeof(payload));
+}
+
+_Use_decl_annotations_
+void GlideTraceRecorder::RecordDrawLine(
+	const void* v1,
+	const void* v2,
+	uint32_t gameContext)
+{
+	RecordGameAddress(gameContext);
+
+	GlideTraceDrawLine payload;
+	payload.gameContext = gameContext;
+	payload.vertices[0] = *(const D2::Vertex*)v1;
+	payload.vertices[1] = *(const D2::Vertex*)v2;
+	WriteRecord(GlideTraceRecordType::DrawLine, &payload, sizeof(payload));
+}
+
+_Use_decl_annotations_
+void GlideTraceRecorder::RecordDrawVertexArray(
+	uint32_t mode,
+	uint32_t count,
+	uint8_t** pointers,
+	uint32_t gameContext)
+{
+	RecordGameAddress(gameContext);
+
+	const GlideTraceDrawVertexArray payload{ mode, count, gameContext };
+	const uint32_t verticesSize = count * sizeof(D2::Vertex);
+
+	GlideTraceRecordHeader header{ GlideTraceRecordType::DrawVertexArray, sizeof(payload) + verticesSize };
+	Write(&header, sizeof(header));
+	Write(&payload, sizeof(payload));
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		Write(pointers[i], sizeof(D2::Vertex));
+	}
+}
+
+_Use_decl_annotations_
+void GlideTraceRecorder::RecordDrawVertexArrayContiguous(
+	uint32_t mode,
+	uint32_t count,
+	const uint8_t* vertex,
+	uint32_t stride,
+	uint32_t gameContext)
+{
+	RecordGameAddress(gameContext);
+
+	const GlideTraceDrawVertexArrayContiguous payload{ mode, count, stride, gameContext };
+	WriteRecord(GlideTraceRecordType::DrawVertexArrayContiguous, &payload, sizeof(payload), vertex, count * stride);
+}
+
+_Use_decl_annotations_
+void GlideTraceRecorder::RecordTexDownloadTable(
+	GrTexTable_t type,
+	const void* data)
+{
+	const uint32_t blobId = WriteBlob(data, 256 * 4);
+	const GlideTraceTexDownloadTable payload{ type, blobId };
+	WriteRecord(GlideTraceRecordType::TexDownloadTable, &payload, sizeof(payload));
+}
+
+_Use_decl_annotations_
+void GlideTraceRecorder::RecordLoadGammaTable(
+	uint32_t nentries,
+	const uint32_t* red,
+	const uint32_t* green,
+	const uint32_t* blue)
+{
+	const GlideTraceLoadGammaTable payload{ nentries };
+	const uint32_t tableSize = nentries * sizeof(uint32_t);
+
+	GlideTraceRecordHeader header{ GlideTraceRecordType::LoadGammaTable, sizeof(payload) + 3 * tableSize };
+	Write(&header, sizeof(header));
+	Write(&payload, sizeof(payload));
+	Write(red, tableSize);
+	Write(green, tableSize);
+	Write(blue, tableSize);
+}
+
+_Use_decl_annotations_
+void GlideTraceRecorder::RecordLfbUnlock(
+	const uint32_t* lfbPtr,
+	uint32_t strideInBytes)
+{
+	const uint32_t blobId = WriteBlob(lfbPtr, strideInBytes * 480);
+	const GlideTraceLfbUnlock payload{ strideInBytes, blobId };
+	WriteRecord(GlideTraceRecordType::LfbUnlock, &payload, sizeof(payload));
+}
+
+_Use_decl_annotations_
+void GlideTraceRecorder::RecordGammaCorrectionRGB(
+	float red,
+	float green,
+	float blue)
+{
+	const GlideTraceGammaCorrectionRGB payload{ red, green, blue };
+	WriteRecord(GlideTraceRecordType::GammaCorrectionRGB, &payload, sizeof(payload));
+}
+
+void GlideTraceRecorder::RecordBufferClear()
+{
+	WriteRecord(GlideTraceRecordType::BufferClear, nullptr, 0);
+}
+
+void GlideTraceRecorder::RecordBufferSwap()
+{
+	RecordFrameState();
+
+	WriteRecord(GlideTraceRecordType::BufferSwap, nullptr, 0);
+
+	++_frame;
+
+	if (!(_frame & 1023))
+	{
+		D2DX_LOG("Glide trace: %u frames, %u unique blobs (%u kB).", _frame, (uint32_t)_blobs.size(), (uint32_t)(_blobBytes / 1024));
+	}
+}
+
+void GlideTraceRecorder::Flush()
+{
+	if (_file && _bufferUsed > 0)
+	{
+		fwrite(_buffer.items, _bufferUsed, 1, _file);
+		fflush(_file);
+		_fileSize += _bufferUsed;
+	}
+
+	_bufferUsed = 0;
+}
+
+_Use_decl_annotations_
+void GlideTraceRecorder::RecordGameAddress(
+	uint32_t gameContext)
+{
+	if (!_knownGameContexts.insert(gameContext).second)
+	{
+		return;
+	}
+
+	const GlideTraceGameAddress payload{ gameContext, (uint32_t)_gameHelper->IdentifyGameAddress(gameContext) };
+	WriteRecord(GlideTraceRecordType::GameAddress, &payload, sizeof(payload));
+}
+
+void GlideTraceRecorder::RecordFrameState()
+{
+	GlideTraceFrameState frameState = { };
+	frameState.screenOpenMode = _gameHelper->ScreenOpenMode();
+	frameState.isInGame = _gameHelper->IsInGame() ? 1 : 0;
+
+	if (frameState.isInGame)
+	{
+		frameState.currentAct = _gameHelper->GetCurrentAct();
+		frameState.isGameMenuOpen = _gameHelper->IsGameMenuOpen() ? 1 : 0;
+	}
+
+	if (memcmp(&frameState, &_lastFrameState, sizeof(frameState)) != 0)
+	{
+		WriteRecord(GlideTraceRecordType::FrameState, &frameState, sizeof(frameState));
+		_lastFrameState = frameState;
+	}
+}
+
+_Use_decl_annotations_
+uint32_t GlideTraceRecorder::WriteBlob(
+	const void* data,
+	uint32_t size)
+{
+	const uint64_t key = HashBlob(data, size);
+	const auto candidates = _blobs.equal_range(key);
+
+	for (auto it = candidates.first; it != candidates.second; ++it)
+	{
+		if (IsBlobEqual(it->second, data, size))
+		{
+			return it->second.id;
+		}
+	}
+
+	const uint32_t blobId = _nextBlobId++;
+	const GlideTraceBlob payload{ blobId, size };
+	WriteRecord(GlideTraceRecordType::Blob, &payload, sizeof(payload), data, size);
+
+	/* The contents were written last, and Write never splits a single call between the file and the buffer. */
+	const uint64_t offset = _fileSize + _bufferUsed - size;
+	_blobs.emplace(key, BlobEntry{ blobId, size, offset });
+	_blobBytes += size;
+
+	return blobId;
+}
+
+_Use_decl_annotations_
+bool GlideTraceRecorder::IsBlobEqual(
+	const BlobEntry& blob,
+	const void* data,
+	uint32_t size)
+{
+	if (blob.size != size || !_file)
+	{
+		return false;
+	}
+
+	if (blob.offset >= _fileSize)
+	{
+		return !memcmp(_buffer.items + (blob.offset - _fileSize), data, size);
+	}
+
+	/* The blob has left the write buffer, so read it back from the file. Every write to the file is
+	   followed by fflush, so it is safe to seek and read here, and the seek to the end afterwards
+	   makes it safe to write again. */
+	const uint8_t* bytes = (const uint8_t*)data;
+	bool isEqual = _fseeki64(_file, (int64_t)blob.offset, SEEK_SET) == 0;
+
+	for (uint32_t compared = 0; isEqual && compared < size; )
+	{
+		const uint32_t chunkSize = min(size - compared, _compareBuffer.capacity);
+
+		isEqual =
+			fread(_compareBuffer.items, chunkSize, 1, _file) == 1 &&
+			!memcmp(_compareBuffer.items, bytes + compared, chunkSize);
+
+		compared += chunkSize;
+	}
+
+	_fseeki64(_file, 0, SEEK_END);
+
+	return isEqual;
+}
+
+_Use_decl_annotations_
+void GlideTraceRecorder::WriteRecord(
+	GlideTraceRecordType type,
+	const void* payload,
+	uint32_t payloadSize,
+	const void* extra,
+	uint32_t extraSize)
+{
+	GlideTraceRecordHeader header{ type, payloadSize + extraSize };
+	Write(&header, sizeof(header));
+
+	if (payloadSize > 0)
+	{
+		Write(payload, payloadSize);
+	}
+
+	if (extraSize > 0)
+	{
+		Write(extra, extraSize);
+	}
+}
+
+_Use_decl_annotations_
+void GlideTraceRecorder::Write(
+	const void* data,
+	uint32_t size)
+{
+	if (!_file)
+	{
+		return;
+	}
+
+	if (_bufferUsed + size > _buffer.capacity)
+	{
+		Flush();
+
+		if (size > _buffer.capacity)
+		{
+			fwrite(data, size, 1, _file);
+			fflush(_file);
+			_fileSize += size;
+			return;
+		}
+	}
+
+	memcpy(_buffer.items + _bufferUsed, data, size);
+	_bufferUsed += size;
+}
@@ -0,0 +1,174 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+#include "GlideTrace.h"
+#include "IGameHelper.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+namespace d2dx
+{
+	class GlideTraceRecorder final
+	{
+	public:
+		GlideTraceRecorder(
+			_In_z_ const char* filename,
+			_In_ const std::shared_ptr<IGameHelper>& gameHelper);
+
+		~GlideTraceRecorder() noexcept;
+
+		void RecordSstWinOpen(
+			_In_ uint32_t hWnd,
+			_In_ int32_t width,
+			_In_ int32_t height);
+
+		void RecordVertexLayout(
+			_In_ uint32_t param,
+			_In_ int32_t offset);
+
+		void RecordTexDownload(
+			_In_ uint32_t tmu,
+			_In_reads_(width * height) const uint8_t* sourceAddress,
+			_In_ uint32_t startAddress,
+			_In_ int32_t width,
+			_In_ int32_t height);
+
+		void RecordTexSource(
+			_In_ uint32_t tmu,
+			_In_ uint32_t startAddress,
+			_In_ int32_t width,
+			_In_ int32_t height);
+
+		void RecordConstantColorValue(
+			_In_ uint32_t color);
+
+		void RecordAlphaBlendFunction(
+			_In_ GrAlphaBlendFnc_t rgb_sf,
+			_In_ GrAlphaBlendFnc_t rgb_df,
+			_In_ GrAlphaBlendFnc_t alpha_sf,
+			_In_ GrAlphaBlendFnc_t alpha_df);
+
+		void RecordCombine(
+			_In_ GlideTraceRecordType type,
+			_In_ GrCombineFunction_t function,
+			_In_ GrCombineFactor_t factor,
+			_In_ GrCombineLocal_t local,
+			_In_ GrCombineOther_t other,
+			_In_ bool invert);
+
+		void RecordChromakeyMode(
+			_In_ GrChromakeyMode_t mode);
+
+		void RecordDrawPoint(
+			_In_ const void* pt,
+			_In_ uint32_t gameContext);
+
+		void RecordDrawLine(
+			_In_ const void* v1,
+			_In_ const void* v2,
+			_In_ uint32_t gameContext);
+
+		void RecordDrawVertexArray(
+			_In_ uint32_t mode,
+			_In_ uint32_t count,
+			_In_reads_(count) uint8_t** pointers,
+			_In_ uint32_t gameContext);
+
+		void RecordDrawVertexArrayContiguous(
+			_In_ uint32_t mode,
+			_In_ uint32_t count,
+			_In_reads_(count * stride) const uint8_t* vertex,
+			_In_ uint32_t stride,
+			_In_ uint32_t gameContext);
+
+		void RecordTexDownloadTable(
+			_In_ GrTexTable_t type,
+			_In_reads_bytes_(256 * 4) const void* data);
+
+		void RecordLoadGammaTable(
+			_In_ uint32_t nentries,
+			_In_reads_(nentries) const uint32_t* red,
+			_In_reads_(nentries) const uint32_t* green,
+			_In_reads_(nentries) const uint32_t* blue);
+
+		void RecordLfbUnlock(
+			_In_reads_bytes_(strideInBytes * 480) const uint32_t* lfbPtr,
+			_In_ uint32_t strideInBytes);
+
+		void RecordGammaCorrectionRGB(
+			_In_ float red,
+			_In_ float green,
+			_In_ float blue);
+
+		void RecordBufferClear();
+
+		void RecordBufferSwap();
+
+		void Flush();
+
+	private:
+		struct BlobEntry final
+		{
+			uint32_t id;
+			uint32_t size;
+			uint64_t offset;
+		};
+
+		void RecordGameAddress(
+			_In_ uint32_t gameContext);
+
+		void RecordFrameState();
+
+		uint32_t WriteBlob(
+			_In_reads_bytes_(size) const void* data,
+			_In_ uint32_t size);
+
+		bool IsBlobEqual(
+			_In_ const BlobEntry& blob,
+			_In_reads_bytes_(size) const void* data,
+			_In_ uint32_t size);
+
+		void WriteRecord(
+			_In_ GlideTraceRecordType type,
+			_In_reads_bytes_(payloadSize) const void* payload,
+			_In_ uint32_t payloadSize,
+			_In_reads_bytes_opt_(extraSize) const void* extra = nullptr,
+			_In_ uint32_t extraSize = 0);
+
+		void Write(
+			_In_reads_bytes_(size) const void* data,
+			_In_ uint32_t size);
+
+		std::shared_ptr<IGameHelper> _gameHelper;
+		FILE* _file = nullptr;
+		Buffer<uint8_t> _buffer;
+		Buffer<uint8_t> _compareBuffer;
+		uint32_t _bufferUsed = 0;
+		uint64_t _fileSize = 0;
+		uint32_t _frame = 0;
+		uint32_t _nextBlobId = 1;
+		uint64_t _blobBytes = 0;
+		std::unordered_multimap<uint64_t, BlobEntry> _blobs;		// Keyed by HashBlob, contents stay in the file.
+		std::unordered_set<uint32_t> _knownGameContexts;
+		GlideTraceFrameState _lastFrameState = { 0xFFFFFFFF };
+	};
+}
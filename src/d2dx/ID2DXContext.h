@@ -18,6 +18,7 @@
 */
 #pragma once
 
+#include "IGameHelper.h"
 #include "IGlide3x.h"
 #include "IWin32InterceptionHandler.h"
 #include "ID2InterceptionHandler.h"
@@ -49,8 +50,15 @@ namespace d2dx
 		virtual void DisableBuiltinResMod() = 0;
 
 		virtual const Options& GetOptions() const = 0;
+
+		virtual const std::shared_ptr<IGameHelper>& GetGameHelper() const = 0;
 		
 		virtual bool IsFeatureEnabled(
 			_In_ Feature feature) = 0;
+
+		virtual MajorGameState GetMajorGameState() const = 0;
+
+		/* Writes the recent frame timings to d2dx_frameprofile.csv, if profiling is enabled. */
+		virtual void DumpFrameProfile() = 0;
 	};
 }
@@ -65,8 +65,13 @@ namespace d2dx
 		virtual GameAddress IdentifyGameAddress(
 			_In_ uint32_t returnAddress) const = 0;
 
-		virtual TextureCategory GetTextureCategoryFromHash(
-			_In_ uint32_t textureHash) const = 0;
+		/* Identifies a texture by its content key: returns its category and, in identityHash, the
+		   FNV-1a hash of its pixels that known game textures are listed by. */
+		virtual TextureCategory GetTextureCategory(
+			_In_ uint64_t contentKey,
+			_In_reads_(pixelsSize) const uint8_t* pixels,
+			_In_ uint32_t pixelsSize,
+			_Out_ uint32_t& identityHash) = 0;
 
 		virtual TextureCategory RefineTextureCategoryFromGameAddress(
 			_In_ TextureCategory previousCategory,
@@ -18,6 +18,7 @@
 */
 #pragma once
 
+#include "FrameTimeHistogram.h"
 #include "ITextureCache.h"
 #include "Types.h"
 #include "Options.h"
@@ -41,10 +42,15 @@ namespace d2dx
 			_In_reads_(vertexCount) const Vertex* vertices,
 			_In_ uint32_t vertexCount) = 0;
 
+		/* lastLocation is where the same texture was found or inserted before, or { -1, -1 }. */
 		virtual TextureCacheLocation UpdateTexture(
 			_In_ const Batch& batch,
 			_In_reads_(tmuDataSize) const uint8_t* tmuData,
-			_In_ uint32_t tmuDataSize) = 0;
+			_In_ uint32_t tmuDataSize,
+			_In_ TextureCacheLocation lastLocation) = 0;
+
+		/* Submits the texture uploads staged by UpdateTexture during the frame. */
+		virtual void FlushTextureUploads() = 0;
 
 		virtual void Draw(
 			_In_ const Batch& batch,
@@ -84,5 +90,11 @@ namespace d2dx
 		virtual int32_t GetFrameTimeFp() const = 0;
 
 		virtual ScreenMode GetScreenMode() const = 0;
+
+		virtual void GetFrameTimeStatistics(
+			_In_ MajorGameState majorGameState,
+			_Out_ FrameTimeStatistics* statistics) const = 0;
+
+		virtual void ResetFrameTimeStatistics() = 0;
 	};
 }
@@ -26,9 +26,28 @@ namespace d2dx
 	{
 		virtual ~ISimd() noexcept {}
 
+		/* No longer used by the texture cache, whose content keys are 64-bit; kept as part of the
+		   public SIMD interface and its tests. */
 		virtual int32_t IndexOfUInt32(
 			_In_reads_(itemsCount) const uint32_t* __restrict items,
 			_In_ uint32_t itemsCount,
 			_In_ uint32_t item) = 0;
+
+		virtual int32_t IndexOfUInt64(
+			_In_reads_(itemsCount) const uint64_t* __restrict items,
+			_In_ uint32_t itemsCount,
+			_In_ uint64_t item) = 0;
+
+		/* Computes the 64-bit WideHash of the data. Never returns zero. */
+		virtual uint64_t HashBytes64(
+			_In_reads_(size) const uint8_t* __restrict data,
+			_In_ uint32_t size) = 0;
+
+		/* Copies size bytes from src to dst and returns the same value as HashBytes64 would
+		   for them, reading the source only once. */
+		virtual uint64_t CopyAndHashBytes64(
+			_Out_writes_all_(size) uint8_t* __restrict dst,
+			_In_reads_(size) const uint8_t* __restrict src,
+			_In_ uint32_t size) = 0;
 	};
 }
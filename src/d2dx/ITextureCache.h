@@ -24,6 +24,7 @@
 namespace d2dx
 {
 	class Batch;
+	class TextureCacheFileWriter;
 
 	struct TextureCacheLocation final
 	{
@@ -33,27 +34,94 @@ namespace d2dx
 
 	static_assert(sizeof(TextureCacheLocation) == 4, "sizeof(TextureCacheLocation) == 4");
 
+	/* Counters of a texture cache, for one frame or accumulated over all completed frames. */
+	struct TextureCacheStatistics final
+	{
+		uint32_t lookupCount;
+		uint32_t hintHitCount;		/* Found at the lastIndex passed to FindTexture. */
+		uint32_t searchHitCount;	/* Found by searching the cache. */
+		uint32_t missCount;
+		uint32_t evictionCount;
+		uint32_t resetCount;		/* Every entry was used within one frame, and the replacement state was reset. */
+		uint64_t uploadedBytes;
+		uint32_t usedCount;			/* Occupied slots at the end of the (last) frame. */
+		uint32_t capacity;
+	};
+
+	/* Per-TextureCategory counters of a texture cache. Hits and misses are cumulative. */
+	struct TextureCachePartitionStatistics final
+	{
+		uint32_t hitCount;
+		uint32_t missCount;
+		uint32_t residentCount;
+	};
+
 	struct ITextureCache abstract
 	{
 		virtual ~ITextureCache() noexcept {}
 
 		virtual void OnNewFrame() = 0;
 
+		/* Submits the uploads staged by InsertTexture. Must be called before drawing with the cache. */
+		virtual void FlushUploads() = 0;
+
+		/* lastIndex is where the texture was last seen (see GetIndex), or -1. It is checked with one
+		   compare before the cache is searched. */
 		virtual TextureCacheLocation FindTexture(
-			_In_ uint32_t contentKey,
+			_In_ uint64_t contentKey,
 			_In_ int32_t lastIndex) = 0;
 
 		virtual TextureCacheLocation InsertTexture(
-			_In_ uint32_t contentKey,
+			_In_ uint64_t contentKey,
 			_In_ const Batch& batch,
 			_In_reads_(tmuDataSize) const uint8_t* tmuData,
 			_In_ uint32_t tmuDataSize) = 0;
 
+		/* Inserts a texture the game has not asked for yet, e.g. from the warm-start file. The pixels
+		   fill a whole slot. Only free slots are used: returns false if there is none, or if the
+		   texture is already present. */
+		virtual bool PreloadTexture(
+			_In_ uint64_t contentKey,
+			_In_ TextureCategory category,
+			_In_reads_(GetTextureSize()) const uint8_t* pixels) = 0;
+
+		/* Reads back every texture in the cache and adds it to the writer. Slow; meant for shutdown. */
+		virtual void SaveTextures(
+			_Inout_ TextureCacheFileWriter& writer) = 0;
+
 		virtual ID3D11ShaderResourceView* GetSrv(
 			_In_ uint32_t atlasIndex) const = 0;
 
+		/* Returns the slot index of a location returned by FindTexture or InsertTexture, for use as lastIndex. */
+		virtual int32_t GetIndex(
+			_In_ TextureCacheLocation location) const = 0;
+
+		/* Bytes of texture memory allocated. Atlases are only created once a texture is inserted into them. */
 		virtual uint32_t GetMemoryFootprint() const = 0;
 
 		virtual uint32_t GetUsedCount() const = 0;
+
+		virtual uint32_t GetTextureSize() const = 0;
+
+		virtual uint32_t GetCapacity() const = 0;
+
+		virtual uint32_t GetMaxCapacity() const = 0;
+
+		virtual void SetCapacity(
+			_In_ uint32_t capacity) = 0;
+
+		/* Evictions per frame, as an exponential moving average. */
+		virtual float GetEvictionRate() const = 0;
+
+		/* Recent peak of the number of entries used within a single frame (decays slowly). */
+		virtual uint32_t GetPeakUsedInFrameCount() const = 0;
+
+		virtual void GetStatistics(
+			_Out_opt_ TextureCacheStatistics* lastFrame,
+			_Out_opt_ TextureCacheStatistics* cumulative) const = 0;
+
+		virtual void GetPartitionStatistics(
+			_In_ TextureCategory category,
+			_Out_ TextureCachePartitionStatistics* statistics) const = 0;
 	};
 }
@@ -0,0 +1,80 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Types.h"
+
+namespace d2dx
+{
+	/*
+		Decides which slot of a texture cache holds which texture. A slot that has been found or
+		inserted during the current frame is never handed out again before OnNewFrame, because
+		batches of the frame may still refer to it; if every slot has been used in the frame, the
+		policy starts over (counted by GetResetCount).
+
+		Every policy honours the pinned quota of TextureCacheSlots: Insert first looks for a
+		victim the quota allows (for a pinned texture at the quota, only pinned slots, even when
+		free slots remain), then for any slot not used in the frame, and only then starts over.
+	*/
+	struct ITextureCachePolicy abstract
+	{
+		virtual ~ITextureCachePolicy() noexcept {}
+
+		/* Returns the slot holding contentKey, or -1. lastIndex is a hint, or -1. */
+		virtual int32_t Find(
+			_In_ uint64_t contentKey,
+			_In_ int32_t lastIndex) = 0;
+
+		/* Returns the slot to store contentKey in. contentKey must not already be present. */
+		virtual int32_t Insert(
+			_In_ uint64_t contentKey,
+			_In_ TextureCategory category,
+			_Out_ bool& evicted) = 0;
+
+		/* Stores contentKey in a free slot without marking it as used, or returns -1 if no slot
+		   is free. contentKey must not already be present. */
+		virtual int32_t InsertFree(
+			_In_ uint64_t contentKey,
+			_In_ TextureCategory category) = 0;
+
+		virtual void OnNewFrame() = 0;
+
+		/* Entries in slots below the new capacity keep their slots; the others are dropped. */
+		virtual void SetCapacity(
+			_In_ uint32_t capacity) = 0;
+
+		virtual uint32_t GetCapacity() const = 0;
+
+		virtual uint32_t GetUsedCount() const = 0;
+
+		virtual uint32_t GetUsedInFrameCount() const = 0;
+
+		virtual uint32_t GetResetCount() const = 0;
+
+		/* Returns the content key in a slot, or 0 if the slot is free. */
+		virtual uint64_t GetContentKey(
+			_In_ int32_t index) const = 0;
+
+		virtual TextureCategory GetCategory(
+			_In_ int32_t index) const = 0;
+
+		virtual uint32_t GetCategoryCount(
+			_In_ TextureCategory category) const = 0;
+	};
+}
@@ -79,6 +79,8 @@ void Options::ApplyCfg(
 		READ_OPTOUTS_FLAG(OptionsFlag::NoCompatModeFix, "nocompatmodefix");
 		READ_OPTOUTS_FLAG(OptionsFlag::NoTitleChange, "notitlechange");
 		READ_OPTOUTS_FLAG(OptionsFlag::NoMotionPrediction, "nomotionprediction");
+		READ_OPTOUTS_FLAG(OptionsFlag::NoTextureCacheWarmStart, "notexturecachewarmstart");
+		READ_OPTOUTS_FLAG(OptionsFlag::NoBatchReordering, "nobatchreordering");
 
 #undef READ_OPTOUTS_FLAG
 	}
@@ -144,6 +146,30 @@ void Options::ApplyCfg(
 		{
 			SetFlag(OptionsFlag::DbgDumpTextures, dumpTextures.u.b);
 		}
+
+		auto recordGlideTrace = toml_bool_in(debug, "recordglidetrace");
+		if (recordGlideTrace.ok)
+		{
+			SetFlag(OptionsFlag::DbgRecordGlideTrace, recordGlideTrace.u.b);
+		}
+
+		auto profileFrames = toml_bool_in(debug, "profileframes");
+		if (profileFrames.ok)
+		{
+			SetFlag(OptionsFlag::DbgProfileFrames, profileFrames.u.b);
+		}
+
+		auto traceEvents = toml_bool_in(debug, "traceevents");
+		if (traceEvents.ok)
+		{
+			SetFlag(OptionsFlag::DbgTraceEvents, traceEvents.u.b);
+		}
+
+		auto recordTextureKeys = toml_bool_in(debug, "recordtexturekeys");
+		if (recordTextureKeys.ok)
+		{
+			SetFlag(OptionsFlag::DbgRecordTextureKeys, recordTextureKeys.u.b);
+		}
 	}
 
 	toml_free(root);
@@ -163,11 +189,17 @@ void Options::ApplyCommandLine(
 	if (strstr(cmdLine, "-dxnocompatmodefix")) SetFlag(OptionsFlag::NoCompatModeFix, true);
 	if (strstr(cmdLine, "-dxnotitlechange")) SetFlag(OptionsFlag::NoTitleChange, true);
 	if (strstr(cmdLine, "-dxnomop")) SetFlag(OptionsFlag::NoMotionPrediction, true);
+	if (strstr(cmdLine, "-dxnowarmstart")) SetFlag(OptionsFlag::NoTextureCacheWarmStart, true);
+	if (strstr(cmdLine, "-dxnoreorder")) SetFlag(OptionsFlag::NoBatchReordering, true);
 
 	if (strstr(cmdLine, "-dxscale3")) SetWindowScale(3.0);
 	else if (strstr(cmdLine, "-dxscale2")) SetWindowScale(2.0);
 
 	if (strstr(cmdLine, "-dxdbg_dump_textures")) SetFlag(OptionsFlag::DbgDumpTextures, true);
+	if (strstr(cmdLine, "-dxdbg_record_glide_trace")) SetFlag(OptionsFlag::DbgRecordGlideTrace, true);
+	if (strstr(cmdLine, "-dxdbg_profile_frames")) SetFlag(OptionsFlag::DbgProfileFrames, true);
+	if (strstr(cmdLine, "-dxdbg_trace_events")) SetFlag(OptionsFlag::DbgTraceEvents, true);
+	if (strstr(cmdLine, "-dxdbg_record_texture_keys")) SetFlag(OptionsFlag::DbgRecordTextureKeys, true);
 }
 
 _Use_decl_annotations_
@@ -34,8 +34,14 @@ namespace d2dx
 		NoTitleChange,
 		NoVSync,
 		NoMotionPrediction,
+		NoTextureCacheWarmStart,
+		NoBatchReordering,
 
 		DbgDumpTextures,
+		DbgRecordGlideTrace,
+		DbgProfileFrames,
+		DbgTraceEvents,
+		DbgRecordTextureKeys,
 
 		Frameless,
 
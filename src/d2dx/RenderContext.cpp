@@ -22,10 +22,13 @@
 #include "RenderContext.h"
 #include "Metrics.h"
 #include "TextureCache.h"
+#include "TraceEventWriter.h"
 #include "Vertex.h"
 #include "Utils.h"
 
 #define MAX_FRAME_LATENCY 1
+#define TEXTURE_CACHE_FILENAME "d2dx_texturecache.bin"
+#define TEXTURE_PRELOAD_BYTES_PER_FRAME (1024 * 1024)
 #undef ALLOW_SET_SOURCE_SIZE
 
 using namespace d2dx;
@@ -67,9 +70,30 @@ RenderContext::RenderContext(
 
 	memset(&_shadowState, 0, sizeof(_shadowState));
 
+	if (_d2dxContext->GetOptions().GetFlag(OptionsFlag::DbgRecordTextureKeys))
+	{
+		_textureKeyLog = std::make_unique<TextureKeyLog>("d2dx_texturekeys.bin");
+	}
+
+	if (!_d2dxContext->GetOptions().GetFlag(OptionsFlag::NoTextureCacheWarmStart))
+	{
+		_textureCacheWarmStart = std::make_unique<TextureCacheWarmStart>(TEXTURE_CACHE_FILENAME, simd);
+		_saveTexturesOnExit = true;
+	}
+
 	_desktopSize = { GetSystemMetrics(SM_CXSCREEN), GetSystemMetrics(SM_CYSCREEN) };
 	_desktopClientMaxHeight = GetSystemMetrics(SM_CYFULLSCREEN);
 
+	DEVMODEA displayMode = { 0 };
+	displayMode.dmSize = sizeof(displayMode);
+	if (EnumDisplaySettingsA(nullptr, ENUM_CURRENT_SETTINGS, &displayMode) && displayMode.dmDisplayFrequency > 1)
+	{
+		for (auto& frameTimeHistogram : _frameTimeHistograms)
+		{
+			frameTimeHistogram.SetBudget(1000.0f / displayMode.dmDisplayFrequency);
+		}
+	}
+
 	_gameSize = gameSize;
 	_windowSize = windowSize;
 	_renderRect = Metrics::GetRenderRect(
@@ -297,6 +321,22 @@ RenderContext::RenderContext(
 	uint32_t offset = 0;
 	ID3D11Buffer* vbs[1] = { _resources->GetVertexBuffer() };
 	_deviceContext->IASetVertexBuffers(0, 1, vbs, &stride, &offset);
+	_deviceContext->IASetIndexBuffer(_resources->GetQuadIndexBuffer(), DXGI_FORMAT_R16_UINT, 0);
+}
+
+RenderContext::~RenderContext() noexcept
+{
+	if (_saveTexturesOnExit && _resources)
+	{
+		try
+		{
+			SaveTextures();
+		}
+		catch (...)
+		{
+			D2DX_LOG("Failed to save the texture caches.");
+		}
+	}
 }
 
 HWND RenderContext::GetHWnd() const
@@ -304,6 +344,11 @@ HWND RenderContext::GetHWnd() const
 	return _hWnd;
 }
 
+void RenderContext::FlushTextureUploads()
+{
+	_resources->FlushTextureUploads();
+}
+
 _Use_decl_annotations_
 void RenderContext::Draw(
 	const Batch& batch,
@@ -319,7 +364,9 @@ void RenderContext::Draw(
 		atlas ? atlas->GetSrv(batch.GetTextureAtlas()) : nullptr,
 		_resources->GetTexture1DSrv(RenderContextTexture1D::Palette));
 
-	_deviceContext->Draw(batch.GetVertexCount(), startVertexLocation + batch.GetStartVertex());
+	assert(!(batch.GetVertexCount() & 3) && batch.GetVertexCount() <= 4 * (D2DX_MAX_QUADS_PER_DRAW_CALL - 1));
+
+	_deviceContext->DrawIndexed(batch.GetVertexCount() / 4 * 6, 0, startVertexLocation + batch.GetStartVertex());
 }
 
 bool RenderContext::IsIntegerScale() const
@@ -437,14 +484,22 @@ void RenderContext::Present()
 #ifndef NDEBUG
 	if (!(_frameCount & 255))
 	{
-		D2DX_LOG("Texture cache use: %u, %u, %u, %u, %u, %u, %u",
-			this->_resources->GetTextureCache(8, 8)->GetUsedCount(),
-			this->_resources->GetTextureCache(16, 16)->GetUsedCount(),
-			this->_resources->GetTextureCache(32, 32)->GetUsedCount(),
-			this->_resources->GetTextureCache(64, 64)->GetUsedCount(),
-			this->_resources->GetTextureCache(128, 128)->GetUsedCount(),
-			this->_resources->GetTextureCache(256, 256)->GetUsedCount(),
-			this->_resources->GetTextureCache(256, 128)->GetUsedCount());
+		char text[1024] = "";
+		int32_t length = 0;
+
+		for (int32_t i = 0; i < D2DX_TEXTURE_CACHE_COUNT; ++i)
+		{
+			int32_t width = 0;
+			int32_t height = 0;
+			uint32_t capacity = 0;
+			RenderContextResources::GetTextureCacheDesc(i, &width, &height, &capacity);
+
+			const ITextureCache* textureCache = _resources->GetTextureCache(width, height);
+			length += sprintf_s(text + length, ARRAYSIZE(text) - length, "%s%ix%i %u/%u", i > 0 ? ", " : "",
+				width, height, textureCache->GetUsedCount(), textureCache->GetCapacity());
+		}
+
+		D2DX_LOG("Texture cache use: %s", text);
 	}
 #endif
 
@@ -469,14 +524,32 @@ void RenderContext::Present()
 	_frameTimeMs = curTime - _prevTime;
 	_prevTime = curTime;
 
+	/* The first frame has no predecessor to measure against. */
+	if (_frameCount > 0)
+	{
+		const MajorGameState majorGameState = _d2dxContext->GetMajorGameState();
+		_frameTimeHistograms[(int32_t)majorGameState].Add(_frameTimeMs);
+	}
+
 	if (_deviceContext1)
 	{
 		_deviceContext1->DiscardView(_resources->GetFramebufferRtv(RenderContextFramebuffer::Game));
 		_deviceContext1->DiscardView(_backbufferRtv.Get());
 	}
 
+	/* Preloaded textures are not marked as used in the frame that just ended, so the game can replace them. */
+	if (_textureCacheWarmStart)
+	{
+		PreloadTextures();
+	}
+
 	_resources->OnNewFrame();
 
+	if (_textureKeyLog)
+	{
+		_textureKeyLog->EndFrame();
+	}
+
 	SetRenderTargets(
 		_resources->GetFramebufferRtv(RenderContextFramebuffer::Game),
 		_resources->GetFramebufferRtv(RenderContextFramebuffer::SurfaceId)
@@ -514,6 +587,9 @@ void RenderContext::WriteToScreen(
 	int32_t height,
 	bool forCinematic)
 {
+	auto traceEventWriter = TraceEventWriter::GetInstance();
+	const int64_t traceStartTicks = traceEventWriter ? TraceEventWriter::GetTicks() : 0;
+
 	D3D11_MAPPED_SUBRESOURCE ms;
 	SetBlendState(AlphaBlend::Opaque);
 	uint32_t startVertexLocation = _vbWriteIndex;
@@ -546,6 +622,14 @@ void RenderContext::WriteToScreen(
 
 	_deviceContext->Draw(vertexCount, startVertexLocation);
 
+	if (traceEventWriter)
+	{
+		auto& traceEvent = traceEventWriter->AddEvent(TraceEventType::Complete, "WriteToScreen", "lfb", traceStartTicks, TraceEventWriter::GetTicks());
+		TraceEventWriter::AddArg(traceEvent, "width", width);
+		TraceEventWriter::AddArg(traceEvent, "height", height);
+		TraceEventWriter::AddArg(traceEvent, "forCinematic", forCinematic ? 1 : 0);
+	}
+
 	Present();
 }
 
@@ -621,18 +705,24 @@ _Use_decl_annotations_
 TextureCacheLocation RenderContext::UpdateTexture(
 	const Batch& batch,
 	const uint8_t* tmuData,
-	uint32_t tmuDataSize)
+	uint32_t tmuDataSize,
+	TextureCacheLocation lastLocation)
 {
 	if (!batch.IsValid())
 	{
 		return { -1, -1 };
 	}
 
-	const uint32_t contentKey = batch.GetHash();
+	const uint64_t contentKey = batch.GetContentKey();
 
 	ITextureCache* atlas = GetTextureCache(batch);
 
-	auto tcl = atlas->FindTexture(contentKey, -1);
+	if (_textureKeyLog)
+	{
+		_textureKeyLog->AddLookup(contentKey, batch.GetTextureWidth(), batch.GetTextureHeight(), batch.GetTextureCategory());
+	}
+
+	auto tcl = atlas->FindTexture(contentKey, atlas->GetIndex(lastLocation));
 
 	if (tcl._textureAtlas < 0)
 	{
@@ -642,6 +732,68 @@ TextureCacheLocation RenderContext::UpdateTexture(
 	return tcl;
 }
 
+void RenderContext::PreloadTextures()
+{
+	uint32_t byteCount = 0;
+
+	while (byteCount < TEXTURE_PRELOAD_BYTES_PER_FRAME)
+	{
+		const TextureCacheFileEntry* entry = _textureCacheWarmStart->GetNextEntry();
+
+		if (!entry)
+		{
+			break;
+		}
+
+		if (max(entry->width, entry->height) < 8)
+		{
+			continue;
+		}
+
+		ITextureCache* textureCache = _resources->GetTextureCache(entry->width, entry->height);
+
+		if (textureCache->GetTextureSize() == (uint32_t)(entry->width * entry->height) &&
+			textureCache->PreloadTexture(entry->contentKey, (TextureCategory)entry->category, _textureCacheWarmStart->GetPixels(*entry)))
+		{
+			++_preloadedTextureCount;
+			byteCount += textureCache->GetTextureSize();
+		}
+	}
+
+	if (_textureCacheWarmStart->IsDone())
+	{
+		if (_preloadedTextureCount > 0)
+		{
+			D2DX_LOG("Preloaded %u textures.", _preloadedTextureCount);
+		}
+
+		_textureCacheWarmStart = nullptr;
+	}
+}
+
+void RenderContext::SaveTextures()
+{
+	/* Unmaps the file, which is about to be overwritten. */
+	_textureCacheWarmStart = nullptr;
+
+	TextureCacheFileWriter writer{ _simd };
+
+	for (int32_t i = 0; i < D2DX_TEXTURE_CACHE_COUNT; ++i)
+	{
+		int32_t width = 0;
+		int32_t height = 0;
+		uint32_t capacity = 0;
+		RenderContextResources::GetTextureCacheDesc(i, &width, &height, &capacity);
+
+		_resources->GetTextureCache(width, height)->SaveTextures(writer);
+	}
+
+	if (writer.Save(TEXTURE_CACHE_FILENAME))
+	{
+		D2DX_LOG("Saved %u textures to %s.", writer.GetEntryCount(), TEXTURE_CACHE_FILENAME);
+	}
+}
+
 _Use_decl_annotations_
 void RenderContext::UpdateViewport(
 	Rect rect)
@@ -715,6 +867,11 @@ static LRESULT CALLBACK d2dxSubclassWndProc(
 			renderContext->ToggleFullscreen();
 			return 0;
 		}
+		else if (wParam == VK_F12 && (HIWORD(lParam) & KF_ALTDOWN))
+		{
+			D2DXContextFactory::GetInstance()->DumpFrameProfile();
+			return 0;
+		}
 	}
 	else if (uMsg == WM_DESTROY)
 	{
@@ -1076,3 +1233,20 @@ ScreenMode RenderContext::GetScreenMode() const
 {
 	return _screenMode;
 }
+
+_Use_decl_annotations_
+void RenderContext::GetFrameTimeStatistics(
+	MajorGameState majorGameState,
+	FrameTimeStatistics* statistics) const
+{
+	assert((int32_t)majorGameState >= 0 && majorGameState < MajorGameState::Count);
+	_frameTimeHistograms[(int32_t)majorGameState].GetStatistics(statistics);
+}
+
+void RenderContext::ResetFrameTimeStatistics()
+{
+	for (auto& frameTimeHistogram : _frameTimeHistograms)
+	{
+		frameTimeHistogram.Reset();
+	}
+}
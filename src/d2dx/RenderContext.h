@@ -22,6 +22,8 @@
 #include "ISimd.h"
 #include "ITextureCache.h"
 #include "RenderContextResources.h"
+#include "TextureCacheWarmStart.h"
+#include "TextureKeyLog.h"
 #include "Types.h"
 
 namespace d2dx
@@ -60,7 +62,7 @@ namespace d2dx
 			_In_ ID2DXContext* d2dxContext,
 			_In_ const std::shared_ptr<ISimd>& simd);
 		
-		virtual ~RenderContext() noexcept {}
+		virtual ~RenderContext() noexcept;
 
 		virtual HWND GetHWnd() const override;
 
@@ -75,7 +77,10 @@ namespace d2dx
 		virtual TextureCacheLocation UpdateTexture(
 			_In_ const Batch& batch,
 			_In_reads_(tmuDataSize) const uint8_t* tmuData,
-			_In_ uint32_t tmuDataSize) override;
+			_In_ uint32_t tmuDataSize,
+			_In_ TextureCacheLocation lastLocation) override;
+
+		virtual void FlushTextureUploads() override;
 
 		virtual void Draw(
 			_In_ const Batch& batch,
@@ -115,6 +120,12 @@ namespace d2dx
 
 		virtual ScreenMode GetScreenMode() const override;
 
+		virtual void GetFrameTimeStatistics(
+			_In_ MajorGameState majorGameState,
+			_Out_ FrameTimeStatistics* statistics) const override;
+
+		virtual void ResetFrameTimeStatistics() override;
+
 		void ClipCursor();
 		void UnclipCursor();
 
@@ -157,6 +168,10 @@ namespace d2dx
 		void SetBlendState(
 			_In_ ID3D11BlendState* blendState);
 
+		void PreloadTextures();
+
+		void SaveTextures();
+
 		struct Constants final
 		{
 			float screenSize[2] = { 0.0f, 0.0f };
@@ -188,6 +203,10 @@ namespace d2dx
 		ComPtr<IDXGISwapChain2> _swapChain2;
 		ComPtr<ID3D11RenderTargetView> _backbufferRtv;
 		std::unique_ptr<RenderContextResources> _resources;
+		std::unique_ptr<TextureKeyLog> _textureKeyLog;
+		std::unique_ptr<TextureCacheWarmStart> _textureCacheWarmStart;
+		uint32_t _preloadedTextureCount = 0;
+		bool _saveTexturesOnExit = false;
 		std::shared_ptr<ISimd> _simd;
 
 		uint32_t _frameCount = 0;
@@ -213,7 +232,8 @@ namespace d2dx
 		int64_t _timeStart;
 		bool _hasAdjustedWindowPlacement = false;
 
-		double _prevTime;
-		double _frameTimeMs;
+		double _prevTime = 0.0;
+		double _frameTimeMs = 0.0;
+		FrameTimeHistogram _frameTimeHistograms[(int32_t)MajorGameState::Count];
 	};
 }
\ No newline at end of file
@@ -18,9 +18,11 @@
 */
 #include "pch.h"
 #include "RenderContextResources.h"
+#include "Buffer.h"
 #include "Utils.h"
 #include "Types.h"
 #include "TextureCache.h"
+#include "TextureCacheBalancer.h"
 #include "DisplayVS_cso.h"
 #include "DisplayNonintegerScalePS_cso.h"
 #include "DisplayIntegerScalePS_cso.h"
@@ -52,6 +54,7 @@ RenderContextResources::RenderContextResources(
 	CreateBlendStates(device);
 	CreateFramebuffers(framebufferSize, device);
 	CreateVertexBuffer(vbSizeBytes, device);
+	CreateQuadIndexBuffer(device);
 	CreateConstantBuffer(cbSizeBytes, device);
 }
 
@@ -61,24 +64,101 @@ void RenderContextResources::OnNewFrame()
 	{
 		_textureCaches[i]->OnNewFrame();
 	}
+
+	_textureCacheBalancer->OnNewFrame();
+}
+
+void RenderContextResources::FlushTextureUploads()
+{
+	for (int32_t i = 0; i < ARRAYSIZE(_textureCaches); ++i)
+	{
+		_textureCaches[i]->FlushUploads();
+	}
 }
 
 ITextureCache* RenderContextResources::GetTextureCache(
 	int32_t textureWidth,
 	int32_t textureHeight) const
 {
-	if (textureWidth == 256 && textureHeight == 128)
+	return _textureCaches[GetTextureCacheIndex(textureWidth, textureHeight)].get();
+}
+
+/* Size classes cover aspect ratios up to 4:1 either way; more elongated textures use the 4:1 class of
+   their longest side. The capacities are starting points: TextureCacheBalancer moves capacity between
+   the classes at runtime, within the total of these. */
+static const struct
+{
+	int16_t width;
+	int16_t height;
+	uint32_t capacity;
+} textureCacheClasses[D2DX_TEXTURE_CACHE_COUNT] =
+{
+	{ 8, 8, 512 },
+	{ 16, 16, 512 },
+	{ 16, 8, 256 },
+	{ 8, 16, 256 },
+	{ 32, 32, 1024 },
+	{ 32, 16, 512 },
+	{ 16, 32, 512 },
+	{ 32, 8, 256 },
+	{ 8, 32, 256 },
+	{ 64, 64, 1024 },
+	{ 64, 32, 512 },
+	{ 32, 64, 512 },
+	{ 64, 16, 256 },
+	{ 16, 64, 256 },
+	{ 128, 128, 512 },
+	{ 128, 64, 256 },
+	{ 64, 128, 256 },
+	{ 128, 32, 128 },
+	{ 32, 128, 128 },
+	{ 256, 256, 256 },
+	{ 256, 128, 1024 },
+	{ 128, 256, 128 },
+	{ 256, 64, 128 },
+	{ 64, 256, 128 },
+};
+
+_Use_decl_annotations_
+int32_t RenderContextResources::GetTextureCacheIndex(
+	int32_t textureWidth,
+	int32_t textureHeight)
+{
+	/* Indexed by log2(height) - 3 and log2(width) - 3. */
+	static const int8_t cacheIndices[6][6] =
 	{
-		return _textureCaches[6].get();
-	}
+		{  0,  2,  7, 12, 17, 22 },
+		{  3,  1,  5, 12, 17, 22 },
+		{  8,  6,  4, 10, 17, 22 },
+		{ 13, 13, 11,  9, 15, 22 },
+		{ 18, 18, 18, 16, 14, 20 },
+		{ 23, 23, 23, 23, 21, 19 },
+	};
 
-	const int32_t longest = max(textureWidth, textureHeight);
-	assert(longest >= 8);
-	uint32_t log2Longest = 0;
-	BitScanForward((DWORD*)&log2Longest, (DWORD)longest);
-	log2Longest -= 3;
-	assert(log2Longest <= 5);
-	return _textureCaches[log2Longest].get();
+	assert(max(textureWidth, textureHeight) >= 8);
+	assert(textureWidth <= 256 && textureHeight <= 256);
+
+	/* Sides below 8 texels are stored in 8 texel slots. */
+	DWORD log2Width = 0;
+	DWORD log2Height = 0;
+	BitScanForward(&log2Width, (DWORD)max(textureWidth, 8));
+	BitScanForward(&log2Height, (DWORD)max(textureHeight, 8));
+
+	return cacheIndices[log2Height - 3][log2Width - 3];
+}
+
+_Use_decl_annotations_
+void RenderContextResources::GetTextureCacheDesc(
+	int32_t cacheIndex,
+	int32_t* width,
+	int32_t* height,
+	uint32_t* capacity)
+{
+	assert(cacheIndex >= 0 && cacheIndex < D2DX_TEXTURE_CACHE_COUNT);
+
+	*width = textureCacheClasses[cacheIndex].width;
+	*height = textureCacheClasses[cacheIndex].height;
+	*capacity = textureCacheClasses[cacheIndex].capacity;
 }
 
 void RenderContextResources::SetFramebufferSize(
@@ -198,31 +278,29 @@ void RenderContextResources::CreateTextureCaches(
 	ID3D11Device* device,
 	const std::shared_ptr<ISimd>& simd)
 {
-	static const uint32_t capacities[7] = { 512, 1024, 2048, 2048, 1024, 512, 1024 };
-
 	const uint32_t texturesPerAtlas = DetermineMaxTextureArraySize(device);
 	D2DX_LOG("The device supports %u textures per atlas.", texturesPerAtlas);
 
 	uint32_t totalSize = 0;
+	ITextureCache* textureCaches[D2DX_TEXTURE_CACHE_COUNT];
 	for (int32_t i = 0; i < ARRAYSIZE(_textureCaches); ++i)
 	{
-		int32_t width = 1U << (i + 3);
-		int32_t height = 1U << (i + 3);
-
-		if (i == 6)
-		{
-			width = 256;
-			height = 128;
-		}
+		int32_t width = 0;
+		int32_t height = 0;
+		uint32_t capacity = 0;
+		GetTextureCacheDesc(i, &width, &height, &capacity);
 
-		_textureCaches[i] = std::make_unique<TextureCache>(width, height, capacities[i], texturesPerAtlas, device, simd);
+		_textureCaches[i] = std::make_unique<TextureCache>(width, height, capacity, texturesPerAtlas, device, simd);
 
-		D2DX_DEBUG_LOG("Creating texture cache for %i x %i with capacity %u (%u kB).", width, height, capacities[i], _textureCaches[i]->GetMemoryFootprint() / 1024);
+		D2DX_DEBUG_LOG("Creating texture cache for %i x %i with capacity %u (%u kB).", width, height, capacity, width * height * capacity / 1024);
 
-		totalSize += _textureCaches[i]->GetMemoryFootprint();
+		totalSize += width * height * capacity;
+		textureCaches[i] = _textureCaches[i].get();
 	}
 
-	D2DX_LOG("Total size of texture caches is %u kB.", totalSize / 1024);
+	_textureCacheBalancer = std::make_unique<TextureCacheBalancer>(textureCaches, D2DX_TEXTURE_CACHE_COUNT);
+
+	D2DX_LOG("Total capacity of texture caches is %u kB (budget %u kB), allocated on first use.", totalSize / 1024, _textureCacheBalancer->GetBudget() / 1024);
 }
 
 _Use_decl_annotations_
@@ -548,6 +626,37 @@ void RenderContextResources::CreateVertexBuffer(
 		device->CreateBuffer(&vbDesc, NULL, &_vb));
 }
 
+_Use_decl_annotations_
+void RenderContextResources::CreateQuadIndexBuffer(
+	ID3D11Device* device)
+{
+	/* Two triangles, (0, 1, 2) and (0, 2, 3), per quad of four consecutive vertices. */
+	Buffer<uint16_t> indices(D2DX_MAX_QUADS_PER_DRAW_CALL * 6);
+
+	for (uint32_t i = 0; i < D2DX_MAX_QUADS_PER_DRAW_CALL; ++i)
+	{
+		const uint32_t baseVertex = i * 4;
+		indices.items[i * 6 + 0] = (uint16_t)baseVertex;
+		indices.items[i * 6 + 1] = (uint16_t)(baseVertex + 1);
+		indices.items[i * 6 + 2] = (uint16_t)(baseVertex + 2);
+		indices.items[i * 6 + 3] = (uint16_t)baseVertex;
+		indices.items[i * 6 + 4] = (uint16_t)(baseVertex + 2);
+		indices.items[i * 6 + 5] = (uint16_t)(baseVertex + 3);
+	}
+
+	const CD3D11_BUFFER_DESC ibDesc
+	{
+		indices.capacity * sizeof(uint16_t),
+		D3D11_BIND_INDEX_BUFFER,
+		D3D11_USAGE_IMMUTABLE
+	};
+
+	D3D11_SUBRESOURCE_DATA ibData = { indices.items, 0, 0 };
+
+	D2DX_CHECK_HR(
+		device->CreateBuffer(&ibDesc, &ibData, &_quadIb));
+}
+
 _Use_decl_annotations_
 void RenderContextResources::CreateConstantBuffer(
 	uint32_t cbSizeBytes,
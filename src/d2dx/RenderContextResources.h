@@ -19,8 +19,11 @@
 #pragma once
 
 #include "ITextureCache.h"
+#include "TextureCacheBalancer.h"
 #include "Types.h"
 
+#define D2DX_TEXTURE_CACHE_COUNT 24
+
 namespace d2dx
 {
 	enum class RenderContextSamplerState
@@ -79,6 +82,8 @@ namespace d2dx
 
 		void OnNewFrame();
 
+		void FlushTextureUploads();
+
 		void SetFramebufferSize(Size framebufferSize, ID3D11Device* device);
 
 		ID3D11InputLayout* GetInputLayout() const { return _inputLayout.Get(); }
@@ -97,6 +102,16 @@ namespace d2dx
 			int32_t textureWidth, 
 			int32_t textureHeight) const;
 
+		static int32_t GetTextureCacheIndex(
+			_In_ int32_t textureWidth,
+			_In_ int32_t textureHeight);
+
+		static void GetTextureCacheDesc(
+			_In_ int32_t cacheIndex,
+			_Out_ int32_t* width,
+			_Out_ int32_t* height,
+			_Out_ uint32_t* capacity);
+
 		ID3D11Texture1D* GetTexture1D(RenderContextTexture1D texture1d) const
 		{ 
 			return _texture1Ds[(int32_t)texture1d].texture.Get();
@@ -177,6 +192,11 @@ namespace d2dx
 			return _vb.Get();
 		}
 
+		ID3D11Buffer* GetQuadIndexBuffer() const
+		{
+			return _quadIb.Get();
+		}
+
 		ID3D11Buffer* GetConstantBuffer() const
 		{
 			return _cb.Get();
@@ -216,6 +236,9 @@ namespace d2dx
 			_In_ uint32_t vbSizeBytes,
 			_In_ ID3D11Device* device);
 
+		void CreateQuadIndexBuffer(
+			_In_ ID3D11Device* device);
+
 		void CreateConstantBuffer(
 			_In_ uint32_t cbSizeBytes,
 			_In_ ID3D11Device* device);
@@ -241,7 +264,8 @@ namespace d2dx
 		ComPtr<ID3D11Texture2D> _cinematicTexture;
 		ComPtr<ID3D11ShaderResourceView> _cinematicTextureSrv;
 
-		std::unique_ptr<ITextureCache> _textureCaches[7];
+		std::unique_ptr<ITextureCache> _textureCaches[D2DX_TEXTURE_CACHE_COUNT];
+		std::unique_ptr<TextureCacheBalancer> _textureCacheBalancer;
 
 		ComPtr<ID3D11RasterizerState> _rasterizerStateNoScissor;
 		ComPtr<ID3D11RasterizerState> _rasterizerState;
@@ -260,6 +284,7 @@ namespace d2dx
 		Size _framebufferSize;
 
 		ComPtr<ID3D11Buffer> _vb;
+		ComPtr<ID3D11Buffer> _quadIb;
 		ComPtr<ID3D11Buffer> _cb;
 	};
 }
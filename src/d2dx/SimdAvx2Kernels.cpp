@@ -0,0 +1,253 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "SimdAvx2Kernels.h"
+#include "WideHash.h"
+#include <assert.h>
+#include <immintrin.h>
+#include <intrin.h>
+#include <string.h>
+
+using namespace d2dx;
+
+/* This file is compiled with /arch:AVX2; see SimdAvx2Kernels.h for what it may include. */
+
+/* BitScanReverse64 comes from windows.h, which this file must not include. */
+static inline bool ScanReverse64(
+	_Out_ unsigned long* index,
+	_In_ uint64_t mask)
+{
+	if (_BitScanReverse(index, (unsigned long)(mask >> 32)))
+	{
+		*index += 32;
+		return true;
+	}
+
+	return _BitScanReverse(index, (unsigned long)mask) != 0;
+}
+
+_Use_decl_annotations_
+int32_t SimdAvx2Kernels::IndexOfUInt32(
+	const uint32_t* __restrict items,
+	uint32_t itemsCount,
+	uint32_t item)
+{
+	assert(items && ((uintptr_t)items & 63) == 0);
+	assert(!(itemsCount & 0x3F));
+
+	const __m256i key8 = _mm256_set1_epi32((int32_t)item);
+
+	uint32_t i = 0;
+	uint64_t res = 0;
+
+	for (; i < itemsCount; i += 64)
+	{
+		const uint32_t res0 = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(key8, _mm256_load_si256((const __m256i*) & items[i + 0]))));
+		const uint32_t res1 = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(key8, _mm256_load_si256((const __m256i*) & items[i + 8]))));
+		const uint32_t res2 = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(key8, _mm256_load_si256((const __m256i*) & items[i + 16]))));
+		const uint32_t res3 = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(key8, _mm256_load_si256((const __m256i*) & items[i + 24]))));
+		const uint32_t res4 = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(key8, _mm256_load_si256((const __m256i*) & items[i + 32]))));
+		const uint32_t res5 = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(key8, _mm256_load_si256((const __m256i*) & items[i + 40]))));
+		const uint32_t res6 = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(key8, _mm256_load_si256((const __m256i*) & items[i + 48]))));
+		const uint32_t res7 = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(key8, _mm256_load_si256((const __m256i*) & items[i + 56]))));
+
+		const uint32_t res0123 = res0 | (res1 << 8) | (res2 << 16) | (res3 << 24);
+		const uint32_t res4567 = res4 | (res5 << 8) | (res6 << 16) | (res7 << 24);
+
+		res = res0123 | ((uint64_t)res4567 << 32);
+		if (res > 0) {
+			break;
+		}
+	}
+
+	if (res > 0)
+	{
+		unsigned long bitIndex = 0;
+		if (ScanReverse64(&bitIndex, res))
+		{
+			const int32_t findIndex = i + bitIndex;
+			assert(findIndex >= 0 && findIndex < (int32_t)itemsCount);
+			assert(items[findIndex] == item);
+			return findIndex;
+		}
+	}
+
+	return -1;
+}
+
+_Use_decl_annotations_
+int32_t SimdAvx2Kernels::IndexOfUInt64(
+	const uint64_t* __restrict items,
+	uint32_t itemsCount,
+	uint64_t item)
+{
+	assert(items && ((uintptr_t)items & 63) == 0);
+	assert(!(itemsCount & 0x3F));
+
+	const __m256i key4 = _mm256_set1_epi64x((int64_t)item);
+
+	uint32_t i = 0;
+	uint32_t res = 0;
+
+	for (; i < itemsCount; i += 32)
+	{
+		const uint32_t res0 = (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(key4, _mm256_load_si256((const __m256i*) & items[i + 0]))));
+		const uint32_t res1 = (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(key4, _mm256_load_si256((const __m256i*) & items[i + 4]))));
+		const uint32_t res2 = (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(key4, _mm256_load_si256((const __m256i*) & items[i + 8]))));
+		const uint32_t res3 = (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(key4, _mm256_load_si256((const __m256i*) & items[i + 12]))));
+		const uint32_t res4 = (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(key4, _mm256_load_si256((const __m256i*) & items[i + 16]))));
+		const uint32_t res5 = (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(key4, _mm256_load_si256((const __m256i*) & items[i + 20]))));
+		const uint32_t res6 = (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(key4, _mm256_load_si256((const __m256i*) & items[i + 24]))));
+		const uint32_t res7 = (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(key4, _mm256_load_si256((const __m256i*) & items[i + 28]))));
+
+		res = res0 | (res1 << 4) | (res2 << 8) | (res3 << 12) | (res4 << 16) | (res5 << 20) | (res6 << 24) | (res7 << 28);
+		if (res > 0) {
+			break;
+		}
+	}
+
+	if (res > 0)
+	{
+		unsigned long bitIndex = 0;
+		if (_BitScanReverse(&bitIndex, res))
+		{
+			const int32_t findIndex = i + bitIndex;
+			assert(findIndex >= 0 && findIndex < (int32_t)itemsCount);
+			assert(items[findIndex] == item);
+			return findIndex;
+		}
+	}
+
+	return -1;
+}
+
+template<bool copy>
+static inline void AccumulateStripeAvx2(
+	_Inout_updates_all_(2) __m256i* acc,
+	_Out_writes_opt_(WideHash::StripeSize) uint8_t* __restrict dst,
+	_In_reads_(WideHash::StripeSize) const uint8_t* __restrict p,
+	_In_reads_(WideHash::StripeSize) const uint8_t* __restrict s)
+{
+	for (int32_t j = 0; j < 2; ++j)
+	{
+		const __m256i data = _mm256_loadu_si256((const __m256i*)(p + 32 * j));
+
+		if (copy)
+		{
+			_mm256_storeu_si256((__m256i*)(dst + 32 * j), data);
+		}
+
+		const __m256i key = _mm256_loadu_si256((const __m256i*)(s + 32 * j));
+		const __m256i dataKey = _mm256_xor_si256(data, key);
+		const __m256i dataKeyHi = _mm256_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1));
+		const __m256i product = _mm256_mul_epu32(dataKey, dataKeyHi);
+		const __m256i dataSwapped = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+		acc[j] = _mm256_add_epi64(acc[j], _mm256_add_epi64(product, dataSwapped));
+	}
+}
+
+static inline void ScrambleAvx2(
+	_Inout_updates_all_(2) __m256i* acc)
+{
+	const uint8_t* s = WideHash::GetSecret() + WideHash::ScrambleSecretOffset;
+	const __m256i prime = _mm256_set1_epi32((int32_t)WideHash::ScramblePrime);
+
+	for (int32_t j = 0; j < 2; ++j)
+	{
+		__m256i a = acc[j];
+		a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+		a = _mm256_xor_si256(a, _mm256_loadu_si256((const __m256i*)(s + 32 * j)));
+		const __m256i productLo = _mm256_mul_epu32(a, prime);
+		const __m256i productHi = _mm256_mul_epu32(_mm256_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+		acc[j] = _mm256_add_epi64(productLo, _mm256_slli_epi64(productHi, 32));
+	}
+}
+
+/* Same structure as HashBytes64Sse2, with the eight accumulator lanes in two registers. */
+template<bool copy>
+static uint64_t HashBytes64Avx2(
+	_Out_writes_opt_(size) uint8_t* __restrict dst,
+	_In_reads_(size) const uint8_t* __restrict data,
+	_In_ uint32_t size)
+{
+	if (size < WideHash::StripeSize)
+	{
+		if (copy)
+		{
+			memcpy(dst, data, size);
+		}
+
+		return WideHash::HashShort(data, size);
+	}
+
+	const uint8_t* s = WideHash::GetSecret();
+	const uint32_t blockSize = WideHash::StripeSize * WideHash::StripesPerBlock;
+	const uint32_t blockCount = (size - 1) / blockSize;
+
+	alignas(32) uint64_t acc64[8];
+	WideHash::InitAccumulators(acc64);
+
+	__m256i acc[2];
+	acc[0] = _mm256_load_si256((const __m256i*)&acc64[0]);
+	acc[1] = _mm256_load_si256((const __m256i*)&acc64[4]);
+
+	const uint8_t* p = data;
+	uint8_t* d = dst;
+
+	for (uint32_t block = 0; block < blockCount; ++block)
+	{
+		for (uint32_t stripe = 0; stripe < WideHash::StripesPerBlock; ++stripe, p += WideHash::StripeSize, d += copy ? WideHash::StripeSize : 0)
+		{
+			AccumulateStripeAvx2<copy>(acc, d, p, s + stripe * 8);
+		}
+
+		ScrambleAvx2(acc);
+	}
+
+	const uint32_t stripeCount = ((size - 1) - blockSize * blockCount) / WideHash::StripeSize;
+
+	for (uint32_t stripe = 0; stripe < stripeCount; ++stripe, p += WideHash::StripeSize, d += copy ? WideHash::StripeSize : 0)
+	{
+		AccumulateStripeAvx2<copy>(acc, d, p, s + stripe * 8);
+	}
+
+	AccumulateStripeAvx2<copy>(acc, copy ? dst + size - WideHash::StripeSize : nullptr, data + size - WideHash::StripeSize, s + WideHash::LastStripeSecretOffset);
+
+	_mm256_store_si256((__m256i*)&acc64[0], acc[0]);
+	_mm256_store_si256((__m256i*)&acc64[4], acc[1]);
+
+	return WideHash::Finalize(acc64, size);
+}
+
+_Use_decl_annotations_
+uint64_t SimdAvx2Kernels::HashBytes64(
+	const uint8_t* __restrict data,
+	uint32_t size)
+{
+	return HashBytes64Avx2<false>(nullptr, data, size);
+}
+
+_Use_decl_annotations_
+uint64_t SimdAvx2Kernels::CopyAndHashBytes64(
+	uint8_t* __restrict dst,
+	const uint8_t* __restrict src,
+	uint32_t size)
+{
+	assert(dst && src);
+	return HashBytes64Avx2<true>(dst, src, size);
+}
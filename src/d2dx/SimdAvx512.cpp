@@ -0,0 +1,58 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "SimdAvx512.h"
+#include "SimdAvx512Kernels.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+int32_t SimdAvx512::IndexOfUInt32(
+	const uint32_t* __restrict items,
+	uint32_t itemsCount,
+	uint32_t item)
+{
+	return SimdAvx512Kernels::IndexOfUInt32(items, itemsCount, item);
+}
+
+_Use_decl_annotations_
+int32_t SimdAvx512::IndexOfUInt64(
+	const uint64_t* __restrict items,
+	uint32_t itemsCount,
+	uint64_t item)
+{
+	return SimdAvx512Kernels::IndexOfUInt64(items, itemsCount, item);
+}
+
+_Use_decl_annotations_
+uint64_t SimdAvx512::HashBytes64(
+	const uint8_t* __restrict data,
+	uint32_t size)
+{
+	return SimdAvx512Kernels::HashBytes64(data, size);
+}
+
+_Use_decl_annotations_
+uint64_t SimdAvx512::CopyAndHashBytes64(
+	uint8_t* __restrict dst,
+	const uint8_t* __restrict src,
+	uint32_t size)
+{
+	return SimdAvx512Kernels::CopyAndHashBytes64(dst, src, size);
+}
@@ -0,0 +1,50 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "ISimd.h"
+
+namespace d2dx
+{
+	/* Must only be created when SimdFactory reports the CPU and OS support it. */
+	class SimdAvx512 final : public ISimd
+	{
+	public:
+		virtual ~SimdAvx512() noexcept {}
+
+		virtual int32_t IndexOfUInt32(
+			_In_reads_(itemsCount) const uint32_t* __restrict items,
+			_In_ uint32_t itemsCount,
+			_In_ uint32_t item) override;
+
+		virtual int32_t IndexOfUInt64(
+			_In_reads_(itemsCount) const uint64_t* __restrict items,
+			_In_ uint32_t itemsCount,
+			_In_ uint64_t item) override;
+
+		virtual uint64_t HashBytes64(
+			_In_reads_(size) const uint8_t* __restrict data,
+			_In_ uint32_t size) override;
+
+		virtual uint64_t CopyAndHashBytes64(
+			_Out_writes_all_(size) uint8_t* __restrict dst,
+			_In_reads_(size) const uint8_t* __restrict src,
+			_In_ uint32_t size) override;
+	};
+}
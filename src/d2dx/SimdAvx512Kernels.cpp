@@ -0,0 +1,234 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "SimdAvx512Kernels.h"
+#include "WideHash.h"
+#include <assert.h>
+#include <immintrin.h>
+#include <intrin.h>
+#include <string.h>
+
+using namespace d2dx;
+
+/* This file is compiled with /arch:AVX512 and only uses AVX-512F instructions; see
+   SimdAvx512Kernels.h for what it may include. */
+
+/* BitScanReverse64 comes from windows.h, which this file must not include. */
+static inline bool ScanReverse64(
+	_Out_ unsigned long* index,
+	_In_ uint64_t mask)
+{
+	if (_BitScanReverse(index, (unsigned long)(mask >> 32)))
+	{
+		*index += 32;
+		return true;
+	}
+
+	return _BitScanReverse(index, (unsigned long)mask) != 0;
+}
+
+_Use_decl_annotations_
+int32_t SimdAvx512Kernels::IndexOfUInt32(
+	const uint32_t* __restrict items,
+	uint32_t itemsCount,
+	uint32_t item)
+{
+	assert(items && ((uintptr_t)items & 63) == 0);
+	assert(!(itemsCount & 0x3F));
+
+	const __m512i key16 = _mm512_set1_epi32((int32_t)item);
+
+	uint32_t i = 0;
+	uint64_t res = 0;
+
+	for (; i < itemsCount; i += 64)
+	{
+		const uint32_t res0 = (uint32_t)_mm512_cmpeq_epi32_mask(key16, _mm512_load_si512((const void*)&items[i + 0]));
+		const uint32_t res1 = (uint32_t)_mm512_cmpeq_epi32_mask(key16, _mm512_load_si512((const void*)&items[i + 16]));
+		const uint32_t res2 = (uint32_t)_mm512_cmpeq_epi32_mask(key16, _mm512_load_si512((const void*)&items[i + 32]));
+		const uint32_t res3 = (uint32_t)_mm512_cmpeq_epi32_mask(key16, _mm512_load_si512((const void*)&items[i + 48]));
+
+		res = (res0 | (res1 << 16)) | ((uint64_t)(res2 | (res3 << 16)) << 32);
+		if (res > 0) {
+			break;
+		}
+	}
+
+	if (res > 0)
+	{
+		unsigned long bitIndex = 0;
+		if (ScanReverse64(&bitIndex, res))
+		{
+			const int32_t findIndex = i + bitIndex;
+			assert(findIndex >= 0 && findIndex < (int32_t)itemsCount);
+			assert(items[findIndex] == item);
+			return findIndex;
+		}
+	}
+
+	return -1;
+}
+
+_Use_decl_annotations_
+int32_t SimdAvx512Kernels::IndexOfUInt64(
+	const uint64_t* __restrict items,
+	uint32_t itemsCount,
+	uint64_t item)
+{
+	assert(items && ((uintptr_t)items & 63) == 0);
+	assert(!(itemsCount & 0x3F));
+
+	const __m512i key8 = _mm512_set1_epi64((int64_t)item);
+
+	uint32_t i = 0;
+	uint32_t res = 0;
+
+	for (; i < itemsCount; i += 32)
+	{
+		const uint32_t res0 = (uint32_t)_mm512_cmpeq_epi64_mask(key8, _mm512_load_si512((const void*)&items[i + 0]));
+		const uint32_t res1 = (uint32_t)_mm512_cmpeq_epi64_mask(key8, _mm512_load_si512((const void*)&items[i + 8]));
+		const uint32_t res2 = (uint32_t)_mm512_cmpeq_epi64_mask(key8, _mm512_load_si512((const void*)&items[i + 16]));
+		const uint32_t res3 = (uint32_t)_mm512_cmpeq_epi64_mask(key8, _mm512_load_si512((const void*)&items[i + 24]));
+
+		res = res0 | (res1 << 8) | (res2 << 16) | (res3 << 24);
+		if (res > 0) {
+			break;
+		}
+	}
+
+	if (res > 0)
+	{
+		unsigned long bitIndex = 0;
+		if (_BitScanReverse(&bitIndex, res))
+		{
+			const int32_t findIndex = i + bitIndex;
+			assert(findIndex >= 0 && findIndex < (int32_t)itemsCount);
+			assert(items[findIndex] == item);
+			return findIndex;
+		}
+	}
+
+	return -1;
+}
+
+template<bool copy>
+static inline __m512i AccumulateStripeAvx512(
+	_In_ __m512i acc,
+	_Out_writes_opt_(WideHash::StripeSize) uint8_t* __restrict dst,
+	_In_reads_(WideHash::StripeSize) const uint8_t* __restrict p,
+	_In_reads_(WideHash::StripeSize) const uint8_t* __restrict s)
+{
+	const __m512i data = _mm512_loadu_si512((const void*)p);
+
+	if (copy)
+	{
+		_mm512_storeu_si512((void*)dst, data);
+	}
+
+	const __m512i key = _mm512_loadu_si512((const void*)s);
+	const __m512i dataKey = _mm512_xor_si512(data, key);
+	const __m512i dataKeyHi = _mm512_shuffle_epi32(dataKey, (_MM_PERM_ENUM)_MM_SHUFFLE(0, 3, 0, 1));
+	const __m512i product = _mm512_mul_epu32(dataKey, dataKeyHi);
+	const __m512i dataSwapped = _mm512_shuffle_epi32(data, (_MM_PERM_ENUM)_MM_SHUFFLE(1, 0, 3, 2));
+	return _mm512_add_epi64(acc, _mm512_add_epi64(product, dataSwapped));
+}
+
+static inline __m512i ScrambleAvx512(
+	_In_ __m512i acc)
+{
+	const uint8_t* s = WideHash::GetSecret() + WideHash::ScrambleSecretOffset;
+	const __m512i prime = _mm512_set1_epi32((int32_t)WideHash::ScramblePrime);
+
+	__m512i a = acc;
+	a = _mm512_xor_si512(a, _mm512_srli_epi64(a, 47));
+	a = _mm512_xor_si512(a, _mm512_loadu_si512((const void*)s));
+	const __m512i productLo = _mm512_mul_epu32(a, prime);
+	const __m512i productHi = _mm512_mul_epu32(_mm512_shuffle_epi32(a, (_MM_PERM_ENUM)_MM_SHUFFLE(0, 3, 0, 1)), prime);
+	return _mm512_add_epi64(productLo, _mm512_slli_epi64(productHi, 32));
+}
+
+/* Same structure as HashBytes64Sse2; a whole stripe fits in one register. */
+template<bool copy>
+static uint64_t HashBytes64Avx512(
+	_Out_writes_opt_(size) uint8_t* __restrict dst,
+	_In_reads_(size) const uint8_t* __restrict data,
+	_In_ uint32_t size)
+{
+	if (size < WideHash::StripeSize)
+	{
+		if (copy)
+		{
+			memcpy(dst, data, size);
+		}
+
+		return WideHash::HashShort(data, size);
+	}
+
+	const uint8_t* s = WideHash::GetSecret();
+	const uint32_t blockSize = WideHash::StripeSize * WideHash::StripesPerBlock;
+	const uint32_t blockCount = (size - 1) / blockSize;
+
+	alignas(64) uint64_t acc64[8];
+	WideHash::InitAccumulators(acc64);
+
+	__m512i acc = _mm512_load_si512((const void*)acc64);
+
+	const uint8_t* p = data;
+	uint8_t* d = dst;
+
+	for (uint32_t block = 0; block < blockCount; ++block)
+	{
+		for (uint32_t stripe = 0; stripe < WideHash::StripesPerBlock; ++stripe, p += WideHash::StripeSize, d += copy ? WideHash::StripeSize : 0)
+		{
+			acc = AccumulateStripeAvx512<copy>(acc, d, p, s + stripe * 8);
+		}
+
+		acc = ScrambleAvx512(acc);
+	}
+
+	const uint32_t stripeCount = ((size - 1) - blockSize * blockCount) / WideHash::StripeSize;
+
+	for (uint32_t stripe = 0; stripe < stripeCount; ++stripe, p += WideHash::StripeSize, d += copy ? WideHash::StripeSize : 0)
+	{
+		acc = AccumulateStripeAvx512<copy>(acc, d, p, s + stripe * 8);
+	}
+
+	acc = AccumulateStripeAvx512<copy>(acc, copy ? dst + size - WideHash::StripeSize : nullptr, data + size - WideHash::StripeSize, s + WideHash::LastStripeSecretOffset);
+
+	_mm512_store_si512((void*)acc64, acc);
+
+	return WideHash::Finalize(acc64, size);
+}
+
+_Use_decl_annotations_
+uint64_t SimdAvx512Kernels::HashBytes64(
+	const uint8_t* __restrict data,
+	uint32_t size)
+{
+	return HashBytes64Avx512<false>(nullptr, data, size);
+}
+
+_Use_decl_annotations_
+uint64_t SimdAvx512Kernels::CopyAndHashBytes64(
+	uint8_t* __restrict dst,
+	const uint8_t* __restrict src,
+	uint32_t size)
+{
+	assert(dst && src);
+	return HashBytes64Avx512<true>(dst, src, size);
+}
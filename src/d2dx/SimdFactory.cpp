@@ -0,0 +1,129 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "SimdFactory.h"
+#include "SimdAvx2.h"
+#include "SimdAvx512.h"
+#include "SimdSse2.h"
+#include "Utils.h"
+#include <intrin.h>
+
+using namespace d2dx;
+
+static SimdLevel DetectSupportedLevel()
+{
+	int32_t regs[4] = { 0 };
+
+	__cpuid(regs, 0);
+	const int32_t maxLeaf = regs[0];
+
+	if (maxLeaf < 7)
+	{
+		return SimdLevel::Sse2;
+	}
+
+	__cpuid(regs, 1);
+	const bool hasFma = (regs[2] & (1 << 12)) != 0;
+	const bool hasOsXsave = (regs[2] & (1 << 27)) != 0;
+	const bool hasAvx = (regs[2] & (1 << 28)) != 0;
+
+	if (!hasOsXsave || !hasAvx)
+	{
+		return SimdLevel::Sse2;
+	}
+
+	/* The OS must save the YMM (and for AVX-512 also the opmask and ZMM) state. */
+	const uint64_t xcr0 = _xgetbv(0);
+	const bool osSavesYmm = (xcr0 & 0x06) == 0x06;
+	const bool osSavesZmm = (xcr0 & 0xE6) == 0xE6;
+
+	__cpuidex(regs, 7, 0);
+	const uint32_t features7 = (uint32_t)regs[1];
+	const bool hasBmi1 = (features7 & (1U << 3)) != 0;
+	const bool hasAvx2 = (features7 & (1U << 5)) != 0;
+	const bool hasBmi2 = (features7 & (1U << 8)) != 0;
+	const bool hasAvx512F = (features7 & (1U << 16)) != 0;
+	const bool hasAvx512DQ = (features7 & (1U << 17)) != 0;
+	const bool hasAvx512CD = (features7 & (1U << 28)) != 0;
+	const bool hasAvx512BW = (features7 & (1U << 30)) != 0;
+	const bool hasAvx512VL = (features7 & (1U << 31)) != 0;
+
+	/* /arch:AVX2 lets the compiler emit FMA, BMI1 and BMI2 instructions, and /arch:AVX512 adds
+	   the BW, DQ, CD and VL subsets, so every one of them must be present. */
+	const bool supportsAvx2 = hasAvx2 && hasFma && hasBmi1 && hasBmi2 && osSavesYmm;
+	const bool supportsAvx512 = supportsAvx2 &&
+		hasAvx512F && hasAvx512DQ && hasAvx512CD && hasAvx512BW && hasAvx512VL && osSavesZmm;
+
+	if (supportsAvx512)
+	{
+		return SimdLevel::Avx512;
+	}
+
+	if (supportsAvx2)
+	{
+		return SimdLevel::Avx2;
+	}
+
+	return SimdLevel::Sse2;
+}
+
+SimdLevel SimdFactory::GetSupportedLevel()
+{
+	static const SimdLevel supportedLevel = DetectSupportedLevel();
+	return supportedLevel;
+}
+
+_Use_decl_annotations_
+std::shared_ptr<ISimd> SimdFactory::Create(
+	SimdLevel level)
+{
+	assert(level <= GetSupportedLevel());
+
+	switch (level)
+	{
+	case SimdLevel::Avx512:
+		return std::make_shared<SimdAvx512>();
+	case SimdLevel::Avx2:
+		return std::make_shared<SimdAvx2>();
+	default:
+		return std::make_shared<SimdSse2>();
+	}
+}
+
+std::shared_ptr<ISimd> SimdFactory::CreateBest()
+{
+	const SimdLevel level = GetSupportedLevel();
+	D2DX_LOG("Using %s SIMD implementation.", GetName(level));
+	return Create(level);
+}
+
+_Use_decl_annotations_
+const char* SimdFactory::GetName(
+	SimdLevel level)
+{
+	switch (level)
+	{
+	case SimdLevel::Avx512:
+		return "SimdAvx512";
+	case SimdLevel::Avx2:
+		return "SimdAvx2";
+	default:
+		return "SimdSse2";
+	}
+}
@@ -0,0 +1,47 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "ISimd.h"
+
+namespace d2dx
+{
+	enum class SimdLevel
+	{
+		Sse2 = 0,
+		Avx2 = 1,
+		Avx512 = 2,
+		Count = 3
+	};
+
+	class SimdFactory final
+	{
+	public:
+		/* Returns the widest level supported by both the CPU and the OS. */
+		static SimdLevel GetSupportedLevel();
+
+		static std::shared_ptr<ISimd> Create(
+			_In_ SimdLevel level);
+
+		static std::shared_ptr<ISimd> CreateBest();
+
+		static const char* GetName(
+			_In_ SimdLevel level);
+	};
+}
@@ -18,6 +18,7 @@
 */
 #include "pch.h"
 #include "SimdSse2.h"
+#include "WideHash.h"
 
 using namespace d2dx;
 using namespace std;
@@ -117,3 +118,193 @@ int32_t SimdSse2::IndexOfUInt32(
 
 	return -1;
 }
+
+_Use_decl_annotations_
+int32_t SimdSse2::IndexOfUInt64(
+	const uint64_t* __restrict items,
+	uint32_t itemsCount,
+	uint64_t item)
+{
+	assert(items && ((uintptr_t)items & 63) == 0);
+	assert(!(itemsCount & 0x3F));
+
+	const __m128i key2 = _mm_set_epi32((int32_t)(item >> 32), (int32_t)item, (int32_t)(item >> 32), (int32_t)item);
+
+	uint32_t i = 0;
+	uint32_t res = 0;
+
+	/* SSE2 lacks a 64-bit compare, so compare the 32-bit halves and AND each with its
+	   neighbour. Sixteen keys are tested per iteration. */
+
+	for (; i < itemsCount; i += 16)
+	{
+		const __m128i cmp0 = _mm_cmpeq_epi32(key2, _mm_load_si128((const __m128i*) & items[i + 0]));
+		const __m128i cmp1 = _mm_cmpeq_epi32(key2, _mm_load_si128((const __m128i*) & items[i + 2]));
+		const __m128i cmp2 = _mm_cmpeq_epi32(key2, _mm_load_si128((const __m128i*) & items[i + 4]));
+		const __m128i cmp3 = _mm_cmpeq_epi32(key2, _mm_load_si128((const __m128i*) & items[i + 6]));
+		const __m128i cmp4 = _mm_cmpeq_epi32(key2, _mm_load_si128((const __m128i*) & items[i + 8]));
+		const __m128i cmp5 = _mm_cmpeq_epi32(key2, _mm_load_si128((const __m128i*) & items[i + 10]));
+		const __m128i cmp6 = _mm_cmpeq_epi32(key2, _mm_load_si128((const __m128i*) & items[i + 12]));
+		const __m128i cmp7 = _mm_cmpeq_epi32(key2, _mm_load_si128((const __m128i*) & items[i + 14]));
+
+		const __m128i eq0 = _mm_and_si128(cmp0, _mm_shuffle_epi32(cmp0, _MM_SHUFFLE(2, 3, 0, 1)));
+		const __m128i eq1 = _mm_and_si128(cmp1, _mm_shuffle_epi32(cmp1, _MM_SHUFFLE(2, 3, 0, 1)));
+		const __m128i eq2 = _mm_and_si128(cmp2, _mm_shuffle_epi32(cmp2, _MM_SHUFFLE(2, 3, 0, 1)));
+		const __m128i eq3 = _mm_and_si128(cmp3, _mm_shuffle_epi32(cmp3, _MM_SHUFFLE(2, 3, 0, 1)));
+		const __m128i eq4 = _mm_and_si128(cmp4, _mm_shuffle_epi32(cmp4, _MM_SHUFFLE(2, 3, 0, 1)));
+		const __m128i eq5 = _mm_and_si128(cmp5, _mm_shuffle_epi32(cmp5, _MM_SHUFFLE(2, 3, 0, 1)));
+		const __m128i eq6 = _mm_and_si128(cmp6, _mm_shuffle_epi32(cmp6, _MM_SHUFFLE(2, 3, 0, 1)));
+		const __m128i eq7 = _mm_and_si128(cmp7, _mm_shuffle_epi32(cmp7, _MM_SHUFFLE(2, 3, 0, 1)));
+
+		/* Each 64-bit lane is now all ones or all zeros; pack down to one byte per key. */
+		const __m128i pack01 = _mm_packs_epi32(eq0, eq1);
+		const __m128i pack23 = _mm_packs_epi32(eq2, eq3);
+		const __m128i pack45 = _mm_packs_epi32(eq4, eq5);
+		const __m128i pack67 = _mm_packs_epi32(eq6, eq7);
+
+		const __m128i pack0123 = _mm_packs_epi16(pack01, pack23);
+		const __m128i pack4567 = _mm_packs_epi16(pack45, pack67);
+
+		res = (uint32_t)_mm_movemask_epi8(pack0123) | ((uint32_t)_mm_movemask_epi8(pack4567) << 16);
+		if (res > 0) {
+			break;
+		}
+	}
+
+	if (res > 0)
+	{
+		DWORD bitIndex = 0;
+		if (BitScanReverse(&bitIndex, res))
+		{
+			const int32_t findIndex = i + (bitIndex >> 1);
+			assert(findIndex >= 0 && findIndex < (int32_t)itemsCount);
+			assert(items[findIndex] == item);
+			return findIndex;
+		}
+	}
+
+	return -1;
+}
+
+template<bool copy>
+static inline void AccumulateStripeSse2(
+	_Inout_updates_all_(4) __m128i* acc,
+	_Out_writes_opt_(WideHash::StripeSize) uint8_t* __restrict dst,
+	_In_reads_(WideHash::StripeSize) const uint8_t* __restrict p,
+	_In_reads_(WideHash::StripeSize) const uint8_t* __restrict s)
+{
+	for (int32_t j = 0; j < 4; ++j)
+	{
+		const __m128i data = _mm_loadu_si128((const __m128i*)(p + 16 * j));
+
+		if (copy)
+		{
+			_mm_storeu_si128((__m128i*)(dst + 16 * j), data);
+		}
+
+		const __m128i key = _mm_loadu_si128((const __m128i*)(s + 16 * j));
+		const __m128i dataKey = _mm_xor_si128(data, key);
+		const __m128i dataKeyHi = _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1));
+		const __m128i product = _mm_mul_epu32(dataKey, dataKeyHi);
+		const __m128i dataSwapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+		acc[j] = _mm_add_epi64(acc[j], _mm_add_epi64(product, dataSwapped));
+	}
+}
+
+static inline void ScrambleSse2(
+	_Inout_updates_all_(4) __m128i* acc)
+{
+	const uint8_t* s = WideHash::GetSecret() + WideHash::ScrambleSecretOffset;
+	const __m128i prime = _mm_set1_epi32((int32_t)WideHash::ScramblePrime);
+
+	for (int32_t j = 0; j < 4; ++j)
+	{
+		__m128i a = acc[j];
+		a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+		a = _mm_xor_si128(a, _mm_loadu_si128((const __m128i*)(s + 16 * j)));
+		const __m128i productLo = _mm_mul_epu32(a, prime);
+		const __m128i productHi = _mm_mul_epu32(_mm_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+		acc[j] = _mm_add_epi64(productLo, _mm_slli_epi64(productHi, 32));
+	}
+}
+
+/* When copy is set, every byte loaded for hashing is also stored to dst, so the data is
+   only streamed through the cache once. */
+template<bool copy>
+static uint64_t HashBytes64Sse2(
+	_Out_writes_opt_(size) uint8_t* __restrict dst,
+	_In_reads_(size) const uint8_t* __restrict data,
+	_In_ uint32_t size)
+{
+	if (size < WideHash::StripeSize)
+	{
+		if (copy)
+		{
+			memcpy(dst, data, size);
+		}
+
+		return WideHash::HashShort(data, size);
+	}
+
+	const uint8_t* s = WideHash::GetSecret();
+	const uint32_t blockSize = WideHash::StripeSize * WideHash::StripesPerBlock;
+	const uint32_t blockCount = (size - 1) / blockSize;
+
+	alignas(16) uint64_t acc64[8];
+	WideHash::InitAccumulators(acc64);
+
+	__m128i acc[4];
+	for (int32_t j = 0; j < 4; ++j)
+	{
+		acc[j] = _mm_load_si128((const __m128i*)&acc64[2 * j]);
+	}
+
+	const uint8_t* p = data;
+	uint8_t* d = dst;
+
+	for (uint32_t block = 0; block < blockCount; ++block)
+	{
+		for (uint32_t stripe = 0; stripe < WideHash::StripesPerBlock; ++stripe, p += WideHash::StripeSize, d += copy ? WideHash::StripeSize : 0)
+		{
+			AccumulateStripeSse2<copy>(acc, d, p, s + stripe * 8);
+		}
+
+		ScrambleSse2(acc);
+	}
+
+	const uint32_t stripeCount = ((size - 1) - blockSize * blockCount) / WideHash::StripeSize;
+
+	for (uint32_t stripe = 0; stripe < stripeCount; ++stripe, p += WideHash::StripeSize, d += copy ? WideHash::StripeSize : 0)
+	{
+		AccumulateStripeSse2<copy>(acc, d, p, s + stripe * 8);
+	}
+
+	/* The last stripe ends at the end of the data and may overlap the one before it, so it
+	   also covers the tail of the copy. */
+	AccumulateStripeSse2<copy>(acc, copy ? dst + size - WideHash::StripeSize : nullptr, data + size - WideHash::StripeSize, s + WideHash::LastStripeSecretOffset);
+
+	for (int32_t j = 0; j < 4; ++j)
+	{
+		_mm_store_si128((__m128i*)&acc64[2 * j], acc[j]);
+	}
+
+	return WideHash::Finalize(acc64, size);
+}
+
+_Use_decl_annotations_
+uint64_t SimdSse2::HashBytes64(
+	const uint8_t* __restrict data,
+	uint32_t size)
+{
+	return HashBytes64Sse2<false>(nullptr, data, size);
+}
+
+_Use_decl_annotations_
+uint64_t SimdSse2::CopyAndHashBytes64(
+	uint8_t* __restrict dst,
+	const uint8_t* __restrict src,
+	uint32_t size)
+{
+	assert(dst && src);
+	return HashBytes64Sse2<true>(dst, src, size);
+}
@@ -39,7 +39,7 @@ void SurfaceIdTracker::OnNewFrame()
 }
 
 _Use_decl_annotations_
-void SurfaceIdTracker::UpdateBatchSurfaceId(
+Rect SurfaceIdTracker::UpdateBatchSurfaceId(
 	Batch& batch,
 	MajorGameState majorGameState,
 	Size gameSize,
@@ -50,20 +50,11 @@ void SurfaceIdTracker::UpdateBatchSurfaceId(
 
 	uint64_t drawCallTexture = (uint64_t)batch.GetTextureIndex() | ((uint64_t)batch.GetTextureAtlas() << 32ULL);
 
-	int32_t minx = INT_MAX;
-	int32_t miny = INT_MAX;
-	int32_t maxx = INT_MIN;
-	int32_t maxy = INT_MIN;
-
-	for (uint32_t i = 0; i < batch.GetVertexCount(); ++i)
-	{
-		int32_t x = (int32_t)batchVertices[i].GetX();
-		int32_t y = (int32_t)batchVertices[i].GetY();
-		minx = min(minx, x);
-		miny = min(miny, y);
-		maxx = max(maxx, x);
-		maxy = max(maxy, y);
-	}
+	const Rect bounds = GetBounds(batchVertices, (int32_t)batch.GetVertexCount());
+	const int32_t minx = bounds.offset.x;
+	const int32_t miny = bounds.offset.y;
+	const int32_t maxx = bounds.offset.x + bounds.size.width;
+	const int32_t maxy = bounds.offset.y + bounds.size.height;
 
 	if (majorGameState != MajorGameState::InGame)
 	{
@@ -147,13 +138,35 @@ void SurfaceIdTracker::UpdateBatchSurfaceId(
 		batchVertices[i].SetSurfaceId(surfaceId);
 	}
 	_previousDrawCallTexture = drawCallTexture;
-	_previousDrawCallRect.offset.x = minx;
-	_previousDrawCallRect.offset.y = miny;
-	_previousDrawCallRect.size.width = maxx - minx;
-	_previousDrawCallRect.size.height = maxy - miny;
+	_previousDrawCallRect = bounds;
+
+	return bounds;
 }
 
 int32_t SurfaceIdTracker::GetCurrentSurfaceId() const
 {
 	return _nextSurfaceId;
 }
+
+_Use_decl_annotations_
+Rect SurfaceIdTracker::GetBounds(
+	const Vertex* vertices,
+	int32_t vertexCount)
+{
+	int32_t minx = INT_MAX;
+	int32_t miny = INT_MAX;
+	int32_t maxx = INT_MIN;
+	int32_t maxy = INT_MIN;
+
+	for (int32_t i = 0; i < vertexCount; ++i)
+	{
+		int32_t x = (int32_t)vertices[i].GetX();
+		int32_t y = (int32_t)vertices[i].GetY();
+		minx = min(minx, x);
+		miny = min(miny, y);
+		maxx = max(maxx, x);
+		maxy = max(maxy, y);
+	}
+
+	return { minx, miny, maxx - minx, maxy - miny };
+}
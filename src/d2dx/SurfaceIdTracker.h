@@ -34,7 +34,8 @@ namespace d2dx
 
 		void OnNewFrame();
 
-		void UpdateBatchSurfaceId(
+		/* Returns the screen bounding box of the batch. */
+		Rect UpdateBatchSurfaceId(
 			_Inout_ Batch& batch,
 			_In_ MajorGameState majorGameState,
 			_In_ Size gameSize,
@@ -43,6 +44,11 @@ namespace d2dx
 
 		int32_t GetCurrentSurfaceId() const;
 
+		/* The bounding box is inclusive: its size is the difference between the extreme coordinates. */
+		static Rect GetBounds(
+			_In_reads_(vertexCount) const Vertex* vertices,
+			_In_ int32_t vertexCount);
+
 	private:
 		std::shared_ptr<IGameHelper> _gameHelper;
 		int32_t _nextSurfaceId = 0;
@@ -20,7 +20,6 @@
 #include "D2DXContext.h"
 #include "Utils.h"
 #include "TextureCache.h"
-#include "TextureCachePolicyBitPmru.h"
 
 using namespace d2dx;
 using namespace std;
@@ -32,66 +31,159 @@ TextureCache::TextureCache(
 	uint32_t capacity,
 	uint32_t texturesPerAtlas,
 	ID3D11Device* device,
-	const std::shared_ptr<ISimd>& simd)
+	const std::shared_ptr<ISimd>& simd,
+	TextureCachePolicyType policyType)
 {
-	assert(_atlasCount <= 4);
+	assert(!(capacity & 63));
+	assert(texturesPerAtlas > 0 && !(texturesPerAtlas & (texturesPerAtlas - 1)));
 
 	_width = width;
 	_height = height;
 	_capacity = capacity;
+	_maxCapacity = (texturesPerAtlas * ARRAYSIZE(_textures)) & ~63U;
 	_texturesPerAtlas = texturesPerAtlas;
-	_atlasCount = (int32_t)max(1, capacity / texturesPerAtlas);
-	_policy = TextureCachePolicyBitPmru(capacity, simd);
+	_policy = TextureCachePolicyFactory::Create(policyType, capacity, simd);
+
+	/* Room for at least 16 textures per frame before a staged upload has to be submitted early. */
+	const uint32_t uploadPixelCapacity = max(256U * 1024U, 16U * width * height);
+	_uploadRing = TextureUploadRing(uploadPixelCapacity, uploadPixelCapacity / (width * height));
+
+	assert(_capacity <= _maxCapacity);
+
+	sprintf_s(_traceName, "TextureCache %ix%i", width, height);
 
 #ifndef D2DX_UNITTEST
+	_device = device;
+	device->GetImmediateContext(&_deviceContext);
+	assert(_deviceContext);
+#endif
+
+	UpdateAtlases();
+}
+
+void TextureCache::UpdateAtlases()
+{
+	const int32_t atlasCount = (int32_t)max(1U, (_capacity + _texturesPerAtlas - 1) / _texturesPerAtlas);
+	assert(atlasCount <= (int32_t)ARRAYSIZE(_textures));
+
+	_atlasCount = atlasCount;
 
-	CD3D11_TEXTURE2D_DESC desc
+	/* Atlases are created on the first insert into one of their slots (see EnsureAtlas). When the
+	   capacity changes, the atlases that exist are recreated with the new slice count, and the
+	   slices they keep are copied. */
+	for (int32_t atlas = 0; atlas < (int32_t)ARRAYSIZE(_textures); ++atlas)
 	{
-		DXGI_FORMAT_R8_UINT,
-		(UINT)width,
-		(UINT)height,
-		_texturesPerAtlas,
-		1U,
-		D3D11_BIND_SHADER_RESOURCE,
-		D3D11_USAGE_DEFAULT
-	};
+		if (_atlasSliceCounts[atlas] > 0 && _atlasSliceCounts[atlas] != GetAtlasSliceCount(atlas))
+		{
+			CreateAtlas(atlas);
+		}
+	}
+}
+
+_Use_decl_annotations_
+uint32_t TextureCache::GetAtlasSliceCount(
+	int32_t atlas) const
+{
+	return atlas < _atlasCount ? min(_texturesPerAtlas, _capacity - atlas * _texturesPerAtlas) : 0;
+}
 
-	uint32_t capacityPerPartition = _capacity;
+_Use_decl_annotations_
+void TextureCache::EnsureAtlas(
+	int32_t atlas)
+{
+	assert(atlas >= 0 && atlas < _atlasCount);
 
-	for (int32_t partition = 0; partition < 4; ++partition)
+	if (_atlasSliceCounts[atlas] == 0)
 	{
-		D2DX_CHECK_HR(device->CreateTexture2D(&desc, nullptr, &_textures[partition]));
-		D2DX_CHECK_HR(device->CreateShaderResourceView(_textures[partition].Get(), NULL, _srvs[partition].GetAddressOf()));
+		CreateAtlas(atlas);
 	}
+}
 
-	device->GetImmediateContext(&_deviceContext);
-	assert(_deviceContext);
+_Use_decl_annotations_
+void TextureCache::CreateAtlas(
+	int32_t atlas)
+{
+	const uint32_t sliceCount = GetAtlasSliceCount(atlas);
+
+#ifndef D2DX_UNITTEST
+	ComPtr<ID3D11Texture2D> texture;
+	ComPtr<ID3D11ShaderResourceView> srv;
+
+	if (sliceCount > 0)
+	{
+		CD3D11_TEXTURE2D_DESC desc
+		{
+			DXGI_FORMAT_R8_UINT,
+			(UINT)_width,
+			(UINT)_height,
+			sliceCount,
+			1U,
+			D3D11_BIND_SHADER_RESOURCE,
+			D3D11_USAGE_DEFAULT
+		};
+
+		D2DX_CHECK_HR(_device->CreateTexture2D(&desc, nullptr, &texture));
+		D2DX_CHECK_HR(_device->CreateShaderResourceView(texture.Get(), NULL, srv.GetAddressOf()));
+
+		const uint32_t keptSliceCount = min(sliceCount, _atlasSliceCounts[atlas]);
+
+		for (uint32_t slice = 0; slice < keptSliceCount; ++slice)
+		{
+			_deviceContext->CopySubresourceRegion(texture.Get(), slice, 0, 0, 0, _textures[atlas].Get(), slice, nullptr);
+		}
+	}
+
+	_textures[atlas] = texture;
+	_srvs[atlas] = srv;
 #endif
+
+	_atlasSliceCounts[atlas] = sliceCount;
 }
 
 uint32_t TextureCache::GetMemoryFootprint() const
 {
-	return _width * _height * _texturesPerAtlas * _atlasCount;
+	uint32_t sliceCount = 0;
+
+	for (int32_t atlas = 0; atlas < (int32_t)ARRAYSIZE(_textures); ++atlas)
+	{
+		sliceCount += _atlasSliceCounts[atlas];
+	}
+
+	return _width * _height * sliceCount;
 }
 
 _Use_decl_annotations_
 TextureCacheLocation TextureCache::FindTexture(
-	uint32_t contentKey,
+	uint64_t contentKey,
 	int32_t lastIndex)
 {
-	const int32_t index = _policy.Find(contentKey, lastIndex);
+	const int32_t index = _policy->Find(contentKey, lastIndex);
+
+	++_frameStatistics.lookupCount;
 
 	if (index < 0)
 	{
+		++_frameStatistics.missCount;
 		return { -1, -1 };
 	}
 
+	if (index == lastIndex)
+	{
+		++_frameStatistics.hintHitCount;
+	}
+	else
+	{
+		++_frameStatistics.searchHitCount;
+	}
+
+	++_hitCounts[(int32_t)_policy->GetCategory(index)];
+
 	return { (int16_t)(index / _texturesPerAtlas), (int16_t)(index & (_texturesPerAtlas - 1)) };
 }
 
 _Use_decl_annotations_
 TextureCacheLocation TextureCache::InsertTexture(
-	uint32_t contentKey,
+	uint64_t contentKey,
 	const Batch& batch,
 	const uint8_t* tmuData,
 	uint32_t tmuDataSize)
@@ -99,41 +191,208 @@ TextureCacheLocation TextureCache::InsertTexture(
 	assert(batch.IsValid() && batch.GetTextureWidth() > 0 && batch.GetTextureHeight() > 0);
 
 	bool evicted = false;
-	int32_t replacementIndex = _policy.Insert(contentKey, evicted);
+	int32_t replacementIndex = _policy->Insert(contentKey, batch.GetTextureCategory(), evicted);
+
+	++_missCounts[(int32_t)batch.GetTextureCategory()];
 
 	if (evicted)
 	{
 		D2DX_DEBUG_LOG("Evicted %ix%i texture %i from cache.", batch.GetTextureWidth(), batch.GetTextureHeight(), replacementIndex);
 	}
 
-#ifndef D2DX_UNITTEST
-	CD3D11_BOX box;
-	box.left = 0;
-	box.top = 0;
-	box.right = batch.GetTextureWidth();
-	box.bottom = batch.GetTextureHeight();
-	box.front = 0;
-	box.back = 1;
+	_frameStatistics.evictionCount += evicted ? 1 : 0;
+	_frameStatistics.uploadedBytes += (uint32_t)(batch.GetTextureWidth() * batch.GetTextureHeight());
+
+	auto traceEventWriter = TraceEventWriter::GetInstance();
+	if (traceEventWriter)
+	{
+		const int64_t ticks = TraceEventWriter::GetTicks();
+		auto& traceEvent = traceEventWriter->AddEvent(TraceEventType::Instant, evicted ? "Evict" : "Insert", "texturecache", ticks, ticks);
+		TraceEventWriter::AddArg(traceEvent, "width", _width);
+		TraceEventWriter::AddArg(traceEvent, "height", _height);
+		TraceEventWriter::AddArg(traceEvent, "index", replacementIndex);
+	}
 
 	const uint8_t* pData = tmuData + batch.GetTextureStartAddress();
+	assert(batch.GetTextureStartAddress() + (uint32_t)(batch.GetTextureWidth() * batch.GetTextureHeight()) <= tmuDataSize);
 
-	_deviceContext->UpdateSubresource(_textures[replacementIndex / _texturesPerAtlas].Get(), replacementIndex & (_texturesPerAtlas - 1), &box, pData, batch.GetTextureWidth(), 0);
-#endif
+	StageUpload(replacementIndex, batch.GetTextureWidth(), batch.GetTextureHeight(), pData);
 
 	return { (int16_t)(replacementIndex / _texturesPerAtlas), (int16_t)(replacementIndex & (_texturesPerAtlas - 1)) };
 }
 
+_Use_decl_annotations_
+bool TextureCache::PreloadTexture(
+	uint64_t contentKey,
+	TextureCategory category,
+	const uint8_t* pixels)
+{
+	assert(contentKey != 0);
+
+	if (_policy->Find(contentKey, -1) >= 0)
+	{
+		return false;
+	}
+
+	const int32_t index = _policy->InsertFree(contentKey, category);
+
+	if (index < 0)
+	{
+		return false;
+	}
+
+	_frameStatistics.uploadedBytes += (uint32_t)(_width * _height);
+
+	StageUpload(index, _width, _height, pixels);
+
+	return true;
+}
+
+_Use_decl_annotations_
+void TextureCache::SaveTextures(
+	TextureCacheFileWriter& writer)
+{
+	FlushUploads();
+
+#ifndef D2DX_UNITTEST
+	for (int32_t atlas = 0; atlas < _atlasCount; ++atlas)
+	{
+		/* Atlases that were never created hold no textures. */
+		const uint32_t sliceCount = _atlasSliceCounts[atlas];
+
+		if (sliceCount == 0)
+		{
+			continue;
+		}
+
+		CD3D11_TEXTURE2D_DESC desc
+		{
+			DXGI_FORMAT_R8_UINT,
+			(UINT)_width,
+			(UINT)_height,
+			sliceCount,
+			1U,
+			0U,
+			D3D11_USAGE_STAGING,
+			D3D11_CPU_ACCESS_READ
+		};
+
+		ComPtr<ID3D11Texture2D> stagingTexture;
+		D2DX_CHECK_HR(_device->CreateTexture2D(&desc, nullptr, &stagingTexture));
+		_deviceContext->CopyResource(stagingTexture.Get(), _textures[atlas].Get());
+
+		for (uint32_t slice = 0; slice < sliceCount; ++slice)
+		{
+			const int32_t index = (int32_t)(atlas * _texturesPerAtlas + slice);
+			const uint64_t contentKey = _policy->GetContentKey(index);
+
+			if (!contentKey)
+			{
+				continue;
+			}
+
+			D3D11_MAPPED_SUBRESOURCE mappedSubresource = { };
+			D2DX_CHECK_HR(_deviceContext->Map(stagingTexture.Get(), slice, D3D11_MAP_READ, 0, &mappedSubresource));
+			writer.AddTexture(contentKey, _width, _height, _policy->GetCategory(index), (const uint8_t*)mappedSubresource.pData, mappedSubresource.RowPitch);
+			_deviceContext->Unmap(stagingTexture.Get(), slice);
+		}
+	}
+#endif
+}
+
+_Use_decl_annotations_
+void TextureCache::StageUpload(
+	int32_t index,
+	int32_t width,
+	int32_t height,
+	const uint8_t* pixels)
+{
+	EnsureAtlas(index / (int32_t)_texturesPerAtlas);
+
+	if (!_uploadRing.Stage(index, width, height, pixels))
+	{
+		/* The ring is full; submit what is staged and start over. */
+		FlushUploads();
+		_uploadRing.Stage(index, width, height, pixels);
+	}
+}
+
 _Use_decl_annotations_
 ID3D11ShaderResourceView* TextureCache::GetSrv(
 	uint32_t textureAtlas) const
 {
-	assert(textureAtlas >= 0 && textureAtlas < (uint32_t)_atlasCount);
+	assert(textureAtlas >= 0 && textureAtlas < (uint32_t)_atlasCount && _atlasSliceCounts[textureAtlas] > 0);
 	return _srvs[textureAtlas].Get();
 }
 
+_Use_decl_annotations_
+int32_t TextureCache::GetIndex(
+	TextureCacheLocation location) const
+{
+	return location._textureAtlas >= 0 ? location._textureAtlas * (int32_t)_texturesPerAtlas + location._textureIndex : -1;
+}
+
+void TextureCache::FlushUploads()
+{
+	const uint32_t uploadCount = _uploadRing.Coalesce();
+
+#ifndef D2DX_UNITTEST
+	for (uint32_t i = 0; i < uploadCount; ++i)
+	{
+		const TextureUpload& upload = _uploadRing.GetUpload(i);
+
+		CD3D11_BOX box;
+		box.left = 0;
+		box.top = 0;
+		box.right = upload.width;
+		box.bottom = upload.height;
+		box.front = 0;
+		box.back = 1;
+
+		_deviceContext->UpdateSubresource(_textures[upload.slot / _texturesPerAtlas].Get(), upload.slot & (_texturesPerAtlas - 1), &box, _uploadRing.GetPixels(upload), upload.width, 0);
+	}
+#endif
+
+	_uploadRing.Clear();
+}
+
 void TextureCache::OnNewFrame()
 {
-	_policy.OnNewFrame();
+	const uint32_t usedInFrameCount = _policy->GetUsedInFrameCount();
+	_peakUsedInFrameCount = max(usedInFrameCount, _peakUsedInFrameCount - (_peakUsedInFrameCount >> 6));
+	_evictionRate += ((float)_frameStatistics.evictionCount - _evictionRate) * (1.0f / 16.0f);
+
+	_policy->OnNewFrame();
+
+	_frameStatistics.resetCount = _policy->GetResetCount() - _frameStartResetCount;
+	_frameStatistics.usedCount = _policy->GetUsedCount();
+	_frameStatistics.capacity = _capacity;
+	_frameStartResetCount = _policy->GetResetCount();
+
+	_cumulativeStatistics.lookupCount += _frameStatistics.lookupCount;
+	_cumulativeStatistics.hintHitCount += _frameStatistics.hintHitCount;
+	_cumulativeStatistics.searchHitCount += _frameStatistics.searchHitCount;
+	_cumulativeStatistics.missCount += _frameStatistics.missCount;
+	_cumulativeStatistics.evictionCount += _frameStatistics.evictionCount;
+	_cumulativeStatistics.resetCount += _frameStatistics.resetCount;
+	_cumulativeStatistics.uploadedBytes += _frameStatistics.uploadedBytes;
+	_cumulativeStatistics.usedCount = _frameStatistics.usedCount;
+	_cumulativeStatistics.capacity = _frameStatistics.capacity;
+
+	auto traceEventWriter = TraceEventWriter::GetInstance();
+	if (traceEventWriter)
+	{
+		const int64_t ticks = TraceEventWriter::GetTicks();
+		auto& traceEvent = traceEventWriter->AddEvent(TraceEventType::Counter, _traceName, "texturecache", ticks, ticks);
+		TraceEventWriter::AddArg(traceEvent, "lookups", _frameStatistics.lookupCount);
+		TraceEventWriter::AddArg(traceEvent, "misses", _frameStatistics.missCount);
+		TraceEventWriter::AddArg(traceEvent, "evictions", _frameStatistics.evictionCount);
+		TraceEventWriter::AddArg(traceEvent, "used", _frameStatistics.usedCount);
+		TraceEventWriter::AddArg(traceEvent, "capacity", _frameStatistics.capacity);
+	}
+
+	_lastFrameStatistics = _frameStatistics;
+	_frameStatistics = {};
 }
 
 _Use_decl_annotations_
@@ -164,5 +423,84 @@ void TextureCache::CopyPixels(
 
 uint32_t TextureCache::GetUsedCount() const
 {
-	return _policy.GetUsedCount();
+	return _policy->GetUsedCount();
+}
+
+uint32_t TextureCache::GetTextureSize() const
+{
+	return (uint32_t)(_width * _height);
+}
+
+uint32_t TextureCache::GetCapacity() const
+{
+	return _capacity;
+}
+
+uint32_t TextureCache::GetMaxCapacity() const
+{
+	return _maxCapacity;
+}
+
+_Use_decl_annotations_
+void TextureCache::SetCapacity(
+	uint32_t capacity)
+{
+	assert(!(capacity & 63) && capacity >= 64 && capacity <= _maxCapacity);
+
+	if (capacity == _capacity)
+	{
+		return;
+	}
+
+	const uint32_t oldCapacity = _capacity;
+
+	/* Staged uploads may target slots that are about to go away. */
+	FlushUploads();
+
+	_capacity = capacity;
+	_policy->SetCapacity(capacity);
+	_peakUsedInFrameCount = min(_peakUsedInFrameCount, capacity);
+
+	UpdateAtlases();
+
+	D2DX_LOG("Resized %ix%i texture cache from %u to %u entries (%u kB allocated).",
+		_width, _height, oldCapacity, capacity, GetMemoryFootprint() / 1024);
+}
+
+float TextureCache::GetEvictionRate() const
+{
+	return _evictionRate;
+}
+
+uint32_t TextureCache::GetPeakUsedInFrameCount() const
+{
+	return _peakUsedInFrameCount;
+}
+
+_Use_decl_annotations_
+void TextureCache::GetStatistics(
+	TextureCacheStatistics* lastFrame,
+	TextureCacheStatistics* cumulative) const
+{
+	if (lastFrame)
+	{
+		*lastFrame = _lastFrameStatistics;
+	}
+
+	if (cumulative)
+	{
+		*cumulative = _cumulativeStatistics;
+	}
+}
+
+_Use_decl_annotations_
+void TextureCache::GetPartitionStatistics(
+	TextureCategory category,
+	TextureCachePartitionStatistics* statistics) const
+{
+	assert(category >= TextureCategory::Unknown && category < TextureCategory::Count);
+
+	statistics->hitCount = _hitCounts[(int32_t)category];
+	statistics->missCount = _missCounts[(int32_t)category];
+	statistics->residentCount = _policy->GetCategoryCount(category);
 }
@@ -19,7 +19,10 @@
 #pragma once
 
 #include "ITextureCache.h"
-#include "TextureCachePolicyBitPmru.h"
+#include "TextureCacheFile.h"
+#include "TextureCachePolicyFactory.h"
+#include "TextureUploadRing.h"
+#include "TraceEventWriter.h"
 
 namespace d2dx
 {
@@ -32,30 +35,82 @@ namespace d2dx
 			_In_ uint32_t capacity,
 			_In_ uint32_t texturesPerAtlas,
 			_In_ ID3D11Device* device,
-			_In_ const std::shared_ptr<ISimd>& simd);
+			_In_ const std::shared_ptr<ISimd>& simd,
+			_In_ TextureCachePolicyType policyType = TextureCachePolicyType::BitPmru);
 		
 		virtual ~TextureCache() noexcept {}
 
 		virtual void OnNewFrame() override;
 
+		virtual void FlushUploads() override;
+
 		virtual TextureCacheLocation FindTexture(
-			_In_ uint32_t contentKey,
+			_In_ uint64_t contentKey,
 			_In_ int32_t lastIndex) override;
 
 		virtual TextureCacheLocation InsertTexture(
-			_In_ uint32_t contentKey,
+			_In_ uint64_t contentKey,
 			_In_ const Batch& batch,
 			_In_reads_(tmuDataSize) const uint8_t* tmuData,
 			_In_ uint32_t tmuDataSize) override;
 		
+		virtual bool PreloadTexture(
+			_In_ uint64_t contentKey,
+			_In_ TextureCategory category,
+			_In_reads_(GetTextureSize()) const uint8_t* pixels) override;
+
+		virtual void SaveTextures(
+			_Inout_ TextureCacheFileWriter& writer) override;
+
 		virtual ID3D11ShaderResourceView* GetSrv(
 			_In_ uint32_t atlasIndex) const override;
+
+		virtual int32_t GetIndex(
+			_In_ TextureCacheLocation location) const override;
 		
 		virtual uint32_t GetMemoryFootprint() const override;
 		
 		virtual uint32_t GetUsedCount() const override;
 
+		virtual uint32_t GetTextureSize() const override;
+
+		virtual uint32_t GetCapacity() const override;
+
+		virtual uint32_t GetMaxCapacity() const override;
+
+		virtual void SetCapacity(
+			_In_ uint32_t capacity) override;
+
+		virtual float GetEvictionRate() const override;
+
+		virtual uint32_t GetPeakUsedInFrameCount() const override;
+
+		virtual void GetStatistics(
+			_Out_opt_ TextureCacheStatistics* lastFrame,
+			_Out_opt_ TextureCacheStatistics* cumulative) const override;
+
+		virtual void GetPartitionStatistics(
+			_In_ TextureCategory category,
+			_Out_ TextureCachePartitionStatistics* statistics) const override;
+
 	private:
+		void UpdateAtlases();
+
+		uint32_t GetAtlasSliceCount(
+			_In_ int32_t atlas) const;
+
+		void EnsureAtlas(
+			_In_ int32_t atlas);
+
+		void CreateAtlas(
+			_In_ int32_t atlas);
+
+		void StageUpload(
+			_In_ int32_t index,
+			_In_ int32_t width,
+			_In_ int32_t height,
+			_In_reads_(width * height) const uint8_t* pixels);
+
 		void CopyPixels(
 			_In_ int32_t srcWidth,
 			_In_ int32_t srcHeight,
@@ -67,11 +122,24 @@ namespace d2dx
 		int32_t _width = 0;
 		int32_t _height = 0;
 		uint32_t _capacity = 0;
+		uint32_t _maxCapacity = 0;
 		uint32_t _texturesPerAtlas = 0;
 		int32_t _atlasCount = 0;
+		ComPtr<ID3D11Device> _device;
 		ComPtr<ID3D11DeviceContext> _deviceContext;
 		ComPtr<ID3D11Texture2D> _textures[4];
 		ComPtr<ID3D11ShaderResourceView> _srvs[4];
-		TextureCachePolicyBitPmru _policy;
+		uint32_t _atlasSliceCounts[4] = {};
+		std::unique_ptr<ITextureCachePolicy> _policy;
+		TextureUploadRing _uploadRing;
+		char _traceName[D2DX_TRACE_EVENT_MAX_NAME_LENGTH];
+		TextureCacheStatistics _frameStatistics = {};
+		TextureCacheStatistics _lastFrameStatistics = {};
+		TextureCacheStatistics _cumulativeStatistics = {};
+		uint32_t _frameStartResetCount = 0;
+		float _evictionRate = 0.0f;
+		uint32_t _peakUsedInFrameCount = 0;
+		uint32_t _hitCounts[(int32_t)TextureCategory::Count] = {};
+		uint32_t _missCounts[(int32_t)TextureCategory::Count] = {};
 	};
 }
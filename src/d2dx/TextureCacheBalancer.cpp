@@ -0,0 +1,188 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "TextureCacheBalancer.h"
+
+using namespace d2dx;
+
+/* A cache is hot once its recent peak use within one frame plus the evictions over one
+   interval reach this fraction of its capacity. */
+static const float HotPressure = 0.75f;
+
+_Use_decl_annotations_
+TextureCacheBalancer::TextureCacheBalancer(
+	ITextureCache* const* caches,
+	uint32_t cacheCount)
+{
+	assert(cacheCount <= MaxCacheCount);
+
+	_cacheCount = cacheCount;
+
+	for (uint32_t i = 0; i < cacheCount; ++i)
+	{
+		assert(caches[i]);
+		_caches[i] = caches[i];
+		_minCapacities[i] = max(64U, (caches[i]->GetCapacity() / 4) & ~63U);
+		_budget += caches[i]->GetCapacity() * caches[i]->GetTextureSize();
+	}
+}
+
+void TextureCacheBalancer::OnNewFrame()
+{
+	bool isAnyCacheSaturated = false;
+
+	for (uint32_t i = 0; i < _cacheCount; ++i)
+	{
+		isAnyCacheSaturated |= _caches[i]->GetPeakUsedInFrameCount() >= _caches[i]->GetCapacity();
+	}
+
+	/* A cache that had every entry used within the last frame is about to start thrashing, so
+	   don't wait for the end of the interval. */
+	if (++_frameCount % RebalanceInterval && !isAnyCacheSaturated)
+	{
+		return;
+	}
+
+	Rebalance();
+}
+
+void TextureCacheBalancer::Rebalance()
+{
+	int32_t hottest = -1;
+	float hottestPressure = HotPressure;
+
+	for (uint32_t i = 0; i < _cacheCount; ++i)
+	{
+		const float pressure = GetPressure(i);
+
+		if (_caches[i]->GetCapacity() < _caches[i]->GetMaxCapacity() && pressure >= hottestPressure)
+		{
+			hottest = (int32_t)i;
+			hottestPressure = pressure;
+		}
+	}
+
+	if (hottest < 0)
+	{
+		return;
+	}
+
+	ITextureCache* hotCache = _caches[hottest];
+	const uint32_t capacity = hotCache->GetCapacity();
+	const uint32_t textureSize = hotCache->GetTextureSize();
+	uint32_t growCount = min(GetStep(capacity), hotCache->GetMaxCapacity() - capacity);
+	uint32_t available = 0;
+
+	for (;;)
+	{
+		const uint32_t allocatedSize = GetAllocatedSize();
+		available = _budget > allocatedSize ? _budget - allocatedSize : 0;
+
+		if (available >= growCount * textureSize)
+		{
+			break;
+		}
+
+		int32_t coldest = -1;
+		float coldestPressure = 0.0f;
+
+		for (uint32_t i = 0; i < _cacheCount; ++i)
+		{
+			const float pressure = GetPressure(i);
+
+			if ((int32_t)i != hottest && GetShrinkableCount(i) > 0 && (coldest < 0 || pressure < coldestPressure))
+			{
+				coldest = (int32_t)i;
+				coldestPressure = pressure;
+			}
+		}
+
+		if (coldest < 0)
+		{
+			break;
+		}
+
+		_caches[coldest]->SetCapacity(_caches[coldest]->GetCapacity() - GetShrinkableCount(coldest));
+	}
+
+	growCount = min(growCount, (available / textureSize) & ~63U);
+
+	if (growCount > 0)
+	{
+		hotCache->SetCapacity(capacity + growCount);
+	}
+}
+
+uint32_t TextureCacheBalancer::GetBudget() const
+{
+	return _budget;
+}
+
+uint32_t TextureCacheBalancer::GetAllocatedSize() const
+{
+	uint32_t allocatedSize = 0;
+
+	for (uint32_t i = 0; i < _cacheCount; ++i)
+	{
+		allocatedSize += _caches[i]->GetCapacity() * _caches[i]->GetTextureSize();
+	}
+
+	return allocatedSize;
+}
+
+_Use_decl_annotations_
+float TextureCacheBalancer::GetPressure(
+	uint32_t cacheIndex) const
+{
+	const ITextureCache* cache = _caches[cacheIndex];
+	const float evictionsPerInterval = cache->GetEvictionRate() * RebalanceInterval;
+	return (cache->GetPeakUsedInFrameCount() + evictionsPerInterval) / cache->GetCapacity();
+}
+
+_Use_decl_annotations_
+uint32_t TextureCacheBalancer::GetShrinkableCount(
+	uint32_t cacheIndex) const
+{
+	const ITextureCache* cache = _caches[cacheIndex];
+	const uint32_t capacity = cache->GetCapacity();
+	const uint32_t peakUsedInFrameCount = cache->GetPeakUsedInFrameCount();
+
+	/* Only idle caches are shrunk, and they keep twice their recent peak. */
+	if (cache->GetEvictionRate() * RebalanceInterval >= 1.0f ||
+		peakUsedInFrameCount > capacity / 2)
+	{
+		return 0;
+	}
+
+	const uint32_t floorCapacity = max(_minCapacities[cacheIndex], (peakUsedInFrameCount * 2 + 63) & ~63U);
+
+	if (capacity <= floorCapacity)
+	{
+		return 0;
+	}
+
+	return min(GetStep(capacity), capacity - floorCapacity);
+}
+
+_Use_decl_annotations_
+uint32_t TextureCacheBalancer::GetStep(
+	uint32_t capacity)
+{
+	return max(64U, (capacity / 4) & ~63U);
+}
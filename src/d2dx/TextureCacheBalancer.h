@@ -0,0 +1,69 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "ITextureCache.h"
+
+namespace d2dx
+{
+	/*
+		Moves texture cache capacity between size classes at runtime. The capacities the caches
+		were created with define a total budget (in texture bytes); every RebalanceInterval frames
+		the class under the most pressure (entries used within a single frame approaching its
+		capacity, or steady evictions) is grown, and if the budget is exhausted, idle classes are
+		shrunk to make room. A class that saturates within a frame is rebalanced right away.
+	*/
+	class TextureCacheBalancer final
+	{
+	public:
+		static constexpr uint32_t MaxCacheCount = 32;
+		static constexpr uint32_t RebalanceInterval = 16;
+
+		TextureCacheBalancer(
+			_In_reads_(cacheCount) ITextureCache* const* caches,
+			_In_ uint32_t cacheCount);
+
+		~TextureCacheBalancer() noexcept {}
+
+		/* Call after the caches have been told about the new frame. */
+		void OnNewFrame();
+
+		void Rebalance();
+
+		uint32_t GetBudget() const;
+
+		uint32_t GetAllocatedSize() const;
+
+	private:
+		float GetPressure(
+			_In_ uint32_t cacheIndex) const;
+
+		uint32_t GetShrinkableCount(
+			_In_ uint32_t cacheIndex) const;
+
+		static uint32_t GetStep(
+			_In_ uint32_t capacity);
+
+		ITextureCache* _caches[MaxCacheCount] = {};
+		uint32_t _minCapacities[MaxCacheCount] = {};
+		uint32_t _cacheCount = 0;
+		uint32_t _budget = 0;
+		uint32_t _frameCount = 0;
+	};
+}
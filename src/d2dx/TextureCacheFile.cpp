@@ -0,0 +1,233 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "TextureCacheFile.h"
+#include "Utils.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+TextureCacheFileWriter::TextureCacheFileWriter(
+	const std::shared_ptr<ISimd>& simd) :
+	_simd{ simd }
+{
+}
+
+_Use_decl_annotations_
+void TextureCacheFileWriter::AddTexture(
+	uint64_t contentKey,
+	int32_t width,
+	int32_t height,
+	TextureCategory category,
+	const uint8_t* pixels,
+	uint32_t pitch)
+{
+	assert(contentKey != 0);
+	assert(width > 0 && width <= 256 && height > 0 && height <= 256 && pitch >= (uint32_t)width);
+
+	/* Pixel offsets are relative to the pixel area until Save. */
+	const size_t pixelOffset = _pixels.size();
+	const size_t pixelSize = (size_t)(width * height);
+	_pixels.resize(pixelOffset + ((pixelSize + D2DX_TEXTURE_CACHE_FILE_ALIGNMENT - 1) & ~(size_t)(D2DX_TEXTURE_CACHE_FILE_ALIGNMENT - 1)));
+
+	uint8_t* dstPixels = _pixels.data() + pixelOffset;
+
+	for (int32_t y = 0; y < height; ++y)
+	{
+		memcpy(dstPixels + y * width, pixels + y * pitch, width);
+	}
+
+	TextureCacheFileEntry entry = { };
+	entry.contentKey = contentKey;
+	entry.checksum = _simd->HashBytes64(dstPixels, (uint32_t)pixelSize);
+	entry.pixelOffset = (uint32_t)pixelOffset;
+	entry.width = (uint16_t)width;
+	entry.height = (uint16_t)height;
+	entry.category = (uint8_t)category;
+	_entries.push_back(entry);
+}
+
+uint32_t TextureCacheFileWriter::GetEntryCount() const
+{
+	return (uint32_t)_entries.size();
+}
+
+_Use_decl_annotations_
+bool TextureCacheFileWriter::Save(
+	const char* filename) const
+{
+	const uint32_t pixelsStart = (uint32_t)(sizeof(TextureCacheFileHeader) + _entries.size() * sizeof(TextureCacheFileEntry));
+	static_assert(!(sizeof(TextureCacheFileHeader) % D2DX_TEXTURE_CACHE_FILE_ALIGNMENT), "header keeps the pixels aligned");
+	static_assert(!(sizeof(TextureCacheFileEntry) % D2DX_TEXTURE_CACHE_FILE_ALIGNMENT), "entries keep the pixels aligned");
+
+	TextureCacheFileHeader header = { };
+	header.magic = D2DX_TEXTURE_CACHE_FILE_MAGIC;
+	header.version = D2DX_TEXTURE_CACHE_FILE_VERSION;
+	header.hashCheck = GetHashCheck(_simd.get());
+	header.fileSize = pixelsStart + _pixels.size();
+	header.entryCount = (uint32_t)_entries.size();
+
+	std::vector<TextureCacheFileEntry> entries{ _entries };
+
+	for (auto& entry : entries)
+	{
+		entry.pixelOffset += pixelsStart;
+	}
+
+	FILE* file = nullptr;
+
+	if (fopen_s(&file, filename, "wb") != 0)
+	{
+		D2DX_LOG("Failed to open %s for writing.", filename);
+		return false;
+	}
+
+	bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+
+	if (success && !entries.empty())
+	{
+		success = fwrite(entries.data(), sizeof(TextureCacheFileEntry), entries.size(), file) == entries.size();
+	}
+
+	if (success && !_pixels.empty())
+	{
+		success = fwrite(_pixels.data(), 1, _pixels.size(), file) == _pixels.size();
+	}
+
+	fclose(file);
+
+	if (!success)
+	{
+		D2DX_LOG("Failed to write %s.", filename);
+		remove(filename);
+	}
+
+	return success;
+}
+
+_Use_decl_annotations_
+uint64_t TextureCacheFileWriter::GetHashCheck(
+	ISimd* simd)
+{
+	alignas(16) uint8_t pattern[256];
+
+	for (uint32_t i = 0; i < ARRAYSIZE(pattern); ++i)
+	{
+		pattern[i] = (uint8_t)(i * 167 + 13);
+	}
+
+	return simd->HashBytes64(pattern, ARRAYSIZE(pattern));
+}
+
+_Use_decl_annotations_
+TextureCacheFileView::TextureCacheFileView(
+	const char* filename)
+{
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+
+	LARGE_INTEGER fileSize = { };
+
+	if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart >= (LONGLONG)sizeof(TextureCacheFileHeader))
+	{
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (mapping)
+		{
+			_data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			_size = _data ? (uint64_t)fileSize.QuadPart : 0;
+			CloseHandle(mapping);
+		}
+	}
+
+	CloseHandle(file);
+}
+
+TextureCacheFileView::~TextureCacheFileView() noexcept
+{
+	if (_data)
+	{
+		UnmapViewOfFile(_data);
+		_data = nullptr;
+	}
+}
+
+_Use_decl_annotations_
+bool TextureCacheFileView::Validate(
+	ISimd* simd) const
+{
+	if (!_data)
+	{
+		return false;
+	}
+
+	const TextureCacheFileHeader* header = (const TextureCacheFileHeader*)_data;
+
+	if (header->magic != D2DX_TEXTURE_CACHE_FILE_MAGIC ||
+		header->version != D2DX_TEXTURE_CACHE_FILE_VERSION ||
+		header->fileSize != _size ||
+		header->hashCheck != TextureCacheFileWriter::GetHashCheck(simd) ||
+		header->entryCount > (_size - sizeof(TextureCacheFileHeader)) / sizeof(TextureCacheFileEntry))
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < header->entryCount; ++i)
+	{
+		const TextureCacheFileEntry& entry = GetEntry(i);
+		const uint64_t pixelSize = (uint64_t)entry.width * entry.height;
+
+		if (entry.contentKey == 0 ||
+			entry.width == 0 || entry.width > 256 ||
+			entry.height == 0 || entry.height > 256 ||
+			entry.category >= (uint8_t)TextureCategory::Count ||
+			(entry.pixelOffset & (D2DX_TEXTURE_CACHE_FILE_ALIGNMENT - 1)) ||
+			entry.pixelOffset + pixelSize > _size ||
+			simd->HashBytes64(_data + entry.pixelOffset, (uint32_t)pixelSize) != entry.checksum)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+uint32_t TextureCacheFileView::GetEntryCount() const
+{
+	return _data ? ((const TextureCacheFileHeader*)_data)->entryCount : 0;
+}
+
+_Use_decl_annotations_
+const TextureCacheFileEntry& TextureCacheFileView::GetEntry(
+	uint32_t index) const
+{
+	assert(index < GetEntryCount());
+	return ((const TextureCacheFileEntry*)(_data + sizeof(TextureCacheFileHeader)))[index];
+}
+
+_Use_decl_annotations_
+const uint8_t* TextureCacheFileView::GetPixels(
+	const TextureCacheFileEntry& entry) const
+{
+	return _data + entry.pixelOffset;
+}
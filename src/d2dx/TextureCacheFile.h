@@ -0,0 +1,123 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "ISimd.h"
+#include "Types.h"
+
+#include <vector>
+
+#define D2DX_TEXTURE_CACHE_FILE_MAGIC 0x43543244 /* "D2TC" */
+#define D2DX_TEXTURE_CACHE_FILE_VERSION 1
+#define D2DX_TEXTURE_CACHE_FILE_ALIGNMENT 16
+
+namespace d2dx
+{
+#pragma pack(push, 1)
+
+	/*
+		The file is the header, followed by entryCount entries, followed by the pixels of the
+		entries. All offsets are from the start of the file, so the file can be used in place
+		through a read-only mapping.
+	*/
+	struct TextureCacheFileHeader final
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t hashCheck;			/* ISimd::HashBytes64 of a fixed pattern; content keys from another hash are useless. */
+		uint64_t fileSize;
+		uint32_t entryCount;
+		uint32_t reserved;
+	};
+
+	/* One texture, stored at the size of the cache slot it occupied. */
+	struct TextureCacheFileEntry final
+	{
+		uint64_t contentKey;
+		uint64_t checksum;			/* ISimd::HashBytes64 of the pixels. */
+		uint32_t pixelOffset;		/* Aligned to D2DX_TEXTURE_CACHE_FILE_ALIGNMENT. */
+		uint16_t width;
+		uint16_t height;
+		uint8_t category;
+		uint8_t reserved[7];
+	};
+
+#pragma pack(pop)
+
+	static_assert(sizeof(TextureCacheFileHeader) == 32, "sizeof(TextureCacheFileHeader) == 32");
+	static_assert(sizeof(TextureCacheFileEntry) == 32, "sizeof(TextureCacheFileEntry) == 32");
+
+	class TextureCacheFileWriter final
+	{
+	public:
+		TextureCacheFileWriter(
+			_In_ const std::shared_ptr<ISimd>& simd);
+
+		void AddTexture(
+			_In_ uint64_t contentKey,
+			_In_ int32_t width,
+			_In_ int32_t height,
+			_In_ TextureCategory category,
+			_In_reads_(pitch * height) const uint8_t* pixels,
+			_In_ uint32_t pitch);
+
+		uint32_t GetEntryCount() const;
+
+		bool Save(
+			_In_z_ const char* filename) const;
+
+		static uint64_t GetHashCheck(
+			_In_ ISimd* simd);
+
+	private:
+		std::shared_ptr<ISimd> _simd;
+		std::vector<TextureCacheFileEntry> _entries;
+		std::vector<uint8_t> _pixels;
+	};
+
+	/* A read-only mapping of a texture cache file. Validate must succeed before the entries are used. */
+	class TextureCacheFileView final
+	{
+	public:
+		TextureCacheFileView(
+			_In_z_ const char* filename);
+
+		~TextureCacheFileView() noexcept;
+
+		TextureCacheFileView(const TextureCacheFileView&) = delete;
+
+		TextureCacheFileView& operator=(const TextureCacheFileView&) = delete;
+
+		/* Checks the header and the bounds and checksum of every entry, touching all of the file. */
+		bool Validate(
+			_In_ ISimd* simd) const;
+
+		uint32_t GetEntryCount() const;
+
+		const TextureCacheFileEntry& GetEntry(
+			_In_ uint32_t index) const;
+
+		const uint8_t* GetPixels(
+			_In_ const TextureCacheFileEntry& entry) const;
+
+	private:
+		const uint8_t* _data = nullptr;
+		uint64_t _size = 0;
+	};
+}
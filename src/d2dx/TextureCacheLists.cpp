@@ -0,0 +1,203 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "TextureCacheLists.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+TextureCacheSlotLists::TextureCacheSlotLists(
+	uint32_t capacity) :
+	_capacity{ capacity },
+	_previous{ capacity, true, -1 },
+	_next{ capacity, true, -1 },
+	_lists{ capacity, true, -1 }
+{
+	for (uint32_t i = 0; i < MaxListCount; ++i)
+	{
+		_front[i] = -1;
+		_back[i] = -1;
+		_sizes[i] = 0;
+	}
+}
+
+_Use_decl_annotations_
+void TextureCacheSlotLists::PushFront(
+	uint32_t list,
+	int32_t slot)
+{
+	assert(list < MaxListCount);
+	assert(slot >= 0 && slot < (int32_t)_capacity && _lists.items[slot] < 0);
+
+	_previous.items[slot] = -1;
+	_next.items[slot] = _front[list];
+
+	if (_front[list] >= 0)
+	{
+		_previous.items[_front[list]] = slot;
+	}
+	else
+	{
+		_back[list] = slot;
+	}
+
+	_front[list] = slot;
+	_lists.items[slot] = (int8_t)list;
+	++_sizes[list];
+}
+
+_Use_decl_annotations_
+void TextureCacheSlotLists::Remove(
+	int32_t slot)
+{
+	assert(slot >= 0 && slot < (int32_t)_capacity);
+
+	const int32_t list = _lists.items[slot];
+
+	if (list < 0)
+	{
+		return;
+	}
+
+	const int32_t previous = _previous.items[slot];
+	const int32_t next = _next.items[slot];
+
+	if (previous >= 0)
+	{
+		_next.items[previous] = next;
+	}
+	else
+	{
+		_front[list] = next;
+	}
+
+	if (next >= 0)
+	{
+		_previous.items[next] = previous;
+	}
+	else
+	{
+		_back[list] = previous;
+	}
+
+	_previous.items[slot] = -1;
+	_next.items[slot] = -1;
+	_lists.items[slot] = -1;
+	--_sizes[list];
+}
+
+_Use_decl_annotations_
+int32_t TextureCacheSlotLists::GetList(
+	int32_t slot) const
+{
+	assert(slot >= 0 && slot < (int32_t)_capacity);
+	return _lists.items[slot];
+}
+
+_Use_decl_annotations_
+int32_t TextureCacheSlotLists::GetBack(
+	uint32_t list) const
+{
+	assert(list < MaxListCount);
+	return _back[list];
+}
+
+_Use_decl_annotations_
+int32_t TextureCacheSlotLists::GetPrevious(
+	int32_t slot) const
+{
+	assert(slot >= 0 && slot < (int32_t)_capacity);
+	return _previous.items[slot];
+}
+
+_Use_decl_annotations_
+uint32_t TextureCacheSlotLists::GetSize(
+	uint32_t list) const
+{
+	assert(list < MaxListCount);
+	return _sizes[list];
+}
+
+_Use_decl_annotations_
+void TextureCacheSlotLists::SetCapacity(
+	uint32_t capacity)
+{
+	for (uint32_t i = capacity; i < _capacity; ++i)
+	{
+		Remove((int32_t)i);
+	}
+
+	const uint32_t keptCount = min(capacity, _capacity);
+
+	Buffer<int32_t> previous(capacity, true, -1);
+	Buffer<int32_t> next(capacity, true, -1);
+	Buffer<int8_t> lists(capacity, true, -1);
+
+	memcpy(previous.items, _previous.items, sizeof(int32_t) * keptCount);
+	memcpy(next.items, _next.items, sizeof(int32_t) * keptCount);
+	memcpy(lists.items, _lists.items, keptCount);
+
+	_capacity = capacity;
+	_previous = std::move(previous);
+	_next = std::move(next);
+	_lists = std::move(lists);
+}
+
+_Use_decl_annotations_
+bool TextureCacheGhostList::Contains(
+	uint64_t contentKey) const
+{
+	return _positions.find(contentKey) != _positions.end();
+}
+
+_Use_decl_annotations_
+void TextureCacheGhostList::PushFront(
+	uint64_t contentKey)
+{
+	assert(!Contains(contentKey));
+	_keys.push_front(contentKey);
+	_positions[contentKey] = _keys.begin();
+}
+
+_Use_decl_annotations_
+void TextureCacheGhostList::Remove(
+	uint64_t contentKey)
+{
+	auto it = _positions.find(contentKey);
+
+	if (it != _positions.end())
+	{
+		_keys.erase(it->second);
+		_positions.erase(it);
+	}
+}
+
+void TextureCacheGhostList::PopBack()
+{
+	if (!_keys.empty())
+	{
+		_positions.erase(_keys.back());
+		_keys.pop_back();
+	}
+}
+
+uint32_t TextureCacheGhostList::GetSize() const
+{
+	return (uint32_t)_keys.size();
+}
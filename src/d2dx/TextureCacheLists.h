@@ -0,0 +1,104 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+
+#include <list>
+#include <unordered_map>
+
+namespace d2dx
+{
+	/*
+		Up to MaxListCount doubly linked lists threaded through the slots of a texture cache.
+		Each slot is in at most one list. The front of a list is its most recently added end.
+	*/
+	class TextureCacheSlotLists final
+	{
+	public:
+		static constexpr uint32_t MaxListCount = 4;
+
+		TextureCacheSlotLists(
+			_In_ uint32_t capacity);
+		~TextureCacheSlotLists() noexcept {}
+
+		void PushFront(
+			_In_ uint32_t list,
+			_In_ int32_t slot);
+
+		void Remove(
+			_In_ int32_t slot);
+
+		/* Returns the list the slot is in, or -1. */
+		int32_t GetList(
+			_In_ int32_t slot) const;
+
+		/* Returns the slot at the back (least recently added end) of the list, or -1. */
+		int32_t GetBack(
+			_In_ uint32_t list) const;
+
+		/* Returns the slot in front of the given one in its list, or -1. */
+		int32_t GetPrevious(
+			_In_ int32_t slot) const;
+
+		uint32_t GetSize(
+			_In_ uint32_t list) const;
+
+		/* Slots at or above the new capacity are removed from their lists. */
+		void SetCapacity(
+			_In_ uint32_t capacity);
+
+	private:
+		uint32_t _capacity = 0;
+		Buffer<int32_t> _previous;
+		Buffer<int32_t> _next;
+		Buffer<int8_t> _lists;
+		int32_t _front[MaxListCount];
+		int32_t _back[MaxListCount];
+		uint32_t _sizes[MaxListCount];
+	};
+
+	/*
+		A list of content keys that are no longer resident, in order of eviction, as used by
+		the adaptive policies to recognize recently evicted textures.
+	*/
+	class TextureCacheGhostList final
+	{
+	public:
+		TextureCacheGhostList() {}
+		~TextureCacheGhostList() noexcept {}
+
+		bool Contains(
+			_In_ uint64_t contentKey) const;
+
+		void PushFront(
+			_In_ uint64_t contentKey);
+
+		void Remove(
+			_In_ uint64_t contentKey);
+
+		void PopBack();
+
+		uint32_t GetSize() const;
+
+	private:
+		std::list<uint64_t> _keys;
+		std::unordered_map<uint64_t, std::list<uint64_t>::iterator> _positions;
+	};
+}
@@ -0,0 +1,268 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "TextureCacheMissCurves.h"
+
+#include <unordered_map>
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+TextureCacheMissCurves::TextureCacheMissCurves(
+	const TextureKeyLogRecord* records,
+	uint32_t recordCount,
+	uint32_t maxCapacity,
+	double sampleRate)
+{
+	assert(sampleRate > 0.0 && sampleRate <= 1.0);
+
+	_sampleRate = sampleRate;
+	_maxCapacity = maxCapacity;
+
+	/* Content keys are hashes already, but mix them again so that the sample does not depend on
+	   the low bits alone. */
+	const uint64_t sampleThreshold = (uint64_t)(sampleRate * (double)(1ULL << 24));
+
+	std::vector<uint64_t> keys;
+	keys.reserve(recordCount);
+
+	for (uint32_t i = 0; i < recordCount; ++i)
+	{
+		const uint64_t contentKey = records[i].contentKey;
+
+		if (contentKey != 0 && ((contentKey * 0x9E3779B97F4A7C15ULL) >> 40) < sampleThreshold)
+		{
+			keys.push_back(contentKey);
+		}
+	}
+
+	_sampledLookupCount = keys.size();
+
+	ComputeLru(keys);
+	ComputeOpt(keys);
+}
+
+_Use_decl_annotations_
+void TextureCacheMissCurves::ComputeLru(
+	const std::vector<uint64_t>& keys)
+{
+	const uint32_t sampledMaxCapacity = (uint32_t)(_maxCapacity * _sampleRate);
+	const uint32_t keyCount = (uint32_t)keys.size();
+
+	/* Marks the position of the latest lookup of each key; the stack distance of a lookup is the
+	   number of marks after the previous lookup of the same key. */
+	std::vector<uint32_t> tree(keyCount + 1, 0);
+	std::unordered_map<uint64_t, uint32_t> lastPositions;
+	std::vector<uint64_t> hits(sampledMaxCapacity + 1, 0);
+
+	auto add = [&](uint32_t position, int32_t delta)
+	{
+		for (uint32_t i = position + 1; i <= keyCount; i += i & (0 - i))
+		{
+			tree[i] += delta;
+		}
+	};
+
+	auto prefixSum = [&](uint32_t position)
+	{
+		uint32_t sum = 0;
+
+		for (uint32_t i = position + 1; i > 0; i -= i & (0 - i))
+		{
+			sum += tree[i];
+		}
+
+		return sum;
+	};
+
+	for (uint32_t position = 0; position < keyCount; ++position)
+	{
+		auto it = lastPositions.find(keys[position]);
+
+		if (it != lastPositions.end())
+		{
+			const uint32_t distance = prefixSum(position) - prefixSum(it->second);
+
+			if (distance < sampledMaxCapacity)
+			{
+				++hits[distance + 1];
+			}
+
+			add(it->second, -1);
+			it->second = position;
+		}
+		else
+		{
+			lastPositions.emplace(keys[position], position);
+		}
+
+		add(position, 1);
+	}
+
+	_sampledDistinctCount = lastPositions.size();
+
+	for (uint32_t c = 1; c <= sampledMaxCapacity; ++c)
+	{
+		hits[c] += hits[c - 1];
+	}
+
+	_lruCumulativeHits = std::move(hits);
+}
+
+_Use_decl_annotations_
+void TextureCacheMissCurves::ComputeOpt(
+	const std::vector<uint64_t>& keys)
+{
+	const uint32_t sampledMaxCapacity = (uint32_t)(_maxCapacity * _sampleRate);
+	const uint32_t keyCount = (uint32_t)keys.size();
+
+	std::vector<uint32_t> nextUses(keyCount);
+	{
+		std::unordered_map<uint64_t, uint32_t> nextPositions;
+
+		for (uint32_t position = keyCount; position-- > 0; )
+		{
+			auto it = nextPositions.find(keys[position]);
+			nextUses[position] = it != nextPositions.end() ? it->second : UINT32_MAX;
+			nextPositions[keys[position]] = position;
+		}
+	}
+
+	struct StackEntry final
+	{
+		uint64_t contentKey;
+		uint32_t nextUse;
+	};
+
+	/* The top c entries are what an optimal cache of capacity c holds. */
+	std::vector<StackEntry> stack;
+	stack.reserve(sampledMaxCapacity);
+	std::vector<uint64_t> hits(sampledMaxCapacity + 1, 0);
+
+	for (uint32_t position = 0; position < keyCount; ++position)
+	{
+		const StackEntry accessed = { keys[position], nextUses[position] };
+		const uint32_t stackSize = (uint32_t)stack.size();
+		uint32_t depth = 0;
+
+		while (depth < stackSize && stack[depth].contentKey != accessed.contentKey)
+		{
+			++depth;
+		}
+
+		if (depth < stackSize)
+		{
+			++hits[depth + 1];
+		}
+
+		if (stackSize == 0)
+		{
+			if (sampledMaxCapacity > 0)
+			{
+				stack.push_back(accessed);
+			}
+
+			continue;
+		}
+
+		/* Push the accessed key on top. Each level above its old depth keeps whichever of its
+		   entry and the one pushed down is used again sooner. */
+		StackEntry carried = depth == 0 ? accessed : stack[0];
+		stack[0] = accessed;
+
+		for (uint32_t i = 1; i < depth; ++i)
+		{
+			if (stack[i].nextUse > carried.nextUse)
+			{
+				std::swap(stack[i], carried);
+			}
+		}
+
+		if (depth == 0)
+		{
+			continue;
+		}
+
+		if (depth < stackSize)
+		{
+			stack[depth] = carried;
+		}
+		else if (stackSize < sampledMaxCapacity)
+		{
+			stack.push_back(carried);
+		}
+	}
+
+	for (uint32_t c = 1; c <= sampledMaxCapacity; ++c)
+	{
+		hits[c] += hits[c - 1];
+	}
+
+	_optCumulativeHits = std::move(hits);
+}
+
+uint64_t TextureCacheMissCurves::GetLookupCount() const
+{
+	return (uint64_t)((double)_sampledLookupCount / _sampleRate);
+}
+
+uint64_t TextureCacheMissCurves::GetDistinctCount() const
+{
+	return (uint64_t)((double)_sampledDistinctCount / _sampleRate);
+}
+
+uint32_t TextureCacheMissCurves::GetMaxCapacity() const
+{
+	return _maxCapacity;
+}
+
+double TextureCacheMissCurves::GetCompulsoryMissRatio() const
+{
+	return _sampledLookupCount > 0 ? (double)_sampledDistinctCount / (double)_sampledLookupCount : 0.0;
+}
+
+_Use_decl_annotations_
+double TextureCacheMissCurves::GetLruMissRatio(
+	uint32_t capacity) const
+{
+	return GetMissRatio(_lruCumulativeHits, capacity);
+}
+
+_Use_decl_annotations_
+double TextureCacheMissCurves::GetOptMissRatio(
+	uint32_t capacity) const
+{
+	return GetMissRatio(_optCumulativeHits, capacity);
+}
+
+_Use_decl_annotations_
+double TextureCacheMissCurves::GetMissRatio(
+	const std::vector<uint64_t>& cumulativeHits,
+	uint32_t capacity) const
+{
+	assert(capacity <= _maxCapacity);
+
+	if (_sampledLookupCount == 0)
+	{
+		return 0.0;
+	}
+
+	const uint32_t sampledCapacity = min((uint32_t)(capacity * _sampleRate), (uint32_t)cumulativeHits.size() - 1);
+	return 1.0 - (double)cumulativeHits[sampledCapacity] / (double)_sampledLookupCount;
+}
@@ -0,0 +1,82 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "TextureKeyLog.h"
+
+#include <vector>
+
+namespace d2dx
+{
+	/*
+		Miss-ratio curves of texture key log records for an LRU cache and for the optimal
+		(Belady) cache, at every capacity up to a maximum. Both are computed in one pass over the
+		records with stack algorithms: LRU stack distances are counted with a Fenwick tree, and
+		the OPT stack is kept ordered by next use (Mattson et al.). The records must all belong to
+		the same size class; end-of-frame records are ignored, so the curves do not account for
+		slots being held for the rest of a frame.
+
+		With a sample rate below 1, only the content keys in a pseudo-random fraction of the key
+		space are followed and capacities are scaled by the same fraction (SHARDS), trading
+		accuracy for time and memory on long logs.
+	*/
+	class TextureCacheMissCurves final
+	{
+	public:
+		TextureCacheMissCurves(
+			_In_reads_(recordCount) const TextureKeyLogRecord* records,
+			_In_ uint32_t recordCount,
+			_In_ uint32_t maxCapacity,
+			_In_ double sampleRate = 1.0);
+
+		/* Lookups in the records (estimated when sampling). */
+		uint64_t GetLookupCount() const;
+
+		/* Distinct content keys in the records (estimated when sampling). */
+		uint64_t GetDistinctCount() const;
+
+		uint32_t GetMaxCapacity() const;
+
+		double GetCompulsoryMissRatio() const;
+
+		double GetLruMissRatio(
+			_In_ uint32_t capacity) const;
+
+		double GetOptMissRatio(
+			_In_ uint32_t capacity) const;
+
+	private:
+		void ComputeLru(
+			_In_ const std::vector<uint64_t>& keys);
+
+		void ComputeOpt(
+			_In_ const std::vector<uint64_t>& keys);
+
+		double GetMissRatio(
+			_In_ const std::vector<uint64_t>& cumulativeHits,
+			_In_ uint32_t capacity) const;
+
+		double _sampleRate = 1.0;
+		uint32_t _maxCapacity = 0;
+		uint64_t _sampledLookupCount = 0;
+		uint64_t _sampledDistinctCount = 0;
+		std::vector<uint64_t> _lruCumulativeHits;	/* [c] = hits in a cache of capacity c (sampled). */
+		std::vector<uint64_t> _optCumulativeHits;
+	};
+}
@@ -0,0 +1,267 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "Utils.h"
+#include "TextureCachePolicyArc.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+TextureCachePolicyArc::TextureCachePolicyArc(
+	uint32_t capacity,
+	const std::shared_ptr<ISimd>& simd) :
+	_slots{ capacity, simd },
+	_lists{ capacity }
+{
+}
+
+_Use_decl_annotations_
+int32_t TextureCachePolicyArc::Find(
+	uint64_t contentKey,
+	int32_t lastIndex)
+{
+	const int32_t index = _slots.Find(contentKey, lastIndex);
+
+	if (index >= 0)
+	{
+		_slots.MarkUsedInFrame(index);
+		_lists.Remove(index);
+		_lists.PushFront(List::Frequent, index);
+	}
+
+	return index;
+}
+
+_Use_decl_annotations_
+int32_t TextureCachePolicyArc::Insert(
+	uint64_t contentKey,
+	TextureCategory category,
+	bool& evicted)
+{
+	const uint32_t capacity = _slots.GetCapacity();
+
+	if (capacity == 0)
+	{
+		evicted = false;
+		return -1;
+	}
+
+	const bool isInRecentGhosts = _recentGhosts.Contains(contentKey);
+	const bool isInFrequentGhosts = _frequentGhosts.Contains(contentKey);
+
+	if (isInRecentGhosts)
+	{
+		const uint32_t delta = max(1U, _frequentGhosts.GetSize() / _recentGhosts.GetSize());
+		_recentTarget = min(capacity, _recentTarget + delta);
+		_recentGhosts.Remove(contentKey);
+	}
+	else if (isInFrequentGhosts)
+	{
+		const uint32_t delta = max(1U, _recentGhosts.GetSize() / _frequentGhosts.GetSize());
+		_recentTarget = _recentTarget > delta ? _recentTarget - delta : 0;
+		_frequentGhosts.Remove(contentKey);
+	}
+
+	const TextureCacheEviction eviction = _slots.GetEviction(category);
+	int32_t replacementIndex = -1;
+
+	if (eviction == TextureCacheEviction::Pinned)
+	{
+		replacementIndex = FindReplacement(isInFrequentGhosts, eviction);
+	}
+
+	if (replacementIndex < 0)
+	{
+		replacementIndex = _slots.FindFree();
+	}
+
+	if (replacementIndex < 0 && eviction != TextureCacheEviction::Pinned)
+	{
+		replacementIndex = FindReplacement(isInFrequentGhosts, eviction);
+	}
+
+	if (replacementIndex < 0)
+	{
+		replacementIndex = FindReplacement(isInFrequentGhosts, TextureCacheEviction::Any);
+	}
+
+	if (replacementIndex < 0)
+	{
+		D2DX_LOG("All texture atlas entries used in a single frame, starting over!");
+		_slots.ClearUsedInFrame();
+		++_resetCount;
+		replacementIndex = FindReplacement(isInFrequentGhosts, eviction);
+	}
+
+	const int32_t replacedList = _lists.GetList(replacementIndex);
+
+	if (replacedList == List::Recent)
+	{
+		_recentGhosts.PushFront(_slots.GetContentKey(replacementIndex));
+	}
+	else if (replacedList == List::Frequent)
+	{
+		_frequentGhosts.PushFront(_slots.GetContentKey(replacementIndex));
+	}
+
+	_lists.Remove(replacementIndex);
+	_lists.PushFront(isInRecentGhosts || isInFrequentGhosts ? List::Frequent : List::Recent, replacementIndex);
+
+	TrimGhosts();
+
+	_slots.MarkUsedInFrame(replacementIndex);
+
+	evicted = _slots.Assign(replacementIndex, contentKey, category);
+
+	return replacementIndex;
+}
+
+_Use_decl_annotations_
+int32_t TextureCachePolicyArc::InsertFree(
+	uint64_t contentKey,
+	TextureCategory category)
+{
+	const int32_t index = _slots.FindFree();
+
+	if (index < 0)
+	{
+		return -1;
+	}
+
+	/* Not a reference, so neither the ghost lists nor the target adapt. */
+	_lists.PushFront(List::Recent, index);
+
+	const bool evicted = _slots.Assign(index, contentKey, category);
+	assert(!evicted);
+
+	return index;
+}
+
+_Use_decl_annotations_
+int32_t TextureCachePolicyArc::FindReplacement(
+	bool isInFrequentGhosts,
+	TextureCacheEviction eviction) const
+{
+	const uint32_t recentSize = _lists.GetSize(List::Recent);
+
+	const bool preferRecent = recentSize > 0 &&
+		(recentSize > _recentTarget || (isInFrequentGhosts && recentSize == _recentTarget));
+
+	const int32_t index = FindReplacementInList(preferRecent ? List::Recent : List::Frequent, eviction);
+
+	return index >= 0 ? index : FindReplacementInList(preferRecent ? List::Frequent : List::Recent, eviction);
+}
+
+_Use_decl_annotations_
+int32_t TextureCachePolicyArc::FindReplacementInList(
+	List list,
+	TextureCacheEviction eviction) const
+{
+	for (int32_t index = _lists.GetBack(list); index >= 0; index = _lists.GetPrevious(index))
+	{
+		if (_slots.CanEvict(index, eviction))
+		{
+			return index;
+		}
+	}
+
+	return -1;
+}
+
+void TextureCachePolicyArc::TrimGhosts()
+{
+	/* Keep |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c. */
+	const uint32_t capacity = _slots.GetCapacity();
+
+	while (_recentGhosts.GetSize() > 0 &&
+		_lists.GetSize(List::Recent) + _recentGhosts.GetSize() > capacity)
+	{
+		_recentGhosts.PopBack();
+	}
+
+	while (_frequentGhosts.GetSize() > 0 &&
+		_lists.GetSize(List::Recent) + _lists.GetSize(List::Frequent) +
+		_recentGhosts.GetSize() + _frequentGhosts.GetSize() > 2 * capacity)
+	{
+		_frequentGhosts.PopBack();
+	}
+}
+
+void TextureCachePolicyArc::OnNewFrame()
+{
+	_slots.ClearUsedInFrame();
+}
+
+_Use_decl_annotations_
+void TextureCachePolicyArc::SetCapacity(
+	uint32_t capacity)
+{
+	assert(!(capacity & 63));
+
+	if (capacity == _slots.GetCapacity())
+	{
+		return;
+	}
+
+	_lists.SetCapacity(capacity);
+	_slots.SetCapacity(capacity);
+	_recentTarget = min(_recentTarget, capacity);
+	TrimGhosts();
+}
+
+uint32_t TextureCachePolicyArc::GetCapacity() const
+{
+	return _slots.GetCapacity();
+}
+
+uint32_t TextureCachePolicyArc::GetUsedCount() const
+{
+	return _slots.GetUsedCount();
+}
+
+uint32_t TextureCachePolicyArc::GetUsedInFrameCount() const
+{
+	return _slots.GetUsedInFrameCount();
+}
+
+uint32_t TextureCachePolicyArc::GetResetCount() const
+{
+	return _resetCount;
+}
+
+_Use_decl_annotations_
+uint64_t TextureCachePolicyArc::GetContentKey(
+	int32_t index) const
+{
+	return _slots.GetContentKey(index);
+}
+
+_Use_decl_annotations_
+TextureCategory TextureCachePolicyArc::GetCategory(
+	int32_t index) const
+{
+	return _slots.GetCategory(index);
+}
+
+_Use_decl_annotations_
+uint32_t TextureCachePolicyArc::GetCategoryCount(
+	TextureCategory category) const
+{
+	return _slots.GetCategoryCount(category);
+}
@@ -0,0 +1,100 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "ITextureCachePolicy.h"
+#include "TextureCacheLists.h"
+#include "TextureCacheSlots.h"
+
+namespace d2dx
+{
+	/*
+		ARC replacement (Megiddo & Modha): textures seen once (T1) and textures seen at least twice
+		(T2) are kept in two LRU lists, with a ghost list of recent evictions from each (B1, B2).
+		A request for a texture in B1 grows the share of T1, one in B2 grows the share of T2, so
+		the split between recency and frequency adapts to the workload.
+	*/
+	class TextureCachePolicyArc final : public ITextureCachePolicy
+	{
+	public:
+		TextureCachePolicyArc(
+			_In_ uint32_t capacity,
+			_In_ const std::shared_ptr<ISimd>& simd);
+		virtual ~TextureCachePolicyArc() noexcept {}
+
+		virtual int32_t Find(
+			_In_ uint64_t contentKey,
+			_In_ int32_t lastIndex) override;
+
+		virtual int32_t Insert(
+			_In_ uint64_t contentKey,
+			_In_ TextureCategory category,
+			_Out_ bool& evicted) override;
+
+		virtual int32_t InsertFree(
+			_In_ uint64_t contentKey,
+			_In_ TextureCategory category) override;
+
+		virtual void OnNewFrame() override;
+
+		virtual void SetCapacity(
+			_In_ uint32_t capacity) override;
+
+		virtual uint32_t GetCapacity() const override;
+
+		virtual uint32_t GetUsedCount() const override;
+
+		virtual uint32_t GetUsedInFrameCount() const override;
+
+		virtual uint32_t GetResetCount() const override;
+
+		virtual uint64_t GetContentKey(
+			_In_ int32_t index) const override;
+
+		virtual TextureCategory GetCategory(
+			_In_ int32_t index) const override;
+
+		virtual uint32_t GetCategoryCount(
+			_In_ TextureCategory category) const override;
+
+	private:
+		enum List
+		{
+			Recent = 0,
+			Frequent = 1,
+		};
+
+		int32_t FindReplacement(
+			_In_ bool isInFrequentGhosts,
+			_In_ TextureCacheEviction eviction) const;
+
+		int32_t FindReplacementInList(
+			_In_ List list,
+			_In_ TextureCacheEviction eviction) const;
+
+		void TrimGhosts();
+
+		TextureCacheSlots _slots;
+		TextureCacheSlotLists _lists;
+		TextureCacheGhostList _recentGhosts;
+		TextureCacheGhostList _frequentGhosts;
+		uint32_t _recentTarget = 0;
+		uint32_t _resetCount = 0;
+	};
+}
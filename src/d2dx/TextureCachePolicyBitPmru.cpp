@@ -19,7 +19,6 @@
 #include "pch.h"
 #include "Utils.h"
 #include "TextureCachePolicyBitPmru.h"
-#include "ISimd.h"
 
 using namespace d2dx;
 
@@ -27,124 +26,211 @@ _Use_decl_annotations_
 TextureCachePolicyBitPmru::TextureCachePolicyBitPmru(
 	uint32_t capacity,
 	const std::shared_ptr<ISimd>& simd) :
-	_capacity{ capacity },
-	_contentKeys{ capacity, true },
-	_usedInFrameBits{ capacity >> 5, true },
+	_slots{ capacity, simd },
 	_mruBits{ capacity >> 5, true },
-	_simd{ simd }
+	_pinnedBits{ capacity >> 5, true }
 {
-	assert(!(capacity & 63));
-	assert(simd);
 }
 
 _Use_decl_annotations_
 int32_t TextureCachePolicyBitPmru::Find(
-	uint32_t contentKey,
+	uint64_t contentKey,
 	int32_t lastIndex)
 {
-	assert(contentKey != 0);
-
-	if (_capacity == 0)
-	{
-		return -1;
-	}
-
-	if (lastIndex >= 0 && lastIndex < (int32_t)_capacity &&
-		contentKey == _contentKeys.items[lastIndex])
-	{
-		_usedInFrameBits.items[lastIndex >> 5] |= 1 << (lastIndex & 31);
-		_mruBits.items[lastIndex >> 5] |= 1 << (lastIndex & 31);
-		return lastIndex;
-	}
-
-	int32_t findIndex = _simd->IndexOfUInt32(_contentKeys.items, _capacity, contentKey);
+	const int32_t findIndex = _slots.Find(contentKey, lastIndex);
 
 	if (findIndex >= 0)
 	{
-		_usedInFrameBits.items[findIndex >> 5] |= 1 << (findIndex & 31);
-		_mruBits.items[findIndex >> 5] |= 1 << (findIndex & 31);
-		return findIndex;
+		MarkUsedInFrame(findIndex);
 	}
 
-	return -1;
+	return findIndex;
 }
 
 _Use_decl_annotations_
 int32_t TextureCachePolicyBitPmru::Insert(
-	uint32_t contentKey,
+	uint64_t contentKey,
+	TextureCategory category,
 	bool& evicted)
 {
-	if (_capacity == 0)
+	const uint32_t capacity = _slots.GetCapacity();
+
+	if (capacity == 0)
 	{
 		evicted = false;
 		return -1;
 	}
 
-	int32_t replacementIndex = -1;
+	const TextureCacheEviction eviction = _slots.GetEviction(category);
 
-	for (uint32_t i = 0; i < _mruBits.capacity; ++i)
+	int32_t replacementIndex = FindReplacement(_mruBits.items, eviction);
+
+	if (replacementIndex < 0)
 	{
-		DWORD ri;
-		if (BitScanForward(&ri, (DWORD)~_mruBits.items[i]))
-		{
-			replacementIndex = (int32_t)(i * 32 + ri);
-			break;
-		}
+		memcpy(_mruBits.items, _slots.GetUsedInFrameBits(), sizeof(uint32_t) * _mruBits.capacity);
+		replacementIndex = FindReplacement(_mruBits.items, eviction);
 	}
 
 	if (replacementIndex < 0)
 	{
-		memcpy(_mruBits.items, _usedInFrameBits.items, sizeof(uint32_t) * _mruBits.capacity);
-
-		for (uint32_t i = 0; i < _mruBits.capacity; ++i)
-		{
-			DWORD ri;
-			if (BitScanForward(&ri, (DWORD)~_mruBits.items[i]))
-			{
-				replacementIndex = (int32_t)(i * 32 + ri);
-				break;
-			}
-		}
+		/* Every slot the pinned quota allows is used in this frame: any other slot is the lesser evil. */
+		replacementIndex = FindReplacement(_mruBits.items, TextureCacheEviction::Any);
 	}
 
 	if (replacementIndex < 0)
 	{
 		D2DX_LOG("All texture atlas entries used in a single frame, starting over!");
 		memset(_mruBits.items, 0, sizeof(uint32_t) * _mruBits.capacity);
-		memset(_usedInFrameBits.items, 0, sizeof(uint32_t) * _usedInFrameBits.capacity);
+		_slots.ClearUsedInFrame();
+		++_resetCount;
+		replacementIndex = FindReplacement(_mruBits.items, eviction);
+	}
+
+	MarkUsedInFrame(replacementIndex);
+
+	evicted = _slots.Assign(replacementIndex, contentKey, category);
+
+	SetPinned(replacementIndex, category);
+
+	return replacementIndex;
+}
+
+_Use_decl_annotations_
+int32_t TextureCachePolicyBitPmru::InsertFree(
+	uint64_t contentKey,
+	TextureCategory category)
+{
+	const int32_t index = _slots.FindFree();
+
+	if (index < 0)
+	{
+		return -1;
+	}
+
+	const bool evicted = _slots.Assign(index, contentKey, category);
+	assert(!evicted);
+
+	SetPinned(index, category);
+
+	return index;
+}
+
+_Use_decl_annotations_
+void TextureCachePolicyBitPmru::SetPinned(
+	int32_t index,
+	TextureCategory category)
+{
+	const uint32_t pinnedMask = 1U << (index & 31);
+
+	if (TextureCacheSlots::IsPinned(category))
+	{
+		_pinnedBits.items[index >> 5] |= pinnedMask;
+	}
+	else
+	{
+		_pinnedBits.items[index >> 5] &= ~pinnedMask;
+	}
+}
+
+_Use_decl_annotations_
+int32_t TextureCachePolicyBitPmru::FindReplacement(
+	const uint32_t* recentBits,
+	TextureCacheEviction eviction) const
+{
+	const uint32_t skipMask = eviction == TextureCacheEviction::Unpinned ? 0xFFFFFFFF : 0;
+	const uint32_t onlyMask = eviction == TextureCacheEviction::Pinned ? 0 : 0xFFFFFFFF;
+
+	for (uint32_t i = 0; i < _mruBits.capacity; ++i)
+	{
+		const uint32_t pinnedBits = _pinnedBits.items[i];
 
-		for (uint32_t i = 0; i < _mruBits.capacity; ++i)
+		DWORD ri;
+		if (BitScanForward(&ri, (DWORD)(~recentBits[i] & ~(pinnedBits & skipMask) & (pinnedBits | onlyMask))))
 		{
-			DWORD ri;
-			if (BitScanForward(&ri, (DWORD)~_mruBits.items[i]))
-			{
-				replacementIndex = (int32_t)(i * 32 + ri);
-				break;
-			}
+			return (int32_t)(i * 32 + ri);
 		}
 	}
 
-	_mruBits.items[replacementIndex >> 5] |= 1 << (replacementIndex & 31);
-	_usedInFrameBits.items[replacementIndex >> 5] |= 1 << (replacementIndex & 31);
+	return -1;
+}
 
-	evicted = _contentKeys.items[replacementIndex] != 0;
+void TextureCachePolicyBitPmru::OnNewFrame()
+{
+	_slots.ClearUsedInFrame();
+}
+
+_Use_decl_annotations_
+void TextureCachePolicyBitPmru::SetCapacity(
+	uint32_t capacity)
+{
+	assert(!(capacity & 63));
 
-	if (!evicted)
+	if (capacity == _slots.GetCapacity())
 	{
-		++_usedCount;
+		return;
 	}
 
-	_contentKeys.items[replacementIndex] = contentKey;
+	/* Entries below the new capacity keep their slots (and thereby their atlas locations);
+	   entries at or above it are dropped. */
+	const uint32_t keptCount = min(capacity, _slots.GetCapacity());
 
-	return replacementIndex;
+	Buffer<uint32_t> mruBits(capacity >> 5, true);
+	Buffer<uint32_t> pinnedBits(capacity >> 5, true);
+
+	memcpy(mruBits.items, _mruBits.items, sizeof(uint32_t) * (keptCount >> 5));
+	memcpy(pinnedBits.items, _pinnedBits.items, sizeof(uint32_t) * (keptCount >> 5));
+
+	_mruBits = std::move(mruBits);
+	_pinnedBits = std::move(pinnedBits);
+
+	_slots.SetCapacity(capacity);
 }
 
-void TextureCachePolicyBitPmru::OnNewFrame()
+uint32_t TextureCachePolicyBitPmru::GetCapacity() const
 {
-	memset(_usedInFrameBits.items, 0, sizeof(uint32_t) * _usedInFrameBits.capacity);
+	return _slots.GetCapacity();
 }
 
 uint32_t TextureCachePolicyBitPmru::GetUsedCount() const
 {
-	return _usedCount;
+	return _slots.GetUsedCount();
+}
+
+uint32_t TextureCachePolicyBitPmru::GetUsedInFrameCount() const
+{
+	return _slots.GetUsedInFrameCount();
+}
+
+uint32_t TextureCachePolicyBitPmru::GetResetCount() const
+{
+	return _resetCount;
+}
+
+_Use_decl_annotations_
+uint64_t TextureCachePolicyBitPmru::GetContentKey(
+	int32_t index) const
+{
+	return _slots.GetContentKey(index);
+}
+
+_Use_decl_annotations_
+TextureCategory TextureCachePolicyBitPmru::GetCategory(
+	int32_t index) const
+{
+	return _slots.GetCategory(index);
+}
+
+_Use_decl_annotations_
+uint32_t TextureCachePolicyBitPmru::GetCategoryCount(
+	TextureCategory category) const
+{
+	return _slots.GetCategoryCount(category);
+}
+
+_Use_decl_annotations_
+void TextureCachePolicyBitPmru::MarkUsedInFrame(
+	int32_t index)
+{
+	_slots.MarkUsedInFrame(index);
+	_mruBits.items[index >> 5] |= 1U << (index & 31);
 }
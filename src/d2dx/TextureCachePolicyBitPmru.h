@@ -19,39 +19,75 @@
 #pragma once
 
 #include "Buffer.h"
-#include "ISimd.h"
+#include "ITextureCachePolicy.h"
+#include "TextureCacheSlots.h"
 
 namespace d2dx
 {
-	class TextureCachePolicyBitPmru final
+	/*
+		Bit-PMRU replacement: evicts the first slot not used recently, where "recently" is reset
+		to "this frame" whenever every slot has been used. The pinned quota of TextureCacheSlots
+		is mirrored in a bit per slot, so that the scan can apply it a word at a time.
+	*/
+	class TextureCachePolicyBitPmru final : public ITextureCachePolicy
 	{
 	public:
-		TextureCachePolicyBitPmru() = default;
-		TextureCachePolicyBitPmru& operator=(TextureCachePolicyBitPmru&& rhs) = default;
-
 		TextureCachePolicyBitPmru(
 			_In_ uint32_t capacity,
 			_In_ const std::shared_ptr<ISimd>& simd);
-		~TextureCachePolicyBitPmru() noexcept {}
+		virtual ~TextureCachePolicyBitPmru() noexcept {}
 
-		int32_t Find(
-			_In_ uint32_t contentKey,
-			_In_ int32_t lastIndex);
+		virtual int32_t Find(
+			_In_ uint64_t contentKey,
+			_In_ int32_t lastIndex) override;
+		
+		virtual int32_t Insert(
+			_In_ uint64_t contentKey,
+			_In_ TextureCategory category,
+			_Out_ bool& evicted) override;
 		
-		int32_t Insert(
-			_In_ uint32_t contentKey,
-			_Out_ bool& evicted);
+		virtual int32_t InsertFree(
+			_In_ uint64_t contentKey,
+			_In_ TextureCategory category) override;
 		
-		void OnNewFrame();
+		virtual void OnNewFrame() override;
+
+		virtual void SetCapacity(
+			_In_ uint32_t capacity) override;
+
+		virtual uint32_t GetCapacity() const override;
+
+		virtual uint32_t GetUsedCount() const override;
+
+		virtual uint32_t GetUsedInFrameCount() const override;
 
-		uint32_t GetUsedCount() const;
+		virtual uint32_t GetResetCount() const override;
+
+		virtual uint64_t GetContentKey(
+			_In_ int32_t index) const override;
+
+		virtual TextureCategory GetCategory(
+			_In_ int32_t index) const override;
+
+		virtual uint32_t GetCategoryCount(
+			_In_ TextureCategory category) const override;
 
 	private:
-		uint32_t _capacity = 0;
-		std::shared_ptr<ISimd> _simd;
-		Buffer<uint32_t> _contentKeys;
-		Buffer<uint32_t> _usedInFrameBits;
+		/* Returns the first slot whose bit in recentBits is clear and that the eviction allows, or -1. */
+		int32_t FindReplacement(
+			_In_reads_(_mruBits.capacity) const uint32_t* recentBits,
+			_In_ TextureCacheEviction eviction) const;
+
+		void SetPinned(
+			_In_ int32_t index,
+			_In_ TextureCategory category);
+
+		void MarkUsedInFrame(
+			_In_ int32_t index);
+
+		TextureCacheSlots _slots;
 		Buffer<uint32_t> _mruBits;
-		uint32_t _usedCount = 0;
+		Buffer<uint32_t> _pinnedBits;
+		uint32_t _resetCount = 0;
 	};
 }
@@ -0,0 +1,215 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "Utils.h"
+#include "TextureCachePolicyClock.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+TextureCachePolicyClock::TextureCachePolicyClock(
+	uint32_t capacity,
+	const std::shared_ptr<ISimd>& simd) :
+	_slots{ capacity, simd },
+	_referenced{ capacity, true }
+{
+}
+
+_Use_decl_annotations_
+int32_t TextureCachePolicyClock::Find(
+	uint64_t contentKey,
+	int32_t lastIndex)
+{
+	const int32_t index = _slots.Find(contentKey, lastIndex);
+
+	if (index >= 0)
+	{
+		_slots.MarkUsedInFrame(index);
+		_referenced.items[index] = 1;
+	}
+
+	return index;
+}
+
+_Use_decl_annotations_
+int32_t TextureCachePolicyClock::Insert(
+	uint64_t contentKey,
+	TextureCategory category,
+	bool& evicted)
+{
+	if (_slots.GetCapacity() == 0)
+	{
+		evicted = false;
+		return -1;
+	}
+
+	const TextureCacheEviction eviction = _slots.GetEviction(category);
+	int32_t replacementIndex = -1;
+
+	if (eviction == TextureCacheEviction::Pinned)
+	{
+		replacementIndex = FindReplacement(eviction);
+	}
+
+	if (replacementIndex < 0)
+	{
+		replacementIndex = _slots.FindFree();
+	}
+
+	if (replacementIndex < 0 && eviction != TextureCacheEviction::Pinned)
+	{
+		replacementIndex = FindReplacement(eviction);
+	}
+
+	if (replacementIndex < 0)
+	{
+		replacementIndex = FindReplacement(TextureCacheEviction::Any);
+	}
+
+	if (replacementIndex < 0)
+	{
+		D2DX_LOG("All texture atlas entries used in a single frame, starting over!");
+		_slots.ClearUsedInFrame();
+		++_resetCount;
+		replacementIndex = FindReplacement(eviction);
+	}
+
+	_slots.MarkUsedInFrame(replacementIndex);
+	_referenced.items[replacementIndex] = 1;
+
+	evicted = _slots.Assign(replacementIndex, contentKey, category);
+
+	return replacementIndex;
+}
+
+_Use_decl_annotations_
+int32_t TextureCachePolicyClock::InsertFree(
+	uint64_t contentKey,
+	TextureCategory category)
+{
+	const int32_t index = _slots.FindFree();
+
+	if (index < 0)
+	{
+		return -1;
+	}
+
+	_referenced.items[index] = 0;
+
+	const bool evicted = _slots.Assign(index, contentKey, category);
+	assert(!evicted);
+
+	return index;
+}
+
+_Use_decl_annotations_
+int32_t TextureCachePolicyClock::FindReplacement(
+	TextureCacheEviction eviction)
+{
+	const uint32_t capacity = _slots.GetCapacity();
+
+	/* The first sweep clears the referenced bits, so two sweeps find a victim unless no slot
+	   may be evicted. */
+	for (uint32_t i = 0; i < 2 * capacity; ++i)
+	{
+		const int32_t index = (int32_t)_hand;
+		_hand = _hand + 1 < capacity ? _hand + 1 : 0;
+
+		if (!_slots.CanEvict(index, eviction))
+		{
+			continue;
+		}
+
+		if (_referenced.items[index])
+		{
+			_referenced.items[index] = 0;
+			continue;
+		}
+
+		return index;
+	}
+
+	return -1;
+}
+
+void TextureCachePolicyClock::OnNewFrame()
+{
+	_slots.ClearUsedInFrame();
+}
+
+_Use_decl_annotations_
+void TextureCachePolicyClock::SetCapacity(
+	uint32_t capacity)
+{
+	assert(!(capacity & 63));
+
+	if (capacity == _slots.GetCapacity())
+	{
+		return;
+	}
+
+	Buffer<uint8_t> referenced(capacity, true);
+	memcpy(referenced.items, _referenced.items, min(capacity, _slots.GetCapacity()));
+	_referenced = std::move(referenced);
+
+	_hand = _hand < capacity ? _hand : 0;
+
+	_slots.SetCapacity(capacity);
+}
+
+uint32_t TextureCachePolicyClock::GetCapacity() const
+{
+	return _slots.GetCapacity();
+}
+
+uint32_t TextureCachePolicyClock::GetUsedCount() const
+{
+	return _slots.GetUsedCount();
+}
+
+uint32_t TextureCachePolicyClock::GetUsedInFrameCount() const
+{
+	return _slots.GetUsedInFrameCount();
+}
+
+uint32_t TextureCachePolicyClock::GetResetCount() const
+{
+	return _resetCount;
+}
+
+_Use_decl_annotations_
+uint64_t TextureCachePolicyClock::GetContentKey(
+	int32_t index) const
+{
+	return _slots.GetContentKey(index);
+}
+
+_Use_decl_annotations_
+TextureCategory TextureCachePolicyClock::GetCategory(
+	int32_t index) const
+{
+	return _slots.GetCategory(index);
+}
+
+_Use_decl_annotations_
+uint32_t TextureCachePolicyClock::GetCategoryCount(
+	TextureCategory category) const
+{
+	return _slots.GetCategoryCount(category);
+}
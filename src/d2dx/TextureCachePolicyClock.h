@@ -0,0 +1,83 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+#include "ITextureCachePolicy.h"
+#include "TextureCacheSlots.h"
+
+namespace d2dx
+{
+	/*
+		CLOCK replacement: a hand sweeps the slots, clearing the referenced bit of each slot it
+		passes, and evicts the first slot that has not been referenced since the last sweep.
+	*/
+	class TextureCachePolicyClock final : public ITextureCachePolicy
+	{
+	public:
+		TextureCachePolicyClock(
+			_In_ uint32_t capacity,
+			_In_ const std::shared_ptr<ISimd>& simd);
+		virtual ~TextureCachePolicyClock() noexcept {}
+
+		virtual int32_t Find(
+			_In_ uint64_t contentKey,
+			_In_ int32_t lastIndex) override;
+
+		virtual int32_t Insert(
+			_In_ uint64_t contentKey,
+			_In_ TextureCategory category,
+			_Out_ bool& evicted) override;
+
+		virtual int32_t InsertFree(
+			_In_ uint64_t contentKey,
+			_In_ TextureCategory category) override;
+
+		virtual void OnNewFrame() override;
+
+		virtual void SetCapacity(
+			_In_ uint32_t capacity) override;
+
+		virtual uint32_t GetCapacity() const override;
+
+		virtual uint32_t GetUsedCount() const override;
+
+		virtual uint32_t GetUsedInFrameCount() const override;
+
+		virtual uint32_t GetResetCount() const override;
+
+		virtual uint64_t GetContentKey(
+			_In_ int32_t index) const override;
+
+		virtual TextureCategory GetCategory(
+			_In_ int32_t index) const override;
+
+		virtual uint32_t GetCategoryCount(
+			_In_ TextureCategory category) const override;
+
+	private:
+		int32_t FindReplacement(
+			_In_ TextureCacheEviction eviction);
+
+		TextureCacheSlots _slots;
+		Buffer<uint8_t> _referenced;
+		uint32_t _hand = 0;
+		uint32_t _resetCount = 0;
+	};
+}
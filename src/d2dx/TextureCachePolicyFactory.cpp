@@ -0,0 +1,82 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "TextureCachePolicyFactory.h"
+#include "TextureCachePolicyArc.h"
+#include "TextureCachePolicyBitPmru.h"
+#include "TextureCachePolicyClock.h"
+#include "TextureCachePolicyLirs.h"
+#include "TextureCachePolicyTwoQueue.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+std::unique_ptr<ITextureCachePolicy> TextureCachePolicyFactory::Create(
+	TextureCachePolicyType type,
+	uint32_t capacity,
+	const std::shared_ptr<ISimd>& simd)
+{
+	switch (type)
+	{
+	case TextureCachePolicyType::Clock:
+		return std::make_unique<TextureCachePolicyClock>(capacity, simd);
+	case TextureCachePolicyType::TwoQueue:
+		return std::make_unique<TextureCachePolicyTwoQueue>(capacity, simd);
+	case TextureCachePolicyType::Arc:
+		return std::make_unique<TextureCachePolicyArc>(capacity, simd);
+	case TextureCachePolicyType::Lirs:
+		return std::make_unique<TextureCachePolicyLirs>(capacity, simd);
+	default:
+		return std::make_unique<TextureCachePolicyBitPmru>(capacity, simd);
+	}
+}
+
+_Use_decl_annotations_
+const char* TextureCachePolicyFactory::GetName(
+	TextureCachePolicyType type)
+{
+	switch (type)
+	{
+	case TextureCachePolicyType::Clock:
+		return "clock";
+	case TextureCachePolicyType::TwoQueue:
+		return "2q";
+	case TextureCachePolicyType::Arc:
+		return "arc";
+	case TextureCachePolicyType::Lirs:
+		return "lirs";
+	default:
+		return "bitpmru";
+	}
+}
+
+_Use_decl_annotations_
+TextureCachePolicyType TextureCachePolicyFactory::FromName(
+	const char* name)
+{
+	for (int32_t i = 0; i < (int32_t)TextureCachePolicyType::Count; ++i)
+	{
+		if (!strcmp(name, GetName((TextureCachePolicyType)i)))
+		{
+			return (TextureCachePolicyType)i;
+		}
+	}
+
+	return TextureCachePolicyType::Count;
+}
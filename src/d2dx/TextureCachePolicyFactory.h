@@ -0,0 +1,51 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "ISimd.h"
+#include "ITextureCachePolicy.h"
+
+namespace d2dx
+{
+	enum class TextureCachePolicyType
+	{
+		BitPmru = 0,
+		Clock = 1,
+		TwoQueue = 2,
+		Arc = 3,
+		Lirs = 4,
+		Count = 5
+	};
+
+	class TextureCachePolicyFactory final
+	{
+	public:
+		static std::unique_ptr<ITextureCachePolicy> Create(
+			_In_ TextureCachePolicyType type,
+			_In_ uint32_t capacity,
+			_In_ const std::shared_ptr<ISimd>& simd);
+
+		static const char* GetName(
+			_In_ TextureCachePolicyType type);
+
+		/* Returns TextureCachePolicyType::Count if the name is not recognized. */
+		static TextureCachePolicyType FromName(
+			_In_z_ const char* name);
+	};
+}
@@ -0,0 +1,417 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "Utils.h"
+#include "TextureCachePolicyLirs.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+TextureCachePolicyLirs::TextureCachePolicyLirs(
+	uint32_t capacity,
+	const std::shared_ptr<ISimd>& simd) :
+	_slots{ capacity, simd }
+{
+}
+
+_Use_decl_annotations_
+int32_t TextureCachePolicyLirs::Find(
+	uint64_t contentKey,
+	int32_t lastIndex)
+{
+	const int32_t index = _slots.Find(contentKey, lastIndex);
+
+	if (index < 0)
+	{
+		return -1;
+	}
+
+	_slots.MarkUsedInFrame(index);
+
+	auto it = _entries.find(contentKey);
+	assert(it != _entries.end());
+	Entry& entry = it->second;
+
+	if (entry.isLir)
+	{
+		const bool wasBottom = _stack.back() == contentKey;
+
+		MoveToStackTop(contentKey, entry);
+
+		if (wasBottom)
+		{
+			PruneStack();
+		}
+	}
+	else if (entry.isInStack)
+	{
+		/* Reused within the reuse distance of the LIR set: becomes LIR. */
+		RemoveFromQueue(entry);
+		entry.isLir = true;
+		++_lirCount;
+		MoveToStackTop(contentKey, entry);
+
+		if (_lirCount > GetMaxLirCount())
+		{
+			DemoteBottomLir();
+		}
+	}
+	else
+	{
+		MoveToStackTop(contentKey, entry);
+		RemoveFromQueue(entry);
+		entry.queuePosition = _queue.insert(_queue.end(), contentKey);
+		entry.isInQueue = true;
+	}
+
+	return index;
+}
+
+_Use_decl_annotations_
+int32_t TextureCachePolicyLirs::Insert(
+	uint64_t contentKey,
+	TextureCategory category,
+	bool& evicted)
+{
+	if (_slots.GetCapacity() == 0)
+	{
+		evicted = false;
+		return -1;
+	}
+
+	const TextureCacheEviction eviction = _slots.GetEviction(category);
+	int32_t replacementIndex = -1;
+
+	if (eviction == TextureCacheEviction::Pinned)
+	{
+		replacementIndex = FindReplacement(eviction);
+	}
+
+	if (replacementIndex < 0)
+	{
+		replacementIndex = _slots.FindFree();
+	}
+
+	if (replacementIndex < 0 && eviction != TextureCacheEviction::Pinned)
+	{
+		replacementIndex = FindReplacement(eviction);
+	}
+
+	if (replacementIndex < 0)
+	{
+		replacementIndex = FindReplacement(TextureCacheEviction::Any);
+	}
+
+	if (replacementIndex < 0)
+	{
+		D2DX_LOG("All texture atlas entries used in a single frame, starting over!");
+		_slots.ClearUsedInFrame();
+		++_resetCount;
+		replacementIndex = FindReplacement(eviction);
+	}
+
+	const uint64_t replacedContentKey = _slots.GetContentKey(replacementIndex);
+
+	if (replacedContentKey != 0)
+	{
+		Evict(replacedContentKey);
+	}
+
+	Entry& entry = _entries[contentKey];
+	entry.slot = replacementIndex;
+
+	if (_lirCount < GetMaxLirCount() || entry.isInStack)
+	{
+		entry.isLir = true;
+		++_lirCount;
+		MoveToStackTop(contentKey, entry);
+
+		if (_lirCount > GetMaxLirCount())
+		{
+			DemoteBottomLir();
+		}
+	}
+	else
+	{
+		MoveToStackTop(contentKey, entry);
+		entry.queuePosition = _queue.insert(_queue.end(), contentKey);
+		entry.isInQueue = true;
+	}
+
+	TrimStack();
+
+	_slots.MarkUsedInFrame(replacementIndex);
+
+	evicted = _slots.Assign(replacementIndex, contentKey, category);
+
+	return replacementIndex;
+}
+
+_Use_decl_annotations_
+int32_t TextureCachePolicyLirs::InsertFree(
+	uint64_t contentKey,
+	TextureCategory category)
+{
+	const int32_t index = _slots.FindFree();
+
+	if (index < 0)
+	{
+		return -1;
+	}
+
+	/* Not a reference: the texture starts out as a resident HIR entry outside the stack, and
+	   becomes LIR only once it is actually used. */
+	Entry& entry = _entries[contentKey];
+	entry.slot = index;
+	entry.queuePosition = _queue.insert(_queue.end(), contentKey);
+	entry.isInQueue = true;
+
+	const bool evicted = _slots.Assign(index, contentKey, category);
+	assert(!evicted);
+
+	return index;
+}
+
+uint32_t TextureCachePolicyLirs::GetMaxLirCount() const
+{
+	const uint32_t capacity = _slots.GetCapacity();
+	return capacity > 0 ? capacity - max(1U, capacity / HirDivisor) : 0;
+}
+
+_Use_decl_annotations_
+int32_t TextureCachePolicyLirs::FindReplacement(
+	TextureCacheEviction eviction) const
+{
+	for (uint64_t contentKey : _queue)
+	{
+		const int32_t slot = _entries.find(contentKey)->second.slot;
+
+		if (_slots.CanEvict(slot, eviction))
+		{
+			return slot;
+		}
+	}
+
+	/* No resident HIR texture may be evicted; fall back to the LIR texture used least recently. */
+	for (auto position = _stack.rbegin(); position != _stack.rend(); ++position)
+	{
+		const Entry& entry = _entries.find(*position)->second;
+
+		if (entry.isLir && _slots.CanEvict(entry.slot, eviction))
+		{
+			return entry.slot;
+		}
+	}
+
+	return -1;
+}
+
+_Use_decl_annotations_
+void TextureCachePolicyLirs::Evict(
+	uint64_t contentKey)
+{
+	auto it = _entries.find(contentKey);
+	assert(it != _entries.end());
+	Entry& entry = it->second;
+
+	entry.slot = -1;
+	RemoveFromQueue(entry);
+
+	if (entry.isLir)
+	{
+		entry.isLir = false;
+		--_lirCount;
+		RemoveFromStack(entry);
+		_entries.erase(it);
+		PruneStack();
+	}
+	else if (!entry.isInStack)
+	{
+		_entries.erase(it);
+	}
+}
+
+_Use_decl_annotations_
+void TextureCachePolicyLirs::MoveToStackTop(
+	uint64_t contentKey,
+	Entry& entry)
+{
+	RemoveFromStack(entry);
+	entry.stackPosition = _stack.insert(_stack.begin(), contentKey);
+	entry.isInStack = true;
+}
+
+_Use_decl_annotations_
+void TextureCachePolicyLirs::RemoveFromStack(
+	Entry& entry)
+{
+	if (entry.isInStack)
+	{
+		_stack.erase(entry.stackPosition);
+		entry.isInStack = false;
+	}
+}
+
+_Use_decl_annotations_
+void TextureCachePolicyLirs::RemoveFromQueue(
+	Entry& entry)
+{
+	if (entry.isInQueue)
+	{
+		_queue.erase(entry.queuePosition);
+		entry.isInQueue = false;
+	}
+}
+
+void TextureCachePolicyLirs::DemoteBottomLir()
+{
+	assert(!_stack.empty());
+
+	const uint64_t contentKey = _stack.back();
+	Entry& entry = _entries.find(contentKey)->second;
+	assert(entry.isLir && entry.slot >= 0);
+
+	entry.isLir = false;
+	--_lirCount;
+	RemoveFromStack(entry);
+	entry.queuePosition = _queue.insert(_queue.end(), contentKey);
+	entry.isInQueue = true;
+
+	PruneStack();
+}
+
+void TextureCachePolicyLirs::PruneStack()
+{
+	/* The bottom of the stack must be a LIR entry, which defines the largest reuse distance
+	   that still counts as short. */
+	while (!_stack.empty())
+	{
+		auto it = _entries.find(_stack.back());
+		Entry& entry = it->second;
+
+		if (entry.isLir)
+		{
+			break;
+		}
+
+		RemoveFromStack(entry);
+
+		if (entry.slot < 0)
+		{
+			_entries.erase(it);
+		}
+	}
+}
+
+void TextureCachePolicyLirs::TrimStack()
+{
+	const size_t maxStackSize = (size_t)MaxStackFactor * _slots.GetCapacity();
+
+	for (auto position = _stack.end(); position != _stack.begin() && _stack.size() > maxStackSize; )
+	{
+		--position;
+
+		auto it = _entries.find(*position);
+
+		if (it->second.slot < 0)
+		{
+			position = _stack.erase(position);
+			_entries.erase(it);
+		}
+	}
+}
+
+void TextureCachePolicyLirs::OnNewFrame()
+{
+	_slots.ClearUsedInFrame();
+}
+
+_Use_decl_annotations_
+void TextureCachePolicyLirs::SetCapacity(
+	uint32_t capacity)
+{
+	assert(!(capacity & 63));
+
+	const uint32_t oldCapacity = _slots.GetCapacity();
+
+	if (capacity == oldCapacity)
+	{
+		return;
+	}
+
+	for (uint32_t i = capacity; i < oldCapacity; ++i)
+	{
+		const uint64_t contentKey = _slots.GetContentKey((int32_t)i);
+
+		if (contentKey != 0)
+		{
+			Evict(contentKey);
+		}
+	}
+
+	_slots.SetCapacity(capacity);
+
+	while (_lirCount > GetMaxLirCount())
+	{
+		DemoteBottomLir();
+	}
+
+	TrimStack();
+}
+
+uint32_t TextureCachePolicyLirs::GetCapacity() const
+{
+	return _slots.GetCapacity();
+}
+
+uint32_t TextureCachePolicyLirs::GetUsedCount() const
+{
+	return _slots.GetUsedCount();
+}
+
+uint32_t TextureCachePolicyLirs::GetUsedInFrameCount() const
+{
+	return _slots.GetUsedInFrameCount();
+}
+
+uint32_t TextureCachePolicyLirs::GetResetCount() const
+{
+	return _resetCount;
+}
+
+_Use_decl_annotations_
+uint64_t TextureCachePolicyLirs::GetContentKey(
+	int32_t index) const
+{
+	return _slots.GetContentKey(index);
+}
+
+_Use_decl_annotations_
+TextureCategory TextureCachePolicyLirs::GetCategory(
+	int32_t index) const
+{
+	return _slots.GetCategory(index);
+}
+
+_Use_decl_annotations_
+uint32_t TextureCachePolicyLirs::GetCategoryCount(
+	TextureCategory category) const
+{
+	return _slots.GetCategoryCount(category);
+}
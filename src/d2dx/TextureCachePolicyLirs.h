@@ -0,0 +1,126 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "ITextureCachePolicy.h"
+#include "TextureCacheSlots.h"
+
+#include <list>
+#include <unordered_map>
+
+namespace d2dx
+{
+	/*
+		LIRS replacement (Jiang & Zhang): ranks textures by reuse distance rather than recency.
+		Textures with a short reuse distance (LIR) keep their slots; the remaining
+		1/HirDivisor of the slots hold textures with a long or unknown reuse distance (HIR),
+		and only those are evicted. The stack also remembers some evicted HIR textures, so that
+		they can become LIR if they return soon enough.
+	*/
+	class TextureCachePolicyLirs final : public ITextureCachePolicy
+	{
+	public:
+		static constexpr uint32_t HirDivisor = 32;
+
+		/* Non-resident entries are dropped when the stack grows beyond this many times the capacity. */
+		static constexpr uint32_t MaxStackFactor = 3;
+
+		TextureCachePolicyLirs(
+			_In_ uint32_t capacity,
+			_In_ const std::shared_ptr<ISimd>& simd);
+		virtual ~TextureCachePolicyLirs() noexcept {}
+
+		virtual int32_t Find(
+			_In_ uint64_t contentKey,
+			_In_ int32_t lastIndex) override;
+
+		virtual int32_t Insert(
+			_In_ uint64_t contentKey,
+			_In_ TextureCategory category,
+			_Out_ bool& evicted) override;
+
+		virtual int32_t InsertFree(
+			_In_ uint64_t contentKey,
+			_In_ TextureCategory category) override;
+
+		virtual void OnNewFrame() override;
+
+		virtual void SetCapacity(
+			_In_ uint32_t capacity) override;
+
+		virtual uint32_t GetCapacity() const override;
+
+		virtual uint32_t GetUsedCount() const override;
+
+		virtual uint32_t GetUsedInFrameCount() const override;
+
+		virtual uint32_t GetResetCount() const override;
+
+		virtual uint64_t GetContentKey(
+			_In_ int32_t index) const override;
+
+		virtual TextureCategory GetCategory(
+			_In_ int32_t index) const override;
+
+		virtual uint32_t GetCategoryCount(
+			_In_ TextureCategory category) const override;
+
+	private:
+		struct Entry final
+		{
+			int32_t slot = -1;				// -1 if not resident.
+			bool isLir = false;
+			bool isInStack = false;
+			bool isInQueue = false;
+			std::list<uint64_t>::iterator stackPosition;
+			std::list<uint64_t>::iterator queuePosition;
+		};
+
+		uint32_t GetMaxLirCount() const;
+
+		int32_t FindReplacement(
+			_In_ TextureCacheEviction eviction) const;
+
+		void Evict(
+			_In_ uint64_t contentKey);
+
+		void MoveToStackTop(
+			_In_ uint64_t contentKey,
+			_Inout_ Entry& entry);
+
+		void RemoveFromStack(
+			_Inout_ Entry& entry);
+
+		void RemoveFromQueue(
+			_Inout_ Entry& entry);
+
+		void DemoteBottomLir();
+
+		void PruneStack();
+
+		void TrimStack();
+
+		TextureCacheSlots _slots;
+		std::unordered_map<uint64_t, Entry> _entries;
+		std::list<uint64_t> _stack;			// Front is the most recently used end.
+		std::list<uint64_t> _queue;			// Resident HIR entries; front is evicted first.
+		uint32_t _lirCount = 0;
+		uint32_t _resetCount = 0;
+	};
+}
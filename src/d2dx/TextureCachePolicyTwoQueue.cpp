@@ -0,0 +1,242 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "Utils.h"
+#include "TextureCachePolicyTwoQueue.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+TextureCachePolicyTwoQueue::TextureCachePolicyTwoQueue(
+	uint32_t capacity,
+	const std::shared_ptr<ISimd>& simd) :
+	_slots{ capacity, simd },
+	_queues{ capacity }
+{
+}
+
+_Use_decl_annotations_
+int32_t TextureCachePolicyTwoQueue::Find(
+	uint64_t contentKey,
+	int32_t lastIndex)
+{
+	const int32_t index = _slots.Find(contentKey, lastIndex);
+
+	if (index >= 0)
+	{
+		_slots.MarkUsedInFrame(index);
+
+		if (_queues.GetList(index) == Queue::Main)
+		{
+			_queues.Remove(index);
+			_queues.PushFront(Queue::Main, index);
+		}
+	}
+
+	return index;
+}
+
+_Use_decl_annotations_
+int32_t TextureCachePolicyTwoQueue::Insert(
+	uint64_t contentKey,
+	TextureCategory category,
+	bool& evicted)
+{
+	if (_slots.GetCapacity() == 0)
+	{
+		evicted = false;
+		return -1;
+	}
+
+	const TextureCacheEviction eviction = _slots.GetEviction(category);
+	int32_t replacementIndex = -1;
+
+	if (eviction == TextureCacheEviction::Pinned)
+	{
+		replacementIndex = FindReplacement(eviction);
+	}
+
+	if (replacementIndex < 0)
+	{
+		replacementIndex = _slots.FindFree();
+	}
+
+	if (replacementIndex < 0 && eviction != TextureCacheEviction::Pinned)
+	{
+		replacementIndex = FindReplacement(eviction);
+	}
+
+	if (replacementIndex < 0)
+	{
+		replacementIndex = FindReplacement(TextureCacheEviction::Any);
+	}
+
+	if (replacementIndex < 0)
+	{
+		D2DX_LOG("All texture atlas entries used in a single frame, starting over!");
+		_slots.ClearUsedInFrame();
+		++_resetCount;
+		replacementIndex = FindReplacement(eviction);
+	}
+
+	if (_queues.GetList(replacementIndex) == Queue::In)
+	{
+		_out.PushFront(_slots.GetContentKey(replacementIndex));
+		TrimOut();
+	}
+
+	_queues.Remove(replacementIndex);
+
+	if (_out.Contains(contentKey))
+	{
+		_out.Remove(contentKey);
+		_queues.PushFront(Queue::Main, replacementIndex);
+	}
+	else
+	{
+		_queues.PushFront(Queue::In, replacementIndex);
+	}
+
+	_slots.MarkUsedInFrame(replacementIndex);
+
+	evicted = _slots.Assign(replacementIndex, contentKey, category);
+
+	return replacementIndex;
+}
+
+_Use_decl_annotations_
+int32_t TextureCachePolicyTwoQueue::InsertFree(
+	uint64_t contentKey,
+	TextureCategory category)
+{
+	const int32_t index = _slots.FindFree();
+
+	if (index < 0)
+	{
+		return -1;
+	}
+
+	_queues.PushFront(Queue::In, index);
+
+	const bool evicted = _slots.Assign(index, contentKey, category);
+	assert(!evicted);
+
+	return index;
+}
+
+_Use_decl_annotations_
+int32_t TextureCachePolicyTwoQueue::FindReplacement(
+	TextureCacheEviction eviction) const
+{
+	const bool preferIn =
+		_queues.GetSize(Queue::In) > max(1U, _slots.GetCapacity() / InDivisor) ||
+		_queues.GetSize(Queue::Main) == 0;
+
+	const int32_t index = FindReplacementInQueue(preferIn ? Queue::In : Queue::Main, eviction);
+
+	return index >= 0 ? index : FindReplacementInQueue(preferIn ? Queue::Main : Queue::In, eviction);
+}
+
+_Use_decl_annotations_
+int32_t TextureCachePolicyTwoQueue::FindReplacementInQueue(
+	Queue queue,
+	TextureCacheEviction eviction) const
+{
+	for (int32_t index = _queues.GetBack(queue); index >= 0; index = _queues.GetPrevious(index))
+	{
+		if (_slots.CanEvict(index, eviction))
+		{
+			return index;
+		}
+	}
+
+	return -1;
+}
+
+void TextureCachePolicyTwoQueue::TrimOut()
+{
+	const uint32_t maxOutSize = max(1U, _slots.GetCapacity() / OutDivisor);
+
+	while (_out.GetSize() > maxOutSize)
+	{
+		_out.PopBack();
+	}
+}
+
+void TextureCachePolicyTwoQueue::OnNewFrame()
+{
+	_slots.ClearUsedInFrame();
+}
+
+_Use_decl_annotations_
+void TextureCachePolicyTwoQueue::SetCapacity(
+	uint32_t capacity)
+{
+	assert(!(capacity & 63));
+
+	if (capacity == _slots.GetCapacity())
+	{
+		return;
+	}
+
+	_queues.SetCapacity(capacity);
+	_slots.SetCapacity(capacity);
+	TrimOut();
+}
+
+uint32_t TextureCachePolicyTwoQueue::GetCapacity() const
+{
+	return _slots.GetCapacity();
+}
+
+uint32_t TextureCachePolicyTwoQueue::GetUsedCount() const
+{
+	return _slots.GetUsedCount();
+}
+
+uint32_t TextureCachePolicyTwoQueue::GetUsedInFrameCount() const
+{
+	return _slots.GetUsedInFrameCount();
+}
+
+uint32_t TextureCachePolicyTwoQueue::GetResetCount() const
+{
+	return _resetCount;
+}
+
+_Use_decl_annotations_
+uint64_t TextureCachePolicyTwoQueue::GetContentKey(
+	int32_t index) const
+{
+	return _slots.GetContentKey(index);
+}
+
+_Use_decl_annotations_
+TextureCategory TextureCachePolicyTwoQueue::GetCategory(
+	int32_t index) const
+{
+	return _slots.GetCategory(index);
+}
+
+_Use_decl_annotations_
+uint32_t TextureCachePolicyTwoQueue::GetCategoryCount(
+	TextureCategory category) const
+{
+	return _slots.GetCategoryCount(category);
+}
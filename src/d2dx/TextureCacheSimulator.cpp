@@ -0,0 +1,61 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "TextureCacheSimulator.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+void TextureCacheSimulator::Run(
+	TextureCachePolicyType policyType,
+	uint32_t capacity,
+	const std::shared_ptr<ISimd>& simd,
+	const TextureKeyLogRecord* records,
+	uint32_t recordCount,
+	TextureCacheSimulationResult* result)
+{
+	auto policy = TextureCachePolicyFactory::Create(policyType, capacity, simd);
+
+	*result = { };
+
+	for (uint32_t i = 0; i < recordCount; ++i)
+	{
+		const TextureKeyLogRecord& record = records[i];
+
+		if (record.contentKey == 0)
+		{
+			policy->OnNewFrame();
+			continue;
+		}
+
+		++result->lookupCount;
+
+		if (policy->Find(record.contentKey, -1) < 0)
+		{
+			const TextureCategory category = record.category < (uint8_t)TextureCategory::Count ?
+				(TextureCategory)record.category : TextureCategory::Unknown;
+
+			bool evicted = false;
+			policy->Insert(record.contentKey, category, evicted);
+			++result->missCount;
+		}
+	}
+
+	result->resetCount = policy->GetResetCount();
+}
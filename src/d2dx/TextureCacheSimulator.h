@@ -0,0 +1,49 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "TextureCachePolicyFactory.h"
+#include "TextureKeyLog.h"
+
+namespace d2dx
+{
+	struct TextureCacheSimulationResult final
+	{
+		uint64_t lookupCount;
+		uint64_t missCount;
+		uint32_t resetCount;
+	};
+
+	/*
+		Replays texture key log records against a texture cache policy the way TextureCache
+		uses it: a lookup, an insert on a miss, and a new frame at each end-of-frame record.
+		The records must all belong to the same size class.
+	*/
+	class TextureCacheSimulator final
+	{
+	public:
+		static void Run(
+			_In_ TextureCachePolicyType policyType,
+			_In_ uint32_t capacity,
+			_In_ const std::shared_ptr<ISimd>& simd,
+			_In_reads_(recordCount) const TextureKeyLogRecord* records,
+			_In_ uint32_t recordCount,
+			_Out_ TextureCacheSimulationResult* result);
+	};
+}
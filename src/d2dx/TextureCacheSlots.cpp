@@ -0,0 +1,362 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "TextureCacheSlots.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+TextureCacheSlots::TextureCacheSlots(
+	uint32_t capacity,
+	const std::shared_ptr<ISimd>& simd) :
+	_capacity{ capacity },
+	_simd{ simd },
+	_contentKeys{ capacity, true },
+	_usedInFrameBits{ capacity >> 5, true },
+	_categories{ capacity, true }
+{
+	assert(!(capacity & 63));
+	assert(simd);
+
+	RebuildIndex();
+}
+
+_Use_decl_annotations_
+int32_t TextureCacheSlots::Find(
+	uint64_t contentKey,
+	int32_t lastIndex) const
+{
+	assert(contentKey != 0);
+
+	if (lastIndex >= 0 && lastIndex < (int32_t)_capacity &&
+		contentKey == _contentKeys.items[lastIndex])
+	{
+		return lastIndex;
+	}
+
+	if (_capacity == 0)
+	{
+		return -1;
+	}
+
+	int32_t findIndex = -1;
+
+	for (uint32_t bucket = GetIndexBucket(contentKey); _index.items[bucket] != 0; bucket = (bucket + 1) & _indexMask)
+	{
+		const int32_t slot = (int32_t)_index.items[bucket] - 1;
+
+		if (_contentKeys.items[slot] == contentKey)
+		{
+			findIndex = slot;
+			break;
+		}
+	}
+
+	assert(findIndex == _simd->IndexOfUInt64(_contentKeys.items, _capacity, contentKey));
+
+	return findIndex;
+}
+
+int32_t TextureCacheSlots::FindFree() const
+{
+	if (_usedCount >= _capacity)
+	{
+		return -1;
+	}
+
+	return _simd->IndexOfUInt64(_contentKeys.items, _capacity, 0);
+}
+
+_Use_decl_annotations_
+bool TextureCacheSlots::Assign(
+	int32_t slot,
+	uint64_t contentKey,
+	TextureCategory category)
+{
+	assert(slot >= 0 && slot < (int32_t)_capacity);
+	assert(contentKey != 0);
+
+	const bool evicted = _contentKeys.items[slot] != 0;
+
+	if (evicted)
+	{
+		RemoveFromIndex(_contentKeys.items[slot], slot);
+		--_categoryCounts[_categories.items[slot]];
+	}
+	else
+	{
+		++_usedCount;
+	}
+
+	_contentKeys.items[slot] = contentKey;
+	AddToIndex(contentKey, slot);
+
+	_categories.items[slot] = (uint8_t)category;
+	++_categoryCounts[(int32_t)category];
+
+	return evicted;
+}
+
+_Use_decl_annotations_
+void TextureCacheSlots::MarkUsedInFrame(
+	int32_t slot)
+{
+	const uint32_t mask = 1U << (slot & 31);
+
+	if (!(_usedInFrameBits.items[slot >> 5] & mask))
+	{
+		_usedInFrameBits.items[slot >> 5] |= mask;
+		++_usedInFrameCount;
+	}
+}
+
+_Use_decl_annotations_
+bool TextureCacheSlots::IsUsedInFrame(
+	int32_t slot) const
+{
+	return (_usedInFrameBits.items[slot >> 5] >> (slot & 31)) & 1;
+}
+
+void TextureCacheSlots::ClearUsedInFrame()
+{
+	memset(_usedInFrameBits.items, 0, sizeof(uint32_t) * _usedInFrameBits.capacity);
+	_usedInFrameCount = 0;
+}
+
+_Use_decl_annotations_
+bool TextureCacheSlots::IsPinned(
+	TextureCategory category)
+{
+	return category == TextureCategory::UserInterface || category == TextureCategory::MousePointer;
+}
+
+uint32_t TextureCacheSlots::GetPinnedCount() const
+{
+	return GetCategoryCount(TextureCategory::UserInterface) + GetCategoryCount(TextureCategory::MousePointer);
+}
+
+_Use_decl_annotations_
+TextureCacheEviction TextureCacheSlots::GetEviction(
+	TextureCategory category) const
+{
+	const uint32_t pinnedQuota = _capacity / PinnedQuotaDivisor;
+	const uint32_t pinnedCount = GetPinnedCount();
+
+	if (IsPinned(category))
+	{
+		return pinnedCount >= pinnedQuota ? TextureCacheEviction::Pinned : TextureCacheEviction::Any;
+	}
+
+	return pinnedCount <= pinnedQuota ? TextureCacheEviction::Unpinned : TextureCacheEviction::Any;
+}
+
+_Use_decl_annotations_
+bool TextureCacheSlots::CanEvict(
+	int32_t slot,
+	TextureCacheEviction eviction) const
+{
+	if (IsUsedInFrame(slot))
+	{
+		return false;
+	}
+
+	switch (eviction)
+	{
+	case TextureCacheEviction::Unpinned:
+		return !IsPinned(GetCategory(slot));
+	case TextureCacheEviction::Pinned:
+		return IsPinned(GetCategory(slot));
+	default:
+		return true;
+	}
+}
+
+const uint32_t* TextureCacheSlots::GetUsedInFrameBits() const
+{
+	return _usedInFrameBits.items;
+}
+
+_Use_decl_annotations_
+void TextureCacheSlots::SetCapacity(
+	uint32_t capacity)
+{
+	assert(!(capacity & 63));
+
+	if (capacity == _capacity)
+	{
+		return;
+	}
+
+	const uint32_t keptCount = min(capacity, _capacity);
+
+	Buffer<uint64_t> contentKeys(capacity, true);
+	Buffer<uint32_t> usedInFrameBits(capacity >> 5, true);
+	Buffer<uint8_t> categories(capacity, true);
+
+	memcpy(contentKeys.items, _contentKeys.items, sizeof(uint64_t) * keptCount);
+	memcpy(usedInFrameBits.items, _usedInFrameBits.items, sizeof(uint32_t) * (keptCount >> 5));
+	memcpy(categories.items, _categories.items, keptCount);
+
+	_capacity = capacity;
+	_contentKeys = std::move(contentKeys);
+	_usedInFrameBits = std::move(usedInFrameBits);
+	_categories = std::move(categories);
+
+	_usedCount = 0;
+	_usedInFrameCount = 0;
+	memset(_categoryCounts, 0, sizeof(_categoryCounts));
+
+	for (uint32_t i = 0; i < keptCount; ++i)
+	{
+		if (_contentKeys.items[i] != 0)
+		{
+			++_usedCount;
+			++_categoryCounts[_categories.items[i]];
+		}
+
+		_usedInFrameCount += IsUsedInFrame((int32_t)i) ? 1 : 0;
+	}
+
+	RebuildIndex();
+}
+
+_Use_decl_annotations_
+uint64_t TextureCacheSlots::GetContentKey(
+	int32_t slot) const
+{
+	assert(slot >= 0 && slot < (int32_t)_capacity);
+	return _contentKeys.items[slot];
+}
+
+_Use_decl_annotations_
+TextureCategory TextureCacheSlots::GetCategory(
+	int32_t slot) const
+{
+	assert(slot >= 0 && slot < (int32_t)_capacity);
+	return (TextureCategory)_categories.items[slot];
+}
+
+uint32_t TextureCacheSlots::GetCapacity() const
+{
+	return _capacity;
+}
+
+uint32_t TextureCacheSlots::GetUsedCount() const
+{
+	return _usedCount;
+}
+
+uint32_t TextureCacheSlots::GetUsedInFrameCount() const
+{
+	return _usedInFrameCount;
+}
+
+_Use_decl_annotations_
+uint32_t TextureCacheSlots::GetCategoryCount(
+	TextureCategory category) const
+{
+	return _categoryCounts[(int32_t)category];
+}
+
+void TextureCacheSlots::RebuildIndex()
+{
+	/* Keep the load factor of the index at or below 1/2, so probe sequences stay short. */
+	uint32_t indexSizeLog2 = 1;
+	while ((1U << indexSizeLog2) < _capacity * 2)
+	{
+		++indexSizeLog2;
+	}
+
+	_index = Buffer<uint32_t>(1U << indexSizeLog2, true);
+	_indexMask = (1U << indexSizeLog2) - 1;
+	_indexShift = 32 - indexSizeLog2;
+
+	for (uint32_t i = 0; i < _capacity; ++i)
+	{
+		if (_contentKeys.items[i] != 0)
+		{
+			AddToIndex(_contentKeys.items[i], (int32_t)i);
+		}
+	}
+}
+
+_Use_decl_annotations_
+uint32_t TextureCacheSlots::GetIndexBucket(
+	uint64_t contentKey) const
+{
+	/* Fibonacci hashing; the top bits of the product are the best mixed. */
+	return ((uint32_t)(contentKey ^ (contentKey >> 32)) * 0x9E3779B1U) >> _indexShift;
+}
+
+_Use_decl_annotations_
+void TextureCacheSlots::AddToIndex(
+	uint64_t contentKey,
+	int32_t slot)
+{
+	uint32_t bucket = GetIndexBucket(contentKey);
+
+	while (_index.items[bucket] != 0)
+	{
+		bucket = (bucket + 1) & _indexMask;
+	}
+
+	_index.items[bucket] = (uint32_t)slot + 1;
+}
+
+_Use_decl_annotations_
+void TextureCacheSlots::RemoveFromIndex(
+	uint64_t contentKey,
+	int32_t slot)
+{
+	uint32_t hole = GetIndexBucket(contentKey);
+
+	while (_index.items[hole] != (uint32_t)slot + 1)
+	{
+		assert(_index.items[hole] != 0);
+		hole = (hole + 1) & _indexMask;
+	}
+
+	/* Backward shift deletion: pull later entries of the probe run into the hole unless
+	   that would move them in front of their home bucket. No tombstones needed. */
+	uint32_t bucket = hole;
+
+	for (;;)
+	{
+		bucket = (bucket + 1) & _indexMask;
+
+		if (_index.items[bucket] == 0)
+		{
+			break;
+		}
+
+		const uint32_t home = GetIndexBucket(_contentKeys.items[_index.items[bucket] - 1]);
+
+		const bool homeInRange = hole <= bucket ?
+			(hole < home && home <= bucket) :
+			(hole < home || home <= bucket);
+
+		if (!homeInRange)
+		{
+			_index.items[hole] = _index.items[bucket];
+			hole = bucket;
+		}
+	}
+
+	_index.items[hole] = 0;
+}
@@ -0,0 +1,142 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+#include "ISimd.h"
+#include "Types.h"
+
+namespace d2dx
+{
+	/* Which entries may be evicted to make room for a new texture; see TextureCacheSlots::GetEviction. */
+	enum class TextureCacheEviction
+	{
+		Any = 0,
+		Unpinned = 1,
+		Pinned = 2,
+	};
+
+	/*
+		Slot bookkeeping shared by the texture cache policies: the content key and category of
+		each slot, an index from content key to slot, and which slots have been used in the
+		current frame. A content key of zero marks a free slot.
+
+		UserInterface and MousePointer textures are pinned: as long as they occupy at most
+		1/PinnedQuotaDivisor of the slots, other categories cannot evict them, and once they
+		reach that quota they replace each other. Every policy applies this through
+		GetEviction and CanEvict.
+	*/
+	class TextureCacheSlots final
+	{
+	public:
+		static constexpr uint32_t PinnedQuotaDivisor = 8;
+
+		TextureCacheSlots() = default;
+		TextureCacheSlots& operator=(TextureCacheSlots&& rhs) = default;
+
+		TextureCacheSlots(
+			_In_ uint32_t capacity,
+			_In_ const std::shared_ptr<ISimd>& simd);
+		~TextureCacheSlots() noexcept {}
+
+		/* Returns the slot holding contentKey, or -1. lastIndex is a hint, or -1. */
+		int32_t Find(
+			_In_ uint64_t contentKey,
+			_In_ int32_t lastIndex) const;
+
+		/* Returns the first free slot, or -1. */
+		int32_t FindFree() const;
+
+		/* Stores contentKey in the slot. Returns true if another entry was evicted from it. */
+		bool Assign(
+			_In_ int32_t slot,
+			_In_ uint64_t contentKey,
+			_In_ TextureCategory category);
+
+		void MarkUsedInFrame(
+			_In_ int32_t slot);
+
+		bool IsUsedInFrame(
+			_In_ int32_t slot) const;
+
+		void ClearUsedInFrame();
+
+		static bool IsPinned(
+			_In_ TextureCategory category);
+
+		uint32_t GetPinnedCount() const;
+
+		/* Returns which entries the pinned quota lets a new texture of the category evict. */
+		TextureCacheEviction GetEviction(
+			_In_ TextureCategory category) const;
+
+		/* Returns whether the entry in the slot may be evicted: it must not have been used in the
+		   current frame, and its category must match the eviction. */
+		bool CanEvict(
+			_In_ int32_t slot,
+			_In_ TextureCacheEviction eviction) const;
+
+		const uint32_t* GetUsedInFrameBits() const;
+
+		/* Entries below the new capacity keep their slots; the others are dropped. */
+		void SetCapacity(
+			_In_ uint32_t capacity);
+
+		uint64_t GetContentKey(
+			_In_ int32_t slot) const;
+
+		TextureCategory GetCategory(
+			_In_ int32_t slot) const;
+
+		uint32_t GetCapacity() const;
+
+		uint32_t GetUsedCount() const;
+
+		uint32_t GetUsedInFrameCount() const;
+
+		uint32_t GetCategoryCount(
+			_In_ TextureCategory category) const;
+
+	private:
+		void RebuildIndex();
+
+		uint32_t GetIndexBucket(
+			_In_ uint64_t contentKey) const;
+
+		void AddToIndex(
+			_In_ uint64_t contentKey,
+			_In_ int32_t slot);
+
+		void RemoveFromIndex(
+			_In_ uint64_t contentKey,
+			_In_ int32_t slot);
+
+		uint32_t _capacity = 0;
+		std::shared_ptr<ISimd> _simd;
+		Buffer<uint64_t> _contentKeys;
+		Buffer<uint32_t> _index;			// Open addressing content key -> slot + 1 (0 = empty).
+		uint32_t _indexMask = 0;
+		uint32_t _indexShift = 0;
+		Buffer<uint32_t> _usedInFrameBits;
+		Buffer<uint8_t> _categories;
+		uint32_t _categoryCounts[(int32_t)TextureCategory::Count] = {};
+		uint32_t _usedCount = 0;
+		uint32_t _usedInFrameCount = 0;
+	};
+}
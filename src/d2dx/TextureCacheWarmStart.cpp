@@ -0,0 +1,87 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "TextureCacheWarmStart.h"
+#include "Utils.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+TextureCacheWarmStart::TextureCacheWarmStart(
+	const char* filename,
+	const std::shared_ptr<ISimd>& simd) :
+	_simd{ simd }
+{
+	_loaderThread = std::thread(&TextureCacheWarmStart::LoaderThreadMain, this, std::string{ filename });
+}
+
+TextureCacheWarmStart::~TextureCacheWarmStart() noexcept
+{
+	WaitForLoad();
+}
+
+_Use_decl_annotations_
+void TextureCacheWarmStart::LoaderThreadMain(
+	std::string filename)
+{
+	auto view = std::make_unique<TextureCacheFileView>(filename.c_str());
+
+	if (view->Validate(_simd.get()))
+	{
+		D2DX_LOG("Preloading %u textures from %s.", view->GetEntryCount(), filename.c_str());
+		_view = std::move(view);
+	}
+	else if (view->GetEntryCount() > 0)
+	{
+		D2DX_LOG("Ignoring %s, which is damaged or was written by another version.", filename.c_str());
+	}
+
+	_isLoaded.store(true, std::memory_order_release);
+}
+
+const TextureCacheFileEntry* TextureCacheWarmStart::GetNextEntry()
+{
+	if (!_isLoaded.load(std::memory_order_acquire) || !_view || _nextEntry >= _view->GetEntryCount())
+	{
+		return nullptr;
+	}
+
+	return &_view->GetEntry(_nextEntry++);
+}
+
+_Use_decl_annotations_
+const uint8_t* TextureCacheWarmStart::GetPixels(
+	const TextureCacheFileEntry& entry) const
+{
+	assert(_view);
+	return _view->GetPixels(entry);
+}
+
+bool TextureCacheWarmStart::IsDone() const
+{
+	return _isLoaded.load(std::memory_order_acquire) && (!_view || _nextEntry >= _view->GetEntryCount());
+}
+
+void TextureCacheWarmStart::WaitForLoad()
+{
+	if (_loaderThread.joinable())
+	{
+		_loaderThread.join();
+	}
+}
@@ -0,0 +1,69 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "ISimd.h"
+#include "TextureCacheFile.h"
+
+#include <atomic>
+#include <thread>
+
+namespace d2dx
+{
+	/*
+		Preloads the textures saved by the previous session. The file is mapped and validated on
+		a background thread, which also brings all of it into memory; the game thread then takes
+		the entries in file order and inserts them into the texture caches, a few per frame.
+	*/
+	class TextureCacheWarmStart final
+	{
+	public:
+		TextureCacheWarmStart(
+			_In_z_ const char* filename,
+			_In_ const std::shared_ptr<ISimd>& simd);
+
+		~TextureCacheWarmStart() noexcept;
+
+		TextureCacheWarmStart(const TextureCacheWarmStart&) = delete;
+
+		TextureCacheWarmStart& operator=(const TextureCacheWarmStart&) = delete;
+
+		/* Returns the next entry to preload, or nullptr if the file is still loading or has no more entries. */
+		const TextureCacheFileEntry* GetNextEntry();
+
+		const uint8_t* GetPixels(
+			_In_ const TextureCacheFileEntry& entry) const;
+
+		/* True when loading has finished and every entry has been taken (or the file was unusable). */
+		bool IsDone() const;
+
+		/* Blocks until the background thread has finished. */
+		void WaitForLoad();
+
+	private:
+		void LoaderThreadMain(
+			_In_ std::string filename);
+
+		std::shared_ptr<ISimd> _simd;
+		std::unique_ptr<TextureCacheFileView> _view;
+		std::atomic<bool> _isLoaded = false;
+		uint32_t _nextEntry = 0;
+		std::thread _loaderThread;
+	};
+}
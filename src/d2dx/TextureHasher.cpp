@@ -23,42 +23,113 @@
 
 using namespace d2dx;
 
-TextureHasher::TextureHasher() :
+_Use_decl_annotations_
+TextureHasher::TextureHasher(
+	const std::shared_ptr<ISimd>& simd) :
+	_simd{ simd },
 	_cache{ D2DX_TMU_MEMORY_SIZE / 256, true },
+	_slotExtents{ D2DX_TMU_MEMORY_SIZE / 256, true },
+	_coverStarts{ D2DX_TMU_MEMORY_SIZE / 256 },
 	_cacheHits{ 0 },
 	_cacheMisses{ 0 }
 {
+	assert(simd);
+
+	for (uint32_t i = 0; i < _coverStarts.capacity; ++i)
+	{
+		_coverStarts.items[i] = (uint16_t)i;
+	}
 }
 
 _Use_decl_annotations_
 void TextureHasher::Invalidate(
-	uint32_t startAddress)
+	uint32_t startAddress,
+	uint32_t size)
+{
+	const uint32_t firstSlot = startAddress >> 8;
+	const uint32_t endSlot = min(_cache.capacity, (startAddress + max(size, 1U) + 255) >> 8);
+
+	if (firstSlot >= endSlot)
+	{
+		return;
+	}
+
+	/* Textures starting before the range can only overlap it by covering its first slot.
+	   _coverStarts tells how far back such textures may start, but it only moves forward on
+	   invalidation and can be stale, so the scan is also limited by the largest extent
+	   recorded: it visits fewer than _maxSlotExtent slots. */
+	const uint32_t extentStart = firstSlot >= _maxSlotExtent ? firstSlot + 1 - _maxSlotExtent : 0;
+	const uint32_t scanStart = max((uint32_t)_coverStarts.items[firstSlot], extentStart);
+
+	for (uint32_t slot = scanStart; slot < firstSlot; ++slot)
+	{
+		if (slot + _slotExtents.items[slot] > firstSlot)
+		{
+			_cache.items[slot] = 0;
+		}
+	}
+
+	for (uint32_t slot = firstSlot; slot < endSlot; ++slot)
+	{
+		_cache.items[slot] = 0;
+		_coverStarts.items[slot] = (uint16_t)slot;
+	}
+}
+
+_Use_decl_annotations_
+void TextureHasher::SetSlotExtent(
+	uint32_t slot,
+	uint32_t size)
+{
+	const uint32_t endSlot = min(_cache.capacity, slot + ((max(size, 1U) + 255) >> 8));
+
+	_slotExtents.items[slot] = (uint16_t)(endSlot - slot);
+	_maxSlotExtent = max(_maxSlotExtent, endSlot - slot);
+
+	for (uint32_t i = slot + 1; i < endSlot; ++i)
+	{
+		_coverStarts.items[i] = min(_coverStarts.items[i], (uint16_t)slot);
+	}
+}
+
+_Use_decl_annotations_
+void TextureHasher::SetHash(
+	uint32_t startAddress,
+	uint64_t contentKey,
+	uint32_t pixelsSize)
 {
-	_cache.items[startAddress >> 8] = 0;
+	assert((startAddress & 255) == 0);
+	assert(contentKey != 0);
+
+	Invalidate(startAddress, pixelsSize);
+	SetSlotExtent(startAddress >> 8, pixelsSize);
+
+	_cache.items[startAddress >> 8] = contentKey;
 }
 
 _Use_decl_annotations_
-uint32_t TextureHasher::GetHash(
+uint64_t TextureHasher::GetHash(
 	uint32_t startAddress,
 	const uint8_t* pixels,
 	uint32_t pixelsSize)
 {
 	assert((startAddress & 255) == 0);
 
-	uint32_t hash = _cache.items[startAddress >> 8];
+	uint64_t contentKey = _cache.items[startAddress >> 8];
 
-	if (hash)
+	if (contentKey)
 	{
 		++_cacheHits;
 	}
 	else
 	{
 		++_cacheMisses;
-		hash = fnv_32a_buf((void*)pixels, pixelsSize, FNV1_32A_INIT);
-		_cache.items[startAddress >> 8] = hash;
+		contentKey = _simd->HashBytes64(pixels, pixelsSize);
+		SetSlotExtent(startAddress >> 8, pixelsSize);
+		_cache.items[startAddress >> 8] = contentKey;
 	}
 
-	return hash;
+	return contentKey;
 }
 
 void TextureHasher::PrintStats()
@@ -19,19 +19,32 @@
 #pragma once
 
 #include "Buffer.h"
+#include "ISimd.h"
 
 namespace d2dx
 {
 	class TextureHasher final
 	{
 	public:
-		TextureHasher();
+		TextureHasher(
+			_In_ const std::shared_ptr<ISimd>& simd);
 		~TextureHasher() noexcept {}
 
+		/* Invalidates the cached hash of every texture overlapping the range
+		   [startAddress, startAddress + size). */
 		void Invalidate(
-			_In_ uint32_t startAddress);
+			_In_ uint32_t startAddress,
+			_In_ uint32_t size);
 
-		uint32_t GetHash(
+		/* Stores a content key computed elsewhere (e.g. while downloading the texture), so
+		   that the next GetHash at this address is a hit. */
+		void SetHash(
+			_In_ uint32_t startAddress,
+			_In_ uint64_t contentKey,
+			_In_ uint32_t pixelsSize);
+
+		/* Returns the 64-bit content key (WideHash) of the texture. */
+		uint64_t GetHash(
 			_In_ uint32_t startAddress,
 			_In_reads_(pixelsSize) const uint8_t* pixels,
 			_In_ uint32_t pixelsSize);
@@ -39,7 +52,15 @@ namespace d2dx
 		void PrintStats();
 
 	private:
-		Buffer<uint32_t> _cache;
+		void SetSlotExtent(
+			_In_ uint32_t slot,
+			_In_ uint32_t size);
+
+		std::shared_ptr<ISimd> _simd;
+		Buffer<uint64_t> _cache;
+		Buffer<uint16_t> _slotExtents;		// Number of 256-byte slots spanned by the texture hashed at a slot.
+		Buffer<uint16_t> _coverStarts;		// Lowest slot whose texture may extend over this slot.
+		uint32_t _maxSlotExtent = 1;		// Largest _slotExtents entry ever recorded.
 		uint32_t _cacheHits;
 		uint32_t _cacheMisses;
 	};
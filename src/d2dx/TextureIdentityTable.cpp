@@ -0,0 +1,93 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "TextureIdentityTable.h"
+
+using namespace d2dx;
+
+TextureIdentityTable::TextureIdentityTable() :
+	_contentKeys{ BucketCount, true },
+	_identityHashes{ BucketCount },
+	_categories{ BucketCount }
+{
+}
+
+_Use_decl_annotations_
+bool TextureIdentityTable::Find(
+	uint64_t contentKey,
+	uint32_t& identityHash,
+	TextureCategory& category) const
+{
+	assert(contentKey != 0);
+
+	for (uint32_t bucket = GetBucket(contentKey); _contentKeys.items[bucket] != 0; bucket = (bucket + 1) & (BucketCount - 1))
+	{
+		if (_contentKeys.items[bucket] == contentKey)
+		{
+			identityHash = _identityHashes.items[bucket];
+			category = (TextureCategory)_categories.items[bucket];
+			return true;
+		}
+	}
+
+	identityHash = 0;
+	category = TextureCategory::Unknown;
+	return false;
+}
+
+_Use_decl_annotations_
+void TextureIdentityTable::Insert(
+	uint64_t contentKey,
+	uint32_t identityHash,
+	TextureCategory category)
+{
+	assert(contentKey != 0);
+
+	if (_count >= MaxCount)
+	{
+		memset(_contentKeys.items, 0, sizeof(uint64_t) * _contentKeys.capacity);
+		_count = 0;
+	}
+
+	uint32_t bucket = GetBucket(contentKey);
+
+	while (_contentKeys.items[bucket] != 0)
+	{
+		assert(_contentKeys.items[bucket] != contentKey);
+		bucket = (bucket + 1) & (BucketCount - 1);
+	}
+
+	_contentKeys.items[bucket] = contentKey;
+	_identityHashes.items[bucket] = identityHash;
+	_categories.items[bucket] = (uint8_t)category;
+	++_count;
+}
+
+uint32_t TextureIdentityTable::GetCount() const
+{
+	return _count;
+}
+
+_Use_decl_annotations_
+uint32_t TextureIdentityTable::GetBucket(
+	uint64_t contentKey) const
+{
+	/* Fibonacci hashing, as in TextureCacheSlots. */
+	return ((uint32_t)(contentKey ^ (contentKey >> 32)) * 0x9E3779B1U) >> (32 - BucketCountLog2);
+}
@@ -0,0 +1,65 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+#include "Types.h"
+
+namespace d2dx
+{
+	/*
+		Maps texture content keys (WideHash) to the FNV-1a hash and category of the content, so
+		that the FNV-1a hash, which the known game textures are listed by, is computed only
+		once per content. The table has a fixed number of buckets and is cleared when it is
+		half full, which takes far more distinct textures than a play session shows.
+	*/
+	class TextureIdentityTable final
+	{
+	public:
+		static constexpr uint32_t BucketCountLog2 = 17;
+		static constexpr uint32_t BucketCount = 1U << BucketCountLog2;
+		static constexpr uint32_t MaxCount = BucketCount / 2;
+
+		TextureIdentityTable();
+		~TextureIdentityTable() noexcept {}
+
+		/* Returns true and the remembered identity if contentKey is present. */
+		bool Find(
+			_In_ uint64_t contentKey,
+			_Out_ uint32_t& identityHash,
+			_Out_ TextureCategory& category) const;
+
+		/* contentKey must not already be present. */
+		void Insert(
+			_In_ uint64_t contentKey,
+			_In_ uint32_t identityHash,
+			_In_ TextureCategory category);
+
+		uint32_t GetCount() const;
+
+	private:
+		uint32_t GetBucket(
+			_In_ uint64_t contentKey) const;
+
+		Buffer<uint64_t> _contentKeys;		// 0 = empty bucket.
+		Buffer<uint32_t> _identityHashes;
+		Buffer<uint8_t> _categories;
+		uint32_t _count = 0;
+	};
+}
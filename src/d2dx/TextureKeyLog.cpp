@@ -0,0 +1,138 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "TextureKeyLog.h"
+#include "Utils.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+TextureKeyLog::TextureKeyLog(
+	const char* filename) :
+	_records{ 64 * 1024 }
+{
+	if (fopen_s(&_file, filename, "wb") != 0)
+	{
+		_file = nullptr;
+		D2DX_LOG("Failed to open texture key log %s.", filename);
+		return;
+	}
+
+	const TextureKeyLogFileHeader header = { D2DX_TEXTURE_KEY_LOG_MAGIC, D2DX_TEXTURE_KEY_LOG_VERSION };
+	fwrite(&header, sizeof(header), 1, _file);
+
+	D2DX_LOG("Recording texture keys to %s.", filename);
+}
+
+TextureKeyLog::~TextureKeyLog() noexcept
+{
+	if (_file)
+	{
+		Flush();
+		fclose(_file);
+		_file = nullptr;
+	}
+}
+
+_Use_decl_annotations_
+void TextureKeyLog::AddLookup(
+	uint64_t contentKey,
+	int32_t width,
+	int32_t height,
+	TextureCategory category)
+{
+	assert(contentKey != 0);
+
+	TextureKeyLogRecord record = { };
+	record.contentKey = contentKey;
+	record.width = (uint16_t)width;
+	record.height = (uint16_t)height;
+	record.category = (uint8_t)category;
+	AddRecord(record);
+}
+
+void TextureKeyLog::EndFrame()
+{
+	const TextureKeyLogRecord record = { };
+	AddRecord(record);
+}
+
+_Use_decl_annotations_
+void TextureKeyLog::AddRecord(
+	const TextureKeyLogRecord& record)
+{
+	if (!_file)
+	{
+		return;
+	}
+
+	_records.items[_recordCount++] = record;
+
+	if (_recordCount == _records.capacity)
+	{
+		Flush();
+	}
+}
+
+void TextureKeyLog::Flush()
+{
+	if (_recordCount > 0)
+	{
+		fwrite(_records.items, sizeof(TextureKeyLogRecord), _recordCount, _file);
+		_recordCount = 0;
+	}
+}
+
+_Use_decl_annotations_
+bool TextureKeyLog::Load(
+	const char* filename,
+	std::vector<TextureKeyLogRecord>& records)
+{
+	records.clear();
+
+	FILE* file = nullptr;
+
+	if (fopen_s(&file, filename, "rb") != 0)
+	{
+		D2DX_LOG("Failed to open %s for reading.", filename);
+		return false;
+	}
+
+	TextureKeyLogFileHeader header = { };
+
+	if (fread(&header, sizeof(header), 1, file) != 1 ||
+		header.magic != D2DX_TEXTURE_KEY_LOG_MAGIC ||
+		header.version != D2DX_TEXTURE_KEY_LOG_VERSION)
+	{
+		D2DX_LOG("%s is not a texture key log of version %u.", filename, D2DX_TEXTURE_KEY_LOG_VERSION);
+		fclose(file);
+		return false;
+	}
+
+	TextureKeyLogRecord block[1024];
+	size_t count;
+
+	while ((count = fread(block, sizeof(TextureKeyLogRecord), ARRAYSIZE(block), file)) > 0)
+	{
+		records.insert(records.end(), block, block + count);
+	}
+
+	fclose(file);
+	return true;
+}
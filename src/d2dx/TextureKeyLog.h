@@ -0,0 +1,88 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+#include "Types.h"
+
+#include <vector>
+
+#define D2DX_TEXTURE_KEY_LOG_MAGIC 0x4B543244 /* "D2TK" */
+#define D2DX_TEXTURE_KEY_LOG_VERSION 1
+
+namespace d2dx
+{
+#pragma pack(push, 1)
+
+	struct TextureKeyLogFileHeader final
+	{
+		uint32_t magic;
+		uint32_t version;
+	};
+
+	/* One texture cache lookup. A record with a content key of zero marks the end of a frame. */
+	struct TextureKeyLogRecord final
+	{
+		uint64_t contentKey;
+		uint16_t width;
+		uint16_t height;
+		uint8_t category;
+		uint8_t reserved[3];
+	};
+
+#pragma pack(pop)
+
+	static_assert(sizeof(TextureKeyLogRecord) == 16, "sizeof(TextureKeyLogRecord) == 16");
+
+	/*
+		Records the sequence of content keys looked up in the texture caches
+		(-dxdbg_record_texture_keys), for trace-driven simulation of cache policies with
+		d2dxreplay -simulate.
+	*/
+	class TextureKeyLog final
+	{
+	public:
+		TextureKeyLog(
+			_In_z_ const char* filename);
+
+		~TextureKeyLog() noexcept;
+
+		void AddLookup(
+			_In_ uint64_t contentKey,
+			_In_ int32_t width,
+			_In_ int32_t height,
+			_In_ TextureCategory category);
+
+		void EndFrame();
+
+		static bool Load(
+			_In_z_ const char* filename,
+			_Out_ std::vector<TextureKeyLogRecord>& records);
+
+	private:
+		void AddRecord(
+			_In_ const TextureKeyLogRecord& record);
+
+		void Flush();
+
+		FILE* _file = nullptr;
+		Buffer<TextureKeyLogRecord> _records;
+		uint32_t _recordCount = 0;
+	};
+}
@@ -0,0 +1,116 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "TextureUploadRing.h"
+
+#include <algorithm>
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+TextureUploadRing::TextureUploadRing(
+	uint32_t pixelCapacity,
+	uint32_t uploadCapacity) :
+	_pixelCapacity{ pixelCapacity },
+	_uploadCapacity{ uploadCapacity }
+{
+}
+
+_Use_decl_annotations_
+bool TextureUploadRing::Stage(
+	uint32_t slot,
+	int32_t width,
+	int32_t height,
+	const uint8_t* pixels)
+{
+	assert(width > 0 && width <= 65535 && height > 0 && height <= 65535);
+
+	const uint32_t size = (uint32_t)(width * height);
+	assert(size <= _pixelCapacity);
+
+	if (_uploadCount >= _uploadCapacity || size > _pixelCapacity - _pixelCount)
+	{
+		return false;
+	}
+
+	if (!_pixels.items)
+	{
+		_pixels = Buffer<uint8_t>(_pixelCapacity);
+		_uploads = Buffer<TextureUpload>(_uploadCapacity);
+	}
+
+	TextureUpload& upload = _uploads.items[_uploadCount++];
+	upload.slot = slot;
+	upload.offset = _pixelCount;
+	upload.width = (uint16_t)width;
+	upload.height = (uint16_t)height;
+
+	memcpy(_pixels.items + _pixelCount, pixels, size);
+	_pixelCount += size;
+
+	return true;
+}
+
+uint32_t TextureUploadRing::Coalesce()
+{
+	/* Stable, so that uploads to the same slot stay in the order they were staged. */
+	std::stable_sort(_uploads.items, _uploads.items + _uploadCount,
+		[](const TextureUpload& a, const TextureUpload& b) { return a.slot < b.slot; });
+
+	uint32_t keptCount = 0;
+
+	for (uint32_t i = 0; i < _uploadCount; ++i)
+	{
+		if (i + 1 < _uploadCount && _uploads.items[i + 1].slot == _uploads.items[i].slot)
+		{
+			continue;
+		}
+
+		_uploads.items[keptCount++] = _uploads.items[i];
+	}
+
+	_uploadCount = keptCount;
+	return keptCount;
+}
+
+uint32_t TextureUploadRing::GetUploadCount() const
+{
+	return _uploadCount;
+}
+
+_Use_decl_annotations_
+const TextureUpload& TextureUploadRing::GetUpload(
+	uint32_t index) const
+{
+	assert(index < _uploadCount);
+	return _uploads.items[index];
+}
+
+_Use_decl_annotations_
+const uint8_t* TextureUploadRing::GetPixels(
+	const TextureUpload& upload) const
+{
+	return _pixels.items + upload.offset;
+}
+
+void TextureUploadRing::Clear()
+{
+	_pixelCount = 0;
+	_uploadCount = 0;
+}
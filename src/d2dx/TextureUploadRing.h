@@ -0,0 +1,79 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+
+namespace d2dx
+{
+	struct TextureUpload final
+	{
+		uint32_t slot;
+		uint32_t offset;
+		uint16_t width;
+		uint16_t height;
+	};
+
+	/*
+		CPU-side staging area for texture cache uploads. Texture cache misses copy their pixels
+		here during the frame, and the cache submits them all at once before the frame is drawn.
+		Coalesce orders the uploads by slot (and thereby by atlas and array slice) and drops
+		uploads that a later upload to the same slot supersedes. Memory is allocated on first use.
+	*/
+	class TextureUploadRing final
+	{
+	public:
+		TextureUploadRing() = default;
+		TextureUploadRing& operator=(TextureUploadRing&& rhs) = default;
+
+		TextureUploadRing(
+			_In_ uint32_t pixelCapacity,
+			_In_ uint32_t uploadCapacity);
+
+		~TextureUploadRing() noexcept {}
+
+		/* Copies width * height pixels. Returns false if there is no room; submit the staged uploads and retry. */
+		bool Stage(
+			_In_ uint32_t slot,
+			_In_ int32_t width,
+			_In_ int32_t height,
+			_In_reads_(width * height) const uint8_t* pixels);
+
+		/* Returns the number of uploads left to submit. */
+		uint32_t Coalesce();
+
+		uint32_t GetUploadCount() const;
+
+		const TextureUpload& GetUpload(
+			_In_ uint32_t index) const;
+
+		const uint8_t* GetPixels(
+			_In_ const TextureUpload& upload) const;
+
+		void Clear();
+
+	private:
+		uint32_t _pixelCapacity = 0;
+		uint32_t _uploadCapacity = 0;
+		Buffer<uint8_t> _pixels;
+		Buffer<TextureUpload> _uploads;
+		uint32_t _pixelCount = 0;
+		uint32_t _uploadCount = 0;
+	};
+}
@@ -0,0 +1,268 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "TraceEventWriter.h"
+#include "Utils.h"
+
+using namespace d2dx;
+
+static TraceEventWriter* instance = nullptr;
+
+_Use_decl_annotations_
+TraceEventWriter::TraceEventWriter(
+	const char* filename)
+{
+	if (fopen_s(&_file, filename, "w") != 0)
+	{
+		D2DX_LOG("Failed to open %s for writing.", filename);
+		_file = nullptr;
+	}
+
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	_usPerTick = 1000000.0 / (double)frequency.QuadPart;
+	_startTicks = GetTicks();
+
+	if (_file)
+	{
+		fprintf(_file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	}
+
+	_currentChunk = std::make_unique<Chunk>();
+	_writerThread = std::thread(&TraceEventWriter::WriterThreadMain, this);
+
+	D2DX_LOG("Writing trace events to %s.", filename);
+}
+
+TraceEventWriter::~TraceEventWriter() noexcept
+{
+	if (instance == this)
+	{
+		instance = nullptr;
+	}
+
+	Flush();
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopRequested = true;
+	}
+
+	_condition.notify_one();
+
+	if (_writerThread.joinable())
+	{
+		_writerThread.join();
+	}
+
+	/* If the thread was torn down before draining (e.g. at process exit), finish here. */
+	while (!_pendingChunks.empty())
+	{
+		WriteChunk(*_pendingChunks.front());
+		_pendingChunks.pop_front();
+	}
+
+	if (_file)
+	{
+		fprintf(_file, "\n]}\n");
+		fclose(_file);
+		_file = nullptr;
+	}
+}
+
+TraceEventWriter* TraceEventWriter::GetInstance()
+{
+	return instance;
+}
+
+_Use_decl_annotations_
+void TraceEventWriter::SetInstance(
+	TraceEventWriter* newInstance)
+{
+	instance = newInstance;
+}
+
+int64_t TraceEventWriter::GetTicks()
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart;
+}
+
+_Use_decl_annotations_
+TraceEvent& TraceEventWriter::AddEvent(
+	TraceEventType type,
+	const char* name,
+	const char* category,
+	int64_t startTicks,
+	int64_t endTicks)
+{
+	if (_currentChunk->count >= _currentChunk->events.capacity)
+	{
+		Flush();
+	}
+
+	TraceEvent& traceEvent = _currentChunk->events.items[_currentChunk->count++];
+
+	strncpy_s(traceEvent.name, name, _TRUNCATE);
+	traceEvent.category = category;
+	traceEvent.startTicks = startTicks;
+	traceEvent.durationTicks = endTicks - startTicks;
+	traceEvent.threadId = GetCurrentThreadId();
+	traceEvent.type = type;
+	traceEvent.argCount = 0;
+
+	return traceEvent;
+}
+
+_Use_decl_annotations_
+void TraceEventWriter::AddComplete(
+	const char* name,
+	const char* category,
+	int64_t startTicks,
+	int64_t endTicks)
+{
+	AddEvent(TraceEventType::Complete, name, category, startTicks, endTicks);
+}
+
+_Use_decl_annotations_
+void TraceEventWriter::AddInstant(
+	const char* name,
+	const char* category)
+{
+	const int64_t ticks = GetTicks();
+	AddEvent(TraceEventType::Instant, name, category, ticks, ticks);
+}
+
+_Use_decl_annotations_
+void TraceEventWriter::AddArg(
+	TraceEvent& traceEvent,
+	const char* argName,
+	double argValue)
+{
+	assert(traceEvent.argCount < D2DX_TRACE_EVENT_MAX_ARGS);
+
+	if (traceEvent.argCount < D2DX_TRACE_EVENT_MAX_ARGS)
+	{
+		traceEvent.argNames[traceEvent.argCount] = argName;
+		traceEvent.argValues[traceEvent.argCount] = argValue;
+		++traceEvent.argCount;
+	}
+}
+
+void TraceEventWriter::Flush()
+{
+	if (!_currentChunk || _currentChunk->count == 0)
+	{
+		return;
+	}
+
+	std::unique_ptr<Chunk> nextChunk;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_pendingChunks.push_back(std::move(_currentChunk));
+
+		if (!_freeChunks.empty())
+		{
+			nextChunk = std::move(_freeChunks.back());
+			_freeChunks.pop_back();
+		}
+	}
+
+	_condition.notify_one();
+
+	_currentChunk = nextChunk ? std::move(nextChunk) : std::make_unique<Chunk>();
+	_currentChunk->count = 0;
+}
+
+void TraceEventWriter::WriterThreadMain()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	while (true)
+	{
+		_condition.wait(lock, [this] { return _stopRequested || !_pendingChunks.empty(); });
+
+		if (_pendingChunks.empty())
+		{
+			break;
+		}
+
+		std::unique_ptr<Chunk> chunk = std::move(_pendingChunks.front());
+		_pendingChunks.pop_front();
+
+		lock.unlock();
+		WriteChunk(*chunk);
+		lock.lock();
+
+		_freeChunks.push_back(std::move(chunk));
+	}
+}
+
+_Use_decl_annotations_
+void TraceEventWriter::WriteChunk(
+	const Chunk& chunk)
+{
+	if (!_file)
+	{
+		return;
+	}
+
+	static const char* phases[] = { "X", "i", "C" };
+
+	for (uint32_t i = 0; i < chunk.count; ++i)
+	{
+		const TraceEvent& traceEvent = chunk.events.items[i];
+
+		fprintf(_file, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%u",
+			_isFirstEvent ? "" : ",\n",
+			traceEvent.name,
+			traceEvent.category,
+			phases[(int32_t)traceEvent.type],
+			(traceEvent.startTicks - _startTicks) * _usPerTick,
+			traceEvent.threadId);
+
+		_isFirstEvent = false;
+
+		if (traceEvent.type == TraceEventType::Complete)
+		{
+			fprintf(_file, ",\"dur\":%.3f", traceEvent.durationTicks * _usPerTick);
+		}
+		else if (traceEvent.type == TraceEventType::Instant)
+		{
+			fprintf(_file, ",\"s\":\"t\"");
+		}
+
+		if (traceEvent.argCount > 0)
+		{
+			fprintf(_file, ",\"args\":{");
+
+			for (uint32_t j = 0; j < traceEvent.argCount; ++j)
+			{
+				fprintf(_file, "%s\"%s\":%g", j > 0 ? "," : "", traceEvent.argNames[j], traceEvent.argValues[j]);
+			}
+
+			fprintf(_file, "}");
+		}
+
+		fprintf(_file, "}");
+	}
+}
@@ -0,0 +1,133 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define D2DX_TRACE_EVENT_CHUNK_SIZE 8192
+#define D2DX_TRACE_EVENT_MAX_ARGS 5
+#define D2DX_TRACE_EVENT_MAX_NAME_LENGTH 32
+
+namespace d2dx
+{
+	enum class TraceEventType : uint8_t
+	{
+		Complete = 0,
+		Instant = 1,
+		Counter = 2,
+	};
+
+	struct TraceEvent final
+	{
+		char name[D2DX_TRACE_EVENT_MAX_NAME_LENGTH];
+		const char* category;
+		int64_t startTicks;
+		int64_t durationTicks;
+		uint32_t threadId;
+		TraceEventType type;
+		uint8_t argCount;
+		const char* argNames[D2DX_TRACE_EVENT_MAX_ARGS];
+		double argValues[D2DX_TRACE_EVENT_MAX_ARGS];
+	};
+
+	/*
+		Writes Chrome trace-event JSON (viewable in about://tracing or Perfetto). Events are
+		appended to an in-memory chunk on the calling thread; full chunks are formatted and
+		written by a background thread, and chunks are recycled so steady-state recording does
+		not allocate. Events must be added from a single thread (the game thread). Category and
+		argument names must be string literals; event names are copied.
+	*/
+	class TraceEventWriter final
+	{
+	public:
+		TraceEventWriter(
+			_In_z_ const char* filename);
+
+		~TraceEventWriter() noexcept;
+
+		TraceEventWriter(const TraceEventWriter&) = delete;
+
+		TraceEventWriter& operator=(const TraceEventWriter&) = delete;
+
+		/* Returns the writer that engine subsystems should report to, or nullptr if tracing is off. */
+		static TraceEventWriter* GetInstance();
+
+		static void SetInstance(
+			_In_opt_ TraceEventWriter* instance);
+
+		static int64_t GetTicks();
+
+		TraceEvent& AddEvent(
+			_In_ TraceEventType type,
+			_In_z_ const char* name,
+			_In_z_ const char* category,
+			_In_ int64_t startTicks,
+			_In_ int64_t endTicks);
+
+		void AddComplete(
+			_In_z_ const char* name,
+			_In_z_ const char* category,
+			_In_ int64_t startTicks,
+			_In_ int64_t endTicks);
+
+		void AddInstant(
+			_In_z_ const char* name,
+			_In_z_ const char* category);
+
+		/* Hands the current chunk to the background thread. */
+		void Flush();
+
+		static void AddArg(
+			_Inout_ TraceEvent& traceEvent,
+			_In_z_ const char* argName,
+			_In_ double argValue);
+
+	private:
+		struct Chunk final
+		{
+			Chunk() : events{ D2DX_TRACE_EVENT_CHUNK_SIZE } {}
+
+			Buffer<TraceEvent> events;
+			uint32_t count = 0;
+		};
+
+		void WriterThreadMain();
+
+		void WriteChunk(
+			_In_ const Chunk& chunk);
+
+		FILE* _file = nullptr;
+		int64_t _startTicks = 0;
+		double _usPerTick = 0.0;
+		bool _isFirstEvent = true;
+		std::unique_ptr<Chunk> _currentChunk;
+		std::deque<std::unique_ptr<Chunk>> _pendingChunks;
+		std::vector<std::unique_ptr<Chunk>> _freeChunks;
+		std::mutex _mutex;
+		std::condition_variable _condition;
+		bool _stopRequested = false;
+		std::thread _writerThread;
+	};
+}
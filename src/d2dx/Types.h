@@ -24,6 +24,9 @@
 #define D2DX_MAX_BATCHES_PER_FRAME 16384
 #define D2DX_MAX_VERTICES_PER_FRAME (1024 * 1024)
 
+/* Batches are drawn as quads (4 vertices each) with a static 16-bit index buffer. */
+#define D2DX_MAX_QUADS_PER_DRAW_CALL (65536 / 4)
+
 #define D2DX_MAX_GAME_PALETTES 14
 #define D2DX_WHITE_PALETTE_INDEX 14
 #define D2DX_LOGO_PALETTE_INDEX 15
@@ -48,6 +51,7 @@ namespace d2dx
 		Menus = 2,
 		InGame = 3,
 		TitleScreen = 4,
+		Count = 5
 	};
 
 	enum class PrimitiveType
@@ -0,0 +1,237 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "WideHash.h"
+
+using namespace d2dx;
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+#define PRIME32_1 0x9E3779B1ULL
+#define PRIME32_2 0x85EBCA77ULL
+#define PRIME32_3 0xC2B2AE3DULL
+
+const uint64_t WideHash::secret[WideHash::SecretSize / 8] =
+{
+	0xF846A458325736BEULL, 0x1E67F02C2DB077DFULL, 0x7783DDC588D79BE4ULL, 0xC9AB6BE4083B1FCBULL,
+	0xBAB6F2222392141AULL, 0x9E4D9DD8D8A5A6F1ULL, 0xF1E38A4292E6EB1EULL, 0xE7255EC728B00B20ULL,
+	0x75AA56F54BF367AFULL, 0x010616552E9A27A6ULL, 0xBE223E194ADA5A26ULL, 0x3DC9A35D5E83CEF9ULL,
+	0x0926C68AC8EFE739ULL, 0xC96ACE8A4254BDC3ULL, 0x7CD33337E96F1D84ULL, 0x4137DEBA85A4F426ULL,
+	0x7EA104A625A4693CULL, 0x3EAA5A2A2FBB0378ULL, 0xBF1C3E7816A9853CULL, 0xAD12C9B13A39DA7CULL,
+	0x6D13A7F595E1DF4CULL, 0x5DC8A3B4E51E22CEULL, 0x99AE69B9129FB3DFULL, 0xC94B36EA04F5924CULL,
+};
+
+static inline uint64_t Read64(
+	_In_reads_(8) const uint8_t* p) noexcept
+{
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint64_t RotL64(
+	uint64_t x,
+	int32_t r) noexcept
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+/* Folds the 128-bit product of a and b into 64 bits. Written with 32-bit partial products
+   since the 64x64->128 multiply intrinsics are unavailable on x86. */
+static inline uint64_t Mul128Fold64(
+	uint64_t a,
+	uint64_t b) noexcept
+{
+	const uint64_t aLo = (uint32_t)a;
+	const uint64_t aHi = a >> 32;
+	const uint64_t bLo = (uint32_t)b;
+	const uint64_t bHi = b >> 32;
+
+	const uint64_t loLo = aLo * bLo;
+	const uint64_t hiLo = aHi * bLo;
+	const uint64_t loHi = aLo * bHi;
+	const uint64_t hiHi = aHi * bHi;
+
+	const uint64_t cross = (loLo >> 32) + (uint32_t)hiLo + loHi;
+	const uint64_t upper = (hiLo >> 32) + (cross >> 32) + hiHi;
+	const uint64_t lower = (cross << 32) | (uint32_t)loLo;
+
+	return lower ^ upper;
+}
+
+static inline uint64_t NonZero(
+	uint64_t h) noexcept
+{
+	/* Zero marks empty slots in the caches keyed by this hash. */
+	return h ? h : 1;
+}
+
+const uint8_t* WideHash::GetSecret() noexcept
+{
+	return (const uint8_t*)secret;
+}
+
+_Use_decl_annotations_
+void WideHash::InitAccumulators(
+	uint64_t* acc) noexcept
+{
+	acc[0] = PRIME32_3;
+	acc[1] = PRIME64_1;
+	acc[2] = PRIME64_2;
+	acc[3] = PRIME64_3;
+	acc[4] = PRIME64_4;
+	acc[5] = PRIME32_2;
+	acc[6] = PRIME64_5;
+	acc[7] = PRIME32_1;
+}
+
+_Use_decl_annotations_
+uint64_t WideHash::HashShort(
+	const uint8_t* data,
+	uint32_t size) noexcept
+{
+	assert(size < StripeSize);
+
+	uint64_t h = PRIME64_5 + size + secret[0];
+
+	for (; size >= 8; size -= 8, data += 8)
+	{
+		uint64_t k = Read64(data) * PRIME64_2;
+		k = RotL64(k, 31) * PRIME64_1;
+		h ^= k;
+		h = RotL64(h, 27) * PRIME64_1 + PRIME64_4;
+	}
+
+	if (size >= 4)
+	{
+		uint32_t k;
+		memcpy(&k, data, sizeof(k));
+		h ^= (uint64_t)k * PRIME64_1;
+		h = RotL64(h, 23) * PRIME64_2 + PRIME64_3;
+		size -= 4;
+		data += 4;
+	}
+
+	for (; size > 0; --size, ++data)
+	{
+		h ^= (uint64_t)*data * PRIME64_5;
+		h = RotL64(h, 11) * PRIME64_1;
+	}
+
+	h ^= h >> 33;
+	h *= PRIME64_2;
+	h ^= h >> 29;
+	h *= PRIME64_3;
+	h ^= h >> 32;
+
+	return NonZero(h);
+}
+
+_Use_decl_annotations_
+uint64_t WideHash::Finalize(
+	const uint64_t* acc,
+	uint32_t size) noexcept
+{
+	const uint8_t* s = GetSecret();
+
+	uint64_t h = (uint64_t)size * PRIME64_1;
+
+	for (int32_t i = 0; i < 4; ++i)
+	{
+		h += Mul128Fold64(acc[2 * i] ^ Read64(s + 11 + 16 * i), acc[2 * i + 1] ^ Read64(s + 19 + 16 * i));
+	}
+
+	h ^= h >> 37;
+	h *= 0x165667919E3779F9ULL;
+	h ^= h >> 32;
+
+	return NonZero(h);
+}
+
+static inline void AccumulateStripeScalar(
+	_Inout_updates_all_(8) uint64_t* acc,
+	_In_reads_(WideHash::StripeSize) const uint8_t* p,
+	_In_reads_(WideHash::StripeSize) const uint8_t* s) noexcept
+{
+	for (int32_t j = 0; j < 8; ++j)
+	{
+		const uint64_t data = Read64(p + 8 * j);
+		const uint64_t dataKey = data ^ Read64(s + 8 * j);
+		acc[j ^ 1] += data;
+		acc[j] += (uint64_t)(uint32_t)dataKey * (dataKey >> 32);
+	}
+}
+
+static inline void ScrambleScalar(
+	_Inout_updates_all_(8) uint64_t* acc) noexcept
+{
+	const uint8_t* s = WideHash::GetSecret() + WideHash::ScrambleSecretOffset;
+
+	for (int32_t j = 0; j < 8; ++j)
+	{
+		uint64_t a = acc[j];
+		a ^= a >> 47;
+		a ^= Read64(s + 8 * j);
+		acc[j] = a * WideHash::ScramblePrime;
+	}
+}
+
+_Use_decl_annotations_
+uint64_t WideHash::HashBytes64Scalar(
+	const uint8_t* data,
+	uint32_t size) noexcept
+{
+	if (size < StripeSize)
+	{
+		return HashShort(data, size);
+	}
+
+	const uint8_t* s = GetSecret();
+	const uint32_t blockSize = StripeSize * StripesPerBlock;
+	const uint32_t blockCount = (size - 1) / blockSize;
+
+	uint64_t acc[8];
+	InitAccumulators(acc);
+
+	const uint8_t* p = data;
+
+	for (uint32_t block = 0; block < blockCount; ++block)
+	{
+		for (uint32_t stripe = 0; stripe < StripesPerBlock; ++stripe, p += StripeSize)
+		{
+			AccumulateStripeScalar(acc, p, s + stripe * 8);
+		}
+
+		ScrambleScalar(acc);
+	}
+
+	const uint32_t stripeCount = ((size - 1) - blockSize * blockCount) / StripeSize;
+
+	for (uint32_t stripe = 0; stripe < stripeCount; ++stripe, p += StripeSize)
+	{
+		AccumulateStripeScalar(acc, p, s + stripe * 8);
+	}
+
+	AccumulateStripeScalar(acc, data + size - StripeSize, s + LastStripeSecretOffset);
+
+	return Finalize(acc, size);
+}
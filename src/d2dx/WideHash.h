@@ -0,0 +1,62 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <sal.h>
+#include <stdint.h>
+
+namespace d2dx
+{
+	/* A 64-bit content hash in the style of xxHash3 (long-input variant). Inputs are consumed
+	   as 64-byte stripes of eight 64-bit lanes, so vectorized implementations (see ISimd) can
+	   process 16 or 32 bytes per instruction and still produce the exact same value as the
+	   scalar reference below. Not compatible with the official xxHash3 outputs. Everything
+	   here is out of line, because the files compiled with /arch:AVX2 or /arch:AVX512 use it. */
+	namespace WideHash
+	{
+		static constexpr uint32_t StripeSize = 64;
+		static constexpr uint32_t StripesPerBlock = 16;
+		static constexpr uint32_t SecretSize = 192;
+		static constexpr uint32_t ScrambleSecretOffset = SecretSize - StripeSize;
+		static constexpr uint32_t LastStripeSecretOffset = SecretSize - StripeSize - 7;
+		static constexpr uint32_t ScramblePrime = 0x9E3779B1U;
+
+		extern const uint64_t secret[SecretSize / 8];
+
+		const uint8_t* GetSecret() noexcept;
+
+		void InitAccumulators(
+			_Out_writes_all_(8) uint64_t* acc) noexcept;
+
+		/* Hash for inputs shorter than one stripe. */
+		uint64_t HashShort(
+			_In_reads_(size) const uint8_t* data,
+			_In_ uint32_t size) noexcept;
+
+		/* Merges the eight accumulator lanes into the final (non-zero) hash. */
+		uint64_t Finalize(
+			_In_reads_(8) const uint64_t* acc,
+			_In_ uint32_t size) noexcept;
+
+		/* Portable reference implementation. */
+		uint64_t HashBytes64Scalar(
+			_In_reads_(size) const uint8_t* data,
+			_In_ uint32_t size) noexcept;
+	}
+}
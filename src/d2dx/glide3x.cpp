@@ -18,16 +18,20 @@
 */
 #include "pch.h"
 #include "D2DXContextFactory.h"
+#include "GlideTraceRecorder.h"
 #include "Utils.h"
 
 using namespace d2dx;
 using namespace std;
 
 static void GetWidthHeightFromTexInfo(const GrTexInfo* info, FxU32* w, FxU32* h);
+static GlideTraceRecorder* GetTraceRecorder();
 
 static GrLfbInfo_t lfbInfo = { 0 };
 static char tempString[2048];
 static bool initialized = false;
+static std::unique_ptr<GlideTraceRecorder> traceRecorder;
+static bool traceRecorderInitialized = false;
 
 extern "C" {
 
@@ -37,6 +41,12 @@ FX_ENTRY void FX_CALL
 	try
 	{
 		const auto returnAddress = (uintptr_t)_ReturnAddress();
+		auto recorder = GetTraceRecorder();
+		if (recorder)
+		{
+			recorder->RecordDrawPoint(pt, returnAddress);
+		}
+
 		D2DXContextFactory::GetInstance()->OnDrawPoint(pt, returnAddress);
 	}
 	catch (...)
@@ -51,6 +61,12 @@ FX_ENTRY void FX_CALL
 	try
 	{
 		const auto returnAddress = (uintptr_t)_ReturnAddress();
+		auto recorder = GetTraceRecorder();
+		if (recorder)
+		{
+			recorder->RecordDrawLine(v1, v2, returnAddress);
+		}
+
 		D2DXContextFactory::GetInstance()->OnDrawLine(v1, v2, returnAddress);
 	}
 	catch (...)
@@ -63,7 +79,13 @@ FX_ENTRY void FX_CALL
 	grVertexLayout(FxU32 param, FxI32 offset, FxU32 mode)
 {
 	try
-	{ 
+	{
+		auto recorder = GetTraceRecorder();
+		if (recorder)
+		{
+			recorder->RecordVertexLayout(param, mode ? offset : 0xFF);
+		}
+
 		D2DXContextFactory::GetInstance()->OnVertexLayout(param, mode ? offset : 0xFF);
 	}
 	catch (...)
@@ -78,6 +100,12 @@ FX_ENTRY void FX_CALL
 	const auto returnAddress = (uintptr_t)_ReturnAddress();
 	try
 	{
+		auto recorder = GetTraceRecorder();
+		if (recorder)
+		{
+			recorder->RecordDrawVertexArray(mode, Count, (uint8_t**)pointers, returnAddress);
+		}
+
 		D2DXContextFactory::GetInstance()->OnDrawVertexArray(mode, Count, (uint8_t**)pointers, returnAddress);	
 	}
 	catch (...)
@@ -93,6 +121,12 @@ FX_ENTRY void FX_CALL
 
 	try
 	{
+		auto recorder = GetTraceRecorder();
+		if (recorder)
+		{
+			recorder->RecordDrawVertexArrayContiguous(mode, Count, (const uint8_t*)vertex, stride, returnAddress);
+		}
+
 		D2DXContextFactory::GetInstance()->OnDrawVertexArrayContiguous(mode, Count, (uint8_t*)vertex, stride, returnAddress);
 	}
 	catch (...)
@@ -106,6 +140,12 @@ FX_ENTRY void FX_CALL
 {
 	try
 	{
+		auto recorder = GetTraceRecorder();
+		if (recorder)
+		{
+			recorder->RecordBufferClear();
+		}
+
 		D2DXContextFactory::GetInstance()->OnBufferClear();
 	}
 	catch (...)
@@ -119,6 +159,12 @@ FX_ENTRY void FX_CALL
 {
 	try
 	{
+		auto recorder = GetTraceRecorder();
+		if (recorder)
+		{
+			recorder->RecordBufferSwap();
+		}
+
 		D2DXContextFactory::GetInstance()->OnBufferSwap();
 	}
 	catch (...)
@@ -187,6 +233,12 @@ FX_ENTRY GrContext_t FX_CALL
 
 	try
 	{
+		auto recorder = GetTraceRecorder();
+		if (recorder)
+		{
+			recorder->RecordSstWinOpen(hWnd, width, height);
+		}
+
 		D2DXContextFactory::GetInstance()->OnSstWinOpen(hWnd, width, height);
 	}
 	catch (...)
@@ -222,6 +274,12 @@ FX_ENTRY void FX_CALL
 {
 	try
 	{
+		auto recorder = GetTraceRecorder();
+		if (recorder)
+		{
+			recorder->RecordAlphaBlendFunction(rgb_sf, rgb_df, alpha_sf, alpha_df);
+		}
+
 		D2DXContextFactory::GetInstance()->OnAlphaBlendFunction(rgb_sf, rgb_df, alpha_sf, alpha_df);
 	}
 	catch (...)
@@ -252,6 +310,12 @@ FX_ENTRY void FX_CALL
 
 	try
 	{
+		auto recorder = GetTraceRecorder();
+		if (recorder)
+		{
+			recorder->RecordCombine(GlideTraceRecordType::AlphaCombine, function, factor, local, other, invert);
+		}
+
 		D2DXContextFactory::GetInstance()->OnAlphaCombine(function, factor, local, other, invert);
 	}
 	catch (...)
@@ -265,6 +329,12 @@ FX_ENTRY void FX_CALL
 {
 	try
 	{
+		auto recorder = GetTraceRecorder();
+		if (recorder)
+		{
+			recorder->RecordChromakeyMode(mode);
+		}
+
 		D2DXContextFactory::GetInstance()->OnChromakeyMode(mode);
 	}
 	catch (...)
@@ -302,6 +372,12 @@ FX_ENTRY void FX_CALL
 				
 	try
 	{
+		auto recorder = GetTraceRecorder();
+		if (recorder)
+		{
+			recorder->RecordCombine(GlideTraceRecordType::ColorCombine, function, factor, local, other, invert);
+		}
+
 		D2DXContextFactory::GetInstance()->OnColorCombine(function, factor, local, other, invert);
 	}
 	catch (...)
@@ -320,6 +396,12 @@ FX_ENTRY void FX_CALL
 {
 	try
 	{
+		auto recorder = GetTraceRecorder();
+		if (recorder)
+		{
+			recorder->RecordConstantColorValue((uint32_t)value);
+		}
+
 		D2DXContextFactory::GetInstance()->OnConstantColorValue((uint32_t)value);
 	}
 	catch (...)
@@ -343,6 +425,12 @@ FX_ENTRY void FX_CALL
 {
 	try
 	{
+		auto recorder = GetTraceRecorder();
+		if (recorder)
+		{
+			recorder->RecordLoadGammaTable(nentries, (const uint32_t*)red, (const uint32_t*)green, (const uint32_t*)blue);
+		}
+
 		D2DXContextFactory::GetInstance()->OnLoadGammaTable(nentries, (uint32_t *)red, (uint32_t*)green, (uint32_t*)blue);
 	}
 	catch (...)
@@ -398,6 +486,12 @@ FX_ENTRY void FX_CALL
 
 	try
 	{
+		auto recorder = GetTraceRecorder();
+		if (recorder)
+		{
+			recorder->RecordTexSource(tmu, startAddress, w, h);
+		}
+
 		D2DXContextFactory::GetInstance()->OnTexSource(tmu, startAddress, w, h);
 	}
 	catch (...)
@@ -442,6 +536,12 @@ FX_ENTRY void FX_CALL
 
 	try
 	{
+		auto recorder = GetTraceRecorder();
+		if (recorder)
+		{
+			recorder->RecordTexDownload(tmu, (const uint8_t*)info->data, startAddress, (int32_t)width, (int32_t)height);
+		}
+
 		D2DXContextFactory::GetInstance()->OnTexDownload(tmu, (const uint8_t*)info->data, startAddress, (int32_t)width, (int32_t)height);
 	}
 	catch (...)
@@ -456,6 +556,12 @@ FX_ENTRY void FX_CALL
 {
 	try
 	{
+		auto recorder = GetTraceRecorder();
+		if (recorder)
+		{
+			recorder->RecordTexDownloadTable(type, data);
+		}
+
 		D2DXContextFactory::GetInstance()->OnTexDownloadTable(type, data);
 	}
 	catch (...)
@@ -511,6 +617,12 @@ FX_ENTRY FxBool FX_CALL
 	{
 		if (type == GR_LFB_WRITE_ONLY && buffer == GR_BUFFER_FRONTBUFFER)
 		{
+			auto recorder = GetTraceRecorder();
+			if (recorder)
+			{
+				recorder->RecordLfbUnlock((const uint32_t*)lfbInfo.lfbPtr, lfbInfo.strideInBytes);
+			}
+
 			D2DXContextFactory::GetInstance()->OnLfbUnlock((const uint32_t*)lfbInfo.lfbPtr, lfbInfo.strideInBytes);
 			return FXTRUE;
 		}
@@ -533,6 +645,10 @@ FX_ENTRY void FX_CALL
 FX_ENTRY void FX_CALL
 	grGlideShutdown(void)
 {
+	if (traceRecorder)
+	{
+		traceRecorder->Flush();
+	}
 }
 
 FX_ENTRY void FX_CALL
@@ -540,6 +656,12 @@ FX_ENTRY void FX_CALL
 {
 	try
 	{
+		auto recorder = GetTraceRecorder();
+		if (recorder)
+		{
+			recorder->RecordGammaCorrectionRGB(red, green, blue);
+		}
+
 		D2DXContextFactory::GetInstance()->OnGammaCorrectionRGB(red, green, blue);
 	}
 	catch (...)
@@ -964,3 +1086,20 @@ static void GetWidthHeightFromTexInfo(const GrTexInfo* info, FxU32* w, FxU32* h)
 		break;
 	}
 }
+
+static GlideTraceRecorder* GetTraceRecorder()
+{
+	if (!traceRecorderInitialized)
+	{
+		traceRecorderInitialized = true;
+
+		auto d2dxContext = D2DXContextFactory::GetInstance();
+
+		if (d2dxContext && d2dxContext->GetOptions().GetFlag(OptionsFlag::DbgRecordGlideTrace))
+		{
+			traceRecorder = std::make_unique<GlideTraceRecorder>("d2dx_glide.trace", d2dxContext->GetGameHelper());
+		}
+	}
+
+	return traceRecorder.get();
+}
@@ -0,0 +1,106 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "BenchmarkRunner.h"
+
+#include <algorithm>
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+BenchmarkRunner::BenchmarkRunner(
+	uint32_t repetitions) :
+	_repetitions{ max(1U, repetitions) }
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	_nsPerTick = 1.0e9 / (double)frequency.QuadPart;
+}
+
+_Use_decl_annotations_
+void BenchmarkRunner::Run(
+	const char* name,
+	const char* distribution,
+	uint32_t size,
+	uint32_t opsPerRun,
+	const Body& body)
+{
+	std::vector<double> nsPerOp(_repetitions);
+
+	/* One untimed run to warm up caches and branch predictors. */
+	body(_checksum);
+
+	for (uint32_t i = 0; i < _repetitions; ++i)
+	{
+		const int64_t ticks = body(_checksum);
+		nsPerOp[i] = (double)ticks * _nsPerTick / (double)opsPerRun;
+	}
+
+	std::sort(nsPerOp.begin(), nsPerOp.end());
+
+	Result result;
+	result.name = name;
+	result.distribution = distribution;
+	result.size = size;
+	result.opsPerRun = opsPerRun;
+	result.minNsPerOp = nsPerOp.front();
+	result.medianNsPerOp = nsPerOp[nsPerOp.size() / 2];
+	_results.push_back(result);
+
+	fprintf(stderr, "%-40s %-8s %8u %10.2f ns/op\n", name, distribution, size, result.medianNsPerOp);
+}
+
+_Use_decl_annotations_
+void BenchmarkRunner::WriteJson(
+	FILE* file) const
+{
+	fprintf(file, "{\n");
+	fprintf(file, "  \"suite\": \"d2dxbench\",\n");
+#ifdef NDEBUG
+	fprintf(file, "  \"configuration\": \"Release\",\n");
+#else
+	fprintf(file, "  \"configuration\": \"Debug\",\n");
+#endif
+	fprintf(file, "  \"repetitions\": %u,\n", _repetitions);
+	fprintf(file, "  \"checksum\": %u,\n", _checksum);
+	fprintf(file, "  \"results\": [\n");
+
+	for (size_t i = 0; i < _results.size(); ++i)
+	{
+		const auto& result = _results[i];
+		fprintf(file, "    { \"name\": \"%s\", \"distribution\": \"%s\", \"size\": %u, \"opsPerRun\": %u, \"minNsPerOp\": %.3f, \"medianNsPerOp\": %.3f }%s\n",
+			result.name.c_str(),
+			result.distribution.c_str(),
+			result.size,
+			result.opsPerRun,
+			result.minNsPerOp,
+			result.medianNsPerOp,
+			i + 1 < _results.size() ? "," : "");
+	}
+
+	fprintf(file, "  ]\n");
+	fprintf(file, "}\n");
+}
+
+int64_t BenchmarkRunner::Now()
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart;
+}
@@ -0,0 +1,70 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace d2dx
+{
+	/*
+		Runs each benchmark a number of times and collects the per-operation cost. The
+		benchmark body times the section it cares about itself (using Now()), so that setup
+		such as refilling a cache can be kept out of the measurement.
+	*/
+	class BenchmarkRunner final
+	{
+	public:
+		using Body = std::function<int64_t(uint32_t& checksum)>;
+
+		BenchmarkRunner(
+			_In_ uint32_t repetitions);
+
+		~BenchmarkRunner() noexcept {}
+
+		void Run(
+			_In_z_ const char* name,
+			_In_z_ const char* distribution,
+			_In_ uint32_t size,
+			_In_ uint32_t opsPerRun,
+			_In_ const Body& body);
+
+		void WriteJson(
+			_In_ FILE* file) const;
+
+		static int64_t Now();
+
+	private:
+		struct Result
+		{
+			std::string name;
+			std::string distribution;
+			uint32_t size;
+			uint32_t opsPerRun;
+			double minNsPerOp;
+			double medianNsPerOp;
+		};
+
+		uint32_t _repetitions;
+		double _nsPerTick;
+		uint32_t _checksum = 0;
+		std::vector<Result> _results;
+	};
+}
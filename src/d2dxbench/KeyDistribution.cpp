@@ -0,0 +1,109 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "KeyDistribution.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+KeyDistribution::KeyDistribution(
+	KeyDistributionType type,
+	uint32_t universeSize,
+	uint32_t seed) :
+	_type{ type },
+	_universeSize{ universeSize },
+	_rng{ seed }
+{
+	assert(universeSize > 0);
+
+	if (_type != KeyDistributionType::Zipf)
+	{
+		return;
+	}
+
+	_cdf = Buffer<double>(universeSize);
+	_permutation = Buffer<uint32_t>(universeSize);
+
+	double sum = 0.0;
+	for (uint32_t i = 0; i < universeSize; ++i)
+	{
+		sum += 1.0 / (double)(i + 1);
+		_cdf.items[i] = sum;
+		_permutation.items[i] = i;
+	}
+
+	for (uint32_t i = 0; i < universeSize; ++i)
+	{
+		_cdf.items[i] /= sum;
+	}
+
+	for (uint32_t i = universeSize - 1; i > 0; --i)
+	{
+		std::uniform_int_distribution<uint32_t> pick(0, i);
+		std::swap(_permutation.items[i], _permutation.items[pick(_rng)]);
+	}
+}
+
+_Use_decl_annotations_
+const char* KeyDistribution::GetName() const
+{
+	return _type == KeyDistributionType::Zipf ? "zipf" : "uniform";
+}
+
+_Use_decl_annotations_
+void KeyDistribution::Generate(
+	uint32_t* indices,
+	uint32_t count)
+{
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		indices[i] = Next();
+	}
+}
+
+uint32_t KeyDistribution::Next()
+{
+	if (_type == KeyDistributionType::Uniform)
+	{
+		std::uniform_int_distribution<uint32_t> pick(0, _universeSize - 1);
+		return pick(_rng);
+	}
+
+	std::uniform_real_distribution<double> pick(0.0, 1.0);
+	const double u = pick(_rng);
+
+	uint32_t lo = 0;
+	uint32_t hi = _universeSize - 1;
+
+	while (lo < hi)
+	{
+		const uint32_t mid = (lo + hi) / 2;
+
+		if (_cdf.items[mid] < u)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	return _permutation.items[lo];
+}
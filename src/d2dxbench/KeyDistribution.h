@@ -0,0 +1,63 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+
+#include <random>
+
+namespace d2dx
+{
+	enum class KeyDistributionType
+	{
+		Uniform = 0,
+		Zipf = 1,
+	};
+
+	/*
+		Draws indices in [0, universeSize). The Zipf distribution (s = 1) models the game's
+		texture use, where a few textures (UI, fonts, floor tiles) make up most lookups; its
+		ranks are shuffled so that the hot indices are scattered over the universe.
+	*/
+	class KeyDistribution final
+	{
+	public:
+		KeyDistribution(
+			_In_ KeyDistributionType type,
+			_In_ uint32_t universeSize,
+			_In_ uint32_t seed);
+
+		~KeyDistribution() noexcept {}
+
+		_Ret_z_ const char* GetName() const;
+
+		void Generate(
+			_Out_writes_all_(count) uint32_t* indices,
+			_In_ uint32_t count);
+
+	private:
+		uint32_t Next();
+
+		KeyDistributionType _type;
+		uint32_t _universeSize;
+		std::mt19937 _rng;
+		Buffer<double> _cdf;
+		Buffer<uint32_t> _permutation;
+	};
+}
@@ -0,0 +1,422 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "BenchmarkRunner.h"
+#include "KeyDistribution.h"
+#include "RenderContextResources.h"
+#include "SimdFactory.h"
+#include "TextureCachePolicyFactory.h"
+#include "TextureHasher.h"
+#include "Types.h"
+
+#include <set>
+
+using namespace d2dx;
+
+/*
+	d2dxbench measures the per-operation cost of the texture hot path: hashing TMU
+	contents, searching a texture cache for a content key and evicting from a full cache.
+	Results go to stdout (or the file given with -o) as JSON, and a summary to stderr.
+*/
+
+static const KeyDistributionType distributionTypes[] = { KeyDistributionType::Uniform, KeyDistributionType::Zipf };
+
+static std::set<uint32_t> GetTextureCacheCapacities()
+{
+	std::set<uint32_t> capacities;
+
+	for (int32_t i = 0; i < D2DX_TEXTURE_CACHE_COUNT; ++i)
+	{
+		int32_t width = 0;
+		int32_t height = 0;
+		uint32_t capacity = 0;
+		RenderContextResources::GetTextureCacheDesc(i, &width, &height, &capacity);
+		capacities.insert(capacity);
+	}
+
+	return capacities;
+}
+
+static void BenchmarkTextureHasher(
+	_In_ BenchmarkRunner& runner,
+	_In_ const Buffer<uint8_t>& tmuMemory,
+	_In_ const std::shared_ptr<ISimd>& simd)
+{
+	static const Size textureSizes[] = { { 16, 16 }, { 64, 64 }, { 256, 128 }, { 256, 256 } };
+
+	for (const auto& textureSize : textureSizes)
+	{
+		const uint32_t pixelsSize = (uint32_t)(textureSize.width * textureSize.height);
+		const uint32_t stride = (pixelsSize + D2DX_TMU_ADDRESS_ALIGNMENT - 1) & ~(D2DX_TMU_ADDRESS_ALIGNMENT - 1);
+		const uint32_t textureCount = min(1024U, tmuMemory.capacity / stride);
+
+		/* Keep each miss run at around 4 MB of hashing. */
+		const uint32_t hitOps = 65536;
+		const uint32_t missOps = max(64U, min(16384U, (4 * 1024 * 1024) / pixelsSize));
+
+		for (auto distributionType : distributionTypes)
+		{
+			KeyDistribution distribution(distributionType, textureCount, 1234);
+			Buffer<uint32_t> addresses(hitOps);
+			distribution.Generate(addresses.items, addresses.capacity);
+
+			for (uint32_t i = 0; i < addresses.capacity; ++i)
+			{
+				addresses.items[i] *= stride;
+			}
+
+			TextureHasher hasher(simd);
+
+			for (uint32_t i = 0; i < textureCount; ++i)
+			{
+				hasher.GetHash(i * stride, tmuMemory.items + i * stride, pixelsSize);
+			}
+
+			runner.Run("TextureHasher.GetHash.Hit", distribution.GetName(), pixelsSize, hitOps, [&](uint32_t& checksum)
+			{
+				const int64_t startTime = BenchmarkRunner::Now();
+
+				for (uint32_t i = 0; i < hitOps; ++i)
+				{
+					const uint32_t address = addresses.items[i];
+					checksum += (uint32_t)hasher.GetHash(address, tmuMemory.items + address, pixelsSize);
+				}
+
+				return BenchmarkRunner::Now() - startTime;
+			});
+
+			runner.Run("TextureHasher.GetHash.Miss", distribution.GetName(), pixelsSize, missOps, [&](uint32_t& checksum)
+			{
+				const int64_t startTime = BenchmarkRunner::Now();
+
+				for (uint32_t i = 0; i < missOps; ++i)
+				{
+					const uint32_t address = addresses.items[i];
+					hasher.Invalidate(address, pixelsSize);
+					checksum += (uint32_t)hasher.GetHash(address, tmuMemory.items + address, pixelsSize);
+				}
+
+				return BenchmarkRunner::Now() - startTime;
+			});
+		}
+	}
+}
+
+/* Raw hashing throughput, without the per-address cache: the old FNV-1a content hash
+   against the WideHash that replaced it. */
+static void BenchmarkHashBytes(
+	_In_ BenchmarkRunner& runner,
+	_In_ const Buffer<uint8_t>& tmuMemory,
+	_In_ SimdLevel simdLevel)
+{
+	auto simd = SimdFactory::Create(simdLevel);
+	const std::string prefix = SimdFactory::GetName(simdLevel);
+
+	static const uint32_t sizes[] = { 256, 4096, 32768, 65536 };
+
+	for (auto size : sizes)
+	{
+		const uint32_t textureCount = tmuMemory.capacity / size;
+		const uint32_t ops = max(64U, min(16384U, (4 * 1024 * 1024) / size));
+
+		if (simdLevel == SimdLevel::Sse2)
+		{
+			runner.Run("fnv_32a_buf", "sequential", size, ops, [&](uint32_t& checksum)
+			{
+				const int64_t startTime = BenchmarkRunner::Now();
+
+				for (uint32_t i = 0; i < ops; ++i)
+				{
+					checksum += fnv_32a_buf((void*)(tmuMemory.items + (i % textureCount) * size), size, FNV1_32A_INIT);
+				}
+
+				return BenchmarkRunner::Now() - startTime;
+			});
+		}
+
+		runner.Run((prefix + ".HashBytes64").c_str(), "sequential", size, ops, [&](uint32_t& checksum)
+		{
+			const int64_t startTime = BenchmarkRunner::Now();
+
+			for (uint32_t i = 0; i < ops; ++i)
+			{
+				checksum += (uint32_t)simd->HashBytes64(tmuMemory.items + (i % textureCount) * size, size);
+			}
+
+			return BenchmarkRunner::Now() - startTime;
+		});
+
+		/* The texture download path: copy into TMU memory and hash, separately or fused. */
+		Buffer<uint8_t> dst(size);
+
+		runner.Run(("memcpy+" + prefix + ".HashBytes64").c_str(), "sequential", size, ops, [&](uint32_t& checksum)
+		{
+			const int64_t startTime = BenchmarkRunner::Now();
+
+			for (uint32_t i = 0; i < ops; ++i)
+			{
+				memcpy(dst.items, tmuMemory.items + (i % textureCount) * size, size);
+				checksum += (uint32_t)simd->HashBytes64(dst.items, size);
+			}
+
+			return BenchmarkRunner::Now() - startTime;
+		});
+
+		runner.Run((prefix + ".CopyAndHashBytes64").c_str(), "sequential", size, ops, [&](uint32_t& checksum)
+		{
+			const int64_t startTime = BenchmarkRunner::Now();
+
+			for (uint32_t i = 0; i < ops; ++i)
+			{
+				checksum += (uint32_t)simd->CopyAndHashBytes64(dst.items, tmuMemory.items + (i % textureCount) * size, size);
+			}
+
+			return BenchmarkRunner::Now() - startTime;
+		});
+	}
+}
+
+static void BenchmarkIndexOfUInt64(
+	_In_ BenchmarkRunner& runner,
+	_In_ SimdLevel simdLevel)
+{
+	auto simd = SimdFactory::Create(simdLevel);
+	const std::string prefix = SimdFactory::GetName(simdLevel);
+
+	const uint32_t ops = 16384;
+
+	for (auto capacity : GetTextureCacheCapacities())
+	{
+		/* Content keys as TextureCacheSlots stores them. Resident keys have the top bit clear, so
+		   that keys with it set are guaranteed misses. */
+		std::mt19937_64 rng(capacity);
+		Buffer<uint64_t> keys(capacity);
+		for (uint32_t i = 0; i < capacity; ++i)
+		{
+			keys.items[i] = ((rng() & 0x7FFFFFFFFFFFFF00ULL) | 1) + ((uint64_t)i << 1);
+		}
+
+		Buffer<uint32_t> distributionIndices(ops);
+		Buffer<uint64_t> queries(ops);
+
+		for (auto distributionType : distributionTypes)
+		{
+			KeyDistribution distribution(distributionType, capacity, 5678);
+			distribution.Generate(distributionIndices.items, distributionIndices.capacity);
+
+			for (uint32_t i = 0; i < ops; ++i)
+			{
+				queries.items[i] = keys.items[distributionIndices.items[i]];
+			}
+
+			runner.Run((prefix + ".IndexOfUInt64.Hit").c_str(), distribution.GetName(), capacity, ops, [&](uint32_t& checksum)
+			{
+				const int64_t startTime = BenchmarkRunner::Now();
+
+				for (uint32_t i = 0; i < ops; ++i)
+				{
+					checksum += (uint32_t)simd->IndexOfUInt64(keys.items, capacity, queries.items[i]);
+				}
+
+				return BenchmarkRunner::Now() - startTime;
+			});
+		}
+
+		for (uint32_t i = 0; i < ops; ++i)
+		{
+			queries.items[i] = rng() | 0x8000000000000000ULL;
+		}
+
+		runner.Run((prefix + ".IndexOfUInt64.Miss").c_str(), "uniform", capacity, ops, [&](uint32_t& checksum)
+		{
+			const int64_t startTime = BenchmarkRunner::Now();
+
+			for (uint32_t i = 0; i < ops; ++i)
+			{
+				checksum += (uint32_t)simd->IndexOfUInt64(keys.items, capacity, queries.items[i]);
+			}
+
+			return BenchmarkRunner::Now() - startTime;
+		});
+	}
+}
+
+/* Replays a key stream against a full cache the way TextureCache does (find, insert on
+   miss), with a new frame every accessesPerFrame accesses. Only the inserts are timed. */
+static int64_t SimulatePolicy(
+	_In_ TextureCachePolicyType policyType,
+	_In_ uint32_t capacity,
+	_In_ const std::shared_ptr<ISimd>& simd,
+	_In_ const Buffer<uint32_t>& keys,
+	_In_ uint32_t accessesPerFrame,
+	_Out_ uint32_t& insertCount,
+	_Inout_ uint32_t& checksum)
+{
+	auto policy = TextureCachePolicyFactory::Create(policyType, capacity, simd);
+	bool evicted = false;
+
+	/* Start full, with keys that are not in the stream. */
+	for (uint32_t i = 0; i < capacity; ++i)
+	{
+		policy->Insert(0x80000000 | (i + 1), TextureCategory::Unknown, evicted);
+	}
+
+	policy->OnNewFrame();
+
+	Buffer<uint32_t> misses(accessesPerFrame);
+	int64_t ticks = 0;
+	insertCount = 0;
+
+	for (uint32_t frameStart = 0; frameStart < keys.capacity; frameStart += accessesPerFrame)
+	{
+		const uint32_t frameEnd = min(keys.capacity, frameStart + accessesPerFrame);
+		uint32_t missCount = 0;
+
+		for (uint32_t i = frameStart; i < frameEnd; ++i)
+		{
+			if (policy->Find(keys.items[i], -1) < 0)
+			{
+				misses.items[missCount++] = keys.items[i];
+			}
+		}
+
+		const int64_t startTime = BenchmarkRunner::Now();
+
+		for (uint32_t i = 0; i < missCount; ++i)
+		{
+			checksum += (uint32_t)policy->Insert(misses.items[i], TextureCategory::Unknown, evicted);
+		}
+
+		ticks += BenchmarkRunner::Now() - startTime;
+		insertCount += missCount;
+
+		policy->OnNewFrame();
+	}
+
+	return ticks;
+}
+
+static void BenchmarkPolicyInsert(
+	_In_ BenchmarkRunner& runner,
+	_In_ const std::shared_ptr<ISimd>& simd)
+{
+	const uint32_t accessCount = 65536;
+	const uint32_t accessesPerFrame = 256;
+
+	static const char* benchmarkNames[(int32_t)TextureCachePolicyType::Count] =
+	{
+		"TextureCachePolicyBitPmru.Insert",
+		"TextureCachePolicyClock.Insert",
+		"TextureCachePolicyTwoQueue.Insert",
+		"TextureCachePolicyArc.Insert",
+		"TextureCachePolicyLirs.Insert",
+	};
+
+	for (auto capacity : GetTextureCacheCapacities())
+	{
+		for (auto distributionType : distributionTypes)
+		{
+			/* A working set four times the capacity keeps the cache evicting. */
+			KeyDistribution distribution(distributionType, 4 * capacity, 9012);
+			Buffer<uint32_t> keys(accessCount);
+			distribution.Generate(keys.items, keys.capacity);
+
+			for (uint32_t i = 0; i < keys.capacity; ++i)
+			{
+				++keys.items[i];
+			}
+
+			for (int32_t type = 0; type < (int32_t)TextureCachePolicyType::Count; ++type)
+			{
+				const TextureCachePolicyType policyType = (TextureCachePolicyType)type;
+
+				uint32_t insertCount = 0;
+				uint32_t dryRunChecksum = 0;
+				SimulatePolicy(policyType, capacity, simd, keys, accessesPerFrame, insertCount, dryRunChecksum);
+
+				runner.Run(benchmarkNames[type], distribution.GetName(), capacity, max(1U, insertCount), [&](uint32_t& checksum)
+				{
+					uint32_t runInsertCount = 0;
+					return SimulatePolicy(policyType, capacity, simd, keys, accessesPerFrame, runInsertCount, checksum);
+				});
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const char* outputFilename = nullptr;
+	uint32_t repetitions = 9;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "-o") && i + 1 < argc)
+		{
+			outputFilename = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-repetitions") && i + 1 < argc)
+		{
+			repetitions = (uint32_t)strtoul(argv[++i], nullptr, 10);
+		}
+		else
+		{
+			fprintf(stderr, "Usage: d2dxbench [-o <file.json>] [-repetitions <count>]\n");
+			return 1;
+		}
+	}
+
+	auto simd = SimdFactory::CreateBest();
+	BenchmarkRunner runner(repetitions);
+
+	Buffer<uint8_t> tmuMemory(D2DX_TMU_MEMORY_SIZE);
+	std::mt19937 rng(42);
+	for (uint32_t i = 0; i < tmuMemory.capacity; ++i)
+	{
+		tmuMemory.items[i] = (uint8_t)rng();
+	}
+
+	/* The raw kernels are measured for every implementation the CPU supports, the rest
+	   with the one d2dx would pick. */
+	for (int32_t level = 0; level <= (int32_t)SimdFactory::GetSupportedLevel(); ++level)
+	{
+		BenchmarkHashBytes(runner, tmuMemory, (SimdLevel)level);
+		BenchmarkIndexOfUInt64(runner, (SimdLevel)level);
+	}
+
+	BenchmarkTextureHasher(runner, tmuMemory, simd);
+	BenchmarkPolicyInsert(runner, simd);
+
+	FILE* file = stdout;
+
+	if (outputFilename && fopen_s(&file, outputFilename, "w") != 0)
+	{
+		fprintf(stderr, "Failed to open %s.\n", outputFilename);
+		return 1;
+	}
+
+	runner.WriteJson(file);
+
+	if (file != stdout)
+	{
+		fclose(file);
+	}
+
+	return 0;
+}
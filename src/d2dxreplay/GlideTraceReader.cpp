@@ -0,0 +1,147 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "GlideTraceReader.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+GlideTraceReader::GlideTraceReader(
+	const char* filename) :
+	_payload{ 64 * 1024 }
+{
+	if (fopen_s(&_file, filename, "rb") != 0)
+	{
+		_file = nullptr;
+		throw std::runtime_error("Failed to open trace file.");
+	}
+
+	Rewind();
+}
+
+GlideTraceReader::~GlideTraceReader() noexcept
+{
+	if (_file)
+	{
+		fclose(_file);
+		_file = nullptr;
+	}
+}
+
+_Use_decl_annotations_
+bool GlideTraceReader::ReadRecord(
+	GlideTraceRecordType* type,
+	uint8_t** payload,
+	uint32_t* payloadSize)
+{
+	while (true)
+	{
+		GlideTraceRecordHeader header;
+
+		if (fread(&header, sizeof(header), 1, _file) != 1)
+		{
+			return false;
+		}
+
+		ReadPayload(header.payloadSize);
+
+		if (header.type == GlideTraceRecordType::Blob)
+		{
+			if (header.payloadSize < sizeof(GlideTraceBlob))
+			{
+				throw std::runtime_error("Truncated blob record.");
+			}
+
+			const GlideTraceBlob* blob = (const GlideTraceBlob*)_payload.items;
+
+			if (blob->size != header.payloadSize - sizeof(GlideTraceBlob) ||
+				blob->blobId != (uint32_t)_blobs.size())
+			{
+				throw std::runtime_error("Malformed blob record.");
+			}
+
+			Buffer<uint8_t> content(max(1U, blob->size));
+			memcpy(content.items, _payload.items + sizeof(GlideTraceBlob), blob->size);
+			_blobs.push_back(std::move(content));
+			continue;
+		}
+
+		*type = header.type;
+		*payload = _payload.items;
+		*payloadSize = header.payloadSize;
+		return true;
+	}
+}
+
+_Use_decl_annotations_
+const uint8_t* GlideTraceReader::GetBlob(
+	uint32_t blobId,
+	uint32_t expectedSize) const
+{
+	if (blobId == 0 || blobId >= _blobs.size() || _blobs[blobId].capacity < expectedSize)
+	{
+		throw std::runtime_error("Reference to missing or truncated blob.");
+	}
+
+	return _blobs[blobId].items;
+}
+
+void GlideTraceReader::Rewind()
+{
+	fseek(_file, 0, SEEK_SET);
+
+	/* Blob ids start at 1. */
+	_blobs.clear();
+	_blobs.emplace_back();
+
+	GlideTraceFileHeader header;
+
+	if (fread(&header, sizeof(header), 1, _file) != 1 ||
+		header.magic != D2DX_GLIDE_TRACE_MAGIC)
+	{
+		throw std::runtime_error("Not a Glide trace file.");
+	}
+
+	if (header.version != D2DX_GLIDE_TRACE_VERSION)
+	{
+		throw std::runtime_error("Unsupported Glide trace version.");
+	}
+}
+
+_Use_decl_annotations_
+void GlideTraceReader::ReadPayload(
+	uint32_t payloadSize)
+{
+	if (payloadSize > _payload.capacity)
+	{
+		uint32_t capacity = _payload.capacity;
+
+		while (capacity < payloadSize)
+		{
+			capacity *= 2;
+		}
+
+		_payload = Buffer<uint8_t>(capacity);
+	}
+
+	if (payloadSize > 0 && fread(_payload.items, payloadSize, 1, _file) != 1)
+	{
+		throw std::runtime_error("Truncated record.");
+	}
+}
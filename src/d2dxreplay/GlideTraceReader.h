@@ -0,0 +1,57 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+#include "GlideTrace.h"
+
+#include <vector>
+
+namespace d2dx
+{
+	class GlideTraceReader final
+	{
+	public:
+		GlideTraceReader(
+			_In_z_ const char* filename);
+
+		~GlideTraceReader() noexcept;
+
+		/* Reads the next record, collecting any Blob records on the way. Returns false at the
+		   end of the trace. The payload stays valid until the next call. */
+		bool ReadRecord(
+			_Out_ GlideTraceRecordType* type,
+			_Outptr_result_bytebuffer_(*payloadSize) uint8_t** payload,
+			_Out_ uint32_t* payloadSize);
+
+		const uint8_t* GetBlob(
+			_In_ uint32_t blobId,
+			_In_ uint32_t expectedSize) const;
+
+		void Rewind();
+
+	private:
+		void ReadPayload(
+			_In_ uint32_t payloadSize);
+
+		FILE* _file = nullptr;
+		Buffer<uint8_t> _payload;
+		std::vector<Buffer<uint8_t>> _blobs;
+	};
+}
@@ -0,0 +1,286 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "NullRenderContext.h"
+#include "Batch.h"
+#include "RenderContextResources.h"
+#include "TextureCache.h"
+#include "TextureCacheBalancer.h"
+#include "Utils.h"
+
+using namespace d2dx;
+
+/* What any feature level 11 device reports; see RenderContextResources::DetermineMaxTextureArraySize. */
+#define D2DX_REPLAY_TEXTURES_PER_ATLAS 2048
+
+_Use_decl_annotations_
+NullRenderContext::NullRenderContext(
+	const std::shared_ptr<ISimd>& simd,
+	ReplayFrameTimes* frameTimes,
+	TextureCachePolicyType policyType) :
+	_frameTimes{ frameTimes }
+{
+	ITextureCache* textureCaches[D2DX_TEXTURE_CACHE_COUNT];
+
+	for (int32_t i = 0; i < D2DX_TEXTURE_CACHE_COUNT; ++i)
+	{
+		int32_t width = 0;
+		int32_t height = 0;
+		uint32_t capacity = 0;
+		RenderContextResources::GetTextureCacheDesc(i, &width, &height, &capacity);
+
+		_textureCaches[i] = std::make_unique<TextureCache>(width, height, capacity, D2DX_REPLAY_TEXTURES_PER_ATLAS, nullptr, simd, policyType);
+		textureCaches[i] = _textureCaches[i].get();
+	}
+
+	_textureCacheBalancer = std::make_unique<TextureCacheBalancer>(textureCaches, D2DX_TEXTURE_CACHE_COUNT);
+}
+
+HWND NullRenderContext::GetHWnd() const
+{
+	return nullptr;
+}
+
+_Use_decl_annotations_
+void NullRenderContext::LoadGammaTable(
+	const uint32_t* values,
+	uint32_t valueCount)
+{
+}
+
+_Use_decl_annotations_
+uint32_t NullRenderContext::BulkWriteVertices(
+	const Vertex* vertices,
+	uint32_t vertexCount)
+{
+	/* D2DXContext draws its batches right after writing the vertices, and presents right after
+	   drawing them, so the time until Present is the time spent in DrawBatches. */
+	_drawBatchesStartTime = TimeStart();
+	return 0;
+}
+
+_Use_decl_annotations_
+TextureCacheLocation NullRenderContext::UpdateTexture(
+	const Batch& batch,
+	const uint8_t* tmuData,
+	uint32_t tmuDataSize,
+	TextureCacheLocation lastLocation)
+{
+	if (!batch.IsValid())
+	{
+		return { -1, -1 };
+	}
+
+	const uint64_t contentKey = batch.GetContentKey();
+
+	ITextureCache* atlas = GetTextureCache(batch);
+
+	if (_textureKeyLog)
+	{
+		_textureKeyLog->AddLookup(contentKey, batch.GetTextureWidth(), batch.GetTextureHeight(), batch.GetTextureCategory());
+	}
+
+	auto tcl = atlas->FindTexture(contentKey, atlas->GetIndex(lastLocation));
+
+	if (tcl._textureAtlas < 0)
+	{
+		tcl = atlas->InsertTexture(contentKey, batch, tmuData, tmuDataSize);
+		++_frameTimes->textureUploadCount;
+	}
+
+	return tcl;
+}
+
+void NullRenderContext::FlushTextureUploads()
+{
+	for (int32_t i = 0; i < D2DX_TEXTURE_CACHE_COUNT; ++i)
+	{
+		_textureCaches[i]->FlushUploads();
+	}
+}
+
+_Use_decl_annotations_
+void NullRenderContext::Draw(
+	const Batch& batch,
+	uint32_t startVertexLocation)
+{
+	++_frameTimes->drawCallCount;
+}
+
+void NullRenderContext::Present()
+{
+	if (_drawBatchesStartTime)
+	{
+		_frameTimes->drawBatchesMs += TimeEndMs(_drawBatchesStartTime);
+		_drawBatchesStartTime = 0;
+	}
+
+	for (int32_t i = 0; i < D2DX_TEXTURE_CACHE_COUNT; ++i)
+	{
+		_textureCaches[i]->OnNewFrame();
+	}
+
+	_textureCacheBalancer->OnNewFrame();
+
+	if (_textureKeyLog)
+	{
+		_textureKeyLog->EndFrame();
+	}
+}
+
+_Use_decl_annotations_
+void NullRenderContext::WriteToScreen(
+	const uint32_t* pixels,
+	int32_t width,
+	int32_t height,
+	bool forCinematic)
+{
+}
+
+_Use_decl_annotations_
+void NullRenderContext::SetPalette(
+	int32_t paletteIndex,
+	const uint32_t* palette)
+{
+}
+
+const Options& NullRenderContext::GetOptions() const
+{
+	return _options;
+}
+
+_Use_decl_annotations_
+ITextureCache* NullRenderContext::GetTextureCache(
+	const Batch& batch) const
+{
+	return _textureCaches[RenderContextResources::GetTextureCacheIndex(batch.GetTextureWidth(), batch.GetTextureHeight())].get();
+}
+
+_Use_decl_annotations_
+void NullRenderContext::SetSizes(
+	Size gameSize,
+	Size windowSize,
+	ScreenMode screenMode)
+{
+	_gameSize = gameSize;
+	_windowSize = windowSize;
+	_screenMode = screenMode;
+}
+
+_Use_decl_annotations_
+void NullRenderContext::GetCurrentMetrics(
+	Size* gameSize,
+	Rect* renderRect,
+	Size* desktopSize) const
+{
+	if (gameSize)
+	{
+		*gameSize = _gameSize;
+	}
+
+	if (renderRect)
+	{
+		*renderRect = Rect(0, 0, _windowSize.width, _windowSize.height);
+	}
+
+	if (desktopSize)
+	{
+		*desktopSize = _windowSize;
+	}
+}
+
+void NullRenderContext::ToggleFullscreen()
+{
+}
+
+float NullRenderContext::GetFrameTime() const
+{
+	/* A fixed frame time keeps replays deterministic. */
+	return 1.0f / 60.0f;
+}
+
+int32_t NullRenderContext::GetFrameTimeFp() const
+{
+	return 65536 / 60;
+}
+
+ScreenMode NullRenderContext::GetScreenMode() const
+{
+	return _screenMode;
+}
+
+_Use_decl_annotations_
+void NullRenderContext::GetFrameTimeStatistics(
+	MajorGameState majorGameState,
+	FrameTimeStatistics* statistics) const
+{
+	/* Frame times are fixed during replay; the per-phase timings are in ReplayFrameTimes. */
+	_emptyFrameTimeHistogram.GetStatistics(statistics);
+}
+
+void NullRenderContext::ResetFrameTimeStatistics()
+{
+}
+
+uint32_t NullRenderContext::GetTextureCacheMemoryFootprint() const
+{
+	uint32_t totalSize = 0;
+
+	for (int32_t i = 0; i < D2DX_TEXTURE_CACHE_COUNT; ++i)
+	{
+		totalSize += _textureCaches[i]->GetMemoryFootprint();
+	}
+
+	return totalSize;
+}
+
+_Use_decl_annotations_
+void NullRenderContext::GetTextureCachePartitionStatistics(
+	TextureCategory category,
+	TextureCachePartitionStatistics* statistics) const
+{
+	*statistics = {};
+
+	for (int32_t i = 0; i < D2DX_TEXTURE_CACHE_COUNT; ++i)
+	{
+		TextureCachePartitionStatistics cacheStatistics;
+		_textureCaches[i]->GetPartitionStatistics(category, &cacheStatistics);
+
+		statistics->hitCount += cacheStatistics.hitCount;
+		statistics->missCount += cacheStatistics.missCount;
+		statistics->residentCount += cacheStatistics.residentCount;
+	}
+}
+
+_Use_decl_annotations_
+void NullRenderContext::SetTextureKeyLog(
+	TextureKeyLog* textureKeyLog)
+{
+	_textureKeyLog = textureKeyLog;
+}
+
+_Use_decl_annotations_
+void NullRenderContext::GetTextureCacheStatistics(
+	int32_t cacheIndex,
+	TextureCacheStatistics* lastFrame,
+	TextureCacheStatistics* cumulative) const
+{
+	assert(cacheIndex >= 0 && cacheIndex < D2DX_TEXTURE_CACHE_COUNT);
+	_textureCaches[cacheIndex]->GetStatistics(lastFrame, cumulative);
+}
@@ -0,0 +1,137 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "IRenderContext.h"
+#include "ISimd.h"
+#include "RenderContextResources.h"
+#include "ReplayFrameTimes.h"
+#include "TextureCacheBalancer.h"
+#include "TextureCachePolicyFactory.h"
+#include "TextureKeyLog.h"
+
+namespace d2dx
+{
+	/*
+		An IRenderContext without a D3D11 device, used when replaying Glide traces. Texture
+		caches are real (with D3D stubbed out by D2DX_UNITTEST) so that cache behavior
+		matches the game; everything else is discarded.
+	*/
+	class NullRenderContext final : public IRenderContext
+	{
+	public:
+		NullRenderContext(
+			_In_ const std::shared_ptr<ISimd>& simd,
+			_In_ ReplayFrameTimes* frameTimes,
+			_In_ TextureCachePolicyType policyType);
+
+		virtual ~NullRenderContext() noexcept {}
+
+		virtual HWND GetHWnd() const override;
+
+		virtual void LoadGammaTable(
+			_In_reads_(valueCount) const uint32_t* values,
+			_In_ uint32_t valueCount) override;
+
+		virtual uint32_t BulkWriteVertices(
+			_In_reads_(vertexCount) const Vertex* vertices,
+			_In_ uint32_t vertexCount) override;
+
+		virtual TextureCacheLocation UpdateTexture(
+			_In_ const Batch& batch,
+			_In_reads_(tmuDataSize) const uint8_t* tmuData,
+			_In_ uint32_t tmuDataSize,
+			_In_ TextureCacheLocation lastLocation) override;
+
+		virtual void FlushTextureUploads() override;
+
+		virtual void Draw(
+			_In_ const Batch& batch,
+			_In_ uint32_t startVertexLocation) override;
+
+		virtual void Present() override;
+
+		virtual void WriteToScreen(
+			_In_reads_(width* height) const uint32_t* pixels,
+			_In_ int32_t width,
+			_In_ int32_t height,
+			_In_ bool forCinematic) override;
+
+		virtual void SetPalette(
+			_In_ int32_t paletteIndex,
+			_In_reads_(256) const uint32_t* palette) override;
+
+		virtual const Options& GetOptions() const override;
+
+		virtual ITextureCache* GetTextureCache(
+			_In_ const Batch& batch) const override;
+
+		virtual void SetSizes(
+			_In_ Size gameSize,
+			_In_ Size windowSize,
+			_In_ ScreenMode screenMode) override;
+
+		virtual void GetCurrentMetrics(
+			_Out_opt_ Size* gameSize,
+			_Out_opt_ Rect* renderRect,
+			_Out_opt_ Size* desktopSize) const override;
+
+		virtual void ToggleFullscreen() override;
+
+		virtual float GetFrameTime() const override;
+
+		virtual int32_t GetFrameTimeFp() const override;
+
+		virtual ScreenMode GetScreenMode() const override;
+
+		virtual void GetFrameTimeStatistics(
+			_In_ MajorGameState majorGameState,
+			_Out_ FrameTimeStatistics* statistics) const override;
+
+		virtual void ResetFrameTimeStatistics() override;
+
+		uint32_t GetTextureCacheMemoryFootprint() const;
+
+		/* Records the texture lookups to the given log (not owned), like -dxdbg_record_texture_keys. */
+		void SetTextureKeyLog(
+			_In_opt_ TextureKeyLog* textureKeyLog);
+
+		/* Sums the partition statistics of all texture caches. */
+		void GetTextureCachePartitionStatistics(
+			_In_ TextureCategory category,
+			_Out_ TextureCachePartitionStatistics* statistics) const;
+
+		void GetTextureCacheStatistics(
+			_In_ int32_t cacheIndex,
+			_Out_opt_ TextureCacheStatistics* lastFrame,
+			_Out_opt_ TextureCacheStatistics* cumulative) const;
+
+	private:
+		ReplayFrameTimes* _frameTimes = nullptr;
+		int64_t _drawBatchesStartTime = 0;
+		Options _options;
+		Size _gameSize = { 640, 480 };
+		Size _windowSize = { 640, 480 };
+		ScreenMode _screenMode = ScreenMode::Windowed;
+		std::unique_ptr<ITextureCache> _textureCaches[D2DX_TEXTURE_CACHE_COUNT];
+		std::unique_ptr<TextureCacheBalancer> _textureCacheBalancer;
+		TextureKeyLog* _textureKeyLog = nullptr;
+		FrameTimeHistogram _emptyFrameTimeHistogram;
+	};
+}
@@ -0,0 +1,193 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "ReplayGameHelper.h"
+#include "GameHelper.h"
+#include "Utils.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+ReplayGameHelper::ReplayGameHelper(
+	ReplayFrameTimes* frameTimes) :
+	_frameTimes{ frameTimes }
+{
+	GameHelper::InitializeTextureHashPrefixTable();
+}
+
+_Use_decl_annotations_
+void ReplayGameHelper::SetGameAddress(
+	const GlideTraceGameAddress& gameAddress)
+{
+	_gameAddresses[gameAddress.gameContext] = (GameAddress)gameAddress.gameAddress;
+}
+
+_Use_decl_annotations_
+void ReplayGameHelper::SetFrameState(
+	const GlideTraceFrameState& frameState)
+{
+	_frameState = frameState;
+}
+
+GameVersion ReplayGameHelper::GetVersion() const
+{
+	return GameVersion::Unsupported;
+}
+
+_Use_decl_annotations_
+const char* ReplayGameHelper::GetVersionString() const
+{
+	return "Replay";
+}
+
+uint32_t ReplayGameHelper::ScreenOpenMode() const
+{
+	return _frameState.screenOpenMode;
+}
+
+Size ReplayGameHelper::GetConfiguredGameSize() const
+{
+	return { 800, 600 };
+}
+
+_Use_decl_annotations_
+GameAddress ReplayGameHelper::IdentifyGameAddress(
+	uint32_t returnAddress) const
+{
+	/* D2DXContext::PrepareBatchForSubmit starts by identifying the game address and ends by
+	   refining the texture category, so the two calls bracket its running time. */
+	_prepareBatchStartTime = TimeStart();
+
+	auto it = _gameAddresses.find(returnAddress);
+	return it != _gameAddresses.end() ? it->second : GameAddress::Unknown;
+}
+
+_Use_decl_annotations_
+TextureCategory ReplayGameHelper::GetTextureCategory(
+	uint64_t contentKey,
+	const uint8_t* pixels,
+	uint32_t pixelsSize,
+	uint32_t& identityHash)
+{
+	return GameHelper::LookupTextureCategory(_textureIdentities, contentKey, pixels, pixelsSize, identityHash);
+}
+
+_Use_decl_annotations_
+TextureCategory ReplayGameHelper::RefineTextureCategoryFromGameAddress(
+	TextureCategory previousCategory,
+	GameAddress gameAddress) const
+{
+	auto category = GameHelper::LookupTextureCategoryFromGameAddress(previousCategory, gameAddress);
+
+	if (_prepareBatchStartTime)
+	{
+		_frameTimes->prepareBatchMs += TimeEndMs(_prepareBatchStartTime);
+		_prepareBatchStartTime = 0;
+	}
+
+	return category;
+}
+
+IMAGE_NT_HEADERS* ReplayGameHelper::GetHeader(LPBYTE pBase)
+{
+	return nullptr;
+}
+
+bool ReplayGameHelper::TryApplyInGameFpsFix()
+{
+	return false;
+}
+
+bool ReplayGameHelper::TryApplyMenuFpsFix()
+{
+	return false;
+}
+
+bool ReplayGameHelper::TryApplyInGameSleepFixes()
+{
+	return false;
+}
+
+_Use_decl_annotations_
+void* ReplayGameHelper::GetFunction(
+	D2Function function) const
+{
+	return nullptr;
+}
+
+_Use_decl_annotations_
+DrawParameters ReplayGameHelper::GetDrawParameters(
+	const D2::CellContextAny* cellContext) const
+{
+	return { 0 };
+}
+
+D2::UnitAny* ReplayGameHelper::GetPlayerUnit() const
+{
+	return nullptr;
+}
+
+_Use_decl_annotations_
+Offset ReplayGameHelper::GetUnitPos(
+	const D2::UnitAny* unit) const
+{
+	return { 0, 0 };
+}
+
+_Use_decl_annotations_
+D2::UnitType ReplayGameHelper::GetUnitType(
+	const D2::UnitAny* unit) const
+{
+	return D2::UnitType::Player;
+}
+
+_Use_decl_annotations_
+uint32_t ReplayGameHelper::GetUnitId(
+	const D2::UnitAny* unit) const
+{
+	return 0;
+}
+
+_Use_decl_annotations_
+D2::UnitAny* ReplayGameHelper::FindUnit(
+	uint32_t unitId,
+	D2::UnitType unitType) const
+{
+	return nullptr;
+}
+
+int32_t ReplayGameHelper::GetCurrentAct() const
+{
+	return _frameState.currentAct;
+}
+
+bool ReplayGameHelper::IsGameMenuOpen() const
+{
+	return _frameState.isGameMenuOpen != 0;
+}
+
+bool ReplayGameHelper::IsInGame() const
+{
+	return _frameState.isInGame != 0;
+}
+
+bool ReplayGameHelper::IsProjectDiablo2() const
+{
+	return false;
+}
@@ -0,0 +1,114 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "GlideTrace.h"
+#include "IGameHelper.h"
+#include "ReplayFrameTimes.h"
+#include "TextureIdentityTable.h"
+
+#include <unordered_map>
+
+namespace d2dx
+{
+	/*
+		An IGameHelper that answers from game state captured in a Glide trace instead of
+		from the game's memory. Version-specific features (motion prediction, fps fixes)
+		are disabled, since no game code is loaded.
+	*/
+	class ReplayGameHelper final : public IGameHelper
+	{
+	public:
+		ReplayGameHelper(
+			_In_ ReplayFrameTimes* frameTimes);
+
+		virtual ~ReplayGameHelper() noexcept {}
+
+		void SetGameAddress(
+			_In_ const GlideTraceGameAddress& gameAddress);
+
+		void SetFrameState(
+			_In_ const GlideTraceFrameState& frameState);
+
+		virtual GameVersion GetVersion() const override;
+
+		virtual _Ret_z_ const char* GetVersionString() const override;
+
+		virtual uint32_t ScreenOpenMode() const override;
+
+		virtual Size GetConfiguredGameSize() const override;
+
+		virtual GameAddress IdentifyGameAddress(
+			_In_ uint32_t returnAddress) const override;
+
+		virtual TextureCategory GetTextureCategory(
+			_In_ uint64_t contentKey,
+			_In_reads_(pixelsSize) const uint8_t* pixels,
+			_In_ uint32_t pixelsSize,
+			_Out_ uint32_t& identityHash) override;
+
+		virtual TextureCategory RefineTextureCategoryFromGameAddress(
+			_In_ TextureCategory previousCategory,
+			_In_ GameAddress gameAddress) const override;
+
+		virtual IMAGE_NT_HEADERS* GetHeader(LPBYTE pBase) override;
+
+		virtual bool TryApplyInGameFpsFix() override;
+
+		virtual bool TryApplyMenuFpsFix() override;
+
+		virtual bool TryApplyInGameSleepFixes() override;
+
+		virtual void* GetFunction(
+			_In_ D2Function function) const override;
+
+		virtual DrawParameters GetDrawParameters(
+			_In_ const D2::CellContextAny* cellContext) const override;
+
+		virtual D2::UnitAny* GetPlayerUnit() const override;
+
+		virtual Offset GetUnitPos(
+			_In_ const D2::UnitAny* unit) const override;
+
+		virtual D2::UnitType GetUnitType(
+			_In_ const D2::UnitAny* unit) const override;
+
+		virtual uint32_t GetUnitId(
+			_In_ const D2::UnitAny* unit) const override;
+
+		virtual D2::UnitAny* FindUnit(
+			_In_ uint32_t unitId,
+			_In_ D2::UnitType unitType) const override;
+
+		virtual int32_t GetCurrentAct() const override;
+
+		virtual bool IsGameMenuOpen() const override;
+
+		virtual bool IsInGame() const override;
+
+		virtual bool IsProjectDiablo2() const override;
+
+	private:
+		ReplayFrameTimes* _frameTimes = nullptr;
+		mutable int64_t _prepareBatchStartTime = 0;
+		GlideTraceFrameState _frameState = { };
+		std::unordered_map<uint32_t, GameAddress> _gameAddresses;
+		TextureIdentityTable _textureIdentities;
+	};
+}
@@ -0,0 +1,200 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "SyntheticWorkload.h"
+#include "D2Types.h"
+#include "Utils.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+SyntheticWorkload::SyntheticWorkload(
+	const SyntheticWorkloadParams& params) :
+	_params{ params },
+	_random{ params.seed },
+	_sizeClassDistribution{ std::begin(params.textureSizeWeights), std::end(params.textureSizeWeights) },
+	_pixels(256 * 256),
+	_palette(256)
+{
+	_params.texturesPerFrame = max(1U, min(_params.texturesPerFrame, _params.batchesPerFrame));
+	_params.distinctTextures = max(1U, _params.distinctTextures);
+	_params.paletteCount = max(1U, min(_params.paletteCount, (uint32_t)D2DX_MAX_GAME_PALETTES));
+	_params.paletteUploadsPerFrame = min(_params.paletteUploadsPerFrame, _params.batchesPerFrame);
+	_params.batchesPerFrame = max(1U, _params.batchesPerFrame);
+
+	/* Size the scratch vertices for the longest strip, allowing for rounding carried over from earlier batches. */
+	const uint32_t maxVerticesPerBatch = (_params.verticesPerFrame + _params.batchesPerFrame - 1) / _params.batchesPerFrame;
+	const uint32_t maxStripLength = max(4U, 2 * (maxVerticesPerBatch / 4) + 3);
+
+	_vertices.resize(maxStripLength * sizeof(D2::Vertex));
+	_vertexPointers.resize(maxStripLength);
+
+	for (uint32_t i = 0; i < maxStripLength; ++i)
+	{
+		_vertexPointers[i] = _vertices.data() + i * sizeof(D2::Vertex);
+	}
+}
+
+_Use_decl_annotations_
+void SyntheticWorkload::Begin(
+	IGlide3x* glide)
+{
+	glide->OnSstWinOpen(0, 640, 480);
+	glide->OnVertexLayout(GR_PARAM_XY, 0);
+	glide->OnVertexLayout(GR_PARAM_PARGB, 8);
+	glide->OnVertexLayout(GR_PARAM_ST0, 16);
+	glide->OnColorCombine(GR_COMBINE_FUNCTION_SCALE_OTHER, GR_COMBINE_FACTOR_LOCAL, GR_COMBINE_LOCAL_ITERATED, GR_COMBINE_OTHER_TEXTURE, false);
+	glide->OnAlphaCombine(GR_COMBINE_FUNCTION_SCALE_OTHER, GR_COMBINE_FACTOR_LOCAL, GR_COMBINE_LOCAL_ITERATED, GR_COMBINE_OTHER_TEXTURE, false);
+	glide->OnAlphaBlendFunction(GR_BLEND_ONE, GR_BLEND_ZERO, GR_BLEND_ZERO, GR_BLEND_ZERO);
+	glide->OnChromakeyMode(GR_CHROMAKEY_ENABLE);
+	UploadPalette(glide);
+}
+
+_Use_decl_annotations_
+void SyntheticWorkload::GenerateFrame(
+	IGlide3x* glide,
+	ReplayFrameTimes& frameTimes)
+{
+	const uint32_t batchCount = _params.batchesPerFrame;
+	uint32_t emittedVertices = 0;
+
+	glide->OnBufferClear();
+
+	for (uint32_t i = 0; i < batchCount; ++i)
+	{
+		/* Spread texture switches and palette uploads evenly over the frame. */
+		if ((uint64_t)i * _params.texturesPerFrame / batchCount != (uint64_t)(i + 1) * _params.texturesPerFrame / batchCount ||
+			i == 0)
+		{
+			SelectTexture(glide, frameTimes);
+		}
+
+		if ((uint64_t)i * _params.paletteUploadsPerFrame / batchCount != (uint64_t)(i + 1) * _params.paletteUploadsPerFrame / batchCount)
+		{
+			UploadPalette(glide);
+		}
+
+		const uint32_t targetVertices = (uint32_t)((uint64_t)(i + 1) * _params.verticesPerFrame / batchCount);
+		const uint32_t vertexCount = targetVertices > emittedVertices ? targetVertices - emittedVertices : 0;
+
+		DrawBatch(glide, vertexCount);
+
+		emittedVertices += vertexCount < 8 ? 4 : 4 * (vertexCount / 4);
+	}
+
+	auto startTime = TimeStart();
+	glide->OnBufferSwap();
+	frameTimes.bufferSwapMs += TimeEndMs(startTime);
+}
+
+_Use_decl_annotations_
+void SyntheticWorkload::SelectTexture(
+	IGlide3x* glide,
+	ReplayFrameTimes& frameTimes)
+{
+	const uint32_t textureId = _random() % _params.distinctTextures;
+
+	/* Derive the size class and contents from the texture id, so that a texture looks the same every time it is used. */
+	std::mt19937 textureRandom{ _params.seed ^ (textureId * 0x9E3779B9U) };
+
+	static const Size textureSizes[D2DX_SYNTHETIC_TEXTURE_SIZE_COUNT] =
+	{
+		{ 8, 8 }, { 16, 16 }, { 32, 32 }, { 64, 64 }, { 128, 128 }, { 256, 256 }, { 256, 128 }
+	};
+
+	const Size textureSize = textureSizes[_sizeClassDistribution(textureRandom)];
+	_textureWidth = textureSize.width;
+	_textureHeight = textureSize.height;
+
+	const uint32_t pixelCount = (uint32_t)(_textureWidth * _textureHeight);
+	uint32_t* pixels = (uint32_t*)_pixels.data();
+
+	for (uint32_t i = 0; i < pixelCount / 4; ++i)
+	{
+		pixels[i] = textureRandom();
+	}
+
+	if (_tmuAddress + pixelCount > D2DX_TMU_MEMORY_SIZE)
+	{
+		_tmuAddress = 256;
+	}
+
+	glide->OnTexDownload(0, _pixels.data(), _tmuAddress, _textureWidth, _textureHeight);
+
+	auto startTime = TimeStart();
+	glide->OnTexSource(0, _tmuAddress, _textureWidth, _textureHeight);
+	frameTimes.texSourceMs += TimeEndMs(startTime);
+
+	_tmuAddress = (_tmuAddress + pixelCount + 255) & ~255U;
+}
+
+_Use_decl_annotations_
+void SyntheticWorkload::UploadPalette(
+	IGlide3x* glide)
+{
+	std::mt19937 paletteRandom{ _params.seed ^ (0x85EBCA6BU + _nextPalette) };
+
+	/* D2DXContext modifies the palette in place, so regenerate it on every upload. */
+	for (uint32_t i = 0; i < 256; ++i)
+	{
+		_palette[i] = paletteRandom() & 0x00FFFFFF;
+	}
+
+	glide->OnTexDownloadTable(GR_TEXTABLE_PALETTE, _palette.data());
+
+	_nextPalette = (_nextPalette + 1) % _params.paletteCount;
+}
+
+_Use_decl_annotations_
+void SyntheticWorkload::DrawBatch(
+	IGlide3x* glide,
+	uint32_t vertexCount)
+{
+	D2::Vertex* vertices = (D2::Vertex*)_vertices.data();
+
+	const float x = (float)(_random() % 600);
+	const float y = (float)(_random() % 440);
+	const float w = (float)_textureWidth;
+	const float h = (float)_textureHeight;
+	const uint32_t color = _random() | 0xFF000000;
+
+	if (vertexCount < 8)
+	{
+		const float corners[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+
+		for (int32_t i = 0; i < 4; ++i)
+		{
+			vertices[i] = { x + corners[i][0] * w, y + corners[i][1] * h, color, 0, corners[i][0] * 255.0f, corners[i][1] * 255.0f, 0 };
+		}
+
+		glide->OnDrawVertexArrayContiguous(GR_TRIANGLE_FAN, 4, _vertices.data(), sizeof(D2::Vertex), 0);
+		return;
+	}
+
+	const uint32_t stripLength = min(2 * (vertexCount / 4) + 1, (uint32_t)_vertexPointers.size());
+
+	for (uint32_t i = 0; i < stripLength; ++i)
+	{
+		const float u = (float)(i >> 1) / (float)(stripLength >> 1);
+		const float v = (float)(i & 1);
+		vertices[i] = { x + u * w, y + v * h, color, 0, u * 255.0f, v * 255.0f, 0 };
+	}
+
+	glide->OnDrawVertexArray(GR_TRIANGLE_STRIP, stripLength, _vertexPointers.data(), 0);
+}
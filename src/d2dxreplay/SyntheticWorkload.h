@@ -0,0 +1,99 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "IGlide3x.h"
+#include "ReplayFrameTimes.h"
+
+#include <random>
+#include <vector>
+
+#define D2DX_SYNTHETIC_TEXTURE_SIZE_COUNT 7
+
+namespace d2dx
+{
+	struct SyntheticWorkloadParams final
+	{
+		uint32_t seed = 1;
+
+		/* Texture switches (download + source) per frame, spread evenly over the batches. */
+		uint32_t texturesPerFrame = 256;
+
+		/* Number of distinct textures to pick from; larger pools force texture cache evictions. */
+		uint32_t distinctTextures = 1024;
+
+		/* Relative weights of 8x8, 16x16, 32x32, 64x64, 128x128, 256x256 and 256x128 textures. */
+		uint32_t textureSizeWeights[D2DX_SYNTHETIC_TEXTURE_SIZE_COUNT] = { 1, 4, 8, 8, 4, 2, 2 };
+
+		/* Distinct palettes to cycle through (at most D2DX_MAX_GAME_PALETTES) and palette uploads per frame. */
+		uint32_t paletteCount = 8;
+		uint32_t paletteUploadsPerFrame = 4;
+
+		uint32_t batchesPerFrame = 2048;
+
+		/* Total vertices per frame as produced by D2DXContext (4 per quad, 4 * ((n - 1) / 2) per strip). */
+		uint32_t verticesPerFrame = 2048 * 4;
+	};
+
+	/*
+		Generates a reproducible synthetic Glide call stream, for pushing D2DXContext's batch and
+		vertex buffers and the texture cache eviction path beyond what recorded traces reach.
+		Batches are quads when they fit the per-batch vertex budget, otherwise triangle strips.
+	*/
+	class SyntheticWorkload final
+	{
+	public:
+		SyntheticWorkload(
+			_In_ const SyntheticWorkloadParams& params);
+
+		~SyntheticWorkload() noexcept {}
+
+		void Begin(
+			_In_ IGlide3x* glide);
+
+		/* Generates one frame, ending with a buffer swap. OnTexSource and OnBufferSwap are timed into frameTimes. */
+		void GenerateFrame(
+			_In_ IGlide3x* glide,
+			_Inout_ ReplayFrameTimes& frameTimes);
+
+	private:
+		void SelectTexture(
+			_In_ IGlide3x* glide,
+			_Inout_ ReplayFrameTimes& frameTimes);
+
+		void UploadPalette(
+			_In_ IGlide3x* glide);
+
+		void DrawBatch(
+			_In_ IGlide3x* glide,
+			_In_ uint32_t vertexCount);
+
+		SyntheticWorkloadParams _params;
+		std::mt19937 _random;
+		std::discrete_distribution<uint32_t> _sizeClassDistribution;
+		std::vector<uint8_t> _pixels;
+		std::vector<uint32_t> _palette;
+		std::vector<uint8_t> _vertices;
+		std::vector<uint8_t*> _vertexPointers;
+		uint32_t _tmuAddress = 256;
+		uint32_t _nextPalette = 0;
+		int32_t _textureWidth = 0;
+		int32_t _textureHeight = 0;
+	};
+}
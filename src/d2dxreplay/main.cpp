@@ -0,0 +1,845 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CompatibilityModeDisabler.h"
+#include "D2DXContext.h"
+#include "FrameDigest.h"
+#include "GlideTraceReader.h"
+#include "NullRenderContext.h"
+#include "ReplayGameHelper.h"
+#include "SimdFactory.h"
+#include "SyntheticWorkload.h"
+#include "TextureCacheMissCurves.h"
+#include "TextureCacheSimulator.h"
+#include "TextureKeyLog.h"
+#include "Utils.h"
+
+#include <vector>
+
+#define D2DX_REPLAY_MAX_SIMULATED_CAPACITIES 8
+#define D2DX_REPLAY_MAX_CURVE_CAPACITY 8192
+
+using namespace d2dx;
+
+/*
+	d2dxreplay drives a D2DXContext with a Glide call stream recorded by the game
+	(-dxdbg_record_glide_trace) or generated from a seed (-synthetic), using a null render
+	context so that no D3D11 device is needed. It reports the CPU time spent per frame in
+	the instrumented phases. With -simulate it instead replays a texture key log
+	(-dxdbg_record_texture_keys) against each texture cache policy, and with -miss-curves it
+	computes the LRU and optimal miss-rate curves of such a log.
+*/
+
+template<typename T>
+static const T* GetPayload(
+	_In_reads_bytes_(payloadSize) const uint8_t* payload,
+	_In_ uint32_t payloadSize,
+	_In_ uint32_t extraSize = 0)
+{
+	if (payloadSize != sizeof(T) + extraSize)
+	{
+		throw std::runtime_error("Record has unexpected size.");
+	}
+
+	return (const T*)payload;
+}
+
+static void ReplayRecord(
+	_In_ GlideTraceRecordType type,
+	_In_reads_bytes_(payloadSize) uint8_t* payload,
+	_In_ uint32_t payloadSize,
+	_In_ const GlideTraceReader& reader,
+	_In_ D2DXContext* d2dxContext,
+	_In_ ReplayGameHelper* gameHelper,
+	_Inout_ ReplayFrameTimes& frameTimes)
+{
+	switch (type)
+	{
+	case GlideTraceRecordType::SstWinOpen:
+	{
+		auto p = GetPayload<GlideTraceSstWinOpen>(payload, payloadSize);
+		d2dxContext->OnSstWinOpen(p->hWnd, p->width, p->height);
+		break;
+	}
+	case GlideTraceRecordType::VertexLayout:
+	{
+		auto p = GetPayload<GlideTraceVertexLayout>(payload, payloadSize);
+		d2dxContext->OnVertexLayout(p->param, p->offset);
+		break;
+	}
+	case GlideTraceRecordType::TexDownload:
+	{
+		auto p = GetPayload<GlideTraceTexDownload>(payload, payloadSize);
+		auto pixels = reader.GetBlob(p->blobId, (uint32_t)(p->width * p->height));
+		d2dxContext->OnTexDownload(p->tmu, pixels, p->startAddress, p->width, p->height);
+		break;
+	}
+	case GlideTraceRecordType::TexSource:
+	{
+		auto p = GetPayload<GlideTraceTexSource>(payload, payloadSize);
+		auto startTime = TimeStart();
+		d2dxContext->OnTexSource(p->tmu, p->startAddress, p->width, p->height);
+		frameTimes.texSourceMs += TimeEndMs(startTime);
+		break;
+	}
+	case GlideTraceRecordType::ConstantColorValue:
+	{
+		auto p = GetPayload<GlideTraceConstantColorValue>(payload, payloadSize);
+		d2dxContext->OnConstantColorValue(p->color);
+		break;
+	}
+	case GlideTraceRecordType::AlphaBlendFunction:
+	{
+		auto p = GetPayload<GlideTraceAlphaBlendFunction>(payload, payloadSize);
+		d2dxContext->OnAlphaBlendFunction(p->rgb_sf, p->rgb_df, p->alpha_sf, p->alpha_df);
+		break;
+	}
+	case GlideTraceRecordType::ColorCombine:
+	{
+		auto p = GetPayload<GlideTraceCombine>(payload, payloadSize);
+		d2dxContext->OnColorCombine(p->function, p->factor, p->local, p->other, p->invert != 0);
+		break;
+	}
+	case GlideTraceRecordType::AlphaCombine:
+	{
+		auto p = GetPayload<GlideTraceCombine>(payload, payloadSize);
+		d2dxContext->OnAlphaCombine(p->function, p->factor, p->local, p->other, p->invert != 0);
+		break;
+	}
+	case GlideTraceRecordType::ChromakeyMode:
+	{
+		auto p = GetPayload<GlideTraceChromakeyMode>(payload, payloadSize);
+		d2dxContext->OnChromakeyMode(p->mode);
+		break;
+	}
+	case GlideTraceRecordType::DrawPoint:
+	{
+		auto p = GetPayload<GlideTraceDrawPoint>(payload, payloadSize);
+		d2dxContext->OnDrawPoint(&p->vertex, p->gameContext);
+		break;
+	}
+	case GlideTraceRecordType::DrawLine:
+	{
+		auto p = GetPayload<GlideTraceDrawLine>(payload, payloadSize);
+		d2dxContext->OnDrawLine(&p->vertices[0], &p->vertices[1], p->gameContext);
+		break;
+	}
+	case GlideTraceRecordType::DrawVertexArray:
+	{
+		if (payloadSize < sizeof(GlideTraceDrawVertexArray))
+		{
+			throw std::runtime_error("Record has unexpected size.");
+		}
+
+		auto p = GetPayload<GlideTraceDrawVertexArray>(payload, payloadSize, ((const GlideTraceDrawVertexArray*)payload)->count * sizeof(D2::Vertex));
+		uint8_t* vertices = payload + sizeof(GlideTraceDrawVertexArray);
+
+		std::vector<uint8_t*> pointers(p->count);
+		for (uint32_t i = 0; i < p->count; ++i)
+		{
+			pointers[i] = vertices + i * sizeof(D2::Vertex);
+		}
+
+		d2dxContext->OnDrawVertexArray(p->mode, p->count, pointers.data(), p->gameContext);
+		break;
+	}
+	case GlideTraceRecordType::DrawVertexArrayContiguous:
+	{
+		if (payloadSize < sizeof(GlideTraceDrawVertexArrayContiguous))
+		{
+			throw std::runtime_error("Record has unexpected size.");
+		}
+
+		auto header = (const GlideTraceDrawVertexArrayContiguous*)payload;
+		auto p = GetPayload<GlideTraceDrawVertexArrayContiguous>(payload, payloadSize, header->count * header->stride);
+		d2dxContext->OnDrawVertexArrayContiguous(p->mode, p->count, payload + sizeof(GlideTraceDrawVertexArrayContiguous), p->stride, p->gameContext);
+		break;
+	}
+	case GlideTraceRecordType::TexDownloadTable:
+	{
+		auto p = GetPayload<GlideTraceTexDownloadTable>(payload, payloadSize);
+
+		/* D2DXContext modifies the palette in place, so give it a copy. */
+		uint32_t palette[256];
+		memcpy(palette, reader.GetBlob(p->blobId, sizeof(palette)), sizeof(palette));
+		d2dxContext->OnTexDownloadTable(p->type, palette);
+		break;
+	}
+	case GlideTraceRecordType::LoadGammaTable:
+	{
+		if (payloadSize < sizeof(GlideTraceLoadGammaTable))
+		{
+			throw std::runtime_error("Record has unexpected size.");
+		}
+
+		const uint32_t nentries = ((const GlideTraceLoadGammaTable*)payload)->nentries;
+		GetPayload<GlideTraceLoadGammaTable>(payload, payloadSize, 3 * nentries * sizeof(uint32_t));
+		uint32_t* red = (uint32_t*)(payload + sizeof(GlideTraceLoadGammaTable));
+		d2dxContext->OnLoadGammaTable(nentries, red, red + nentries, red + 2 * nentries);
+		break;
+	}
+	case GlideTraceRecordType::LfbUnlock:
+	{
+		auto p = GetPayload<GlideTraceLfbUnlock>(payload, payloadSize);
+		auto pixels = (const uint32_t*)reader.GetBlob(p->blobId, p->strideInBytes * 480);
+		d2dxContext->OnLfbUnlock(pixels, p->strideInBytes);
+		break;
+	}
+	case GlideTraceRecordType::GammaCorrectionRGB:
+	{
+		auto p = GetPayload<GlideTraceGammaCorrectionRGB>(payload, payloadSize);
+		d2dxContext->OnGammaCorrectionRGB(p->red, p->green, p->blue);
+		break;
+	}
+	case GlideTraceRecordType::BufferClear:
+		d2dxContext->OnBufferClear();
+		break;
+	case GlideTraceRecordType::BufferSwap:
+	{
+		auto startTime = TimeStart();
+		d2dxContext->OnBufferSwap();
+		frameTimes.bufferSwapMs += TimeEndMs(startTime);
+		break;
+	}
+	case GlideTraceRecordType::GameAddress:
+		gameHelper->SetGameAddress(*GetPayload<GlideTraceGameAddress>(payload, payloadSize));
+		break;
+	case GlideTraceRecordType::FrameState:
+		gameHelper->SetFrameState(*GetPayload<GlideTraceFrameState>(payload, payloadSize));
+		break;
+	default:
+		throw std::runtime_error("Unknown record type.");
+	}
+}
+
+static void PrintSummary(
+	_In_ const std::vector<ReplayFrameTimes>& frames,
+	_In_ float totalMs,
+	_In_ const NullRenderContext& renderContext)
+{
+	ReplayFrameTimes sum;
+	ReplayFrameTimes worst;
+
+	for (const auto& frame : frames)
+	{
+		sum.texSourceMs += frame.texSourceMs;
+		sum.prepareBatchMs += frame.prepareBatchMs;
+		sum.drawBatchesMs += frame.drawBatchesMs;
+		sum.bufferSwapMs += frame.bufferSwapMs;
+		sum.drawCallCount += frame.drawCallCount;
+		sum.textureUploadCount += frame.textureUploadCount;
+		worst.texSourceMs = max(worst.texSourceMs, frame.texSourceMs);
+		worst.prepareBatchMs = max(worst.prepareBatchMs, frame.prepareBatchMs);
+		worst.drawBatchesMs = max(worst.drawBatchesMs, frame.drawBatchesMs);
+		worst.bufferSwapMs = max(worst.bufferSwapMs, frame.bufferSwapMs);
+	}
+
+	const double n = max(1.0, (double)frames.size());
+
+	printf("Replayed %u frames in %.1f ms.\n", (uint32_t)frames.size(), totalMs);
+	printf("%-22s %10s %10s\n", "phase", "avg ms", "max ms");
+	printf("%-22s %10.4f %10.4f\n", "OnTexSource", sum.texSourceMs / n, worst.texSourceMs);
+	printf("%-22s %10.4f %10.4f\n", "PrepareBatchForSubmit", sum.prepareBatchMs / n, worst.prepareBatchMs);
+	printf("%-22s %10.4f %10.4f\n", "DrawBatches", sum.drawBatchesMs / n, worst.drawBatchesMs);
+	printf("%-22s %10.4f %10.4f\n", "OnBufferSwap", sum.bufferSwapMs / n, worst.bufferSwapMs);
+	printf("Draw calls/frame: %.1f, texture uploads/frame: %.2f, texture cache size: %u kB.\n",
+		sum.drawCallCount / n, sum.textureUploadCount / n, renderContext.GetTextureCacheMemoryFootprint() / 1024);
+
+	static const char* categoryNames[(int32_t)TextureCategory::Count] =
+	{
+		"Unknown", "MousePointer", "Player", "LoadingScreen", "Floor", "TitleScreen", "Wall", "UserInterface"
+	};
+
+	printf("%-22s %10s %10s %10s\n", "texture category", "hits", "misses", "resident");
+
+	for (int32_t i = 0; i < (int32_t)TextureCategory::Count; ++i)
+	{
+		TextureCachePartitionStatistics statistics;
+		renderContext.GetTextureCachePartitionStatistics((TextureCategory)i, &statistics);
+
+		if (statistics.hitCount + statistics.missCount > 0)
+		{
+			printf("%-22s %10u %10u %10u\n", categoryNames[i], statistics.hitCount, statistics.missCount, statistics.residentCount);
+		}
+	}
+
+	printf("%-10s %10s %10s %10s %10s %10s %8s %10s %12s\n",
+		"cache", "lookups", "hint hits", "hits", "misses", "evictions", "resets", "used", "uploaded kB");
+
+	for (int32_t i = 0; i < D2DX_TEXTURE_CACHE_COUNT; ++i)
+	{
+		int32_t width, height;
+		uint32_t capacity;
+		RenderContextResources::GetTextureCacheDesc(i, &width, &height, &capacity);
+
+		TextureCacheStatistics statistics;
+		renderContext.GetTextureCacheStatistics(i, nullptr, &statistics);
+
+		if (statistics.lookupCount > 0)
+		{
+			char name[16];
+			sprintf_s(name, "%ix%i", width, height);
+
+			printf("%-10s %10u %10u %10u %10u %10u %8u %4u/%-5u %12u\n",
+				name, statistics.lookupCount, statistics.hintHitCount, statistics.searchHitCount, statistics.missCount,
+				statistics.evictionCount, statistics.resetCount, statistics.usedCount, statistics.capacity,
+				(uint32_t)(statistics.uploadedBytes / 1024));
+		}
+	}
+}
+
+static void WriteCsv(
+	_In_z_ const char* filename,
+	_In_ const std::vector<ReplayFrameTimes>& frames)
+{
+	FILE* file = nullptr;
+
+	if (fopen_s(&file, filename, "w") != 0)
+	{
+		throw std::runtime_error("Failed to open CSV file.");
+	}
+
+	fprintf(file, "frame,texSourceMs,prepareBatchMs,drawBatchesMs,bufferSwapMs,drawCalls,textureUploads\n");
+
+	for (uint32_t i = 0; i < (uint32_t)frames.size(); ++i)
+	{
+		const auto& frame = frames[i];
+		fprintf(file, "%u,%.4f,%.4f,%.4f,%.4f,%u,%u\n", i, frame.texSourceMs, frame.prepareBatchMs,
+			frame.drawBatchesMs, frame.bufferSwapMs, frame.drawCallCount, frame.textureUploadCount);
+	}
+
+	fclose(file);
+}
+
+static bool ParseSizeWeights(
+	_In_z_ const char* text,
+	_Out_writes_(D2DX_SYNTHETIC_TEXTURE_SIZE_COUNT) uint32_t* weights)
+{
+	for (int32_t i = 0; i < D2DX_SYNTHETIC_TEXTURE_SIZE_COUNT; ++i)
+	{
+		char* end = nullptr;
+		weights[i] = (uint32_t)strtoul(text, &end, 10);
+
+		if (end == text || (i < D2DX_SYNTHETIC_TEXTURE_SIZE_COUNT - 1 && *end != ','))
+		{
+			return false;
+		}
+
+		text = end + 1;
+	}
+
+	return true;
+}
+
+static bool ParseCapacities(
+	_In_z_ const char* text,
+	_Out_writes_(D2DX_REPLAY_MAX_SIMULATED_CAPACITIES) uint32_t* capacities,
+	_Out_ uint32_t& capacityCount)
+{
+	capacityCount = 0;
+
+	while (capacityCount < D2DX_REPLAY_MAX_SIMULATED_CAPACITIES)
+	{
+		char* end = nullptr;
+		const uint32_t capacity = (uint32_t)strtoul(text, &end, 10);
+
+		if (end == text || capacity == 0 || (capacity & 63))
+		{
+			return false;
+		}
+
+		capacities[capacityCount++] = capacity;
+
+		if (*end != ',')
+		{
+			return *end == 0;
+		}
+
+		text = end + 1;
+	}
+
+	return false;
+}
+
+/* Loads a texture key log and splits it by size class. Every class sees every frame end, but
+   consecutive frame ends are equivalent to one. */
+static void LoadTextureKeyLogByClass(
+	_In_z_ const char* filename,
+	_Out_writes_(D2DX_TEXTURE_CACHE_COUNT) std::vector<TextureKeyLogRecord>* classRecords)
+{
+	std::vector<TextureKeyLogRecord> records;
+
+	if (!TextureKeyLog::Load(filename, records))
+	{
+		throw std::runtime_error("Failed to read texture key log.");
+	}
+
+	uint32_t frameCount = 0;
+	uint64_t lookupCount = 0;
+
+	for (const auto& record : records)
+	{
+		if (record.contentKey == 0)
+		{
+			for (int32_t i = 0; i < D2DX_TEXTURE_CACHE_COUNT; ++i)
+			{
+				if (!classRecords[i].empty() && classRecords[i].back().contentKey != 0)
+				{
+					classRecords[i].push_back(record);
+				}
+			}
+
+			++frameCount;
+		}
+		else if (record.width <= 256 && record.height <= 256 && max(record.width, record.height) >= 8)
+		{
+			classRecords[RenderContextResources::GetTextureCacheIndex(record.width, record.height)].push_back(record);
+			++lookupCount;
+		}
+	}
+
+	printf("%s: %u frames, %llu texture lookups.\n", filename, frameCount, lookupCount);
+}
+
+/* Replays a texture key log against every policy at several capacities per size class. Unless
+   capacities are given, each class is simulated at 1/4 to 4 times its initial capacity. */
+static void SimulatePolicies(
+	_In_z_ const char* filename,
+	_In_reads_(capacityCount) const uint32_t* capacities,
+	_In_ uint32_t capacityCount,
+	_In_ const std::shared_ptr<ISimd>& simd)
+{
+	std::vector<TextureKeyLogRecord> classRecords[D2DX_TEXTURE_CACHE_COUNT];
+	LoadTextureKeyLogByClass(filename, classRecords);
+
+	printf("Miss rate (%%) per size class and capacity:\n");
+	printf("%-10s %8s", "cache", "capacity");
+
+	for (int32_t p = 0; p < (int32_t)TextureCachePolicyType::Count; ++p)
+	{
+		printf(" %8s", TextureCachePolicyFactory::GetName((TextureCachePolicyType)p));
+	}
+
+	printf("\n");
+
+	for (int32_t i = 0; i < D2DX_TEXTURE_CACHE_COUNT; ++i)
+	{
+		if (classRecords[i].empty())
+		{
+			continue;
+		}
+
+		int32_t width, height;
+		uint32_t initialCapacity;
+		RenderContextResources::GetTextureCacheDesc(i, &width, &height, &initialCapacity);
+
+		uint32_t classCapacities[D2DX_REPLAY_MAX_SIMULATED_CAPACITIES];
+		uint32_t classCapacityCount = capacityCount;
+
+		if (capacityCount > 0)
+		{
+			memcpy(classCapacities, capacities, sizeof(uint32_t) * capacityCount);
+		}
+		else
+		{
+			classCapacityCount = 0;
+
+			for (uint32_t scale = 0; scale < 5; ++scale)
+			{
+				const uint32_t capacity = max(64U, ((initialCapacity << scale) >> 2) & ~63U);
+
+				if (classCapacityCount == 0 || classCapacities[classCapacityCount - 1] != capacity)
+				{
+					classCapacities[classCapacityCount++] = capacity;
+				}
+			}
+		}
+
+		char name[16];
+		sprintf_s(name, "%ix%i", width, height);
+
+		for (uint32_t c = 0; c < classCapacityCount; ++c)
+		{
+			printf("%-10s %8u", name, classCapacities[c]);
+
+			for (int32_t p = 0; p < (int32_t)TextureCachePolicyType::Count; ++p)
+			{
+				TextureCacheSimulationResult result;
+				TextureCacheSimulator::Run((TextureCachePolicyType)p, classCapacities[c], simd,
+					classRecords[i].data(), (uint32_t)classRecords[i].size(), &result);
+
+				printf(" %8.3f", 100.0 * (double)result.missCount / (double)max(1ULL, result.lookupCount));
+			}
+
+			printf("\n");
+		}
+	}
+}
+
+/* Prints the LRU and optimal (Belady) miss-rate curves of a texture key log per size class, and
+   suggests the smallest capacity at which LRU capacity misses stay below 1% of the lookups. */
+static void PrintMissCurves(
+	_In_z_ const char* filename,
+	_In_ double sampleRate)
+{
+	std::vector<TextureKeyLogRecord> classRecords[D2DX_TEXTURE_CACHE_COUNT];
+	LoadTextureKeyLogByClass(filename, classRecords);
+
+	if (sampleRate < 1.0)
+	{
+		printf("Sampling %.1f%% of the content keys.\n", 100.0 * sampleRate);
+	}
+
+	printf("Miss rate (%%) per size class and capacity:\n");
+	printf("%-10s %8s %8s %8s\n", "cache", "capacity", "lru", "opt");
+
+	uint64_t initialFootprint = 0;
+	uint64_t suggestedFootprint = 0;
+
+	for (int32_t i = 0; i < D2DX_TEXTURE_CACHE_COUNT; ++i)
+	{
+		int32_t width, height;
+		uint32_t initialCapacity;
+		RenderContextResources::GetTextureCacheDesc(i, &width, &height, &initialCapacity);
+
+		initialFootprint += (uint64_t)width * height * initialCapacity;
+
+		if (classRecords[i].empty())
+		{
+			suggestedFootprint += (uint64_t)width * height * 64;
+			continue;
+		}
+
+		const uint32_t maxCapacity = (uint32_t)min((uint64_t)D2DX_REPLAY_MAX_CURVE_CAPACITY, (classRecords[i].size() + 63) & ~63ULL);
+		TextureCacheMissCurves missCurves{ classRecords[i].data(), (uint32_t)classRecords[i].size(), maxCapacity, sampleRate };
+
+		char name[16];
+		sprintf_s(name, "%ix%i", width, height);
+
+		for (uint32_t capacity = 64; capacity <= maxCapacity; capacity *= 2)
+		{
+			printf("%-10s %8u %8.3f %8.3f%s\n", name, capacity,
+				100.0 * missCurves.GetLruMissRatio(capacity), 100.0 * missCurves.GetOptMissRatio(capacity),
+				capacity == initialCapacity ? " (initial)" : "");
+		}
+
+		uint32_t suggestedCapacity = 64;
+
+		while (suggestedCapacity < maxCapacity &&
+			missCurves.GetLruMissRatio(suggestedCapacity) - missCurves.GetCompulsoryMissRatio() > 0.01)
+		{
+			suggestedCapacity += 64;
+		}
+
+		suggestedFootprint += (uint64_t)width * height * suggestedCapacity;
+
+		printf("%-10s %llu lookups, %llu distinct textures (%.3f%% compulsory misses), suggested capacity %u (initial %u).\n",
+			name, missCurves.GetLookupCount(), missCurves.GetDistinctCount(), 100.0 * missCurves.GetCompulsoryMissRatio(),
+			suggestedCapacity, initialCapacity);
+	}
+
+	printf("Texture cache footprint: %llu kB initial, %llu kB suggested.\n", initialFootprint / 1024, suggestedFootprint / 1024);
+}
+
+static bool CheckDigests(
+	_In_z_ const char* filename,
+	_In_ const FrameDigest& actual)
+{
+	FrameDigest expected;
+
+	if (!expected.Load(filename))
+	{
+		throw std::runtime_error("Failed to read digest file.");
+	}
+
+	FrameDigestMismatch mismatch;
+
+	if (FrameDigest::Compare(expected, actual, &mismatch))
+	{
+		printf("Output digests match %s (%u frames).\n", filename, actual.GetFrameCount());
+		return true;
+	}
+
+	if (mismatch.frame >= min(expected.GetFrameCount(), actual.GetFrameCount()))
+	{
+		printf("Output digest mismatch: expected %u frames, got %u.\n", mismatch.expected, mismatch.actual);
+	}
+	else if (mismatch.batchIndex < 0)
+	{
+		printf("Output digest mismatch in frame %u: vertex count expected %u, got %u.\n",
+			mismatch.frame, expected.GetFrame(mismatch.frame).vertexCount, actual.GetFrame(mismatch.frame).vertexCount);
+	}
+	else
+	{
+		printf("Output digest mismatch in frame %u, first differing batch %i (expected %08x, got %08x; %u vs %u batches).\n",
+			mismatch.frame, mismatch.batchIndex, mismatch.expected, mismatch.actual,
+			(uint32_t)expected.GetFrame(mismatch.frame).batchDigests.size(),
+			(uint32_t)actual.GetFrame(mismatch.frame).batchDigests.size());
+	}
+
+	return false;
+}
+
+static void PrintUsage()
+{
+	fprintf(stderr,
+		"Usage: d2dxreplay <trace file> [-frames <count>] [-csv <file>] [-digest-out <file>] [-digest-check <file>]\n"
+		"       d2dxreplay -synthetic [-frames <count>] [-csv <file>] [-digest-out <file>] [-digest-check <file>] [-seed <n>]\n"
+		"                  [-textures <per frame>] [-distinct-textures <n>] [-size-weights <w0,...,w6>]\n"
+		"                  [-palettes <n>] [-palette-uploads <per frame>]\n"
+		"                  [-batches <per frame>] [-vertices <per frame>]\n"
+		"       d2dxreplay -simulate <texture key log> [-capacities <c0,c1,...>]\n"
+		"       d2dxreplay -miss-curves <texture key log> [-sample-rate <0..1>]\n"
+		"Replays also accept -policy <bitpmru|clock|2q|arc|lirs> and -texture-keys-out <file>.\n"
+		"Size weights are for 8x8, 16x16, 32x32, 64x64, 128x128, 256x256 and 256x128 textures.\n"
+		"-digest-out writes a golden file of per-frame output digests; -digest-check compares against one.\n");
+}
+
+int main(int argc, char** argv)
+{
+	const char* traceFilename = nullptr;
+	const char* csvFilename = nullptr;
+	const char* digestOutFilename = nullptr;
+	const char* digestCheckFilename = nullptr;
+	uint32_t maxFrames = UINT32_MAX;
+	const char* simulateFilename = nullptr;
+	const char* missCurvesFilename = nullptr;
+	double sampleRate = 1.0;
+	const char* textureKeysOutFilename = nullptr;
+	uint32_t simulatedCapacities[D2DX_REPLAY_MAX_SIMULATED_CAPACITIES];
+	uint32_t simulatedCapacityCount = 0;
+	TextureCachePolicyType policyType = TextureCachePolicyType::BitPmru;
+	bool isSynthetic = false;
+	bool isValid = true;
+	SyntheticWorkloadParams syntheticParams;
+
+	for (int i = 1; i < argc && isValid; ++i)
+	{
+		const bool hasValue = i + 1 < argc;
+
+		if (!strcmp(argv[i], "-frames") && hasValue)
+		{
+			maxFrames = (uint32_t)strtoul(argv[++i], nullptr, 10);
+		}
+		else if (!strcmp(argv[i], "-csv") && hasValue)
+		{
+			csvFilename = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-digest-out") && hasValue)
+		{
+			digestOutFilename = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-digest-check") && hasValue)
+		{
+			digestCheckFilename = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-synthetic"))
+		{
+			isSynthetic = true;
+		}
+		else if (!strcmp(argv[i], "-seed") && hasValue)
+		{
+			syntheticParams.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+		}
+		else if (!strcmp(argv[i], "-textures") && hasValue)
+		{
+			syntheticParams.texturesPerFrame = (uint32_t)strtoul(argv[++i], nullptr, 10);
+		}
+		else if (!strcmp(argv[i], "-distinct-textures") && hasValue)
+		{
+			syntheticParams.distinctTextures = (uint32_t)strtoul(argv[++i], nullptr, 10);
+		}
+		else if (!strcmp(argv[i], "-size-weights") && hasValue)
+		{
+			isValid = ParseSizeWeights(argv[++i], syntheticParams.textureSizeWeights);
+		}
+		else if (!strcmp(argv[i], "-palettes") && hasValue)
+		{
+			syntheticParams.paletteCount = (uint32_t)strtoul(argv[++i], nullptr, 10);
+		}
+		else if (!strcmp(argv[i], "-palette-uploads") && hasValue)
+		{
+			syntheticParams.paletteUploadsPerFrame = (uint32_t)strtoul(argv[++i], nullptr, 10);
+		}
+		else if (!strcmp(argv[i], "-batches") && hasValue)
+		{
+			syntheticParams.batchesPerFrame = (uint32_t)strtoul(argv[++i], nullptr, 10);
+		}
+		else if (!strcmp(argv[i], "-vertices") && hasValue)
+		{
+			syntheticParams.verticesPerFrame = min((uint32_t)strtoul(argv[++i], nullptr, 10), (uint32_t)D2DX_MAX_VERTICES_PER_FRAME);
+		}
+		else if (!strcmp(argv[i], "-simulate") && hasValue)
+		{
+			simulateFilename = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-miss-curves") && hasValue)
+		{
+			missCurvesFilename = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-sample-rate") && hasValue)
+		{
+			sampleRate = atof(argv[++i]);
+			isValid = sampleRate > 0.0 && sampleRate <= 1.0;
+		}
+		else if (!strcmp(argv[i], "-capacities") && hasValue)
+		{
+			isValid = ParseCapacities(argv[++i], simulatedCapacities, simulatedCapacityCount);
+		}
+		else if (!strcmp(argv[i], "-policy") && hasValue)
+		{
+			policyType = TextureCachePolicyFactory::FromName(argv[++i]);
+			isValid = policyType != TextureCachePolicyType::Count;
+		}
+		else if (!strcmp(argv[i], "-texture-keys-out") && hasValue)
+		{
+			textureKeysOutFilename = argv[++i];
+		}
+		else if (!traceFilename && argv[i][0] != '-')
+		{
+			traceFilename = argv[i];
+		}
+		else
+		{
+			isValid = false;
+		}
+	}
+
+	if (!isValid || (isSynthetic ? 1 : 0) + (traceFilename ? 1 : 0) + (simulateFilename ? 1 : 0) + (missCurvesFilename ? 1 : 0) != 1)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (simulateFilename)
+	{
+		try
+		{
+			SimulatePolicies(simulateFilename, simulatedCapacities, simulatedCapacityCount, SimdFactory::CreateBest());
+		}
+		catch (const std::exception& e)
+		{
+			fprintf(stderr, "Simulation failed: %s\n", e.what());
+			return 1;
+		}
+
+		return 0;
+	}
+
+	if (missCurvesFilename)
+	{
+		try
+		{
+			PrintMissCurves(missCurvesFilename, sampleRate);
+		}
+		catch (const std::exception& e)
+		{
+			fprintf(stderr, "Miss curve analysis failed: %s\n", e.what());
+			return 1;
+		}
+
+		return 0;
+	}
+
+	if (isSynthetic && maxFrames == UINT32_MAX)
+	{
+		maxFrames = 600;
+	}
+
+	try
+	{
+		ReplayFrameTimes frameTimes;
+		std::vector<ReplayFrameTimes> frames;
+
+		auto simd = SimdFactory::CreateBest();
+		auto gameHelper = std::make_shared<ReplayGameHelper>(&frameTimes);
+		auto renderContext = std::make_shared<NullRenderContext>(simd, &frameTimes, policyType);
+		std::unique_ptr<TextureKeyLog> textureKeyLog;
+
+		if (textureKeysOutFilename)
+		{
+			textureKeyLog = std::make_unique<TextureKeyLog>(textureKeysOutFilename);
+			renderContext->SetTextureKeyLog(textureKeyLog.get());
+		}
+		auto d2dxContext = std::make_unique<D2DXContext>(gameHelper, simd, std::make_shared<CompatibilityModeDisabler>(), renderContext);
+
+		FrameDigest frameDigest;
+		d2dxContext->SetFrameDigest(&frameDigest);
+
+		auto startTime = TimeStart();
+
+		if (isSynthetic)
+		{
+			SyntheticWorkload workload(syntheticParams);
+			workload.Begin(d2dxContext.get());
+
+			while (frames.size() < maxFrames)
+			{
+				workload.GenerateFrame(d2dxContext.get(), frameTimes);
+				frames.push_back(frameTimes);
+				frameTimes = ReplayFrameTimes();
+			}
+		}
+		else
+		{
+			GlideTraceReader reader(traceFilename);
+
+			GlideTraceRecordType type;
+			uint8_t* payload = nullptr;
+			uint32_t payloadSize = 0;
+
+			while (frames.size() < maxFrames && reader.ReadRecord(&type, &payload, &payloadSize))
+			{
+				ReplayRecord(type, payload, payloadSize, reader, d2dxContext.get(), gameHelper.get(), frameTimes);
+
+				if (type == GlideTraceRecordType::BufferSwap)
+				{
+					frames.push_back(frameTimes);
+					frameTimes = ReplayFrameTimes();
+				}
+			}
+		}
+
+		const float totalMs = TimeEndMs(startTime);
+
+		PrintSummary(frames, totalMs, *renderContext);
+
+		if (csvFilename)
+		{
+			WriteCsv(csvFilename, frames);
+		}
+
+		if (digestOutFilename && !frameDigest.Save(digestOutFilename))
+		{
+			throw std::runtime_error("Failed to write digest file.");
+		}
+
+		if (digestCheckFilename && !CheckDigests(digestCheckFilename, frameDigest))
+		{
+			return 2;
+		}
+	}
+	catch (const std::exception& e)
+	{
+		fprintf(stderr, "Replay failed: %s\n", e.what());
+		return 1;
+	}
+
+	return 0;
+}
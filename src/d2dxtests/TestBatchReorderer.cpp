@@ -0,0 +1,181 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include <vector>
+#include "CppUnitTest.h"
+
+#include "../d2dx/BatchReorderer.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestBatchReorderer)
+	{
+	public:
+		struct Frame final
+		{
+			std::vector<Batch> batches;
+			std::vector<Rect> rects;
+			std::vector<BatchDrawState> drawStates;
+			std::vector<Vertex> vertices;
+
+			/* Adds a 10x10 batch with one quad, its vertices tagged with the batch number. */
+			void AddBatch(
+				uint32_t textureAtlas,
+				int32_t x,
+				int32_t y)
+			{
+				const int32_t batchNumber = (int32_t)batches.size();
+
+				Batch batch;
+				batch.SetTextureStartAddress(256);
+				batch.SetTextureAtlas(textureAtlas);
+				batch.SetStartVertex((int32_t)vertices.size());
+				batch.SetVertexCount(4);
+
+				vertices.push_back(Vertex(x, y, batchNumber, 0, 0xFFFFFFFF, true, 0, 0, 0));
+				vertices.push_back(Vertex(x + 10, y, batchNumber, 0, 0xFFFFFFFF, true, 0, 0, 0));
+				vertices.push_back(Vertex(x + 10, y + 10, batchNumber, 0, 0xFFFFFFFF, true, 0, 0, 0));
+				vertices.push_back(Vertex(x, y + 10, batchNumber, 0, 0xFFFFFFFF, true, 0, 0, 0));
+
+				batches.push_back(batch);
+				rects.push_back({ x, y, 10, 10 });
+				drawStates.push_back({ nullptr, textureAtlas, AlphaBlend::Opaque });
+			}
+
+			uint32_t Reorder(
+				bool allowReordering,
+				std::vector<Batch>& drawBatches,
+				std::vector<int32_t>& batchOrder)
+			{
+				BatchReorderer batchReorderer{ (uint32_t)batches.size() };
+				std::vector<Vertex> drawVertices(vertices.size());
+				uint32_t drawVertexCount = 0;
+
+				drawBatches.resize(batches.size());
+
+				const uint32_t drawBatchCount = batchReorderer.Reorder(
+					batches.data(), rects.data(), drawStates.data(), (uint32_t)batches.size(), vertices.data(),
+					allowReordering, drawBatches.data(), drawVertices.data(), &drawVertexCount);
+
+				batchOrder.clear();
+
+				for (uint32_t i = 0; i < drawVertexCount; i += 4)
+				{
+					batchOrder.push_back(drawVertices[i].GetS());
+				}
+
+				return drawBatchCount;
+			}
+		};
+
+		TEST_METHOD(InterleavedBatchesAreGroupedByDrawState)
+		{
+			Frame frame;
+			frame.AddBatch(0, 0, 0);
+			frame.AddBatch(1, 100, 0);
+			frame.AddBatch(0, 0, 5);
+			frame.AddBatch(1, 100, 5);
+
+			std::vector<Batch> drawBatches;
+			std::vector<int32_t> batchOrder;
+			Assert::AreEqual(2U, frame.Reorder(true, drawBatches, batchOrder));
+
+			Assert::AreEqual(0U, drawBatches[0].GetTextureAtlas());
+			Assert::AreEqual(0, drawBatches[0].GetStartVertex());
+			Assert::AreEqual(8U, drawBatches[0].GetVertexCount());
+			Assert::AreEqual(1U, drawBatches[1].GetTextureAtlas());
+			Assert::AreEqual(8, drawBatches[1].GetStartVertex());
+			Assert::AreEqual(8U, drawBatches[1].GetVertexCount());
+
+			const std::vector<int32_t> expectedOrder = { 0, 2, 1, 3 };
+			Assert::IsTrue(expectedOrder == batchOrder);
+		}
+
+		TEST_METHOD(OverlappingBatchesKeepPaintersOrder)
+		{
+			Frame frame;
+			frame.AddBatch(0, 0, 0);
+			frame.AddBatch(1, 100, 0);
+			frame.AddBatch(2, 5, 5);
+			frame.AddBatch(0, 100, 5);
+			frame.AddBatch(1, 8, 8);
+
+			std::vector<Batch> drawBatches;
+			std::vector<int32_t> batchOrder;
+			Assert::AreEqual(5U, frame.Reorder(true, drawBatches, batchOrder));
+
+			/* Batch 3 overlaps batch 1 and batch 4 overlaps batch 2, so neither can be moved before them. */
+			const std::vector<int32_t> expectedOrder = { 0, 1, 2, 3, 4 };
+			Assert::IsTrue(expectedOrder == batchOrder);
+		}
+
+		TEST_METHOD(WithoutReorderingOnlyConsecutiveBatchesAreMerged)
+		{
+			Frame frame;
+			frame.AddBatch(0, 0, 0);
+			frame.AddBatch(0, 0, 20);
+			frame.AddBatch(1, 100, 0);
+			frame.AddBatch(0, 0, 40);
+
+			std::vector<Batch> drawBatches;
+			std::vector<int32_t> batchOrder;
+			Assert::AreEqual(3U, frame.Reorder(false, drawBatches, batchOrder));
+			Assert::AreEqual(2U, frame.Reorder(true, drawBatches, batchOrder));
+
+			const std::vector<int32_t> expectedOrder = { 0, 1, 3, 2 };
+			Assert::IsTrue(expectedOrder == batchOrder);
+		}
+
+		TEST_METHOD(MergedDrawCallsStayWithinVertexCountLimit)
+		{
+			Frame frame;
+
+			for (uint32_t i = 0; i < D2DX_MAX_QUADS_PER_DRAW_CALL; ++i)
+			{
+				frame.AddBatch(0, 0, 0);
+			}
+
+			std::vector<Batch> drawBatches;
+			std::vector<int32_t> batchOrder;
+			Assert::AreEqual(2U, frame.Reorder(true, drawBatches, batchOrder));
+
+			Assert::AreEqual(BatchReorderer::MaxDrawCallVertexCount, drawBatches[0].GetVertexCount());
+			Assert::AreEqual((int32_t)BatchReorderer::MaxDrawCallVertexCount, drawBatches[1].GetStartVertex());
+			Assert::AreEqual(4U, drawBatches[1].GetVertexCount());
+		}
+
+		TEST_METHOD(InvalidBatchesAreDropped)
+		{
+			Frame frame;
+			frame.AddBatch(0, 0, 0);
+			frame.AddBatch(0, 0, 20);
+			frame.batches[0] = Batch();
+
+			std::vector<Batch> drawBatches;
+			std::vector<int32_t> batchOrder;
+			Assert::AreEqual(1U, frame.Reorder(true, drawBatches, batchOrder));
+
+			const std::vector<int32_t> expectedOrder = { 1 };
+			Assert::IsTrue(expectedOrder == batchOrder);
+		}
+	};
+}
@@ -0,0 +1,96 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include <array>
+#include "CppUnitTest.h"
+#include "../d2dx/FrameDigest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestFrameDigest)
+	{
+	public:
+		static void AddTestFrame(
+			FrameDigest& frameDigest,
+			int32_t changedVertex)
+		{
+			std::array<Batch, 3> batches;
+			std::array<Vertex, 18> vertices;
+
+			for (int32_t i = 0; i < 3; ++i)
+			{
+				batches[i].SetTextureHash(0x1000 + i);
+				batches[i].SetStartVertex(i * 6);
+				batches[i].SetVertexCount(6);
+			}
+
+			for (int32_t i = 0; i < 18; ++i)
+			{
+				vertices[i] = Vertex(i, i == changedVertex ? 100 : 0, 0, 0, 0xFFFFFFFF, false, 0, 0, 0);
+			}
+
+			frameDigest.AddFrame(batches.data(), (uint32_t)batches.size(), vertices.data(), (uint32_t)vertices.size());
+		}
+
+		TEST_METHOD(IdenticalFramesMatch)
+		{
+			FrameDigest expected;
+			FrameDigest actual;
+			AddTestFrame(expected, -1);
+			AddTestFrame(actual, -1);
+
+			FrameDigestMismatch mismatch;
+			Assert::IsTrue(FrameDigest::Compare(expected, actual, &mismatch));
+		}
+
+		TEST_METHOD(MismatchPointsToFirstDifferingBatch)
+		{
+			FrameDigest expected;
+			FrameDigest actual;
+			AddTestFrame(expected, -1);
+			AddTestFrame(actual, -1);
+			AddTestFrame(expected, -1);
+			AddTestFrame(actual, 13);
+
+			FrameDigestMismatch mismatch;
+			Assert::IsFalse(FrameDigest::Compare(expected, actual, &mismatch));
+			Assert::AreEqual(1U, mismatch.frame);
+			Assert::AreEqual(2, mismatch.batchIndex);
+		}
+
+		TEST_METHOD(FrameCountMismatch)
+		{
+			FrameDigest expected;
+			FrameDigest actual;
+			AddTestFrame(expected, -1);
+			AddTestFrame(expected, -1);
+			AddTestFrame(actual, -1);
+
+			FrameDigestMismatch mismatch;
+			Assert::IsFalse(FrameDigest::Compare(expected, actual, &mismatch));
+			Assert::AreEqual(1U, mismatch.frame);
+			Assert::AreEqual(-1, mismatch.batchIndex);
+			Assert::AreEqual(2U, mismatch.expected);
+			Assert::AreEqual(1U, mismatch.actual);
+		}
+	};
+}
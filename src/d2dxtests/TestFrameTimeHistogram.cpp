@@ -0,0 +1,89 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../d2dx/FrameTimeHistogram.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestFrameTimeHistogram)
+	{
+	public:
+		TEST_METHOD(Empty)
+		{
+			FrameTimeHistogram histogram;
+			FrameTimeStatistics statistics;
+			histogram.GetStatistics(&statistics);
+
+			Assert::AreEqual(0U, statistics.frameCount);
+			Assert::AreEqual(0U, statistics.framesOverBudget);
+			Assert::AreEqual(0.0f, statistics.p50Ms);
+			Assert::AreEqual(0.0f, statistics.maxMs);
+		}
+
+		TEST_METHOD(Percentiles)
+		{
+			FrameTimeHistogram histogram;
+			histogram.SetBudget(16.0f);
+
+			for (int32_t i = 0; i < 98; ++i)
+			{
+				histogram.Add(10.1);
+			}
+
+			histogram.Add(20.1);
+			histogram.Add(50.1);
+
+			FrameTimeStatistics statistics;
+			histogram.GetStatistics(&statistics);
+
+			Assert::AreEqual(100U, statistics.frameCount);
+			Assert::AreEqual(2U, statistics.framesOverBudget);
+			Assert::AreEqual(10.25f, statistics.p50Ms);
+			Assert::AreEqual(10.25f, statistics.p95Ms);
+			Assert::AreEqual(20.25f, statistics.p99Ms);
+			Assert::AreEqual(50.1f, statistics.maxMs, 0.001f);
+		}
+
+		TEST_METHOD(LongFramesClampToMax)
+		{
+			FrameTimeHistogram histogram;
+			histogram.Add(1000.0);
+
+			Assert::AreEqual(1000.0f, histogram.GetPercentile(50.0f));
+			Assert::AreEqual(1000.0f, histogram.GetPercentile(100.0f));
+		}
+
+		TEST_METHOD(Reset)
+		{
+			FrameTimeHistogram histogram;
+			histogram.Add(5.0);
+			histogram.Reset();
+
+			FrameTimeStatistics statistics;
+			histogram.GetStatistics(&statistics);
+
+			Assert::AreEqual(0U, statistics.frameCount);
+			Assert::AreEqual(0.0f, statistics.maxMs);
+		}
+	};
+}
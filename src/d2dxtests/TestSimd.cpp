@@ -18,8 +18,10 @@
 */
 #include "pch.h"
 #include <array>
+#include <vector>
 #include "CppUnitTest.h"
-#include "../d2dx/SimdSse2.h"
+#include "../d2dx/SimdFactory.h"
+#include "../d2dx/WideHash.h"
 
 using namespace Microsoft::WRL;
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
@@ -30,26 +32,133 @@ namespace d2dxtests
 	TEST_CLASS(TestSimd)
 	{
 	public:
+		/* Every implementation the test machine can run. */
+		static std::vector<std::shared_ptr<ISimd>> GetImplementations()
+		{
+			std::vector<std::shared_ptr<ISimd>> implementations;
+
+			for (int32_t level = 0; level <= (int32_t)SimdFactory::GetSupportedLevel(); ++level)
+			{
+				implementations.push_back(SimdFactory::Create((SimdLevel)level));
+			}
+
+			return implementations;
+		}
+
 		TEST_METHOD(Create)
 		{
-			auto simd = std::make_shared<SimdSse2>();
+			for (int32_t level = 0; level <= (int32_t)SimdFactory::GetSupportedLevel(); ++level)
+			{
+				Assert::IsTrue(SimdFactory::Create((SimdLevel)level) != nullptr);
+			}
+
+			Assert::IsTrue(SimdFactory::CreateBest() != nullptr);
 		}
 
 		TEST_METHOD(FindUInt32)
 		{
-			auto simd = std::make_shared<SimdSse2>();
+			for (auto& simd : GetImplementations())
+			{
+				alignas(64) std::array<uint32_t, 1024> items;
+
+				for (int32_t i = 0; i < 1024; ++i)
+				{
+					items[i] = 1023 - i;
+				}
+
+				Assert::AreEqual(0, simd->IndexOfUInt32(items.data(), items.size(), 1023));
+				Assert::AreEqual(1023, simd->IndexOfUInt32(items.data(), items.size(), 0));
+				Assert::AreEqual(1009, simd->IndexOfUInt32(items.data(), items.size(), 14));
+				Assert::AreEqual(114, simd->IndexOfUInt32(items.data(), items.size(), 909));
+			}
+		}
+
+		TEST_METHOD(FindUInt64)
+		{
+			for (auto& simd : GetImplementations())
+			{
+				alignas(64) std::array<uint64_t, 1024> items;
+
+				for (int32_t i = 0; i < 1024; ++i)
+				{
+					items[i] = ((uint64_t)(1023 - i) << 32) | 0xABCD;
+				}
+
+				Assert::AreEqual(0, simd->IndexOfUInt64(items.data(), items.size(), (1023ULL << 32) | 0xABCD));
+				Assert::AreEqual(1023, simd->IndexOfUInt64(items.data(), items.size(), 0xABCD));
+				Assert::AreEqual(1009, simd->IndexOfUInt64(items.data(), items.size(), (14ULL << 32) | 0xABCD));
+
+				/* Only one half matching is not a match. */
+				Assert::AreEqual(-1, simd->IndexOfUInt64(items.data(), items.size(), (14ULL << 32) | 0xABCE));
+				Assert::AreEqual(-1, simd->IndexOfUInt64(items.data(), items.size(), (2000ULL << 32) | 0xABCD));
+			}
+		}
+
+		TEST_METHOD(HashBytes64MatchesScalar)
+		{
+			for (auto& simd : GetImplementations())
+			{
+				std::array<uint8_t, 4096 + 3> data;
 
-			alignas(64) std::array<uint32_t, 1024> items;
+				for (uint32_t i = 0; i < data.size(); ++i)
+				{
+					data[i] = (uint8_t)(i * 2654435761U >> 24);
+				}
 
-			for (int32_t i = 0; i < 1024; ++i)
+				for (uint32_t size = 0; size <= 4096; size += (size < 300 ? 1 : 61))
+				{
+					for (uint32_t offset = 0; offset < 3; ++offset)
+					{
+						const uint64_t expected = WideHash::HashBytes64Scalar(data.data() + offset, size);
+						Assert::AreEqual(expected, simd->HashBytes64(data.data() + offset, size));
+						Assert::AreNotEqual(0ULL, expected);
+					}
+				}
+			}
+		}
+
+		TEST_METHOD(CopyAndHashBytes64MatchesHashBytes64)
+		{
+			for (auto& simd : GetImplementations())
 			{
-				items[i] = 1023 - i;
+				std::array<uint8_t, 2048> src;
+				std::array<uint8_t, 2048 + 2> dst;
+
+				for (uint32_t i = 0; i < src.size(); ++i)
+				{
+					src[i] = (uint8_t)(i * 7 + (i >> 8));
+				}
+
+				for (uint32_t size : { 0U, 5U, 63U, 64U, 65U, 256U, 1024U, 1025U, 2047U, 2048U })
+				{
+					dst.fill(0xCC);
+
+					const uint64_t hash = simd->CopyAndHashBytes64(dst.data() + 1, src.data(), size);
+
+					Assert::AreEqual(simd->HashBytes64(src.data(), size), hash);
+					Assert::AreEqual(0, memcmp(dst.data() + 1, src.data(), size));
+					Assert::AreEqual((uint8_t)0xCC, dst[0]);
+					Assert::AreEqual((uint8_t)0xCC, dst[size + 1]);
+				}
 			}
+		}
 
-			Assert::AreEqual(0, simd->IndexOfUInt32(items.data(), items.size(), 1023));
-			Assert::AreEqual(1023, simd->IndexOfUInt32(items.data(), items.size(), 0));
-			Assert::AreEqual(1009, simd->IndexOfUInt32(items.data(), items.size(), 14));
-			Assert::AreEqual(114, simd->IndexOfUInt32(items.data(), items.size(), 909));
+		TEST_METHOD(HashBytes64DetectsSingleByteChange)
+		{
+			for (auto& simd : GetImplementations())
+			{
+				std::array<uint8_t, 256 * 256> pixels{};
+				const uint64_t original = simd->HashBytes64(pixels.data(), (uint32_t)pixels.size());
+
+				for (uint32_t i = 0; i < pixels.size(); i += 997)
+				{
+					pixels[i] ^= 1;
+					Assert::AreNotEqual(original, simd->HashBytes64(pixels.data(), (uint32_t)pixels.size()));
+					pixels[i] ^= 1;
+				}
+
+				Assert::AreEqual(original, simd->HashBytes64(pixels.data(), (uint32_t)pixels.size()));
+			}
 		}
 	};
 }
@@ -24,6 +24,7 @@
 #include "../d2dx/SimdSse2.h"
 #include "../d2dx/Types.h"
 #include "../d2dx/TextureCache.h"
+#include "../d2dx/TextureCacheSlots.h"
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 using namespace d2dx;
@@ -192,5 +193,367 @@ namespace d2dxtests
 				Assert::AreEqual(expectedTextureIndex, tcl._textureIndex);
 			}
 		}
+
+		TEST_METHOD(FindAfterManyEvictions)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			std::array<uint32_t, 16 * 16> tmuData;
+
+			Batch batch;
+			batch.SetTextureStartAddress(0);
+			batch.SetTextureSize(16, 16);
+
+			auto textureCache = std::make_unique<TextureCache>(16, 16, 128, 512, (ID3D11Device*)nullptr, simd);
+			std::array<uint64_t, 128> residentKeys{};
+
+			for (uint64_t i = 1; i <= 4096; ++i)
+			{
+				/* Every other key has the same lower and upper half, so they all collide in the index. */
+				const uint64_t contentKey = (i & 1) ? (i << 32) | i : i * 0x9E3779B97F4A7C15ULL;
+
+				if ((i & 7) == 0)
+				{
+					textureCache->OnNewFrame();
+				}
+
+				auto tcl = textureCache->InsertTexture(contentKey, batch, (const uint8_t*)tmuData.data(), (uint32_t)(tmuData.size() * sizeof(uint32_t)));
+				const uint64_t evictedKey = residentKeys[tcl._textureIndex];
+				residentKeys[tcl._textureIndex] = contentKey;
+
+				if (evictedKey)
+				{
+					Assert::AreEqual((int16_t)-1, textureCache->FindTexture(evictedKey, -1)._textureAtlas);
+				}
+
+				for (uint32_t j = 0; j < residentKeys.size(); j += 17)
+				{
+					if (residentKeys[j])
+					{
+						Assert::AreEqual((int16_t)j, textureCache->FindTexture(residentKeys[j], -1)._textureIndex);
+					}
+				}
+			}
+		}
+
+		TEST_METHOD(SetCapacityKeepsTexturesInRemainingSlots)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			std::array<uint32_t, 16 * 16> tmuData;
+
+			Batch batch;
+			batch.SetTextureStartAddress(0);
+			batch.SetTextureSize(16, 16);
+
+			auto textureCache = std::make_unique<TextureCache>(16, 16, 128, 512, (ID3D11Device*)nullptr, simd);
+
+			for (uint64_t i = 1; i <= 128; ++i)
+			{
+				textureCache->InsertTexture(i, batch, (const uint8_t*)tmuData.data(), (uint32_t)(tmuData.size() * sizeof(uint32_t)));
+			}
+
+			textureCache->SetCapacity(1024);
+			Assert::AreEqual(1024U, textureCache->GetCapacity());
+			Assert::AreEqual(128U, textureCache->GetUsedCount());
+
+			for (uint64_t i = 1; i <= 128; ++i)
+			{
+				Assert::AreEqual((int16_t)(i - 1), textureCache->FindTexture(i, -1)._textureIndex);
+			}
+
+			/* Growing adds a second atlas; new textures go to the free slots. */
+			auto tcl = textureCache->InsertTexture(1000, batch, (const uint8_t*)tmuData.data(), (uint32_t)(tmuData.size() * sizeof(uint32_t)));
+			Assert::AreEqual((int16_t)0, tcl._textureAtlas);
+			Assert::AreEqual((int16_t)128, tcl._textureIndex);
+
+			textureCache->SetCapacity(64);
+			Assert::AreEqual(64U, textureCache->GetCapacity());
+			Assert::AreEqual(64U, textureCache->GetUsedCount());
+
+			for (uint64_t i = 1; i <= 128; ++i)
+			{
+				Assert::AreEqual((int16_t)(i <= 64 ? i - 1 : -1), textureCache->FindTexture(i, -1)._textureIndex);
+			}
+
+			Assert::AreEqual((int16_t)-1, textureCache->FindTexture(1000, -1)._textureIndex);
+		}
+
+		TEST_METHOD(FloorTexturesDoNotEvictPinnedUserInterfaceTextures)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			std::array<uint32_t, 16 * 16> tmuData;
+
+			Batch uiBatch;
+			uiBatch.SetTextureStartAddress(0);
+			uiBatch.SetTextureSize(16, 16);
+			uiBatch.SetTextureCategory(TextureCategory::UserInterface);
+
+			Batch floorBatch = uiBatch;
+			floorBatch.SetTextureCategory(TextureCategory::Floor);
+
+			auto textureCache = std::make_unique<TextureCache>(16, 16, 128, 512, (ID3D11Device*)nullptr, simd);
+			const uint32_t quota = 128 / TextureCacheSlots::PinnedQuotaDivisor;
+
+			for (uint64_t i = 1; i <= quota; ++i)
+			{
+				textureCache->InsertTexture(i, uiBatch, (const uint8_t*)tmuData.data(), (uint32_t)(tmuData.size() * sizeof(uint32_t)));
+			}
+
+			for (uint64_t i = 1; i <= 4096; ++i)
+			{
+				if ((i & 63) == 0)
+				{
+					textureCache->OnNewFrame();
+				}
+
+				textureCache->InsertTexture(1000 + i, floorBatch, (const uint8_t*)tmuData.data(), (uint32_t)(tmuData.size() * sizeof(uint32_t)));
+			}
+
+			for (uint64_t i = 1; i <= quota; ++i)
+			{
+				Assert::IsTrue(textureCache->FindTexture(i, -1)._textureAtlas >= 0);
+			}
+
+			TextureCachePartitionStatistics statistics;
+			textureCache->GetPartitionStatistics(TextureCategory::UserInterface, &statistics);
+			Assert::AreEqual(quota, statistics.hitCount);
+			Assert::AreEqual(quota, statistics.missCount);
+			Assert::AreEqual(quota, statistics.residentCount);
+
+			textureCache->GetPartitionStatistics(TextureCategory::Floor, &statistics);
+			Assert::AreEqual(0U, statistics.hitCount);
+			Assert::AreEqual(4096U, statistics.missCount);
+			Assert::AreEqual(128U - quota, statistics.residentCount);
+		}
+
+		TEST_METHOD(PinnedTexturesBeyondQuotaCanBeEvicted)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			std::array<uint32_t, 16 * 16> tmuData;
+
+			Batch uiBatch;
+			uiBatch.SetTextureStartAddress(0);
+			uiBatch.SetTextureSize(16, 16);
+			uiBatch.SetTextureCategory(TextureCategory::UserInterface);
+
+			Batch floorBatch = uiBatch;
+			floorBatch.SetTextureCategory(TextureCategory::Floor);
+
+			auto textureCache = std::make_unique<TextureCache>(16, 16, 128, 512, (ID3D11Device*)nullptr, simd);
+			const uint32_t quota = 128 / TextureCacheSlots::PinnedQuotaDivisor;
+
+			for (uint64_t i = 1; i <= 64; ++i)
+			{
+				textureCache->InsertTexture(i, uiBatch, (const uint8_t*)tmuData.data(), (uint32_t)(tmuData.size() * sizeof(uint32_t)));
+			}
+
+			for (uint64_t i = 1; i <= 4096; ++i)
+			{
+				if ((i & 63) == 0)
+				{
+					textureCache->OnNewFrame();
+				}
+
+				textureCache->InsertTexture(1000 + i, floorBatch, (const uint8_t*)tmuData.data(), (uint32_t)(tmuData.size() * sizeof(uint32_t)));
+			}
+
+			TextureCachePartitionStatistics statistics;
+			textureCache->GetPartitionStatistics(TextureCategory::UserInterface, &statistics);
+			Assert::AreEqual(quota, statistics.residentCount);
+		}
+
+		TEST_METHOD(StatisticsCountHitsMissesAndEvictions)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			std::array<uint32_t, 16 * 16> tmuData;
+
+			Batch batch;
+			batch.SetTextureStartAddress(0);
+			batch.SetTextureSize(16, 16);
+
+			auto textureCache = std::make_unique<TextureCache>(16, 16, 64, 512, (ID3D11Device*)nullptr, simd);
+
+			for (uint64_t i = 1; i <= 65; ++i)
+			{
+				textureCache->FindTexture(i, -1);
+				textureCache->InsertTexture(i, batch, (const uint8_t*)tmuData.data(), (uint32_t)(tmuData.size() * sizeof(uint32_t)));
+			}
+
+			textureCache->OnNewFrame();
+
+			auto tcl = textureCache->FindTexture(2, -1);
+			textureCache->FindTexture(2, tcl._textureIndex);
+			textureCache->FindTexture(1, -1);
+
+			textureCache->OnNewFrame();
+
+			TextureCacheStatistics lastFrame;
+			TextureCacheStatistics cumulative;
+			textureCache->GetStatistics(&lastFrame, &cumulative);
+
+			Assert::AreEqual(3U, lastFrame.lookupCount);
+			Assert::AreEqual(1U, lastFrame.hintHitCount);
+			Assert::AreEqual(1U, lastFrame.searchHitCount);
+			Assert::AreEqual(1U, lastFrame.missCount);
+			Assert::AreEqual(0U, lastFrame.evictionCount);
+			Assert::AreEqual(0ULL, lastFrame.uploadedBytes);
+			Assert::AreEqual(64U, lastFrame.usedCount);
+			Assert::AreEqual(64U, lastFrame.capacity);
+
+			Assert::AreEqual(68U, cumulative.lookupCount);
+			Assert::AreEqual(66U, cumulative.missCount);
+			Assert::AreEqual(1U, cumulative.evictionCount);
+			Assert::AreEqual(1U, cumulative.resetCount);
+			Assert::AreEqual(65ULL * 16 * 16, cumulative.uploadedBytes);
+		}
+
+		TEST_METHOD(LastLocationIsFoundWithoutSearch)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			std::array<uint8_t, 16 * 16> tmuData = { };
+
+			Batch batch;
+			batch.SetTextureStartAddress(0);
+			batch.SetTextureSize(16, 16);
+
+			auto textureCache = std::make_unique<TextureCache>(16, 16, 1024, 512, (ID3D11Device*)nullptr, simd);
+
+			for (uint64_t i = 1; i <= 513; ++i)
+			{
+				textureCache->InsertTexture(i, batch, tmuData.data(), (uint32_t)tmuData.size());
+			}
+
+			textureCache->OnNewFrame();
+
+			auto tcl = textureCache->FindTexture(513, -1);
+			Assert::AreEqual(1, (int32_t)tcl._textureAtlas);
+			Assert::AreEqual(512, textureCache->GetIndex(tcl));
+			Assert::AreEqual(-1, textureCache->GetIndex({ -1, -1 }));
+
+			auto hintTcl = textureCache->FindTexture(513, textureCache->GetIndex(tcl));
+			Assert::AreEqual(tcl._textureAtlas, hintTcl._textureAtlas);
+			Assert::AreEqual(tcl._textureIndex, hintTcl._textureIndex);
+
+			/* A stale location falls back to searching. */
+			auto otherTcl = textureCache->FindTexture(1, textureCache->GetIndex(tcl));
+			Assert::AreEqual(0, (int32_t)otherTcl._textureAtlas);
+
+			textureCache->OnNewFrame();
+
+			TextureCacheStatistics lastFrame;
+			textureCache->GetStatistics(&lastFrame, nullptr);
+			Assert::AreEqual(1U, lastFrame.hintHitCount);
+			Assert::AreEqual(2U, lastFrame.searchHitCount);
+		}
+
+		TEST_METHOD(AtlasesAreCreatedOnFirstInsert)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			std::array<uint8_t, 16 * 16> tmuData = { };
+
+			Batch batch;
+			batch.SetTextureStartAddress(0);
+			batch.SetTextureSize(16, 16);
+
+			auto textureCache = std::make_unique<TextureCache>(16, 16, 1024, 512, (ID3D11Device*)nullptr, simd);
+			Assert::AreEqual(0U, textureCache->GetMemoryFootprint());
+
+			textureCache->InsertTexture(1, batch, tmuData.data(), (uint32_t)tmuData.size());
+			Assert::AreEqual(512U * 16 * 16, textureCache->GetMemoryFootprint());
+
+			for (uint64_t i = 2; i <= 513; ++i)
+			{
+				textureCache->InsertTexture(i, batch, tmuData.data(), (uint32_t)tmuData.size());
+			}
+
+			Assert::AreEqual(1024U * 16 * 16, textureCache->GetMemoryFootprint());
+
+			textureCache->SetCapacity(256);
+			Assert::AreEqual(256U * 16 * 16, textureCache->GetMemoryFootprint());
+
+			textureCache->SetCapacity(1024);
+			Assert::AreEqual(512U * 16 * 16, textureCache->GetMemoryFootprint());
+		}
+
+		TEST_METHOD(PreloadOnlyUsesFreeSlots)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			std::array<uint8_t, 16 * 16> pixels = { };
+
+			auto textureCache = std::make_unique<TextureCache>(16, 16, 64, 512, (ID3D11Device*)nullptr, simd);
+
+			for (uint64_t i = 1; i <= 64; ++i)
+			{
+				Assert::IsTrue(textureCache->PreloadTexture(i, TextureCategory::Floor, pixels.data()));
+			}
+
+			Assert::IsFalse(textureCache->PreloadTexture(65, TextureCategory::Floor, pixels.data()));
+			Assert::AreEqual(64U, textureCache->GetUsedCount());
+
+			textureCache->OnNewFrame();
+
+			Assert::IsFalse(textureCache->PreloadTexture(1, TextureCategory::Floor, pixels.data()));
+
+			for (uint64_t i = 1; i <= 64; ++i)
+			{
+				Assert::IsTrue(textureCache->FindTexture(i, -1)._textureIndex >= 0);
+			}
+
+			TextureCacheStatistics lastFrame;
+			textureCache->GetStatistics(&lastFrame, nullptr);
+			Assert::AreEqual(0U, lastFrame.missCount);
+			Assert::AreEqual(0U, lastFrame.evictionCount);
+		}
+
+		TEST_METHOD(PreloadDoesNotEvictTexturesNotRecentlyUsed)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			std::array<uint8_t, 16 * 16> tmuData = { };
+
+			Batch batch;
+			batch.SetTextureStartAddress(0);
+			batch.SetTextureSize(16, 16);
+
+			auto textureCache = std::make_unique<TextureCache>(16, 16, 256, 512, (ID3D11Device*)nullptr, simd);
+			textureCache->SetCapacity(128);
+
+			for (uint64_t i = 1; i <= 128; ++i)
+			{
+				textureCache->InsertTexture(i, batch, tmuData.data(), (uint32_t)tmuData.size());
+			}
+
+			textureCache->OnNewFrame();
+
+			for (uint64_t i = 1; i <= 64; ++i)
+			{
+				Assert::IsTrue(textureCache->FindTexture(i, -1)._textureIndex >= 0);
+			}
+
+			/* Replaces a texture from the previous frame, which leaves the slots of the other
+			   textures from that frame occupied but not recently used. */
+			textureCache->InsertTexture(129, batch, tmuData.data(), (uint32_t)tmuData.size());
+			Assert::IsTrue(textureCache->FindTexture(65, -1)._textureIndex < 0);
+
+			textureCache->SetCapacity(256);
+			textureCache->OnNewFrame();
+
+			for (uint64_t i = 1001; i <= 1128; ++i)
+			{
+				Assert::IsTrue(textureCache->PreloadTexture(i, TextureCategory::Floor, tmuData.data()));
+			}
+
+			Assert::IsFalse(textureCache->PreloadTexture(1129, TextureCategory::Floor, tmuData.data()));
+			Assert::AreEqual(256U, textureCache->GetUsedCount());
+
+			textureCache->OnNewFrame();
+
+			TextureCacheStatistics lastFrame;
+			textureCache->GetStatistics(&lastFrame, nullptr);
+			Assert::AreEqual(0U, lastFrame.evictionCount);
+
+			for (uint64_t i = 1; i <= 129; ++i)
+			{
+				Assert::AreEqual(i != 65, textureCache->FindTexture(i, -1)._textureIndex >= 0);
+			}
+		}
 	};
 }
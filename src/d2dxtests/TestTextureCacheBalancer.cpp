@@ -0,0 +1,107 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include <array>
+#include "CppUnitTest.h"
+
+#include "../d2dx/Batch.h"
+#include "../d2dx/SimdSse2.h"
+#include "../d2dx/TextureCache.h"
+#include "../d2dx/TextureCacheBalancer.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestTextureCacheBalancer)
+	{
+	public:
+		static void UseTextures(
+			ITextureCache* textureCache,
+			uint64_t firstContentKey,
+			uint32_t count)
+		{
+			std::array<uint8_t, 16 * 16> tmuData{};
+
+			Batch batch;
+			batch.SetTextureStartAddress(0);
+			batch.SetTextureSize(16, 16);
+
+			for (uint64_t contentKey = firstContentKey; contentKey < firstContentKey + count; ++contentKey)
+			{
+				if (textureCache->FindTexture(contentKey, -1)._textureAtlas < 0)
+				{
+					textureCache->InsertTexture(contentKey, batch, tmuData.data(), (uint32_t)tmuData.size());
+				}
+			}
+		}
+
+		TEST_METHOD(GrowsThrashingCacheAtExpenseOfIdleCache)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			auto hotCache = std::make_unique<TextureCache>(16, 16, 256, 512, (ID3D11Device*)nullptr, simd);
+			auto idleCache = std::make_unique<TextureCache>(16, 16, 256, 512, (ID3D11Device*)nullptr, simd);
+			ITextureCache* caches[] = { hotCache.get(), idleCache.get() };
+			TextureCacheBalancer balancer(caches, 2);
+
+			for (uint32_t frame = 0; frame < 8 * TextureCacheBalancer::RebalanceInterval; ++frame)
+			{
+				/* Every frame uses more distinct textures than fit in the cache. */
+				UseTextures(hotCache.get(), 1 + (frame & 1) * 1000, 320);
+				UseTextures(idleCache.get(), 100000, 16);
+
+				hotCache->OnNewFrame();
+				idleCache->OnNewFrame();
+				balancer.OnNewFrame();
+			}
+
+			Assert::IsTrue(hotCache->GetCapacity() > 256);
+			Assert::IsTrue(idleCache->GetCapacity() < 256);
+			Assert::IsTrue(idleCache->GetCapacity() >= 64);
+			Assert::IsTrue(balancer.GetAllocatedSize() <= balancer.GetBudget());
+
+			/* The idle cache keeps the textures it still uses. */
+			Assert::IsTrue(idleCache->FindTexture(100000, -1)._textureAtlas >= 0);
+		}
+
+		TEST_METHOD(LeavesBalancedCachesAlone)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			auto cache0 = std::make_unique<TextureCache>(16, 16, 256, 512, (ID3D11Device*)nullptr, simd);
+			auto cache1 = std::make_unique<TextureCache>(16, 16, 128, 512, (ID3D11Device*)nullptr, simd);
+			ITextureCache* caches[] = { cache0.get(), cache1.get() };
+			TextureCacheBalancer balancer(caches, 2);
+
+			for (uint32_t frame = 0; frame < 8 * TextureCacheBalancer::RebalanceInterval; ++frame)
+			{
+				UseTextures(cache0.get(), 1, 100);
+				UseTextures(cache1.get(), 1, 50);
+
+				cache0->OnNewFrame();
+				cache1->OnNewFrame();
+				balancer.OnNewFrame();
+			}
+
+			Assert::AreEqual(256U, cache0->GetCapacity());
+			Assert::AreEqual(128U, cache1->GetCapacity());
+			Assert::AreEqual(balancer.GetBudget(), balancer.GetAllocatedSize());
+		}
+	};
+}
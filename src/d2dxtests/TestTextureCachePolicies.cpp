@@ -0,0 +1,498 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include "CppUnitTest.h"
+
+#include "../d2dx/SimdSse2.h"
+#include "../d2dx/TextureCacheMissCurves.h"
+#include "../d2dx/TextureCachePolicyFactory.h"
+#include "../d2dx/TextureCacheSimulator.h"
+#include "../d2dx/TextureCacheSlots.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestTextureCachePolicies)
+	{
+	public:
+		TEST_METHOD(InsertAndFindTextures)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+
+			for (int32_t type = 0; type < (int32_t)TextureCachePolicyType::Count; ++type)
+			{
+				auto policy = TextureCachePolicyFactory::Create((TextureCachePolicyType)type, 128, simd);
+				int32_t slots[128];
+
+				for (uint64_t i = 0; i < 128; ++i)
+				{
+					bool evicted = true;
+					slots[i] = policy->Insert(i + 1, TextureCategory::Floor, evicted);
+					Assert::IsFalse(evicted);
+					Assert::IsTrue(slots[i] >= 0 && slots[i] < 128);
+				}
+
+				policy->OnNewFrame();
+
+				for (uint64_t i = 0; i < 128; ++i)
+				{
+					Assert::AreEqual(slots[i], policy->Find(i + 1, -1));
+				}
+
+				Assert::AreEqual(128U, policy->GetUsedCount());
+				Assert::AreEqual(128U, policy->GetCategoryCount(TextureCategory::Floor));
+				Assert::AreEqual(-1, policy->Find(1000, -1));
+			}
+		}
+
+		TEST_METHOD(SlotsUsedInFrameAreNotReplaced)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+
+			for (int32_t type = 0; type < (int32_t)TextureCachePolicyType::Count; ++type)
+			{
+				auto policy = TextureCachePolicyFactory::Create((TextureCachePolicyType)type, 64, simd);
+				bool evicted = false;
+
+				for (uint64_t i = 1; i <= 64; ++i)
+				{
+					policy->Insert(i, TextureCategory::Unknown, evicted);
+				}
+
+				policy->OnNewFrame();
+
+				bool isUsed[64] = { };
+
+				for (uint64_t i = 1; i <= 32; ++i)
+				{
+					isUsed[policy->Find(i, -1)] = true;
+				}
+
+				for (uint64_t i = 1; i <= 32; ++i)
+				{
+					const int32_t slot = policy->Insert(1000 + i, TextureCategory::Unknown, evicted);
+					Assert::IsTrue(evicted);
+					Assert::IsFalse(isUsed[slot]);
+					isUsed[slot] = true;
+				}
+
+				Assert::AreEqual(64U, policy->GetUsedInFrameCount());
+				Assert::AreEqual(0U, policy->GetResetCount());
+
+				policy->Insert(2000, TextureCategory::Unknown, evicted);
+				Assert::AreEqual(1U, policy->GetResetCount());
+			}
+		}
+
+		TEST_METHOD(InsertFreeOnlyUsesFreeSlots)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+
+			for (int32_t type = 0; type < (int32_t)TextureCachePolicyType::Count; ++type)
+			{
+				auto policy = TextureCachePolicyFactory::Create((TextureCachePolicyType)type, 64, simd);
+				bool evicted = false;
+
+				for (uint64_t i = 1; i <= 64; ++i)
+				{
+					policy->Insert(i, TextureCategory::Floor, evicted);
+				}
+
+				policy->OnNewFrame();
+
+				for (uint64_t i = 1; i <= 32; ++i)
+				{
+					policy->Find(i, -1);
+				}
+
+				/* Leaves occupied slots behind whose textures were not used recently. */
+				policy->Insert(1000, TextureCategory::Floor, evicted);
+				Assert::IsTrue(evicted);
+
+				policy->SetCapacity(128);
+
+				const uint32_t usedInFrameCount = policy->GetUsedInFrameCount();
+
+				for (uint64_t i = 2001; i <= 2064; ++i)
+				{
+					const int32_t slot = policy->InsertFree(i, TextureCategory::Floor);
+					Assert::IsTrue(slot >= 64 && slot < 128);
+				}
+
+				Assert::AreEqual(-1, policy->InsertFree(3000, TextureCategory::Floor));
+				Assert::AreEqual(128U, policy->GetUsedCount());
+				Assert::AreEqual(usedInFrameCount, policy->GetUsedInFrameCount());
+				Assert::AreEqual(0U, policy->GetResetCount());
+
+				for (uint64_t i = 2001; i <= 2064; ++i)
+				{
+					Assert::IsTrue(policy->Find(i, -1) >= 0);
+				}
+			}
+		}
+
+		TEST_METHOD(EvictUnusedPinnedSlotBeforeStartingOver)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+
+			for (int32_t type = 0; type < (int32_t)TextureCachePolicyType::Count; ++type)
+			{
+				auto policy = TextureCachePolicyFactory::Create((TextureCachePolicyType)type, 64, simd);
+				bool evicted = false;
+
+				for (uint64_t i = 1; i <= 4; ++i)
+				{
+					policy->Insert(i, TextureCategory::UserInterface, evicted);
+				}
+
+				policy->OnNewFrame();
+
+				for (uint64_t i = 1; i <= 60; ++i)
+				{
+					Assert::IsTrue(policy->Insert(100 + i, TextureCategory::Floor, evicted) >= 0);
+					Assert::IsFalse(evicted);
+				}
+
+				/* Every unpinned slot is now used in this frame. */
+				const int32_t slot = policy->Insert(1000, TextureCategory::Floor, evicted);
+				Assert::IsTrue(evicted);
+				Assert::AreEqual(0U, policy->GetResetCount());
+				Assert::AreEqual(3U, policy->GetCategoryCount(TextureCategory::UserInterface));
+				Assert::AreEqual(slot, policy->Find(1000, -1));
+
+				for (uint64_t i = 1; i <= 60; ++i)
+				{
+					Assert::IsTrue(policy->Find(100 + i, -1) >= 0);
+				}
+			}
+		}
+
+		TEST_METHOD(KeepPinnedTexturesWithinQuota)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			const uint32_t quota = 128 / TextureCacheSlots::PinnedQuotaDivisor;
+
+			for (int32_t type = 0; type < (int32_t)TextureCachePolicyType::Count; ++type)
+			{
+				auto policy = TextureCachePolicyFactory::Create((TextureCachePolicyType)type, 128, simd);
+				bool evicted = false;
+
+				for (uint64_t i = 1; i <= 4 * quota; ++i)
+				{
+					policy->Insert(i, TextureCategory::UserInterface, evicted);
+					policy->OnNewFrame();
+				}
+
+				Assert::AreEqual(quota, policy->GetCategoryCount(TextureCategory::UserInterface));
+				Assert::AreEqual(quota, policy->GetUsedCount());
+				Assert::AreEqual(0U, policy->GetResetCount());
+			}
+		}
+
+		TEST_METHOD(PinnedTexturesSurviveOtherCategories)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+
+			for (int32_t type = 0; type < (int32_t)TextureCachePolicyType::Count; ++type)
+			{
+				auto policy = TextureCachePolicyFactory::Create((TextureCachePolicyType)type, 128, simd);
+				bool evicted = false;
+
+				for (uint64_t i = 1; i <= 8; ++i)
+				{
+					policy->Insert(i, TextureCategory::MousePointer, evicted);
+				}
+
+				for (uint64_t i = 1; i <= 1024; ++i)
+				{
+					policy->OnNewFrame();
+					policy->Insert(100 + i, TextureCategory::Floor, evicted);
+				}
+
+				for (uint64_t i = 1; i <= 8; ++i)
+				{
+					Assert::IsTrue(policy->Find(i, -1) >= 0);
+				}
+			}
+		}
+
+		TEST_METHOD(SetCapacityKeepsTexturesInRemainingSlots)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+
+			for (int32_t type = 0; type < (int32_t)TextureCachePolicyType::Count; ++type)
+			{
+				auto policy = TextureCachePolicyFactory::Create((TextureCachePolicyType)type, 128, simd);
+				int32_t slots[128];
+				bool evicted = false;
+
+				for (uint64_t i = 0; i < 128; ++i)
+				{
+					slots[i] = policy->Insert(i + 1, TextureCategory::Unknown, evicted);
+				}
+
+				policy->SetCapacity(64);
+
+				for (uint64_t i = 0; i < 128; ++i)
+				{
+					Assert::AreEqual(slots[i] < 64 ? slots[i] : -1, policy->Find(i + 1, -1));
+				}
+
+				Assert::AreEqual(64U, policy->GetUsedCount());
+
+				policy->SetCapacity(192);
+				policy->OnNewFrame();
+
+				for (uint64_t i = 0; i < 128; ++i)
+				{
+					const int32_t slot = policy->Insert(1000 + i, TextureCategory::Unknown, evicted);
+					Assert::IsTrue(slot >= 64 && slot < 192);
+					Assert::IsFalse(evicted);
+				}
+
+				Assert::AreEqual(192U, policy->GetUsedCount());
+			}
+		}
+
+		TEST_METHOD(RandomWorkloadKeepsSlotsConsistent)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+
+			for (int32_t type = 0; type < (int32_t)TextureCachePolicyType::Count; ++type)
+			{
+				auto policy = TextureCachePolicyFactory::Create((TextureCachePolicyType)type, 256, simd);
+				std::unordered_map<uint64_t, int32_t> residents;
+				std::vector<uint64_t> slotKeys(256, 0);
+				std::vector<bool> isUsedInFrame(256, false);
+				uint32_t seed = 12345;
+
+				for (uint32_t access = 0; access < 100000; ++access)
+				{
+					if ((access % 100) == 99)
+					{
+						policy->OnNewFrame();
+						std::fill(isUsedInFrame.begin(), isUsedInFrame.end(), false);
+					}
+
+					if (access == 50000)
+					{
+						policy->SetCapacity(128);
+
+						for (uint32_t slot = 128; slot < 256; ++slot)
+						{
+							residents.erase(slotKeys[slot]);
+							slotKeys[slot] = 0;
+						}
+					}
+
+					/* Skewed towards low keys, so that some textures are reused often. */
+					seed = seed * 1664525 + 1013904223;
+					const uint32_t r = seed >> 8;
+					const uint64_t contentKey = 1 + (r % 1024) * ((r >> 10) % 1024) / 1024;
+
+					int32_t slot = policy->Find(contentKey, -1);
+					auto it = residents.find(contentKey);
+
+					if (it != residents.end())
+					{
+						Assert::AreEqual(it->second, slot);
+					}
+					else
+					{
+						Assert::AreEqual(-1, slot);
+
+						const uint32_t resetCount = policy->GetResetCount();
+						bool evicted = false;
+						slot = policy->Insert(contentKey, TextureCategory::Unknown, evicted);
+
+						Assert::IsTrue(slot >= 0 && slot < (int32_t)policy->GetCapacity());
+						Assert::AreEqual(slotKeys[slot] != 0, evicted);
+
+						if (policy->GetResetCount() != resetCount)
+						{
+							std::fill(isUsedInFrame.begin(), isUsedInFrame.end(), false);
+						}
+
+						Assert::IsFalse(isUsedInFrame[slot]);
+
+						residents.erase(slotKeys[slot]);
+						residents[contentKey] = slot;
+						slotKeys[slot] = contentKey;
+					}
+
+					isUsedInFrame[slot] = true;
+				}
+
+				Assert::AreEqual((uint32_t)residents.size(), policy->GetUsedCount());
+			}
+		}
+
+		TEST_METHOD(SimulatorCountsOnlyCompulsoryMissesWhenEverythingFits)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			std::vector<TextureKeyLogRecord> records;
+
+			for (uint32_t frame = 0; frame < 10; ++frame)
+			{
+				for (uint64_t i = 1; i <= 100; ++i)
+				{
+					TextureKeyLogRecord record = { };
+					record.contentKey = i;
+					record.width = 16;
+					record.height = 16;
+					records.push_back(record);
+				}
+
+				records.push_back(TextureKeyLogRecord());
+			}
+
+			for (int32_t type = 0; type < (int32_t)TextureCachePolicyType::Count; ++type)
+			{
+				TextureCacheSimulationResult result;
+				TextureCacheSimulator::Run((TextureCachePolicyType)type, 128, simd, records.data(), (uint32_t)records.size(), &result);
+
+				Assert::AreEqual(1000ULL, result.lookupCount);
+				Assert::AreEqual(100ULL, result.missCount);
+				Assert::AreEqual(0U, result.resetCount);
+			}
+		}
+
+		TEST_METHOD(MissCurvesOfCyclicWorkload)
+		{
+			std::vector<TextureKeyLogRecord> records;
+
+			for (uint32_t round = 0; round < 10; ++round)
+			{
+				for (uint64_t i = 1; i <= 4; ++i)
+				{
+					TextureKeyLogRecord record = { };
+					record.contentKey = i;
+					records.push_back(record);
+				}
+
+				records.push_back(TextureKeyLogRecord());
+			}
+
+			TextureCacheMissCurves missCurves{ records.data(), (uint32_t)records.size(), 8 };
+
+			Assert::AreEqual(40ULL, missCurves.GetLookupCount());
+			Assert::AreEqual(4ULL, missCurves.GetDistinctCount());
+			Assert::AreEqual(0.1, missCurves.GetCompulsoryMissRatio(), 1e-9);
+
+			/* LRU always evicts the key needed next; OPT keeps most of the cycle. */
+			Assert::AreEqual(1.0, missCurves.GetLruMissRatio(3), 1e-9);
+			Assert::IsTrue(missCurves.GetOptMissRatio(3) < 0.5);
+			Assert::AreEqual(0.1, missCurves.GetLruMissRatio(4), 1e-9);
+			Assert::AreEqual(0.1, missCurves.GetOptMissRatio(4), 1e-9);
+			Assert::AreEqual(1.0, missCurves.GetOptMissRatio(0), 1e-9);
+		}
+
+		TEST_METHOD(MissCurvesMatchDirectSimulation)
+		{
+			std::vector<TextureKeyLogRecord> records;
+			uint32_t seed = 12345;
+
+			for (uint32_t i = 0; i < 5000; ++i)
+			{
+				seed = seed * 1664525 + 1013904223;
+
+				/* A small hot set and a long tail. */
+				TextureKeyLogRecord record = { };
+				record.contentKey = 1 + ((seed >> 8) & 3 ? (seed >> 12) % 24 : (seed >> 12) % 200);
+				records.push_back(record);
+			}
+
+			TextureCacheMissCurves missCurves{ records.data(), (uint32_t)records.size(), 64 };
+
+			for (uint32_t capacity : { 1U, 2U, 8U, 20U, 32U, 64U })
+			{
+				std::list<uint64_t> lru;
+				std::vector<uint64_t> opt;
+				uint32_t lruMissCount = 0;
+				uint32_t optMissCount = 0;
+
+				for (uint32_t i = 0; i < records.size(); ++i)
+				{
+					const uint64_t contentKey = records[i].contentKey;
+
+					auto it = std::find(lru.begin(), lru.end(), contentKey);
+
+					if (it != lru.end())
+					{
+						lru.erase(it);
+					}
+					else
+					{
+						++lruMissCount;
+
+						if (lru.size() == capacity)
+						{
+							lru.pop_back();
+						}
+					}
+
+					lru.push_front(contentKey);
+
+					if (std::find(opt.begin(), opt.end(), contentKey) != opt.end())
+					{
+						continue;
+					}
+
+					++optMissCount;
+
+					if (opt.size() < capacity)
+					{
+						opt.push_back(contentKey);
+						continue;
+					}
+
+					/* Replace the entry used again furthest in the future. */
+					uint32_t victim = 0;
+					uint32_t victimNextUse = 0;
+
+					for (uint32_t j = 0; j < opt.size(); ++j)
+					{
+						uint32_t nextUse = i + 1;
+
+						while (nextUse < records.size() && records[nextUse].contentKey != opt[j])
+						{
+							++nextUse;
+						}
+
+						if (nextUse > victimNextUse)
+						{
+							victim = j;
+							victimNextUse = nextUse;
+						}
+					}
+
+					opt[victim] = contentKey;
+				}
+
+				Assert::AreEqual((double)lruMissCount / records.size(), missCurves.GetLruMissRatio(capacity), 1e-9);
+				Assert::AreEqual((double)optMissCount / records.size(), missCurves.GetOptMissRatio(capacity), 1e-9);
+			}
+		}
+	};
+}
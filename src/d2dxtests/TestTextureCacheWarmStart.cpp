@@ -0,0 +1,140 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include <array>
+#include "CppUnitTest.h"
+
+#include "../d2dx/SimdSse2.h"
+#include "../d2dx/TextureCacheFile.h"
+#include "../d2dx/TextureCacheWarmStart.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestTextureCacheWarmStart)
+	{
+	public:
+		TEST_METHOD(SavedTexturesCanBeMapped)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			std::array<uint8_t, 32 * 16> pixels;
+
+			for (uint32_t i = 0; i < pixels.size(); ++i)
+			{
+				pixels[i] = (uint8_t)(i * 7);
+			}
+
+			TextureCacheFileWriter writer{ simd };
+			writer.AddTexture(0x1234, 16, 16, TextureCategory::Floor, pixels.data(), 32);
+			writer.AddTexture(0x5678, 8, 8, TextureCategory::UserInterface, pixels.data() + 1, 9);
+			Assert::IsTrue(writer.Save("d2dxtests_texturecache.bin"));
+
+			{
+				TextureCacheFileView view{ "d2dxtests_texturecache.bin" };
+				Assert::IsTrue(view.Validate(simd.get()));
+				Assert::AreEqual(2U, view.GetEntryCount());
+
+				const TextureCacheFileEntry& entry0 = view.GetEntry(0);
+				Assert::AreEqual(0x1234ULL, entry0.contentKey);
+				Assert::AreEqual((uint16_t)16, entry0.width);
+				Assert::AreEqual((uint16_t)16, entry0.height);
+				Assert::AreEqual((uint8_t)TextureCategory::Floor, entry0.category);
+				Assert::AreEqual(0U, entry0.pixelOffset % D2DX_TEXTURE_CACHE_FILE_ALIGNMENT);
+
+				const TextureCacheFileEntry& entry1 = view.GetEntry(1);
+				Assert::AreEqual(0x5678ULL, entry1.contentKey);
+				Assert::AreEqual((uint8_t)TextureCategory::UserInterface, entry1.category);
+				Assert::AreEqual(0U, entry1.pixelOffset % D2DX_TEXTURE_CACHE_FILE_ALIGNMENT);
+
+				for (int32_t y = 0; y < 16; ++y)
+				{
+					Assert::AreEqual(0, memcmp(view.GetPixels(entry0) + y * 16, pixels.data() + y * 32, 16));
+				}
+
+				for (int32_t y = 0; y < 8; ++y)
+				{
+					Assert::AreEqual(0, memcmp(view.GetPixels(entry1) + y * 8, pixels.data() + 1 + y * 9, 8));
+				}
+			}
+
+			remove("d2dxtests_texturecache.bin");
+		}
+
+		TEST_METHOD(DamagedFileIsRejected)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			std::array<uint8_t, 16 * 16> pixels = { };
+
+			TextureCacheFileWriter writer{ simd };
+			writer.AddTexture(0x1234, 16, 16, TextureCategory::Floor, pixels.data(), 16);
+			Assert::IsTrue(writer.Save("d2dxtests_texturecache.bin"));
+
+			FILE* file = nullptr;
+			Assert::AreEqual(0, (int)fopen_s(&file, "d2dxtests_texturecache.bin", "r+b"));
+			fseek(file, -1, SEEK_END);
+			fputc(1, file);
+			fclose(file);
+
+			{
+				TextureCacheFileView view{ "d2dxtests_texturecache.bin" };
+				Assert::IsFalse(view.Validate(simd.get()));
+			}
+
+			remove("d2dxtests_texturecache.bin");
+
+			TextureCacheFileView missingView{ "d2dxtests_texturecache.bin" };
+			Assert::IsFalse(missingView.Validate(simd.get()));
+		}
+
+		TEST_METHOD(WarmStartReturnsEachEntryOnce)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			std::array<uint8_t, 16 * 16> pixels = { };
+
+			TextureCacheFileWriter writer{ simd };
+
+			for (uint64_t i = 1; i <= 10; ++i)
+			{
+				writer.AddTexture(i, 16, 16, TextureCategory::Floor, pixels.data(), 16);
+			}
+
+			Assert::IsTrue(writer.Save("d2dxtests_texturecache.bin"));
+
+			{
+				TextureCacheWarmStart warmStart{ "d2dxtests_texturecache.bin", simd };
+				warmStart.WaitForLoad();
+
+				for (uint64_t i = 1; i <= 10; ++i)
+				{
+					Assert::IsFalse(warmStart.IsDone());
+					const TextureCacheFileEntry* entry = warmStart.GetNextEntry();
+					Assert::IsNotNull(entry);
+					Assert::AreEqual(i, entry->contentKey);
+				}
+
+				Assert::IsNull(warmStart.GetNextEntry());
+				Assert::IsTrue(warmStart.IsDone());
+			}
+
+			remove("d2dxtests_texturecache.bin");
+		}
+	};
+}
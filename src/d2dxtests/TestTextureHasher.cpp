@@ -0,0 +1,152 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include <vector>
+#include "CppUnitTest.h"
+#include "../d2dx/SimdSse2.h"
+#include "../d2dx/TextureHasher.h"
+#include "../d2dx/TextureIdentityTable.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestTextureHasher)
+	{
+	public:
+		static uint64_t Download(
+			TextureHasher& hasher,
+			ISimd& simd,
+			std::vector<uint8_t>& tmu,
+			uint32_t startAddress,
+			uint32_t size,
+			uint8_t value)
+		{
+			std::vector<uint8_t> pixels(size, value);
+			const uint64_t contentKey = simd.CopyAndHashBytes64(tmu.data() + startAddress, pixels.data(), size);
+			hasher.SetHash(startAddress, contentKey, size);
+			return contentKey;
+		}
+
+		TEST_METHOD(DownloadOverInteriorTextureInvalidatesIt)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			TextureHasher hasher(simd);
+			std::vector<uint8_t> tmu(0x40000);
+
+			Download(hasher, *simd, tmu, 0x11000, 16 * 16, 1);
+			const uint64_t before = hasher.GetHash(0x11000, tmu.data() + 0x11000, 16 * 16);
+
+			/* A 256x128 upload that covers the 16x16 texture. */
+			Download(hasher, *simd, tmu, 0x10000, 256 * 128, 2);
+
+			const uint64_t after = hasher.GetHash(0x11000, tmu.data() + 0x11000, 16 * 16);
+			Assert::AreNotEqual(before, after);
+			Assert::AreEqual(simd->HashBytes64(tmu.data() + 0x11000, 16 * 16), after);
+		}
+
+		TEST_METHOD(DownloadIntoTextureTailInvalidatesIt)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			TextureHasher hasher(simd);
+			std::vector<uint8_t> tmu(0x40000);
+
+			const uint64_t before = Download(hasher, *simd, tmu, 0x20000, 64 * 64, 1);
+
+			/* Overwrite the middle of the 64x64 texture. */
+			Download(hasher, *simd, tmu, 0x20800, 16 * 16, 2);
+
+			const uint64_t after = hasher.GetHash(0x20000, tmu.data() + 0x20000, 64 * 64);
+			Assert::AreNotEqual(before, after);
+			Assert::AreEqual(simd->HashBytes64(tmu.data() + 0x20000, 64 * 64), after);
+		}
+
+		TEST_METHOD(DownloadIntoLastSlotOfLargestTextureInvalidatesIt)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			TextureHasher hasher(simd);
+			std::vector<uint8_t> tmu(0x40000);
+
+			/* The back-scan is limited by the largest extent recorded, which is this texture's. */
+			const uint64_t before = Download(hasher, *simd, tmu, 0x20000, 64 * 64, 1);
+			Download(hasher, *simd, tmu, 0x20F00, 16 * 16, 2);
+
+			const uint64_t after = hasher.GetHash(0x20000, tmu.data() + 0x20000, 64 * 64);
+			Assert::AreNotEqual(before, after);
+			Assert::AreEqual(simd->HashBytes64(tmu.data() + 0x20000, 64 * 64), after);
+		}
+
+		TEST_METHOD(DownloadNextToTextureKeepsIt)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			TextureHasher hasher(simd);
+			std::vector<uint8_t> tmu(0x40000);
+
+			const uint64_t before = Download(hasher, *simd, tmu, 0x30000, 16 * 16, 1);
+			Download(hasher, *simd, tmu, 0x30100, 16 * 16, 2);
+
+			/* Scribble over the texture behind the hasher's back: a cache hit returns the old key. */
+			memset(tmu.data() + 0x30000, 3, 16 * 16);
+
+			Assert::AreEqual(before, hasher.GetHash(0x30000, tmu.data() + 0x30000, 16 * 16));
+		}
+
+		TEST_METHOD(IdentityTableFindsInsertedContent)
+		{
+			TextureIdentityTable textureIdentities;
+			uint32_t identityHash = 0;
+			TextureCategory category = TextureCategory::Unknown;
+
+			for (uint64_t i = 1; i <= 1000; ++i)
+			{
+				textureIdentities.Insert(i << 40, (uint32_t)i, TextureCategory::Floor);
+			}
+
+			for (uint64_t i = 1; i <= 1000; ++i)
+			{
+				Assert::IsTrue(textureIdentities.Find(i << 40, identityHash, category));
+				Assert::AreEqual((uint32_t)i, identityHash);
+				Assert::IsTrue(category == TextureCategory::Floor);
+			}
+
+			Assert::IsFalse(textureIdentities.Find(1001ULL << 40, identityHash, category));
+		}
+
+		TEST_METHOD(IdentityTableIsClearedWhenFull)
+		{
+			TextureIdentityTable textureIdentities;
+			uint32_t identityHash = 0;
+			TextureCategory category = TextureCategory::Unknown;
+
+			for (uint64_t i = 1; i <= TextureIdentityTable::MaxCount; ++i)
+			{
+				textureIdentities.Insert(i, (uint32_t)i, TextureCategory::Wall);
+			}
+
+			Assert::AreEqual(TextureIdentityTable::MaxCount, textureIdentities.GetCount());
+
+			textureIdentities.Insert(TextureIdentityTable::MaxCount + 1, 0, TextureCategory::Wall);
+
+			Assert::AreEqual(1U, textureIdentities.GetCount());
+			Assert::IsFalse(textureIdentities.Find(1, identityHash, category));
+			Assert::IsTrue(textureIdentities.Find(TextureIdentityTable::MaxCount + 1, identityHash, category));
+		}
+	};
+}
@@ -0,0 +1,100 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include <array>
+#include "CppUnitTest.h"
+
+#include "../d2dx/TextureUploadRing.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestTextureUploadRing)
+	{
+	public:
+		TEST_METHOD(CoalescedUploadsAreOrderedBySlot)
+		{
+			TextureUploadRing ring(1024, 16);
+			std::array<uint8_t, 64> pixels;
+
+			const uint32_t slots[] = { 7, 3, 12, 0 };
+
+			for (uint32_t slot : slots)
+			{
+				pixels.fill((uint8_t)slot);
+				Assert::IsTrue(ring.Stage(slot, 8, 8, pixels.data()));
+			}
+
+			Assert::AreEqual(4U, ring.Coalesce());
+
+			const uint32_t expectedSlots[] = { 0, 3, 7, 12 };
+
+			for (uint32_t i = 0; i < 4; ++i)
+			{
+				const TextureUpload& upload = ring.GetUpload(i);
+				Assert::AreEqual(expectedSlots[i], upload.slot);
+				Assert::AreEqual((uint16_t)8, upload.width);
+				Assert::AreEqual((uint16_t)8, upload.height);
+				Assert::AreEqual((uint8_t)expectedSlots[i], ring.GetPixels(upload)[63]);
+			}
+		}
+
+		TEST_METHOD(LastUploadToSlotWins)
+		{
+			TextureUploadRing ring(1024, 16);
+			std::array<uint8_t, 64> pixels;
+
+			for (uint8_t value = 1; value <= 3; ++value)
+			{
+				pixels.fill(value);
+				Assert::IsTrue(ring.Stage(5, 8, 8, pixels.data()));
+
+				pixels.fill(100 + value);
+				Assert::IsTrue(ring.Stage(value, 8, 8, pixels.data()));
+			}
+
+			Assert::AreEqual(4U, ring.Coalesce());
+			Assert::AreEqual(5U, ring.GetUpload(3).slot);
+			Assert::AreEqual((uint8_t)3, ring.GetPixels(ring.GetUpload(3))[0]);
+			Assert::AreEqual((uint8_t)101, ring.GetPixels(ring.GetUpload(0))[0]);
+		}
+
+		TEST_METHOD(StageFailsWhenFullAndSucceedsAfterClear)
+		{
+			TextureUploadRing ring(256, 16);
+			std::array<uint8_t, 128> pixels{};
+
+			Assert::IsTrue(ring.Stage(0, 16, 8, pixels.data()));
+			Assert::IsTrue(ring.Stage(1, 16, 8, pixels.data()));
+			Assert::IsFalse(ring.Stage(2, 16, 8, pixels.data()));
+			Assert::AreEqual(2U, ring.GetUploadCount());
+
+			ring.Clear();
+
+			Assert::AreEqual(0U, ring.GetUploadCount());
+			Assert::IsTrue(ring.Stage(2, 16, 8, pixels.data()));
+
+			TextureUploadRing smallRing(1024, 1);
+			Assert::IsTrue(smallRing.Stage(0, 8, 8, pixels.data()));
+			Assert::IsFalse(smallRing.Stage(1, 8, 8, pixels.data()));
+		}
+	};
+}